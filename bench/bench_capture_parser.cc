@@ -0,0 +1,50 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "capture_parser.h"
+
+
+int main()
+{
+    using namespace siren::http;
+
+    std::string c;
+
+    for (int i = 0; c.size() < 64 * 1024 * 1024; ++i) {
+        c += "GET /index/" + std::to_string(i) + "?q=abc HTTP/1.1\r\n"
+             "Host: www.example.com\r\n"
+             "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+             "Accept: text/html,application/xhtml+xml\r\n"
+             "Accept-Encoding: gzip, deflate\r\n"
+             "Content-Length: 4\r\n"
+             "\r\n"
+             "ping";
+    }
+
+    ParseOptions po;
+    unsigned int maxNumberOfThreads = std::thread::hardware_concurrency();
+
+    if (maxNumberOfThreads == 0) {
+        maxNumberOfThreads = 1;
+    }
+
+    std::printf("%-8s %12s %12s\n", "threads", "requests", "MB/s");
+
+    for (unsigned int n = 1;; n = n * 2 > maxNumberOfThreads && n < maxNumberOfThreads
+                                  ? maxNumberOfThreads : n * 2) {
+        auto t1 = std::chrono::steady_clock::now();
+        std::size_t m = ParseCapturedRequests(po, c.data(), c.size(), n).size();
+        auto t2 = std::chrono::steady_clock::now();
+        double s = std::chrono::duration<double>(t2 - t1).count();
+        std::printf("%-8u %12zu %12.1f\n", n, m, c.size() / s / (1024 * 1024));
+
+        if (n >= maxNumberOfThreads) {
+            break;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "request.h"
+#include "router.h"
+
+
+int main()
+{
+    using namespace siren::http;
+
+    const char *resources[] = {"users", "groups", "orders", "items", "repos"};
+    Router<int> r;
+    std::vector<std::string> paths;
+
+    for (int i = 0; i < 10000; ++i) {
+        std::string p = "/api/v" + std::to_string(i % 4) + "/" + resources[i % 5]
+                        + std::to_string(i / 20);
+
+        switch (i % 4) {
+        case 0:
+            r.addRoute(MethodType::Get, p.c_str(), i);
+            paths.push_back(p);
+            break;
+
+        case 1:
+            r.addRoute(MethodType::Get, (p + "/:id").c_str(), i);
+            paths.push_back(p + "/12345");
+            break;
+
+        case 2:
+            r.addRoute(MethodType::Get, (p + "/:id/children/:childID").c_str(), i);
+            paths.push_back(p + "/12345/children/678");
+            break;
+
+        default:
+            r.addRoute(MethodType::Get, (p + "/*path").c_str(), i);
+            paths.push_back(p + "/a/b/c.txt");
+            break;
+        }
+    }
+
+    const int n = 10000000;
+    RouteParameters ps;
+    long m = 0;
+    auto t1 = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < n; ++i) {
+        const int *v = r.matchRoute(MethodType::Get, paths[i % paths.size()].c_str(), &ps);
+        m += v == nullptr ? 0 : *v;
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double>(t2 - t1).count();
+    std::printf("%-8s %12s %12s\n", "routes", "lookups", "ns/lookup");
+    std::printf("%-8zu %12d %12.1f\n", paths.size(), n, s * 1e9 / n);
+    return m == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <siren/ip_endpoint.h>
+#include <siren/loop.h>
+#include <siren/tcp_socket.h>
+
+#include "request.h"
+#include "response.h"
+#include "server.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+const int NumberOfConnectionsPerClient = 16;
+const int NumberOfRequestsPerConnection = 20000;
+
+
+const struct Transport
+{
+    const char *name;
+    ConnectionTransport value;
+    bool receiveIsMultishot;
+} Transports[] = {
+    {"socket", ConnectionTransport::Socket, false},
+    {"io_uring", ConnectionTransport::IOURing, false},
+    {"multishot", ConnectionTransport::IOURing, true},
+};
+
+
+void SkipPayload(PayloadReader *);
+void Serve(Connection *);
+void RunClient(const IPEndpoint &);
+
+} // namespace
+
+
+int main()
+{
+    unsigned int maxNumberOfReactors = std::thread::hardware_concurrency() / 2;
+
+    if (maxNumberOfReactors == 0) {
+        maxNumberOfReactors = 1;
+    }
+
+    std::printf("%-10s %-8s %12s %12s\n", "transport", "reactors", "requests", "requests/s");
+
+    for (const Transport &transport : Transports) {
+        for (unsigned int n = 1;; n = n * 2 > maxNumberOfReactors && n < maxNumberOfReactors
+                                      ? maxNumberOfReactors : n * 2) {
+            ServerOptions so;
+            so.numberOfReactors = n;
+            so.reactorsArePinned = true;
+            so.transport = transport.value;
+            so.receiveIsMultishot = transport.receiveIsMultishot;
+            Server server(so, Serve);
+            server.start(IPEndpoint());
+            std::vector<std::thread> clients;
+            auto t1 = std::chrono::steady_clock::now();
+
+            for (unsigned int i = 0; i < n; ++i) {
+                clients.emplace_back(RunClient, server.getLocalEndpoint());
+            }
+
+            for (std::thread &client : clients) {
+                client.join();
+            }
+
+            auto t2 = std::chrono::steady_clock::now();
+            server.stop();
+            server.wait();
+            double s = std::chrono::duration<double>(t2 - t1).count();
+            long m = static_cast<long>(n) * NumberOfConnectionsPerClient
+                     * NumberOfRequestsPerConnection;
+            std::printf("%-10s %-8u %12ld %12.0f\n", transport.name, n, m, m / s);
+
+            if (n >= maxNumberOfReactors) {
+                break;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
+namespace {
+
+void
+SkipPayload(PayloadReader *payloadReader)
+{
+    for (;;) {
+        std::size_t n = payloadReader->getRemainingBodyOrChunkSize();
+
+        if (n == 0 && !payloadReader->bodyIsChunked()) {
+            return;
+        }
+
+        payloadReader->peekData(n);
+        payloadReader->discardData(n);
+    }
+}
+
+
+void
+Serve(Connection *connection)
+{
+    Response rsp;
+    rsp.majorVersionNumber = 1;
+    rsp.minorVersionNumber = 1;
+    rsp.statusCode = StatusCode::OK;
+    rsp.reasonPhrase = "OK";
+
+    do {
+        Request req;
+        PayloadReader pr = connection->parseRequest(&req);
+        SkipPayload(&pr);
+        PayloadWriter pw = connection->dumpResponse(rsp, 5);
+        char *b = pw.reserveBuffer(5);
+        std::memcpy(b, "hello", 5);
+        pw.flushBuffer(5);
+    } while (connection->isReusable());
+}
+
+
+void
+RunClient(const IPEndpoint &endpoint)
+{
+    Loop loop;
+
+    for (int i = 0; i < NumberOfConnectionsPerClient; ++i) {
+        loop.createFiber([&loop, &endpoint] () -> void {
+            TCPSocket tcpSocket(&loop);
+            tcpSocket.connect(endpoint);
+            tcpSocket.setNoDelay(true);
+            Connection connection(ConnectionOptions(), std::move(tcpSocket));
+            Request req;
+            req.methodType = MethodType::Get;
+            req.uri.setPathName("/");
+            req.majorVersionNumber = 1;
+            req.minorVersionNumber = 1;
+
+            for (int j = 0; j < NumberOfRequestsPerConnection; ++j) {
+                connection.dumpRequest(req, 0);
+                Response rsp;
+                PayloadReader pr = connection.parseResponse(&rsp);
+                SkipPayload(&pr);
+            }
+        });
+    }
+
+    loop.run();
+}
+
+} // namespace
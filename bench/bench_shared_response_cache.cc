@@ -0,0 +1,186 @@
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "request.h"
+#include "response.h"
+#include "response_cache.h"
+#include "shared_response_cache.h"
+
+
+namespace {
+
+using namespace siren::http;
+
+
+constexpr int NumberOfPaths = 10000;
+constexpr int NumberOfLookupsPerProcess = 2000000;
+
+
+struct WorkerResult
+{
+    double nanosecondsPerLookup;
+    long numberOfReads;
+    long numberOfHits;
+};
+
+
+void MakeRequest(Request *, int);
+void RunWorker(SharedResponseCache *, int, int, WorkerResult *);
+
+} // namespace
+
+
+int main()
+{
+    SharedResponseCacheOptions srco;
+    srco.segmentSize = 256 * 1024 * 1024;
+    srco.numberOfBuckets = 64 * 1024;
+    void *results = mmap(nullptr, 64 * sizeof(WorkerResult), PROT_READ | PROT_WRITE
+                         , MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (results == MAP_FAILED) {
+        std::perror("mmap() failed");
+        return EXIT_FAILURE;
+    }
+
+    WorkerResult *workerResults = static_cast<WorkerResult *>(results);
+    std::printf("%-10s %-8s %12s %12s %10s\n", "processes", "writes", "lookups", "ns/lookup"
+                , "hit rate");
+
+    for (int writeRatio : {0, 1, 10}) {
+        for (int numberOfProcesses : {1, 2, 4, 8}) {
+            SharedResponseCache src(srco);
+
+            for (int i = 0; i < NumberOfPaths; ++i) {
+                Request req;
+                MakeRequest(&req, i);
+                Response rsp;
+                rsp.majorVersionNumber = 1;
+                rsp.minorVersionNumber = 1;
+                rsp.statusCode = StatusCode::OK;
+                rsp.reasonPhrase = "OK";
+                rsp.header.addField("Cache-Control", "max-age=3600");
+                std::string body(512 + i % 1024, 'x');
+                src.storeResponse(req, rsp, body.data(), body.size());
+            }
+
+            std::vector<pid_t> pids;
+
+            for (int i = 0; i < numberOfProcesses; ++i) {
+                pid_t pid = fork();
+
+                if (pid < 0) {
+                    std::perror("fork() failed");
+                    return EXIT_FAILURE;
+                }
+
+                if (pid == 0) {
+                    RunWorker(&src, i, writeRatio, &workerResults[i]);
+                    _exit(EXIT_SUCCESS);
+                }
+
+                pids.push_back(pid);
+            }
+
+            for (pid_t pid : pids) {
+                int status;
+
+                if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)
+                    || WEXITSTATUS(status) != EXIT_SUCCESS) {
+                    std::fprintf(stderr, "worker failed\n");
+                    return EXIT_FAILURE;
+                }
+            }
+
+            double nanosecondsPerLookup = 0.0;
+            long numberOfReads = 0;
+            long numberOfHits = 0;
+
+            for (int i = 0; i < numberOfProcesses; ++i) {
+                nanosecondsPerLookup += workerResults[i].nanosecondsPerLookup;
+                numberOfReads += workerResults[i].numberOfReads;
+                numberOfHits += workerResults[i].numberOfHits;
+            }
+
+            std::string writes = std::to_string(writeRatio) + "%";
+            std::printf("%-10d %-8s %12d %12.1f %9.1f%%\n", numberOfProcesses, writes.c_str()
+                        , NumberOfLookupsPerProcess, nanosecondsPerLookup / numberOfProcesses
+                        , numberOfHits * 100.0 / numberOfReads);
+        }
+    }
+
+    munmap(results, 64 * sizeof(WorkerResult));
+    return EXIT_SUCCESS;
+}
+
+
+namespace {
+
+void
+MakeRequest(Request *request, int pathIndex)
+{
+    request->methodType = MethodType::Get;
+    request->uri.reset();
+    request->uri.setPathName("/objects/" + std::to_string(pathIndex));
+    request->majorVersionNumber = 1;
+    request->minorVersionNumber = 1;
+    request->header.reset();
+    request->header.addField("Host", "example.com");
+}
+
+
+void
+RunWorker(SharedResponseCache *sharedResponseCache, int workerIndex, int writeRatio
+          , WorkerResult *workerResult)
+{
+    std::vector<Request> requests(NumberOfPaths);
+
+    for (int i = 0; i < NumberOfPaths; ++i) {
+        MakeRequest(&requests[i], i);
+    }
+
+    Response response;
+    response.majorVersionNumber = 1;
+    response.minorVersionNumber = 1;
+    response.statusCode = StatusCode::OK;
+    response.reasonPhrase = "OK";
+    response.header.addField("Cache-Control", "max-age=3600");
+    std::string body(1024, 'y');
+    unsigned int randomNumber = workerIndex * 2654435761U + 1;
+    long numberOfReads = 0;
+    long numberOfHits = 0;
+    auto t1 = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < NumberOfLookupsPerProcess; ++i) {
+        randomNumber = randomNumber * 1103515245U + 12345U;
+        unsigned int r = randomNumber >> 8;
+        const Request &request = requests[r % 100 < 60 ? r % (NumberOfPaths / 100)
+                                                       : r % NumberOfPaths];
+
+        if (static_cast<int>((r >> 12) % 100) < writeRatio) {
+            sharedResponseCache->storeResponse(request, response, body.data(), body.size());
+        } else {
+            ++numberOfReads;
+
+            if (sharedResponseCache->findResponse(request) != nullptr) {
+                ++numberOfHits;
+            }
+        }
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+    workerResult->nanosecondsPerLookup = std::chrono::duration<double>(t2 - t1).count() * 1e9
+                                         / NumberOfLookupsPerProcess;
+    workerResult->numberOfReads = numberOfReads;
+    workerResult->numberOfHits = numberOfHits;
+}
+
+} // namespace
@@ -0,0 +1,159 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "request.h"
+#include "router.h"
+#include "static_router.h"
+
+
+namespace {
+
+using namespace siren::http;
+
+
+constexpr char P0[] = "/";
+constexpr char P1[] = "/health";
+constexpr char P2[] = "/api/v1/users";
+constexpr char P3[] = "/api/v1/users/:id";
+constexpr char P4[] = "/api/v1/users/:id/orders";
+constexpr char P5[] = "/api/v1/users/:id/orders/:orderID";
+constexpr char P6[] = "/api/v1/groups";
+constexpr char P7[] = "/api/v1/groups/:id";
+constexpr char P8[] = "/api/v1/groups/:id/members";
+constexpr char P9[] = "/api/v1/items";
+constexpr char P10[] = "/api/v1/items/:id";
+constexpr char P11[] = "/api/v2/users/:id";
+constexpr char P12[] = "/api/v2/groups/:id";
+constexpr char P13[] = "/static/*path";
+constexpr char P14[] = "/metrics";
+constexpr char P15[] = "/login";
+constexpr char P16[] = "/api/v1/orders";
+constexpr char P17[] = "/api/v1/orders/:id";
+constexpr char P18[] = "/api/v1/orders/:id/items";
+constexpr char P19[] = "/api/v1/orders/:id/items/:itemID";
+constexpr char P20[] = "/api/v1/products";
+constexpr char P21[] = "/api/v1/products/:id";
+constexpr char P22[] = "/api/v1/products/:id/reviews";
+constexpr char P23[] = "/api/v1/products/search";
+constexpr char P24[] = "/api/v1/carts/:id";
+constexpr char P25[] = "/api/v1/carts/:id/checkout";
+constexpr char P26[] = "/api/v2/orders/:id";
+constexpr char P27[] = "/api/v2/products/:id";
+constexpr char P28[] = "/api/v2/carts/:id";
+constexpr char P29[] = "/admin/users/:id";
+constexpr char P30[] = "/admin/settings";
+constexpr char P31[] = "/assets/*path";
+
+
+typedef StaticRouter<
+    StaticRoute<MethodType::Get, P0>,
+    StaticRoute<MethodType::Get, P1>,
+    StaticRoute<MethodType::Get, P2>,
+    StaticRoute<MethodType::Get, P3>,
+    StaticRoute<MethodType::Get, P4>,
+    StaticRoute<MethodType::Get, P5>,
+    StaticRoute<MethodType::Get, P6>,
+    StaticRoute<MethodType::Get, P7>,
+    StaticRoute<MethodType::Get, P8>,
+    StaticRoute<MethodType::Get, P9>,
+    StaticRoute<MethodType::Get, P10>,
+    StaticRoute<MethodType::Get, P11>,
+    StaticRoute<MethodType::Get, P12>,
+    StaticRoute<MethodType::Get, P13>,
+    StaticRoute<MethodType::Get, P14>,
+    StaticRoute<MethodType::Post, P15>,
+    StaticRoute<MethodType::Get, P16>,
+    StaticRoute<MethodType::Get, P17>,
+    StaticRoute<MethodType::Get, P18>,
+    StaticRoute<MethodType::Get, P19>,
+    StaticRoute<MethodType::Get, P20>,
+    StaticRoute<MethodType::Get, P21>,
+    StaticRoute<MethodType::Get, P22>,
+    StaticRoute<MethodType::Get, P23>,
+    StaticRoute<MethodType::Get, P24>,
+    StaticRoute<MethodType::Get, P25>,
+    StaticRoute<MethodType::Get, P26>,
+    StaticRoute<MethodType::Get, P27>,
+    StaticRoute<MethodType::Get, P28>,
+    StaticRoute<MethodType::Get, P29>,
+    StaticRoute<MethodType::Get, P30>,
+    StaticRoute<MethodType::Get, P31>
+> BenchRouter;
+
+
+const char *const Patterns[] = {
+    P0, P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12, P13, P14, nullptr,
+    P16, P17, P18, P19, P20, P21, P22, P23, P24, P25, P26, P27, P28, P29, P30, P31,
+};
+
+
+const char *const Paths[] = {
+    "/", "/health", "/api/v1/users", "/api/v1/users/123", "/api/v1/users/123/orders",
+    "/api/v1/users/123/orders/456", "/api/v1/groups", "/api/v1/groups/7",
+    "/api/v1/groups/7/members", "/api/v1/items", "/api/v1/items/99", "/api/v2/users/5",
+    "/api/v2/groups/5", "/static/js/app.js", "/metrics", "/not/found", "/api/v1/orders",
+    "/api/v1/orders/8", "/api/v1/orders/8/items", "/api/v1/orders/8/items/3",
+    "/api/v1/products", "/api/v1/products/11", "/api/v1/products/11/reviews",
+    "/api/v1/products/search", "/api/v1/carts/2", "/api/v1/carts/2/checkout",
+    "/api/v2/orders/8", "/api/v2/products/11", "/api/v2/carts/2", "/admin/users/1",
+    "/admin/settings", "/assets/img/logo.png",
+};
+
+
+constexpr int NumberOfPaths = sizeof(Paths) / sizeof(*Paths);
+constexpr int NumberOfLookups = 10000000;
+
+
+template <class T>
+double
+Measure(T &&match)
+{
+    RouteParameters ps;
+    std::size_t m = 0;
+    auto t1 = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < NumberOfLookups; ++i) {
+        m += match(Paths[i % NumberOfPaths], &ps);
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+
+    if (m == 0) {
+        std::abort();
+    }
+
+    return std::chrono::duration<double>(t2 - t1).count() * 1e9 / NumberOfLookups;
+}
+
+} // namespace
+
+
+int main()
+{
+    Router<std::size_t> r;
+
+    for (std::size_t i = 0; i < sizeof(Patterns) / sizeof(*Patterns); ++i) {
+        if (Patterns[i] == nullptr) {
+            r.addRoute(MethodType::Post, P15, i);
+        } else {
+            r.addRoute(MethodType::Get, Patterns[i], i);
+        }
+    }
+
+    static_assert(BenchRouter::NumberOfRoutes == sizeof(Patterns) / sizeof(*Patterns), "");
+
+    double t1 = Measure([&] (const char *path, RouteParameters *ps) -> std::size_t {
+        const std::size_t *v = r.matchRoute(MethodType::Get, path, ps);
+        return v == nullptr ? 0 : *v + 1;
+    });
+
+    double t2 = Measure([] (const char *path, RouteParameters *ps) -> std::size_t {
+        return BenchRouter::MatchRoute(MethodType::Get, path, ps) + 1;
+    });
+
+    std::printf("%-8s %12s\n", "router", "ns/lookup");
+    std::printf("%-8s %12.1f\n", "runtime", t1);
+    std::printf("%-8s %12.1f\n", "static", t2);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+
+namespace siren {
+
+namespace http {
+
+class Connection;
+class Header;
+class PayloadWriter;
+struct Response;
+
+
+constexpr std::size_t MaxNumberOfByteRanges = 16;
+
+
+struct ByteRange
+{
+    std::size_t offset;
+    std::size_t size;
+};
+
+
+enum class ByteRangesStatus
+{
+    None = 0,
+    Satisfiable,
+    Unsatisfiable,
+};
+
+
+typedef std::function<void (PayloadWriter *, const ByteRange &)> ByteRangeWriter;
+
+
+ByteRangesStatus ParseByteRanges(const Header &, std::size_t, const char *, const char *
+                                 , std::vector<ByteRange> *);
+void DumpPartialResponse(Connection *, Response *, std::size_t, const std::vector<ByteRange> &
+                         , const ByteRangeWriter &);
+void DumpRangeNotSatisfiableResponse(Connection *, Response *, std::size_t);
+
+} // namespace http
+
+} // namespace siren
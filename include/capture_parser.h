@@ -0,0 +1,41 @@
+#pragma once
+
+
+#include <cstddef>
+#include <vector>
+
+#include "parser.h"
+#include "request.h"
+#include "response.h"
+
+
+namespace siren {
+
+namespace http {
+
+struct CapturedRequest
+{
+    Request request;
+    std::size_t offset;
+    std::size_t size;
+    std::size_t bodySize;
+};
+
+
+struct CapturedResponse
+{
+    Response response;
+    std::size_t offset;
+    std::size_t size;
+    std::size_t bodySize;
+};
+
+
+std::vector<CapturedRequest> ParseCapturedRequests(const ParseOptions &, const void *
+                                                   , std::size_t, unsigned int);
+std::vector<CapturedResponse> ParseCapturedResponses(const ParseOptions &, const void *
+                                                     , std::size_t, unsigned int);
+
+} // namespace http
+
+} // namespace siren
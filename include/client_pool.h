@@ -0,0 +1,230 @@
+#pragma once
+
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+#include <siren/semaphore.h>
+
+#include "connection.h"
+
+
+namespace siren {
+
+class Loop;
+struct IPEndpoint;
+
+
+namespace http {
+
+class ClientPool;
+
+
+namespace detail {
+
+struct ClientPoolOptions
+{
+    std::size_t maxNumberOfConnectionsPerEndpoint = 16;
+    long maxIdleTime = 60000;
+};
+
+
+struct ClientPoolEndpoint;
+
+
+struct PooledConnection
+{
+    ClientPoolEndpoint *endpoint;
+    int fd;
+    std::chrono::steady_clock::time_point lastUseTime;
+    Connection connection;
+
+    explicit PooledConnection(ClientPoolEndpoint *, const http::ConnectionOptions &, TCPSocket &&);
+};
+
+
+struct ClientPoolEndpoint
+{
+    std::deque<std::unique_ptr<PooledConnection>> idleConnections;
+    Semaphore semaphore;
+
+    explicit ClientPoolEndpoint(Loop *, std::size_t);
+};
+
+} // namespace detail
+
+
+struct ClientPoolOptions
+  : detail::ClientPoolOptions,
+    ConnectionOptions
+{
+};
+
+
+class ClientConnection final
+{
+public:
+    inline ClientConnection(ClientConnection &&) noexcept;
+    inline ClientConnection &operator=(ClientConnection &&) noexcept;
+    inline ~ClientConnection();
+
+    inline bool isValid() const noexcept;
+    inline Connection *get() const noexcept;
+    inline Connection *operator->() const noexcept;
+    inline void release();
+
+private:
+    ClientPool *pool_;
+    detail::PooledConnection *pooledConnection_;
+
+    inline explicit ClientConnection(ClientPool *, detail::PooledConnection *) noexcept;
+
+    inline void initialize(ClientPool *, detail::PooledConnection *) noexcept;
+    inline void move(ClientConnection *) noexcept;
+    inline void discard() noexcept;
+
+    friend ClientPool;
+};
+
+
+class ClientPool final
+{
+public:
+    explicit ClientPool(Loop *, const ClientPoolOptions &);
+
+    std::size_t getNumberOfIdleConnections(const IPEndpoint &) const noexcept;
+    ClientConnection acquireConnection(const IPEndpoint &);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Loop *loop_;
+    ClientPoolOptions options_;
+    std::unordered_map<std::uint64_t, std::unique_ptr<detail::ClientPoolEndpoint>> endpoints_;
+
+    ClientPool(const ClientPool &) = delete;
+    ClientPool &operator=(const ClientPool &) = delete;
+
+    static std::uint64_t MakeEndpointKey(const IPEndpoint &) noexcept;
+
+    bool connectionIsHealthy(const detail::PooledConnection &, Clock::time_point) const noexcept;
+    void evictIdleConnections(detail::ClientPoolEndpoint *, Clock::time_point) noexcept;
+    void releaseConnection(detail::PooledConnection *) noexcept;
+    void discardConnection(detail::PooledConnection *) noexcept;
+
+    friend ClientConnection;
+};
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "client_pool-inl.h"
+ */
+
+
+#include <siren/assert.h>
+
+
+namespace siren {
+
+namespace http {
+
+ClientConnection::ClientConnection(ClientPool *pool, detail::PooledConnection *pooledConnection)
+    noexcept
+{
+    initialize(pool, pooledConnection);
+}
+
+
+ClientConnection::ClientConnection(ClientConnection &&other) noexcept
+{
+    other.move(this);
+}
+
+
+ClientConnection::~ClientConnection()
+{
+    discard();
+}
+
+
+ClientConnection &
+ClientConnection::operator=(ClientConnection &&other) noexcept
+{
+    if (&other != this) {
+        discard();
+        other.move(this);
+    }
+
+    return *this;
+}
+
+
+void
+ClientConnection::initialize(ClientPool *pool, detail::PooledConnection *pooledConnection)
+    noexcept
+{
+    pool_ = pool;
+    pooledConnection_ = pooledConnection;
+}
+
+
+void
+ClientConnection::move(ClientConnection *other) noexcept
+{
+    other->initialize(pool_, pooledConnection_);
+    initialize(nullptr, nullptr);
+}
+
+
+void
+ClientConnection::discard() noexcept
+{
+    if (isValid()) {
+        pool_->discardConnection(pooledConnection_);
+        initialize(nullptr, nullptr);
+    }
+}
+
+
+bool
+ClientConnection::isValid() const noexcept
+{
+    return pooledConnection_ != nullptr;
+}
+
+
+Connection *
+ClientConnection::get() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return &pooledConnection_->connection;
+}
+
+
+Connection *
+ClientConnection::operator->() const noexcept
+{
+    return get();
+}
+
+
+void
+ClientConnection::release()
+{
+    SIREN_ASSERT(isValid());
+    pooledConnection_->connection.flush();
+    pool_->releaseConnection(pooledConnection_);
+    initialize(nullptr, nullptr);
+}
+
+} // namespace http
+
+} // namespace siren
@@ -1,13 +1,19 @@
 #pragma once
 
 
+#include <sys/types.h>
+
 #include <cstddef>
 
+#include <siren/semaphore.h>
 #include <siren/stream.h>
 #include <siren/tcp_socket.h>
 
+#include "content_coding.h"
 #include "dumper.h"
+#include "io_uring.h"
 #include "parser.h"
+#include "timer_wheel.h"
 
 
 namespace siren {
@@ -20,19 +26,88 @@ struct Request;
 struct Response;
 
 
+class Connection;
+
+
+enum class ConnectionTransport
+{
+    Socket = 0,
+    IOURing,
+};
+
+
 namespace detail {
 
 struct ConnectionOptions
 {
+    ConnectionTransport transport = ConnectionTransport::Socket;
+    bool receiveIsMultishot = false;
     std::size_t minReadBufferSize = 4096;
+    std::size_t maxPipelineDepth = 1;
+    std::size_t maxNumberOfRequests = 0;
+    long headerTimeout = 0;
+    long bodyTimeout = 0;
+    long idleTimeout = 0;
+};
+
+
+enum class ConnectionDeadline
+{
+    None = 0,
+    Header,
+    Body,
+    Idle,
+};
+
+
+class ConnectionTimer final
+  : public Timer
+{
+public:
+    inline explicit ConnectionTimer(Connection *) noexcept;
+
+    inline void expire();
+
+private:
+    Connection *connection_;
+};
+
+
+class ConnectionStreamReader final
+{
+public:
+    inline explicit ConnectionStreamReader(Connection *) noexcept;
+
+    inline void operator()(Stream *) const;
+
+private:
+    Connection *connection_;
 };
 
+
+class ConnectionStreamWriter final
+{
+public:
+    inline explicit ConnectionStreamWriter(Connection *) noexcept;
+
+    inline void operator()(Stream *) const;
+
+private:
+    Connection *connection_;
+};
+
+
+typedef BasicParser<BasicInputStream<ConnectionStreamWriter>> ConnectionParser;
+typedef BasicDumper<BasicOutputStream<ConnectionStreamReader>> ConnectionDumper;
+
 } // namespace detail
 
 
 struct ConnectionOptions
   : detail::ConnectionOptions,
-    ParseOptions
+    ParseOptions,
+    DumpOptions,
+    CompressOptions
 {
 };
 
@@ -41,26 +116,70 @@ class Connection final
 {
 public:
     inline bool isValid() const noexcept;
+    inline bool isReusable() const noexcept;
+    inline bool isIdle() const noexcept;
+    inline std::size_t getNumberOfRequests() const noexcept;
     inline PayloadReader parseRequest(Request *);
     inline PayloadReader parseResponse(Response *);
+    inline PayloadReader parseResponse(Response *, MethodType);
+    inline PayloadReader parseDecompressedRequest(Request *);
+    inline PayloadReader parseDecompressedResponse(Response *);
     inline PayloadWriter dumpRequest(const Request &);
     inline PayloadWriter dumpRequest(const Request &, std::size_t);
     inline PayloadWriter dumpResponse(const Response &);
     inline PayloadWriter dumpResponse(const Response &, std::size_t);
+    inline PayloadWriter dumpCompressedResponse(const Response &);
+    inline PayloadWriter dumpCompressedResponse(const Response &, std::size_t);
+    inline PayloadWriter dumpEncodedResponse(const Response &, ContentCoding, std::size_t);
+    inline void dumpRawResponse(const char *, std::size_t, std::size_t, unsigned short
+                                , unsigned short);
+    inline void deferFlush() noexcept;
+    inline void flush();
+
+    explicit Connection(const ConnectionOptions &, TCPSocket &&, detail::TimerWheel * = nullptr
+                        , IOURing * = nullptr);
 
-    explicit Connection(const ConnectionOptions &, TCPSocket &&);
+    void sendFile(int, off_t, std::size_t);
 
 private:
-    typedef detail::ConnectionOptions Options;
+    typedef ConnectionOptions Options;
+    typedef detail::ConnectionDeadline Deadline;
 
     Options options_;
     TCPSocket tcpSocket_;
-    Stream streams_[2];
-    Parser parser_;
-    Dumper dumper_;
-
+    detail::IOURingSocket ioURingSocket_;
+    Stream inputStream_;
+    detail::ConnectionParser parser_;
+    detail::Decompressor decompressor_;
+    Stream outputStream_;
+    detail::ConnectionDumper dumper_;
+    detail::Compressor compressor_;
+    ContentCoding acceptedContentCoding_;
+    Semaphore writeSemaphore_;
+    std::size_t numberOfDeferredMessages_;
+    std::size_t numberOfRequests_;
+    std::size_t numberOfPendingResponses_;
+    bool isReusable_;
+    detail::TimerWheel *timerWheel_;
+    detail::ConnectionTimer timer_;
+    Deadline deadline_;
+    bool isTimedOut_;
+
+    bool responseIsCompressible(const Response &) const noexcept;
+    void updateReusability(const Header &) noexcept;
+    bool bodyIsBuffered() const noexcept;
+    PayloadReader makeDecompressedPayloadReader(ContentCoding);
+    void setDeadline(Deadline);
+    void handleTimeout();
+    void deferResponse() noexcept;
     void readStream(Stream *);
     void writeStream(Stream *);
+    std::size_t readSocket(Stream *);
+    void writeSocket(Stream *);
+
+    friend detail::ConnectionStreamReader;
+    friend detail::ConnectionStreamWriter;
+    friend detail::ConnectionTimer;
 };
 
 
@@ -77,13 +196,16 @@ public:
     inline void discardData(std::size_t);
 
 protected:
-    inline explicit PayloadReader(Parser *) noexcept;
+    inline explicit PayloadReader(detail::ConnectionParser *, detail::Decompressor * = nullptr)
+        noexcept;
 
 private:
-    Parser *parser_;
+    detail::ConnectionParser *parser_;
+    detail::Decompressor *decompressor_;
 
-    inline void initialize(Parser *) noexcept;
+    inline void initialize(detail::ConnectionParser *, detail::Decompressor *) noexcept;
     inline void move(PayloadReader *) noexcept;
+    inline void readDecompressedData();
 
     friend Connection;
 };
@@ -102,13 +224,16 @@ public:
     inline void flushBuffer(std::size_t);
 
 protected:
-    inline explicit PayloadWriter(Dumper *) noexcept;
+    inline explicit PayloadWriter(detail::ConnectionDumper *, detail::Compressor * = nullptr)
+        noexcept;
 
 private:
-    Dumper *dumper_;
+    detail::ConnectionDumper *dumper_;
+    detail::Compressor *compressor_;
 
-    inline void initialize(Dumper *) noexcept;
+    inline void initialize(detail::ConnectionDumper *, detail::Compressor *) noexcept;
     inline void move(PayloadWriter *) noexcept;
+    inline void flushCompressedBuffer(std::size_t);
 
     friend Connection;
 };
@@ -123,6 +248,9 @@ private:
  */
 
 
+#include <algorithm>
+#include <tuple>
+
 #include <siren/assert.h>
 
 
@@ -130,6 +258,49 @@ namespace siren {
 
 namespace http {
 
+namespace detail {
+
+ConnectionStreamReader::ConnectionStreamReader(Connection *connection) noexcept
+  : connection_(connection)
+{
+}
+
+
+void
+ConnectionStreamReader::operator()(Stream *stream) const
+{
+    connection_->readStream(stream);
+}
+
+
+ConnectionStreamWriter::ConnectionStreamWriter(Connection *connection) noexcept
+  : connection_(connection)
+{
+}
+
+
+void
+ConnectionStreamWriter::operator()(Stream *stream) const
+{
+    connection_->writeStream(stream);
+}
+
+
+ConnectionTimer::ConnectionTimer(Connection *connection) noexcept
+  : connection_(connection)
+{
+}
+
+
+void
+ConnectionTimer::expire()
+{
+    connection_->handleTimeout();
+}
+
+} // namespace detail
+
+
 bool
 Connection::isValid() const noexcept
 {
@@ -137,29 +308,112 @@ Connection::isValid() const noexcept
 }
 
 
+bool
+Connection::isReusable() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return isReusable_;
+}
+
+
+bool
+Connection::isIdle() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return numberOfPendingResponses_ == 0 && !parser_.bodyIsChunked()
+           && parser_.getRemainingBodyOrChunkSize() == 0 && inputStream_.getDataSize() == 0
+           && !dumper_.bodyIsChunked() && dumper_.getRemainingBodySize() == 0;
+}
+
+
+std::size_t
+Connection::getNumberOfRequests() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return numberOfRequests_;
+}
+
+
 PayloadReader
 Connection::parseRequest(Request *request)
 {
     SIREN_ASSERT(isValid());
+    setDeadline(numberOfRequests_ >= 1 && inputStream_.getDataSize() == 0 ? Deadline::Idle
+                                                                          : Deadline::Header);
     parser_.getRequest(request);
+    acceptedContentCoding_ = NegotiateContentCoding(request->header);
+    setDeadline(parser_.bodyIsChunked() || parser_.getRemainingBodyOrChunkSize() >= 1
+                ? Deadline::Body : Deadline::None);
+    ++numberOfRequests_;
+    isReusable_ = isReusable_ && parser_.connectionIsPersistent()
+                  && (options_.maxNumberOfRequests == 0
+                      || numberOfRequests_ < options_.maxNumberOfRequests);
+    dumper_.setConnectionPersistence(isReusable_ ? ConnectionPersistence::KeepAlive
+                                                 : ConnectionPersistence::Close);
     return PayloadReader(&parser_);
 }
 
 
 PayloadReader
 Connection::parseResponse(Response *response)
+{
+    return parseResponse(response, MethodType::Get);
+}
+
+
+PayloadReader
+Connection::parseResponse(Response *response, MethodType requestMethodType)
 {
     SIREN_ASSERT(isValid());
-    parser_.getResponse(response);
+    setDeadline(Deadline::Header);
+    parser_.getResponse(response, requestMethodType);
+    setDeadline(parser_.bodyIsChunked() || parser_.getRemainingBodyOrChunkSize() >= 1
+                ? Deadline::Body : Deadline::None);
+    isReusable_ = isReusable_ && parser_.connectionIsPersistent();
+
+    if (numberOfPendingResponses_ >= 1) {
+        --numberOfPendingResponses_;
+    }
+
     return PayloadReader(&parser_);
 }
 
 
+PayloadReader
+Connection::parseDecompressedRequest(Request *request)
+{
+    PayloadReader payloadReader = parseRequest(request);
+    ContentCoding contentCoding = ExtractContentCoding(&request->header);
+
+    if (contentCoding == ContentCoding::Identity) {
+        return payloadReader;
+    }
+
+    return makeDecompressedPayloadReader(contentCoding);
+}
+
+
+PayloadReader
+Connection::parseDecompressedResponse(Response *response)
+{
+    PayloadReader payloadReader = parseResponse(response);
+    ContentCoding contentCoding = ExtractContentCoding(&response->header);
+
+    if (contentCoding == ContentCoding::Identity) {
+        return payloadReader;
+    }
+
+    return makeDecompressedPayloadReader(contentCoding);
+}
+
+
 PayloadWriter
 Connection::dumpRequest(const Request &request)
 {
     SIREN_ASSERT(isValid());
+    updateReusability(request.header);
     dumper_.putRequest(request);
+    ++numberOfPendingResponses_;
     return PayloadWriter(&dumper_);
 }
 
@@ -168,7 +422,9 @@ PayloadWriter
 Connection::dumpRequest(const Request &request, std::size_t bodySize)
 {
     SIREN_ASSERT(isValid());
+    updateReusability(request.header);
     dumper_.putRequest(request, bodySize);
+    ++numberOfPendingResponses_;
     return PayloadWriter(&dumper_);
 }
 
@@ -177,6 +433,13 @@ PayloadWriter
 Connection::dumpResponse(const Response &response)
 {
     SIREN_ASSERT(isValid());
+
+    if (deadline_ == Deadline::Body) {
+        setDeadline(Deadline::None);
+    }
+
+    updateReusability(response.header);
+    deferResponse();
     dumper_.putResponse(response);
     return PayloadWriter(&dumper_);
 }
@@ -186,14 +449,112 @@ PayloadWriter
 Connection::dumpResponse(const Response &response, std::size_t bodySize)
 {
     SIREN_ASSERT(isValid());
+
+    if (deadline_ == Deadline::Body) {
+        setDeadline(Deadline::None);
+    }
+
+    updateReusability(response.header);
+    deferResponse();
     dumper_.putResponse(response, bodySize);
     return PayloadWriter(&dumper_);
 }
 
 
-PayloadReader::PayloadReader(Parser *parser) noexcept
+PayloadWriter
+Connection::dumpCompressedResponse(const Response &response)
+{
+    SIREN_ASSERT(isValid());
+
+    if (!responseIsCompressible(response)) {
+        return dumpResponse(response);
+    }
+
+    if (acceptedContentCoding_ == ContentCoding::Identity) {
+        dumper_.setContentCodingName(GetContentCodingName(ContentCoding::Identity));
+        return dumpResponse(response);
+    }
+
+    compressor_.start(acceptedContentCoding_, options_.compressionLevel, true, 0);
+    dumper_.setContentCodingName(GetContentCodingName(acceptedContentCoding_));
+    PayloadWriter payloadWriter = dumpResponse(response);
+    payloadWriter.compressor_ = &compressor_;
+    return payloadWriter;
+}
+
+
+PayloadWriter
+Connection::dumpCompressedResponse(const Response &response, std::size_t bodySize)
+{
+    SIREN_ASSERT(isValid());
+
+    if (!responseIsCompressible(response)) {
+        return dumpResponse(response, bodySize);
+    }
+
+    if (acceptedContentCoding_ == ContentCoding::Identity
+        || bodySize < options_.minCompressionSize) {
+        dumper_.setContentCodingName(GetContentCodingName(ContentCoding::Identity));
+        return dumpResponse(response, bodySize);
+    }
+
+    compressor_.start(acceptedContentCoding_, options_.compressionLevel, false
+                      , bodySize);
+    dumper_.setContentCodingName(GetContentCodingName(acceptedContentCoding_));
+    PayloadWriter payloadWriter = dumpResponse(response);
+    payloadWriter.compressor_ = &compressor_;
+    return payloadWriter;
+}
+
+
+PayloadWriter
+Connection::dumpEncodedResponse(const Response &response, ContentCoding contentCoding
+                                , std::size_t bodySize)
+{
+    SIREN_ASSERT(isValid());
+    dumper_.setContentCodingName(GetContentCodingName(contentCoding));
+    return dumpResponse(response, bodySize);
+}
+
+
+void
+Connection::dumpRawResponse(const char *rawResponse, std::size_t rawResponseSize
+                            , std::size_t startLineSize, unsigned short majorVersionNumber
+                            , unsigned short minorVersionNumber)
+{
+    SIREN_ASSERT(isValid());
+
+    if (deadline_ == Deadline::Body) {
+        setDeadline(Deadline::None);
+    }
+
+    deferResponse();
+    dumper_.putRawResponse(rawResponse, rawResponseSize, startLineSize, majorVersionNumber
+                           , minorVersionNumber);
+}
+
+
+void
+Connection::deferFlush() noexcept
 {
-    initialize(parser);
+    SIREN_ASSERT(isValid());
+    dumper_.deferFlush();
+    ++numberOfDeferredMessages_;
+}
+
+
+void
+Connection::flush()
+{
+    SIREN_ASSERT(isValid());
+    dumper_.flush();
+}
+
+
+PayloadReader::PayloadReader(detail::ConnectionParser *parser
+                             , detail::Decompressor *decompressor) noexcept
+{
+    initialize(parser, decompressor);
 }
 
 
@@ -215,17 +576,19 @@ PayloadReader::operator=(PayloadReader &&other) noexcept
 
 
 void
-PayloadReader::initialize(Parser *parser) noexcept
+PayloadReader::initialize(detail::ConnectionParser *parser, detail::Decompressor *decompressor)
+    noexcept
 {
     parser_ = parser;
+    decompressor_ = decompressor;
 }
 
 
 void
 PayloadReader::move(PayloadReader *other) noexcept
 {
-    other->parser_ = parser_;
-    parser_ = nullptr;
+    other->initialize(parser_, decompressor_);
+    initialize(nullptr, nullptr);
 }
 
 
@@ -240,7 +603,7 @@ bool
 PayloadReader::bodyIsChunked() const noexcept
 {
     SIREN_ASSERT(isValid());
-    return parser_->bodyIsChunked();
+    return decompressor_ == nullptr ? parser_->bodyIsChunked() : decompressor_->isActive();
 }
 
 
@@ -248,7 +611,9 @@ std::size_t
 PayloadReader::getRemainingBodyOrChunkSize() const noexcept
 {
     SIREN_ASSERT(isValid());
-    return parser_->getRemainingBodyOrChunkSize();
+
+    return decompressor_ == nullptr ? parser_->getRemainingBodyOrChunkSize()
+                                    : decompressor_->getDataSize();
 }
 
 
@@ -256,7 +621,13 @@ char *
 PayloadReader::peekData(std::size_t dataSize)
 {
     SIREN_ASSERT(isValid());
-    return parser_->peekPayloadData(dataSize);
+
+    if (decompressor_ == nullptr) {
+        return parser_->peekPayloadData(dataSize);
+    } else {
+        SIREN_ASSERT(dataSize <= decompressor_->getDataSize());
+        return decompressor_->isActive() ? decompressor_->getData() : nullptr;
+    }
 }
 
 
@@ -264,13 +635,61 @@ void
 PayloadReader::discardData(std::size_t dataSize)
 {
     SIREN_ASSERT(isValid());
-    return parser_->discardPayloadData(dataSize);
+
+    if (decompressor_ == nullptr) {
+        parser_->discardPayloadData(dataSize);
+    } else if (decompressor_->isActive()) {
+        decompressor_->discardData(dataSize);
+
+        if (decompressor_->getDataSize() == 0) {
+            readDecompressedData();
+        }
+    }
+}
+
+
+void
+PayloadReader::readDecompressedData()
+{
+    while (!decompressor_->isFinished()) {
+        std::size_t n = parser_->getRemainingBodyOrChunkSize();
+
+        if (n == 0) {
+            throw InvalidMessage();
+        }
+
+        n = std::min(n, detail::DecompressorBufferSize);
+        const char *data = parser_->peekPayloadData(n);
+        parser_->discardPayloadData(decompressor_->decompress(data, n));
+
+        if (decompressor_->getDataSize() >= 1) {
+            return;
+        }
+    }
+
+    for (;;) {
+        std::size_t n = parser_->getRemainingBodyOrChunkSize();
+
+        if (n >= 1) {
+            throw InvalidMessage();
+        }
+
+        if (!parser_->bodyIsChunked()) {
+            break;
+        }
+
+        parser_->peekPayloadData(0);
+        parser_->discardPayloadData(0);
+    }
+
+    decompressor_->stop();
 }
 
 
-PayloadWriter::PayloadWriter(Dumper *dumper) noexcept
+PayloadWriter::PayloadWriter(detail::ConnectionDumper *dumper, detail::Compressor *compressor)
+    noexcept
 {
-    initialize(dumper);
+    initialize(dumper, compressor);
 }
 
 
@@ -292,17 +711,19 @@ PayloadWriter::operator=(PayloadWriter &&other) noexcept
 
 
 void
-PayloadWriter::initialize(Dumper *dumper) noexcept
+PayloadWriter::initialize(detail::ConnectionDumper *dumper, detail::Compressor *compressor)
+    noexcept
 {
     dumper_ = dumper;
+    compressor_ = compressor;
 }
 
 
 void
 PayloadWriter::move(PayloadWriter *other) noexcept
 {
-    other->dumper_ = dumper_;
-    dumper_ = nullptr;
+    other->initialize(dumper_, compressor_);
+    initialize(nullptr, nullptr);
 }
 
 
@@ -317,7 +738,7 @@ bool
 PayloadWriter::bodyIsChunked() const noexcept
 {
     SIREN_ASSERT(isValid());
-    return dumper_->bodyIsChunked();
+    return compressor_ == nullptr ? dumper_->bodyIsChunked() : compressor_->inputIsChunked();
 }
 
 
@@ -325,7 +746,9 @@ std::size_t
 PayloadWriter::getRemainingBodySize() const noexcept
 {
     SIREN_ASSERT(isValid());
-    return dumper_->getRemainingBodySize();
+
+    return compressor_ == nullptr ? dumper_->getRemainingBodySize()
+                                  : compressor_->getRemainingInputSize();
 }
 
 
@@ -333,7 +756,9 @@ char *
 PayloadWriter::reserveBuffer(std::size_t bufferSize)
 {
     SIREN_ASSERT(isValid());
-    return dumper_->reservePayloadBuffer(bufferSize);
+
+    return compressor_ == nullptr ? dumper_->reservePayloadBuffer(bufferSize)
+                                  : compressor_->reserveInputBuffer(bufferSize);
 }
 
 
@@ -341,7 +766,41 @@ void
 PayloadWriter::flushBuffer(std::size_t bufferSize)
 {
     SIREN_ASSERT(isValid());
-    return dumper_->flushPayloadBuffer(bufferSize);
+
+    if (compressor_ == nullptr) {
+        dumper_->flushPayloadBuffer(bufferSize);
+    } else {
+        flushCompressedBuffer(bufferSize);
+    }
+}
+
+
+void
+PayloadWriter::flushCompressedBuffer(std::size_t bufferSize)
+{
+    bool inputIsFinal = compressor_->commitInput(bufferSize);
+    const char *input = compressor_->getInputBuffer();
+    std::size_t inputSize = bufferSize;
+
+    while (inputSize >= 1 || (inputIsFinal && !compressor_->isFinished())) {
+        std::size_t outputSize = compressor_->getMaxOutputSize(inputSize);
+        char *output = dumper_->reservePayloadBuffer(outputSize);
+        std::size_t n1, n2;
+        std::tie(n1, n2) = compressor_->compress(input, inputSize, output, outputSize
+                                                 , inputIsFinal);
+        input += n1;
+        inputSize -= n1;
+
+        if (n2 >= 1) {
+            dumper_->flushPayloadBuffer(n2);
+        }
+    }
+
+    if (inputIsFinal) {
+        compressor_->stop();
+        dumper_->reservePayloadBuffer(0);
+        dumper_->flushPayloadBuffer(0);
+    }
 }
 
 } // namespace http
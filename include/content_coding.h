@@ -0,0 +1,215 @@
+#pragma once
+
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+
+namespace siren {
+
+namespace http {
+
+class Header;
+
+
+enum class ContentCoding
+{
+    Identity = 0,
+    Gzip,
+    Deflate,
+    Brotli,
+    Zstd,
+};
+
+
+struct CompressOptions
+{
+    std::size_t minCompressionSize = 1024;
+    int compressionLevel = -1;
+};
+
+
+const char *GetContentCodingName(ContentCoding) noexcept;
+bool ContentCodingIsSupported(ContentCoding) noexcept;
+ContentCoding NegotiateContentCoding(const Header &) noexcept;
+ContentCoding NegotiateContentCoding(const Header &, unsigned int) noexcept;
+ContentCoding ExtractContentCoding(Header *);
+
+
+namespace detail {
+
+constexpr std::size_t DecompressorBufferSize = 16 * 1024;
+
+
+struct CompressorState;
+struct DecompressorState;
+
+
+class Compressor final
+{
+public:
+    inline bool isActive() const noexcept;
+    inline bool isFinished() const noexcept;
+    inline bool inputIsChunked() const noexcept;
+    inline std::size_t getRemainingInputSize() const noexcept;
+    inline char *getInputBuffer() noexcept;
+
+    explicit Compressor() noexcept;
+    ~Compressor();
+
+    void start(ContentCoding, int, bool, std::size_t);
+    char *reserveInputBuffer(std::size_t);
+    bool commitInput(std::size_t) noexcept;
+    std::size_t getMaxOutputSize(std::size_t) const noexcept;
+    std::pair<std::size_t, std::size_t> compress(const char *, std::size_t, char *, std::size_t
+                                                 , bool);
+    void stop() noexcept;
+
+private:
+    CompressorState *state_;
+    ContentCoding contentCoding_;
+    bool isFinished_;
+    bool inputIsChunked_;
+    std::size_t remainingInputSize_;
+    std::string inputBuffer_;
+
+    Compressor(const Compressor &) = delete;
+    Compressor &operator=(const Compressor &) = delete;
+};
+
+
+class Decompressor final
+{
+public:
+    inline bool isActive() const noexcept;
+    inline bool isFinished() const noexcept;
+    inline std::size_t getDataSize() const noexcept;
+    inline char *getData() noexcept;
+    inline void discardData(std::size_t) noexcept;
+
+    explicit Decompressor() noexcept;
+    ~Decompressor();
+
+    void start(ContentCoding, std::size_t);
+    std::size_t decompress(const char *, std::size_t);
+    void stop() noexcept;
+
+private:
+    DecompressorState *state_;
+    ContentCoding contentCoding_;
+    bool isFinished_;
+    std::size_t remainingOutputSize_;
+    std::string buffer_;
+    std::size_t dataOffset_;
+    std::size_t dataSize_;
+
+    Decompressor(const Decompressor &) = delete;
+    Decompressor &operator=(const Decompressor &) = delete;
+};
+
+} // namespace detail
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "content_coding-inl.h"
+ */
+
+
+#include <siren/assert.h>
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+bool
+Compressor::isActive() const noexcept
+{
+    return contentCoding_ != ContentCoding::Identity;
+}
+
+
+bool
+Compressor::isFinished() const noexcept
+{
+    SIREN_ASSERT(isActive());
+    return isFinished_;
+}
+
+
+bool
+Compressor::inputIsChunked() const noexcept
+{
+    SIREN_ASSERT(isActive());
+    return inputIsChunked_;
+}
+
+
+std::size_t
+Compressor::getRemainingInputSize() const noexcept
+{
+    SIREN_ASSERT(isActive());
+    SIREN_ASSERT(!inputIsChunked_);
+    return remainingInputSize_;
+}
+
+
+char *
+Compressor::getInputBuffer() noexcept
+{
+    SIREN_ASSERT(isActive());
+    return &inputBuffer_[0];
+}
+
+
+bool
+Decompressor::isActive() const noexcept
+{
+    return contentCoding_ != ContentCoding::Identity;
+}
+
+
+bool
+Decompressor::isFinished() const noexcept
+{
+    SIREN_ASSERT(isActive());
+    return isFinished_;
+}
+
+
+std::size_t
+Decompressor::getDataSize() const noexcept
+{
+    return dataSize_;
+}
+
+
+char *
+Decompressor::getData() noexcept
+{
+    SIREN_ASSERT(isActive());
+    return &buffer_[dataOffset_];
+}
+
+
+void
+Decompressor::discardData(std::size_t dataSize) noexcept
+{
+    SIREN_ASSERT(isActive());
+    SIREN_ASSERT(dataSize <= dataSize_);
+    dataOffset_ += dataSize;
+    dataSize_ -= dataSize;
+}
+
+} // namespace detail
+
+} // namespace http
+
+} // namespace siren
@@ -13,38 +13,102 @@ struct Request;
 struct Response;
 
 
-class Dumper final
+struct DumpOptions
 {
-public:
-    inline bool isValid() const noexcept;
-    inline bool bodyIsChunked() const noexcept;
-    inline std::size_t getRemainingBodySize() const noexcept;
+    std::size_t minFlushSize = 0;
+};
 
-    template <class ...T>
-    inline explicit Dumper(T &&...);
 
-    Dumper(Dumper &&) noexcept;
-    Dumper &operator=(Dumper &&) noexcept;
+enum class ConnectionPersistence
+{
+    Unspecified = 0,
+    KeepAlive,
+    Close,
+};
 
-    void putRequest(const Request &);
-    void putRequest(const Request &, std::size_t);
-    void putResponse(const Response &);
-    void putResponse(const Response &, std::size_t);
-    char *reservePayloadBuffer(std::size_t);
-    void flushPayloadBuffer(std::size_t);
 
-private:
-    OutputStream outputStream_;
+namespace detail {
+
+class DumperBase
+{
+protected:
+    DumpOptions options_;
     bool bodyIsChunked_;
+    bool flushIsDeferred_;
+    ConnectionPersistence connectionPersistence_;
+    const char *contentCodingName_;
     std::size_t remainingBodySize_;
 
+    static std::size_t GetMaxRequestStartLineSize(const Request &) noexcept;
+    static char *DumpRequestStartLine(const Request &, char *) noexcept;
+    static std::size_t GetMaxResponseStartLineSize(const Response &) noexcept;
+    static char *DumpResponseStartLine(const Response &, char *) noexcept;
+    static std::size_t GetMaxHeaderSize(const Header &, bool, std::size_t, const char *
+                                        , const char *) noexcept;
+    static char *DumpHeader(const Header &, bool, std::size_t, const char *, const char *, char *)
+        noexcept;
+    static char *DumpChunkSize(std::size_t, char *) noexcept;
+
+    explicit DumperBase(const DumpOptions &) noexcept;
+    DumperBase(DumperBase &&) noexcept;
+    DumperBase &operator=(DumperBase &&) noexcept;
+
+    const char *getConnectionToken(const Header &, unsigned short, unsigned short) const noexcept;
+    const char *getConnectionToken(unsigned short, unsigned short) const noexcept;
+
+private:
     void initialize() noexcept;
-    void move(Dumper *) noexcept;
-    void dumpRequestStartLine(const Request &);
-    void dumpResponseStartLine(const Response &);
-    void dumpHeader(const Header &, bool, std::size_t);
+    void move(DumperBase *) noexcept;
 };
 
+} // namespace detail
+
+
+template <class T = OutputStream>
+class BasicDumper final
+  : private detail::DumperBase
+{
+public:
+    typedef DumpOptions Options;
+
+    inline bool isValid() const noexcept;
+    inline bool bodyIsChunked() const noexcept;
+    inline std::size_t getRemainingBodySize() const noexcept;
+
+    template <class ...U>
+    inline explicit BasicDumper(const Options &, U &&...);
+
+    inline BasicDumper(BasicDumper &&) noexcept;
+    inline BasicDumper &operator=(BasicDumper &&) noexcept;
+
+    inline void putRequest(const Request &);
+    inline void putRequest(const Request &, std::size_t);
+    inline void putResponse(const Response &);
+    inline void putResponse(const Response &, std::size_t);
+    inline void putRawResponse(const char *, std::size_t, std::size_t, unsigned short
+                               , unsigned short);
+    inline char *reservePayloadBuffer(std::size_t);
+    inline void flushPayloadBuffer(std::size_t);
+    inline void skipPayload(std::size_t);
+    inline void setConnectionPersistence(ConnectionPersistence) noexcept;
+    inline void setContentCodingName(const char *) noexcept;
+    inline void deferFlush() noexcept;
+    inline void flush();
+
+private:
+    T outputStream_;
+
+    inline void endHeader();
+    inline void endPayload();
+    inline void endMessage();
+    inline void dumpRequestStartLine(const Request &);
+    inline void dumpResponseStartLine(const Response &);
+    inline void dumpHeader(const Header &, unsigned short, unsigned short, bool, std::size_t);
+};
+
+
+typedef BasicDumper<> Dumper;
+
 } // namespace http
 
 } // namespace siren
@@ -55,46 +119,345 @@ private:
  */
 
 
+#include <cstdio>
+#include <cstring>
+#include <limits>
 #include <utility>
 
 #include <siren/assert.h>
+#include <siren/utility.h>
+
+#include "request.h"
+#include "response.h"
 
 
 namespace siren {
 
 namespace http {
 
-template <class ...T>
-Dumper::Dumper(T &&...outputStream)
-  : outputStream_(std::forward<T>(outputStream)...)
+template <class T>
+template <class ...U>
+BasicDumper<T>::BasicDumper(const Options &options, U &&...outputStream)
+  : DumperBase(options),
+    outputStream_(std::forward<U>(outputStream)...)
 {
-    initialize();
 }
 
 
+template <class T>
+BasicDumper<T>::BasicDumper(BasicDumper &&other) noexcept
+  : DumperBase(std::move(other)),
+    outputStream_(std::move(other.outputStream_))
+{
+}
+
+
+template <class T>
+BasicDumper<T> &
+BasicDumper<T>::operator=(BasicDumper &&other) noexcept
+{
+    if (&other != this) {
+        DumperBase::operator=(std::move(other));
+        outputStream_ = std::move(other.outputStream_);
+    }
+
+    return *this;
+}
+
+
+template <class T>
 bool
-Dumper::isValid() const noexcept
+BasicDumper<T>::isValid() const noexcept
 {
     return outputStream_.isValid();
 }
 
 
+template <class T>
 bool
-Dumper::bodyIsChunked() const noexcept
+BasicDumper<T>::bodyIsChunked() const noexcept
 {
     SIREN_ASSERT(isValid());
     return bodyIsChunked_;
 }
 
 
+template <class T>
 std::size_t
-Dumper::getRemainingBodySize() const noexcept
+BasicDumper<T>::getRemainingBodySize() const noexcept
 {
     SIREN_ASSERT(isValid());
     SIREN_ASSERT(!bodyIsChunked_);
     return remainingBodySize_;
 }
 
+
+template <class T>
+void
+BasicDumper<T>::putRequest(const Request &request)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
+    dumpRequestStartLine(request);
+    dumpHeader(request.header, request.majorVersionNumber, request.minorVersionNumber, true
+               , -1);
+    bodyIsChunked_ = true;
+    endHeader();
+}
+
+
+template <class T>
+void
+BasicDumper<T>::putRequest(const Request &request, std::size_t bodySize)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
+    dumpRequestStartLine(request);
+    dumpHeader(request.header, request.majorVersionNumber, request.minorVersionNumber, false
+               , bodySize);
+    bodyIsChunked_ = false;
+    remainingBodySize_ = bodySize;
+    endHeader();
+}
+
+
+template <class T>
+void
+BasicDumper<T>::putResponse(const Response &response)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
+    dumpResponseStartLine(response);
+    dumpHeader(response.header, response.majorVersionNumber, response.minorVersionNumber, true
+               , -1);
+    bodyIsChunked_ = true;
+    endHeader();
+}
+
+
+template <class T>
+void
+BasicDumper<T>::putResponse(const Response &response, std::size_t bodySize)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
+    dumpResponseStartLine(response);
+    dumpHeader(response.header, response.majorVersionNumber, response.minorVersionNumber, false
+               , bodySize);
+    bodyIsChunked_ = false;
+    remainingBodySize_ = bodySize;
+    endHeader();
+}
+
+
+template <class T>
+void
+BasicDumper<T>::putRawResponse(const char *rawResponse, std::size_t rawResponseSize
+                               , std::size_t startLineSize, unsigned short majorVersionNumber
+                               , unsigned short minorVersionNumber)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
+    SIREN_ASSERT(startLineSize <= rawResponseSize);
+    const char *connectionToken = getConnectionToken(majorVersionNumber, minorVersionNumber);
+    std::size_t connectionFieldSize = connectionToken == nullptr
+                                      ? 0
+                                      : SIREN_STRLEN("Connection: ") + std::strlen(connectionToken)
+                                        + SIREN_STRLEN("\r\n");
+    outputStream_.reserveBuffer(rawResponseSize + connectionFieldSize + 1);
+    char *s1 = outputStream_.getBuffer();
+    char *s2 = s1;
+    std::memcpy(s2, rawResponse, startLineSize);
+    s2 += startLineSize;
+
+    if (connectionToken != nullptr) {
+        s2 += std::sprintf(s2, "Connection: %s\r\n", connectionToken);
+    }
+
+    std::memcpy(s2, rawResponse + startLineSize, rawResponseSize - startLineSize);
+    s2 += rawResponseSize - startLineSize;
+    outputStream_.commitBuffer(s2 - s1);
+    contentCodingName_ = nullptr;
+    endMessage();
+}
+
+
+template <class T>
+char *
+BasicDumper<T>::reservePayloadBuffer(std::size_t payloadBufferSize)
+{
+    SIREN_ASSERT(isValid());
+    char *payloadBuffer;
+
+    if (bodyIsChunked_) {
+        constexpr unsigned int k = (std::numeric_limits<std::size_t>::digits + 3) / 4;
+
+        outputStream_.reserveBuffer(k + SIREN_STRLEN("\r\n") + payloadBufferSize
+                                    + SIREN_STRLEN("\r\n"));
+        payloadBuffer = outputStream_.getBuffer() + k + SIREN_STRLEN("\r\n");
+    } else {
+        SIREN_ASSERT(payloadBufferSize <= remainingBodySize_);
+        outputStream_.reserveBuffer(payloadBufferSize);
+        payloadBuffer = outputStream_.getBuffer();
+    }
+
+    return payloadBuffer;
+}
+
+
+template <class T>
+void
+BasicDumper<T>::flushPayloadBuffer(std::size_t payloadBufferSize)
+{
+    SIREN_ASSERT(isValid());
+
+    if (bodyIsChunked_) {
+        char *s1 = outputStream_.getBuffer();
+        char *s2 = DumpChunkSize(payloadBufferSize, s1);
+        s2 += payloadBufferSize;
+        *s2++ = '\r';
+        *s2++ = '\n';
+        outputStream_.commitBuffer(s2 - s1);
+
+        if (payloadBufferSize == 0) {
+            bodyIsChunked_ = false;
+        }
+    } else {
+        SIREN_ASSERT(payloadBufferSize <= remainingBodySize_);
+        outputStream_.commitBuffer(payloadBufferSize);
+        remainingBodySize_ -= payloadBufferSize;
+    }
+
+    endPayload();
+}
+
+
+template <class T>
+void
+BasicDumper<T>::skipPayload(std::size_t payloadSize)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(!bodyIsChunked_);
+    SIREN_ASSERT(payloadSize <= remainingBodySize_);
+    remainingBodySize_ -= payloadSize;
+
+    if (remainingBodySize_ == 0) {
+        endMessage();
+    }
+}
+
+
+template <class T>
+void
+BasicDumper<T>::setConnectionPersistence(ConnectionPersistence connectionPersistence) noexcept
+{
+    SIREN_ASSERT(isValid());
+    connectionPersistence_ = connectionPersistence;
+}
+
+
+template <class T>
+void
+BasicDumper<T>::setContentCodingName(const char *contentCodingName) noexcept
+{
+    SIREN_ASSERT(isValid());
+    contentCodingName_ = contentCodingName;
+}
+
+
+template <class T>
+void
+BasicDumper<T>::deferFlush() noexcept
+{
+    SIREN_ASSERT(isValid());
+    flushIsDeferred_ = true;
+}
+
+
+template <class T>
+void
+BasicDumper<T>::flush()
+{
+    SIREN_ASSERT(isValid());
+    outputStream_.flush();
+}
+
+
+template <class T>
+void
+BasicDumper<T>::endHeader()
+{
+    if (!bodyIsChunked_ && remainingBodySize_ == 0) {
+        endMessage();
+    } else if (!flushIsDeferred_ && outputStream_.getDataSize() >= options_.minFlushSize) {
+        outputStream_.flush();
+    }
+}
+
+
+template <class T>
+void
+BasicDumper<T>::endPayload()
+{
+    if (!bodyIsChunked_ && remainingBodySize_ == 0) {
+        endMessage();
+    } else if (outputStream_.getDataSize() >= options_.minFlushSize) {
+        outputStream_.flush();
+    }
+}
+
+
+template <class T>
+void
+BasicDumper<T>::endMessage()
+{
+    if (flushIsDeferred_) {
+        flushIsDeferred_ = false;
+    } else {
+        outputStream_.flush();
+    }
+}
+
+
+template <class T>
+void
+BasicDumper<T>::dumpRequestStartLine(const Request &request)
+{
+    outputStream_.reserveBuffer(GetMaxRequestStartLineSize(request));
+    char *s1 = outputStream_.getBuffer();
+    char *s2 = DumpRequestStartLine(request, s1);
+    outputStream_.commitBuffer(s2 - s1);
+}
+
+
+template <class T>
+void
+BasicDumper<T>::dumpResponseStartLine(const Response &response)
+{
+    outputStream_.reserveBuffer(GetMaxResponseStartLineSize(response));
+    char *s1 = outputStream_.getBuffer();
+    char *s2 = DumpResponseStartLine(response, s1);
+    outputStream_.commitBuffer(s2 - s1);
+}
+
+
+template <class T>
+void
+BasicDumper<T>::dumpHeader(const Header &header, unsigned short majorVersionNumber
+                           , unsigned short minorVersionNumber, bool bodyIsChunked
+                           , std::size_t bodySize)
+{
+    const char *connectionToken = getConnectionToken(header, majorVersionNumber
+                                                     , minorVersionNumber);
+    outputStream_.reserveBuffer(GetMaxHeaderSize(header, bodyIsChunked, bodySize, connectionToken
+                                                 , contentCodingName_));
+    char *s1 = outputStream_.getBuffer();
+    char *s2 = DumpHeader(header, bodyIsChunked, bodySize, connectionToken, contentCodingName_
+                          , s1);
+    outputStream_.commitBuffer(s2 - s1);
+    contentCodingName_ = nullptr;
+}
+
 } // namespace http
 
 } // namespace siren
@@ -0,0 +1,79 @@
+#pragma once
+
+
+#include <time.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace siren {
+
+namespace http {
+
+class Connection;
+class Header;
+struct Request;
+struct Response;
+
+
+namespace detail {
+
+std::uint32_t UpdateCRC32C(std::uint32_t, const void *, std::size_t) noexcept;
+bool ParseHTTPDate(const char *, time_t *) noexcept;
+
+} // namespace detail
+
+
+class ETagGenerator final
+{
+public:
+    inline explicit ETagGenerator() noexcept;
+
+    inline void update(const void *, std::size_t) noexcept;
+
+    std::string getETag() const;
+
+private:
+    std::uint32_t crc_;
+    std::size_t size_;
+};
+
+
+std::string MakeETag(const void *, std::size_t);
+bool ResourceIsNotModified(const Header &, const char *, const char *) noexcept;
+void DumpNotModifiedResponse(Connection *, Response *, const char *);
+void DumpTaggedResponse(Connection *, const Request &, Response *, const void *, std::size_t);
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "etag-inl.h"
+ */
+
+
+namespace siren {
+
+namespace http {
+
+ETagGenerator::ETagGenerator() noexcept
+  : crc_(0),
+    size_(0)
+{
+}
+
+
+void
+ETagGenerator::update(const void *data, std::size_t dataSize) noexcept
+{
+    crc_ = detail::UpdateCRC32C(crc_, data, dataSize);
+    size_ += dataSize;
+}
+
+} // namespace http
+
+} // namespace siren
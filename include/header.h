@@ -14,12 +14,33 @@ namespace siren {
 
 namespace http {
 
+class Header;
+
+
 namespace detail {
 
 struct HeaderField
 {
     std::size_t nameOffset;
     std::size_t valueOffset;
+    std::size_t rawFieldNumber;
+};
+
+
+struct RawHeaderField
+{
+    std::size_t offset;
+    std::size_t size;
+    bool isEdited;
+};
+
+
+struct HeaderAccess
+{
+    static inline std::size_t AddRaw(Header *, const char *, std::size_t);
+
+    template <class T, class U>
+    static inline void AddRawField(Header *, std::size_t, std::size_t, T &&, U &&);
 };
 
 } // namespace detail
@@ -38,19 +59,28 @@ public:
     template <class T>
     inline void traverse(T &&) const;
 
+    template <class T, class U>
+    inline void traverseEdits(T &&, U &&) const;
+
     template <class T>
     inline void search(const char *, T &&) const;
 
     template <class T, class U>
     inline void addField(T &&, U &&);
 
+    template <class T>
+    inline void setFieldValue(std::size_t, T &&);
+
     void sort();
 
 private:
     typedef detail::HeaderField Field;
+    typedef detail::RawHeaderField RawField;
 
     std::string base_;
     std::vector<Field> fields_;
+    std::string raw_;
+    std::vector<RawField> rawFields_;
     bool isSorted_;
 
     inline void initialize() noexcept;
@@ -63,6 +93,10 @@ private:
     template <class T>
     inline std::enable_if_t<!SIREN_TEST_INSTANTIATION(T, std::tuple)
                             , std::size_t> addFieldNameOrValue(T &&);
+
+    inline void editRawField(Field *) noexcept;
+
+    friend detail::HeaderAccess;
 };
 
 } // namespace http
@@ -94,7 +128,9 @@ Header::Header() noexcept
 
 Header::Header(Header &&other) noexcept
   : base_(std::move(other.base_)),
-    fields_(std::move(other.fields_))
+    fields_(std::move(other.fields_)),
+    raw_(std::move(other.raw_)),
+    rawFields_(std::move(other.rawFields_))
 {
     other.move(this);
 }
@@ -106,6 +142,8 @@ Header::operator=(Header &&other) noexcept
     if (&other != this) {
         base_ = std::move(other.base_);
         fields_ = std::move(other.fields_);
+        raw_ = std::move(other.raw_);
+        rawFields_ = std::move(other.rawFields_);
         other.move(this);
     }
 
@@ -133,6 +171,8 @@ Header::reset() noexcept
 {
     base_.clear();
     fields_.clear();
+    raw_.clear();
+    rawFields_.clear();
     initialize();
 }
 
@@ -182,16 +222,64 @@ Header::search(const char *fieldName, T &&callback) const
 }
 
 
+template <class T, class U>
+void
+Header::traverseEdits(T &&rawCallback, U &&fieldCallback) const
+{
+    std::size_t rawOffset = 0;
+    std::size_t rawSize = 0;
+
+    for (const RawField &rawField : rawFields_) {
+        if (!rawField.isEdited) {
+            if (rawField.offset != rawOffset + rawSize) {
+                if (rawSize >= 1) {
+                    rawCallback(raw_.data() + rawOffset, rawSize);
+                }
+
+                rawOffset = rawField.offset;
+                rawSize = 0;
+            }
+
+            rawSize += rawField.size;
+        }
+    }
+
+    if (rawSize >= 1) {
+        rawCallback(raw_.data() + rawOffset, rawSize);
+    }
+
+    for (auto it = fields_.begin(); it < fields_.end(); ++it) {
+        if (it->valueOffset >= 1 && it->rawFieldNumber == 0) {
+            const char *fieldName = base_.c_str() + it->nameOffset;
+            const char *fieldValue = base_.c_str() + it->valueOffset;
+            fieldCallback(it - fields_.begin(), fieldName, fieldValue);
+        }
+    }
+}
+
+
 template <class T, class U>
 void
 Header::addField(T &&fieldName, U &&fieldValue)
 {
     fields_.push_back({addFieldNameOrValue(std::forward<T>(fieldName))
-                       , addFieldNameOrValue(std::forward<U>(fieldValue))});
+                       , addFieldNameOrValue(std::forward<U>(fieldValue)), 0});
     isSorted_ = false;
 }
 
 
+template <class T>
+void
+Header::setFieldValue(std::size_t fieldIndex, T &&fieldValue)
+{
+    SIREN_ASSERT(fieldIndex < fields_.size());
+    Field *field = &fields_[fieldIndex];
+    SIREN_ASSERT(field->valueOffset >= 1);
+    editRawField(field);
+    field->valueOffset = addFieldNameOrValue(std::forward<T>(fieldValue));
+}
+
+
 template <class T>
 std::enable_if_t<SIREN_TEST_INSTANTIATION(T, std::tuple), std::size_t>
 Header::addFieldNameOrValue(T &&fieldNameOrValue)
@@ -223,9 +311,44 @@ Header::removeField(std::size_t fieldIndex) noexcept
 {
     SIREN_ASSERT(fieldIndex < fields_.size());
     Field *field = &fields_[fieldIndex];
+    editRawField(field);
     field->valueOffset = 0;
 }
 
+
+void
+Header::editRawField(Field *field) noexcept
+{
+    if (field->rawFieldNumber >= 1) {
+        rawFields_[field->rawFieldNumber - 1].isEdited = true;
+        field->rawFieldNumber = 0;
+    }
+}
+
+
+namespace detail {
+
+std::size_t
+HeaderAccess::AddRaw(Header *header, const char *raw, std::size_t rawSize)
+{
+    std::size_t rawOffset = header->raw_.size();
+    header->raw_.append(raw, rawSize);
+    return rawOffset;
+}
+
+
+template <class T, class U>
+void
+HeaderAccess::AddRawField(Header *header, std::size_t rawFieldOffset, std::size_t rawFieldSize
+                          , T &&fieldName, U &&fieldValue)
+{
+    header->rawFields_.push_back({rawFieldOffset, rawFieldSize, false});
+    header->addField(std::forward<T>(fieldName), std::forward<U>(fieldValue));
+    header->fields_.back().rawFieldNumber = header->rawFields_.size();
+}
+
+} // namespace detail
+
 } // namespace http
 
 } // namespace siren
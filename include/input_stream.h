@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <functional>
+#include <utility>
 
 
 namespace siren {
@@ -12,14 +13,27 @@ class Stream;
 
 namespace http {
 
-class InputStream final
+namespace detail {
+
+template <class T>
+inline auto InputStreamWriterIsValid(const T &, int) noexcept
+    -> decltype(std::declval<T>() != nullptr);
+
+template <class T>
+inline bool InputStreamWriterIsValid(const T &, long) noexcept;
+
+} // namespace detail
+
+
+template <class T = std::function<void (Stream *)>>
+class BasicInputStream final
 {
 public:
-    inline InputStream(InputStream &&) noexcept;
-    inline InputStream &operator=(InputStream &&) noexcept;
+    inline BasicInputStream(BasicInputStream &&) noexcept;
+    inline BasicInputStream &operator=(BasicInputStream &&) noexcept;
 
-    template <class T, class = std::enable_if_t<!std::is_same<T, nullptr_t>::value>>
-    inline explicit InputStream(Stream *, T &&);
+    template <class U, class = std::enable_if_t<!std::is_same<U, nullptr_t>::value>>
+    inline explicit BasicInputStream(Stream *, U &&);
 
     inline bool isValid() const noexcept;
     inline void peekData(std::size_t);
@@ -28,12 +42,15 @@ public:
 
 private:
     Stream *base_;
-    std::function<void (Stream *)> writer_;
+    T writer_;
 
     inline void initialize(Stream *) noexcept;
-    inline void move(InputStream *) noexcept;
+    inline void move(BasicInputStream *) noexcept;
 };
 
+
+typedef BasicInputStream<> InputStream;
+
 } // namespace http
 
 } // namespace siren
@@ -54,24 +71,47 @@ namespace siren {
 
 namespace http {
 
-template <class T, class>
-InputStream::InputStream(Stream *base, T &&writer)
-  : writer_(std::forward<T>(writer))
+namespace detail {
+
+template <class T>
+auto
+InputStreamWriterIsValid(const T &writer, int) noexcept -> decltype(std::declval<T>() != nullptr)
+{
+    return writer != nullptr;
+}
+
+
+template <class T>
+bool
+InputStreamWriterIsValid(const T &, long) noexcept
+{
+    return true;
+}
+
+} // namespace detail
+
+
+template <class T>
+template <class U, class>
+BasicInputStream<T>::BasicInputStream(Stream *base, U &&writer)
+  : writer_(std::forward<U>(writer))
 {
     SIREN_ASSERT(base != nullptr);
     initialize(base);
 }
 
 
-InputStream::InputStream(InputStream &&other) noexcept
+template <class T>
+BasicInputStream<T>::BasicInputStream(BasicInputStream &&other) noexcept
   : writer_(std::move(other.writer_))
 {
     other.move(this);
 }
 
 
-InputStream &
-InputStream::operator=(InputStream &&other) noexcept
+template <class T>
+BasicInputStream<T> &
+BasicInputStream<T>::operator=(BasicInputStream &&other) noexcept
 {
     if (&other != this) {
         writer_ = std::move(other.writer_);
@@ -82,30 +122,34 @@ InputStream::operator=(InputStream &&other) noexcept
 }
 
 
+template <class T>
 void
-InputStream::initialize(Stream *base) noexcept
+BasicInputStream<T>::initialize(Stream *base) noexcept
 {
     base_ = base;
 }
 
 
+template <class T>
 void
-InputStream::move(InputStream *other) noexcept
+BasicInputStream<T>::move(BasicInputStream *other) noexcept
 {
     other->base_ = base_;
     base_ = nullptr;
 }
 
 
+template <class T>
 bool
-InputStream::isValid() const noexcept
+BasicInputStream<T>::isValid() const noexcept
 {
-    return base_ != nullptr && writer_ != nullptr;
+    return base_ != nullptr && detail::InputStreamWriterIsValid(writer_, 0);
 }
 
 
+template <class T>
 void
-InputStream::peekData(std::size_t dataSize)
+BasicInputStream<T>::peekData(std::size_t dataSize)
 {
     SIREN_ASSERT(isValid());
 
@@ -115,16 +159,18 @@ InputStream::peekData(std::size_t dataSize)
 }
 
 
+template <class T>
 char *
-InputStream::getData() noexcept
+BasicInputStream<T>::getData() noexcept
 {
     SIREN_ASSERT(isValid());
     return static_cast<char *>(base_->getData());
 }
 
 
+template <class T>
 void
-InputStream::discardData(std::size_t dataSize) noexcept
+BasicInputStream<T>::discardData(std::size_t dataSize) noexcept
 {
     SIREN_ASSERT(isValid());
     base_->discardData(dataSize);
@@ -0,0 +1,182 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include <siren/semaphore.h>
+#include <siren/stream.h>
+
+
+struct io_uring_buf;
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+
+namespace siren {
+
+class Loop;
+
+
+namespace http {
+
+class IOURing;
+
+
+struct IOURingOptions
+{
+    unsigned int submissionQueueSize = 256;
+    unsigned int numberOfReceiveBuffers = 256;
+    std::size_t receiveBufferSize = 16 * 1024;
+};
+
+
+namespace detail {
+
+struct IOURingCompletion
+{
+    int result;
+    unsigned int flags;
+};
+
+
+struct IOURingOperation
+{
+    Semaphore semaphore;
+    std::deque<IOURingCompletion> completions;
+    bool isPending;
+    bool isOrphaned;
+
+    inline explicit IOURingOperation(Loop *);
+};
+
+
+class IOURingSocket final
+{
+public:
+    inline bool isValid() const noexcept;
+
+    explicit IOURingSocket(IOURing *, int, bool);
+    ~IOURingSocket();
+
+    std::size_t read(Stream *);
+    std::size_t write(Stream *);
+
+private:
+    typedef IOURingOperation Operation;
+
+    IOURing *ioURing_;
+    int fd_;
+    bool receiveIsMultishot_;
+    Operation *receiveOperation_;
+    Operation *sendOperation_;
+    Stream sendStream_;
+
+    IOURingSocket(const IOURingSocket &) = delete;
+    IOURingSocket &operator=(const IOURingSocket &) = delete;
+
+    std::size_t receive(Stream *);
+    std::size_t receiveMultishot(Stream *);
+    Operation *makeOperation();
+    void releaseOperation(Operation *);
+};
+
+} // namespace detail
+
+
+class IOURing final
+{
+public:
+    explicit IOURing(const IOURingOptions &, Loop *);
+    ~IOURing();
+
+    void run();
+    void stop() noexcept;
+
+private:
+    typedef detail::IOURingOperation Operation;
+
+    IOURingOptions options_;
+    Loop *loop_;
+    int fd_;
+    int eventFD_;
+    char *submissionRing_;
+    std::size_t submissionRingSize_;
+    char *completionRing_;
+    std::size_t completionRingSize_;
+    io_uring_sqe *submissionEntries_;
+    std::size_t submissionEntriesSize_;
+    unsigned int *submissionHead_;
+    unsigned int *submissionTail_;
+    unsigned int *submissionFlags_;
+    unsigned int submissionMask_;
+    unsigned int *completionHead_;
+    unsigned int *completionTail_;
+    unsigned int completionMask_;
+    io_uring_cqe *completionEntries_;
+    io_uring_buf *receiveBufferRing_;
+    std::size_t receiveBufferRingSize_;
+    char *receiveBuffers_;
+    unsigned short receiveBufferTail_;
+    unsigned int numberOfUnsubmittedEntries_;
+    std::size_t numberOfSockets_;
+    std::size_t numberOfPendingOperations_;
+    Semaphore submissionSemaphore_;
+    bool isStopping_;
+    bool isFinished_;
+
+    IOURing(const IOURing &) = delete;
+    IOURing &operator=(const IOURing &) = delete;
+
+    void initialize();
+    void setUpReceiveBuffers();
+    void finalize() noexcept;
+    void wake() noexcept;
+    void submitEntries();
+    void flushEntries();
+    void reapCompletions();
+    void addEntry(Operation *, const io_uring_sqe &);
+    const char *getReceiveBuffer(unsigned int) const noexcept;
+    void releaseReceiveBuffer(unsigned int) noexcept;
+    bool attachSocket() noexcept;
+    void detachSocket() noexcept;
+
+    friend detail::IOURingSocket;
+};
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "io_uring-inl.h"
+ */
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+IOURingOperation::IOURingOperation(Loop *loop)
+  : semaphore(loop, 0, 0, 1),
+    isPending(false),
+    isOrphaned(false)
+{
+}
+
+
+bool
+IOURingSocket::isValid() const noexcept
+{
+    return ioURing_ != nullptr;
+}
+
+} // namespace detail
+
+} // namespace http
+
+} // namespace siren
@@ -0,0 +1,135 @@
+#pragma once
+
+
+#include <cstddef>
+
+
+namespace siren {
+
+namespace http {
+
+class MemoryInputStream final
+{
+public:
+    inline explicit MemoryInputStream(const void *, std::size_t) noexcept;
+    inline MemoryInputStream(MemoryInputStream &&) noexcept;
+    inline MemoryInputStream &operator=(MemoryInputStream &&) noexcept;
+
+    inline bool isValid() const noexcept;
+    inline std::size_t getDataSize() const noexcept;
+    inline void peekData(std::size_t);
+    inline const char *getData() const noexcept;
+    inline void discardData(std::size_t) noexcept;
+
+private:
+    const char *data_;
+    std::size_t dataSize_;
+
+    inline void initialize(const void *, std::size_t) noexcept;
+    inline void move(MemoryInputStream *) noexcept;
+};
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "memory_input_stream-inl.h"
+ */
+
+
+#include <siren/assert.h>
+#include <siren/stream.h>
+
+
+namespace siren {
+
+namespace http {
+
+MemoryInputStream::MemoryInputStream(const void *data, std::size_t dataSize) noexcept
+{
+    SIREN_ASSERT(data != nullptr);
+    initialize(data, dataSize);
+}
+
+
+MemoryInputStream::MemoryInputStream(MemoryInputStream &&other) noexcept
+{
+    other.move(this);
+}
+
+
+MemoryInputStream &
+MemoryInputStream::operator=(MemoryInputStream &&other) noexcept
+{
+    if (&other != this) {
+        other.move(this);
+    }
+
+    return *this;
+}
+
+
+void
+MemoryInputStream::initialize(const void *data, std::size_t dataSize) noexcept
+{
+    data_ = static_cast<const char *>(data);
+    dataSize_ = dataSize;
+}
+
+
+void
+MemoryInputStream::move(MemoryInputStream *other) noexcept
+{
+    other->initialize(data_, dataSize_);
+    initialize(nullptr, 0);
+}
+
+
+bool
+MemoryInputStream::isValid() const noexcept
+{
+    return data_ != nullptr;
+}
+
+
+std::size_t
+MemoryInputStream::getDataSize() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return dataSize_;
+}
+
+
+void
+MemoryInputStream::peekData(std::size_t dataSize)
+{
+    SIREN_ASSERT(isValid());
+
+    if (dataSize_ < dataSize) {
+        throw EndOfStream();
+    }
+}
+
+
+const char *
+MemoryInputStream::getData() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return data_;
+}
+
+
+void
+MemoryInputStream::discardData(std::size_t dataSize) noexcept
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(dataSize <= dataSize_);
+    data_ += dataSize;
+    dataSize_ -= dataSize;
+}
+
+} // namespace http
+
+} // namespace siren
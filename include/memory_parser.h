@@ -0,0 +1,230 @@
+#pragma once
+
+
+#include <cstddef>
+
+#include "memory_input_stream.h"
+#include "parser.h"
+
+
+namespace siren {
+
+namespace http {
+
+struct Request;
+struct Response;
+
+
+class MemoryParser final
+{
+public:
+    typedef ParseOptions Options;
+
+    inline explicit MemoryParser(const Options &, const void *, std::size_t);
+    inline MemoryParser(MemoryParser &&) noexcept;
+    inline MemoryParser &operator=(MemoryParser &&) noexcept;
+
+    inline bool isValid() const noexcept;
+    inline std::size_t getOffset() const noexcept;
+    inline std::size_t getRemainingDataSize() const noexcept;
+    inline bool bodyIsChunked() const noexcept;
+    inline std::size_t getRemainingBodyOrChunkSize() const noexcept;
+    inline bool getRequest(Request *);
+    inline bool getResponse(Response *);
+    inline const char *peekPayloadData(std::size_t);
+    inline void discardPayloadData(std::size_t);
+    inline void skipPayload();
+
+    template <class T>
+    inline void readPayload(T &&);
+
+private:
+    const char *data_;
+    BasicParser<MemoryInputStream> parser_;
+
+    inline void initialize(const void *) noexcept;
+    inline void move(MemoryParser *) noexcept;
+    inline bool payloadIsPending() const noexcept;
+};
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "memory_parser-inl.h"
+ */
+
+
+#include <utility>
+
+#include <siren/assert.h>
+
+
+namespace siren {
+
+namespace http {
+
+MemoryParser::MemoryParser(const Options &options, const void *data, std::size_t dataSize)
+  : parser_(options, data, dataSize)
+{
+    initialize(data);
+}
+
+
+MemoryParser::MemoryParser(MemoryParser &&other) noexcept
+  : parser_(std::move(other.parser_))
+{
+    other.move(this);
+}
+
+
+MemoryParser &
+MemoryParser::operator=(MemoryParser &&other) noexcept
+{
+    if (&other != this) {
+        parser_ = std::move(other.parser_);
+        other.move(this);
+    }
+
+    return *this;
+}
+
+
+void
+MemoryParser::initialize(const void *data) noexcept
+{
+    data_ = static_cast<const char *>(data);
+}
+
+
+void
+MemoryParser::move(MemoryParser *other) noexcept
+{
+    other->data_ = data_;
+    data_ = nullptr;
+}
+
+
+bool
+MemoryParser::isValid() const noexcept
+{
+    return parser_.isValid();
+}
+
+
+std::size_t
+MemoryParser::getOffset() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return parser_.getInputStream().getData() - data_;
+}
+
+
+std::size_t
+MemoryParser::getRemainingDataSize() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return parser_.getInputStream().getDataSize();
+}
+
+
+bool
+MemoryParser::bodyIsChunked() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return parser_.bodyIsChunked();
+}
+
+
+std::size_t
+MemoryParser::getRemainingBodyOrChunkSize() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return parser_.getRemainingBodyOrChunkSize();
+}
+
+
+bool
+MemoryParser::getRequest(Request *request)
+{
+    SIREN_ASSERT(isValid());
+    skipPayload();
+
+    if (getRemainingDataSize() == 0) {
+        return false;
+    }
+
+    parser_.getRequest(request);
+    return true;
+}
+
+
+bool
+MemoryParser::getResponse(Response *response)
+{
+    SIREN_ASSERT(isValid());
+    skipPayload();
+
+    if (getRemainingDataSize() == 0) {
+        return false;
+    }
+
+    parser_.getResponse(response);
+    return true;
+}
+
+
+const char *
+MemoryParser::peekPayloadData(std::size_t payloadDataSize)
+{
+    SIREN_ASSERT(isValid());
+    return parser_.peekPayloadData(payloadDataSize);
+}
+
+
+void
+MemoryParser::discardPayloadData(std::size_t payloadDataSize)
+{
+    SIREN_ASSERT(isValid());
+    parser_.discardPayloadData(payloadDataSize);
+}
+
+
+void
+MemoryParser::skipPayload()
+{
+    SIREN_ASSERT(isValid());
+    readPayload([] (const char *, std::size_t) -> void {});
+}
+
+
+template <class T>
+void
+MemoryParser::readPayload(T &&callback)
+{
+    SIREN_ASSERT(isValid());
+
+    while (payloadIsPending()) {
+        std::size_t payloadDataSize = parser_.getRemainingBodyOrChunkSize();
+        const char *payloadData = parser_.peekPayloadData(payloadDataSize);
+
+        if (payloadDataSize >= 1) {
+            callback(payloadData, payloadDataSize);
+        }
+
+        parser_.discardPayloadData(payloadDataSize);
+    }
+}
+
+
+bool
+MemoryParser::payloadIsPending() const noexcept
+{
+    return parser_.bodyIsChunked() || parser_.getRemainingBodyOrChunkSize() >= 1;
+}
+
+} // namespace http
+
+} // namespace siren
@@ -0,0 +1,117 @@
+#pragma once
+
+
+#include <atomic>
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+template <class T>
+struct MPSCQueueNode
+{
+    std::atomic<MPSCQueueNode *> next;
+    T value;
+};
+
+
+template <class T>
+class MPSCQueue final
+{
+public:
+    inline explicit MPSCQueue();
+    inline ~MPSCQueue();
+
+    template <class U>
+    inline void push(U &&);
+
+    inline bool pop(T *);
+
+private:
+    typedef MPSCQueueNode<T> Node;
+
+    std::atomic<Node *> head_;
+    char padding_[64 - sizeof(std::atomic<Node *>)];
+    Node *tail_;
+
+    MPSCQueue(const MPSCQueue &) = delete;
+    MPSCQueue &operator=(const MPSCQueue &) = delete;
+};
+
+} // namespace detail
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "mpsc_queue-inl.h"
+ */
+
+
+#include <utility>
+
+#include <siren/assert.h>
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+template <class T>
+MPSCQueue<T>::MPSCQueue()
+  : head_(new Node{{nullptr}, T()})
+{
+    tail_ = head_.load(std::memory_order_relaxed);
+}
+
+
+template <class T>
+MPSCQueue<T>::~MPSCQueue()
+{
+    for (Node *node = tail_, *nextNode; node != nullptr; node = nextNode) {
+        nextNode = node->next.load(std::memory_order_relaxed);
+        delete node;
+    }
+}
+
+
+template <class T>
+template <class U>
+void
+MPSCQueue<T>::push(U &&value)
+{
+    auto node = new Node{{nullptr}, std::forward<U>(value)};
+    Node *prevNode = head_.exchange(node, std::memory_order_acq_rel);
+    prevNode->next.store(node, std::memory_order_release);
+}
+
+
+template <class T>
+bool
+MPSCQueue<T>::pop(T *value)
+{
+    SIREN_ASSERT(value != nullptr);
+    Node *nextNode = tail_->next.load(std::memory_order_acquire);
+
+    if (nextNode == nullptr) {
+        return false;
+    }
+
+    *value = std::move(nextNode->value);
+    delete tail_;
+    tail_ = nextNode;
+    return true;
+}
+
+} // namespace detail
+
+} // namespace http
+
+} // namespace siren
@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <functional>
+#include <utility>
 
 
 namespace siren {
@@ -12,28 +13,47 @@ class Stream;
 
 namespace http {
 
-class OutputStream final
+namespace detail {
+
+template <class T>
+inline auto OutputStreamReaderIsValid(const T &, int) noexcept
+    -> decltype(std::declval<T>() != nullptr);
+
+template <class T>
+inline bool OutputStreamReaderIsValid(const T &, long) noexcept;
+
+} // namespace detail
+
+
+template <class T = std::function<void (Stream *)>>
+class BasicOutputStream final
 {
 public:
-    inline OutputStream(OutputStream &&) noexcept;
-    inline OutputStream &operator=(OutputStream &&) noexcept;
+    inline BasicOutputStream(BasicOutputStream &&) noexcept;
+    inline BasicOutputStream &operator=(BasicOutputStream &&) noexcept;
 
-    template <class T, class = std::enable_if_t<!std::is_same<T, nullptr_t>::value>>
-    inline explicit OutputStream(Stream *, T &&);
+    template <class U, class = std::enable_if_t<!std::is_same<U, nullptr_t>::value>>
+    inline explicit BasicOutputStream(Stream *, U &&);
 
     inline bool isValid() const noexcept;
     inline void reserveBuffer(std::size_t);
     inline char *getBuffer() noexcept;
+    inline void commitBuffer(std::size_t);
     inline void flushBuffer(std::size_t);
+    inline std::size_t getDataSize() const noexcept;
+    inline void flush();
 
 private:
     Stream *base_;
-    std::function<void (Stream *)> reader_;
+    T reader_;
 
     inline void initialize(Stream *) noexcept;
-    inline void move(OutputStream *) noexcept;
+    inline void move(BasicOutputStream *) noexcept;
 };
 
+
+typedef BasicOutputStream<> OutputStream;
+
 } // namespace http
 
 } // namespace siren
@@ -54,24 +74,47 @@ namespace siren {
 
 namespace http {
 
-template <class T, class>
-OutputStream::OutputStream(Stream *base, T &&writer)
-  : reader_(std::forward<T>(writer))
+namespace detail {
+
+template <class T>
+auto
+OutputStreamReaderIsValid(const T &reader, int) noexcept -> decltype(std::declval<T>() != nullptr)
+{
+    return reader != nullptr;
+}
+
+
+template <class T>
+bool
+OutputStreamReaderIsValid(const T &, long) noexcept
+{
+    return true;
+}
+
+} // namespace detail
+
+
+template <class T>
+template <class U, class>
+BasicOutputStream<T>::BasicOutputStream(Stream *base, U &&reader)
+  : reader_(std::forward<U>(reader))
 {
     SIREN_ASSERT(base != nullptr);
     initialize(base);
 }
 
 
-OutputStream::OutputStream(OutputStream &&other) noexcept
+template <class T>
+BasicOutputStream<T>::BasicOutputStream(BasicOutputStream &&other) noexcept
   : reader_(std::move(other.reader_))
 {
     other.move(this);
 }
 
 
-OutputStream &
-OutputStream::operator=(OutputStream &&other) noexcept
+template <class T>
+BasicOutputStream<T> &
+BasicOutputStream<T>::operator=(BasicOutputStream &&other) noexcept
 {
     if (&other != this) {
         reader_ = std::move(other.reader_);
@@ -82,49 +125,81 @@ OutputStream::operator=(OutputStream &&other) noexcept
 }
 
 
+template <class T>
 void
-OutputStream::initialize(Stream *base) noexcept
+BasicOutputStream<T>::initialize(Stream *base) noexcept
 {
     base_ = base;
 }
 
 
+template <class T>
 void
-OutputStream::move(OutputStream *other) noexcept
+BasicOutputStream<T>::move(BasicOutputStream *other) noexcept
 {
     other->base_ = base_;
     base_ = nullptr;
 }
 
 
+template <class T>
 bool
-OutputStream::isValid() const noexcept
+BasicOutputStream<T>::isValid() const noexcept
 {
-    return base_ != nullptr && reader_ != nullptr;
+    return base_ != nullptr && detail::OutputStreamReaderIsValid(reader_, 0);
 }
 
 
+template <class T>
 void
-OutputStream::reserveBuffer(std::size_t bufferSize)
+BasicOutputStream<T>::reserveBuffer(std::size_t bufferSize)
 {
     SIREN_ASSERT(isValid());
     base_->reserveBuffer(bufferSize);
 }
 
 
+template <class T>
 char *
-OutputStream::getBuffer() noexcept
+BasicOutputStream<T>::getBuffer() noexcept
 {
     SIREN_ASSERT(isValid());
     return static_cast<char *>(base_->getBuffer());
 }
 
 
+template <class T>
 void
-OutputStream::flushBuffer(std::size_t bufferSize)
+BasicOutputStream<T>::commitBuffer(std::size_t bufferSize)
 {
     SIREN_ASSERT(isValid());
     base_->commitBuffer(bufferSize);
+}
+
+
+template <class T>
+void
+BasicOutputStream<T>::flushBuffer(std::size_t bufferSize)
+{
+    commitBuffer(bufferSize);
+    flush();
+}
+
+
+template <class T>
+std::size_t
+BasicOutputStream<T>::getDataSize() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return base_->getDataSize();
+}
+
+
+template <class T>
+void
+BasicOutputStream<T>::flush()
+{
+    SIREN_ASSERT(isValid());
 
     while (base_->getDataSize() >= 1) {
         reader_(base_);
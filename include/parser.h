@@ -29,31 +29,15 @@ struct ParseOptions
 };
 
 
-class Parser final
-{
-public:
-    typedef ParseOptions Options;
-
-    inline bool isValid() const noexcept;
-    inline bool bodyIsChunked() const noexcept;
-    inline std::size_t getRemainingBodyOrChunkSize() const noexcept;
-
-    template <class ...T>
-    inline explicit Parser(const Options &, T &&...);
-
-    Parser(Parser &&) noexcept;
-    Parser &operator=(Parser &&) noexcept;
+namespace detail {
 
-    void getRequest(Request *);
-    void getResponse(Response *);
-    char *peekPayloadData(std::size_t);
-    void discardPayloadData(std::size_t);
-
-private:
+class ParserBase
+{
+protected:
     ParseOptions options_;
     std::size_t maxChunkSize_;
-    InputStream inputStream_;
     bool bodyIsChunked_;
+    bool connectionIsPersistent_;
 
     union {
         std::size_t remainingBodySize_;
@@ -61,12 +45,25 @@ private:
         std::size_t remainingBodyOrChunkSize_;
     };
 
-    static MethodType ParseMethod(const char *);
-    static void ParseURI(const char *, URI *);
-    static std::tuple<unsigned short, unsigned short> ParseVersion(const char *);
-    static StatusCode ParseStatusCode(const char *);
-    static void ParseHeaderFields(const char *, Header *);
-    static void ParseHeaderField(const char *, const char *, Header *);
+    static void ParseRequestStartLine(const char *, std::size_t, Request *);
+    static void ParseResponseStartLine(const char *, std::size_t, Response *);
+    static void ParseHeader(const char *, std::size_t, Header *);
+    static std::size_t ParseChunkSize(const char *, std::size_t);
+    static bool ParseConnectionPersistence(const Header &, unsigned short, unsigned short);
+
+    explicit ParserBase(const ParseOptions &) noexcept;
+    ParserBase(ParserBase &&) noexcept;
+    ParserBase &operator=(ParserBase &&) noexcept;
+
+    std::tuple<bool, std::size_t> parseBodySize(Header *) const;
+
+private:
+    static MethodType ParseMethod(const char *, const char *);
+    static void ParseURI(const char *, const char *, URI *);
+    static std::tuple<unsigned short, unsigned short> ParseVersion(const char *, const char *);
+    static StatusCode ParseStatusCode(const char *, const char *);
+    static void ParseHeaderFields(const char *, const char *, Header *);
+    static void ParseHeaderField(const char *, const char *, std::size_t, Header *);
 
     template <class T, std::size_t N = 10>
     static T ParseNumber(const char *);
@@ -75,22 +72,58 @@ private:
     static T ParseNumber(const char *, const char *);
 
     void initialize() noexcept;
-    void move(Parser *) noexcept;
-    void parseRequestStartLine(Request *);
-    void parseResponseStartLine(Response *);
-    void parseHeader(Header *);
-    std::tuple<bool, std::size_t> parseBodyOrChunkSize(Header *);
-    std::size_t parseFirstChunkSize();
-    std::size_t parseChunkSize();
+    void move(ParserBase *) noexcept;
+};
+
+} // namespace detail
+
+
+template <class T = InputStream>
+class BasicParser final
+  : private detail::ParserBase
+{
+public:
+    typedef ParseOptions Options;
+
+    inline bool isValid() const noexcept;
+    inline bool bodyIsChunked() const noexcept;
+    inline bool connectionIsPersistent() const noexcept;
+    inline std::size_t getRemainingBodyOrChunkSize() const noexcept;
+    inline const T &getInputStream() const noexcept;
+
+    template <class ...U>
+    inline explicit BasicParser(const Options &, U &&...);
+
+    inline BasicParser(BasicParser &&) noexcept;
+    inline BasicParser &operator=(BasicParser &&) noexcept;
+
+    inline void getRequest(Request *);
+    inline void getResponse(Response *);
+    inline void getResponse(Response *, MethodType);
+    inline auto peekPayloadData(std::size_t);
+    inline void discardPayloadData(std::size_t);
+
+private:
+    T inputStream_;
+
+    inline void parseRequestStartLine(Request *);
+    inline void parseResponseStartLine(Response *);
+    inline void parseHeader(Header *);
+    inline void parseBodyOrChunkSize(Header *);
+    inline std::size_t parseFirstChunkSize();
+    inline std::size_t parseChunkSize();
 
     template <ParseException F()>
-    std::tuple<char *, std::size_t> peekCharsUntilCRLF(std::size_t);
+    inline std::tuple<const char *, std::size_t> peekCharsUntilCRLF(std::size_t);
 
     template <ParseException F()>
-    std::tuple<char *, std::size_t> peekCharsUntilCRLFCRLF(std::size_t);
+    inline std::tuple<const char *, std::size_t> peekCharsUntilCRLFCRLF(std::size_t);
 };
 
 
+typedef BasicParser<> Parser;
+
+
 enum class ParseExceptionType
 {
     InvalidMessage = 0,
@@ -99,6 +132,8 @@ enum class ParseExceptionType
     StartLineTooLong,
     HeaderTooLarge,
     BodyTooLarge,
+    TimedOut,
+    UnknownContentCoding,
 };
 
 
@@ -125,6 +160,8 @@ inline ParseException UnknownStatus();
 inline ParseException StartLineTooLong();
 inline ParseException HeaderTooLarge();
 inline ParseException BodyTooLarge();
+inline ParseException TimedOut();
+inline ParseException UnknownContentCoding();
 
 } // namespace http
 
@@ -136,47 +173,356 @@ inline ParseException BodyTooLarge();
  */
 
 
+#include <limits>
 #include <utility>
 
 #include <siren/assert.h>
+#include <siren/utility.h>
+
+#include "request.h"
+#include "response.h"
 
 
 namespace siren {
 
 namespace http {
 
-template <class ...T>
-Parser::Parser(const Options &options, T &&...inputStream)
-  : options_(options),
-    inputStream_(std::forward<T>(inputStream)...)
+template <class T>
+template <class ...U>
+BasicParser<T>::BasicParser(const Options &options, U &&...inputStream)
+  : ParserBase(options),
+    inputStream_(std::forward<U>(inputStream)...)
+{
+}
+
+
+template <class T>
+BasicParser<T>::BasicParser(BasicParser &&other) noexcept
+  : ParserBase(std::move(other)),
+    inputStream_(std::move(other.inputStream_))
+{
+}
+
+
+template <class T>
+BasicParser<T> &
+BasicParser<T>::operator=(BasicParser &&other) noexcept
 {
-    initialize();
+    if (&other != this) {
+        ParserBase::operator=(std::move(other));
+        inputStream_ = std::move(other.inputStream_);
+    }
+
+    return *this;
 }
 
 
+template <class T>
 bool
-Parser::isValid() const noexcept
+BasicParser<T>::isValid() const noexcept
 {
     return inputStream_.isValid();
 }
 
 
+template <class T>
 bool
-Parser::bodyIsChunked() const noexcept
+BasicParser<T>::bodyIsChunked() const noexcept
 {
     SIREN_ASSERT(isValid());
     return bodyIsChunked_;
 }
 
 
+template <class T>
+bool
+BasicParser<T>::connectionIsPersistent() const noexcept
+{
+    SIREN_ASSERT(isValid());
+    return connectionIsPersistent_;
+}
+
+
+template <class T>
 std::size_t
-Parser::getRemainingBodyOrChunkSize() const noexcept
+BasicParser<T>::getRemainingBodyOrChunkSize() const noexcept
 {
     SIREN_ASSERT(isValid());
     return remainingBodyOrChunkSize_;
 }
 
 
+template <class T>
+const T &
+BasicParser<T>::getInputStream() const noexcept
+{
+    return inputStream_;
+}
+
+
+template <class T>
+void
+BasicParser<T>::getRequest(Request *request)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
+    SIREN_ASSERT(request != nullptr);
+    parseRequestStartLine(request);
+    parseHeader(&request->header);
+    parseBodyOrChunkSize(&request->header);
+    connectionIsPersistent_ = ParseConnectionPersistence(request->header
+                                                         , request->majorVersionNumber
+                                                         , request->minorVersionNumber);
+}
+
+
+template <class T>
+void
+BasicParser<T>::getResponse(Response *response)
+{
+    getResponse(response, MethodType::Get);
+}
+
+
+template <class T>
+void
+BasicParser<T>::getResponse(Response *response, MethodType requestMethodType)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
+    SIREN_ASSERT(response != nullptr);
+    parseResponseStartLine(response);
+    parseHeader(&response->header);
+
+    if (requestMethodType == MethodType::Head) {
+        response->header.sort();
+        bodyIsChunked_ = false;
+        remainingBodySize_ = 0;
+    } else {
+        parseBodyOrChunkSize(&response->header);
+    }
+
+    connectionIsPersistent_ = ParseConnectionPersistence(response->header
+                                                         , response->majorVersionNumber
+                                                         , response->minorVersionNumber);
+}
+
+
+template <class T>
+auto
+BasicParser<T>::peekPayloadData(std::size_t payloadDataSize)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(payloadDataSize <= remainingBodyOrChunkSize_);
+    decltype(inputStream_.getData()) payloadData;
+
+    if (payloadDataSize == remainingBodyOrChunkSize_ && bodyIsChunked_) {
+        inputStream_.peekData(remainingChunkSize_ + 2);
+        payloadData = inputStream_.getData();
+
+        if (!(payloadData[remainingChunkSize_] == '\r'
+              && payloadData[remainingChunkSize_ + 1] == '\n')) {
+            throw InvalidMessage();
+        }
+    } else {
+        inputStream_.peekData(payloadDataSize);
+        payloadData = inputStream_.getData();
+    }
+
+    return payloadData;
+}
+
+
+template <class T>
+void
+BasicParser<T>::discardPayloadData(std::size_t payloadDataSize)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(payloadDataSize <= remainingBodyOrChunkSize_);
+
+    if (payloadDataSize == remainingBodyOrChunkSize_ && bodyIsChunked_) {
+        inputStream_.discardData(remainingChunkSize_ + SIREN_STRLEN("\r\n"));
+
+        if (remainingChunkSize_ == 0) {
+            bodyIsChunked_ = false;
+        } else {
+            remainingChunkSize_ = parseChunkSize();
+        }
+    } else {
+        inputStream_.discardData(payloadDataSize);
+        remainingBodyOrChunkSize_ -= payloadDataSize;
+    }
+}
+
+
+template <class T>
+void
+BasicParser<T>::parseRequestStartLine(Request *request)
+{
+    const char *s;
+    std::size_t n;
+    std::tie(s, n) = peekCharsUntilCRLF<StartLineTooLong>(options_.maxStartLineSize);
+    ParseRequestStartLine(s, n, request);
+    inputStream_.discardData(n);
+}
+
+
+template <class T>
+void
+BasicParser<T>::parseResponseStartLine(Response *response)
+{
+    const char *s;
+    std::size_t n;
+    std::tie(s, n) = peekCharsUntilCRLF<StartLineTooLong>(options_.maxStartLineSize);
+    ParseResponseStartLine(s, n, response);
+    inputStream_.discardData(n);
+}
+
+
+template <class T>
+void
+BasicParser<T>::parseHeader(Header *header)
+{
+    std::size_t n = 2;
+    inputStream_.peekData(n);
+    const char *s = inputStream_.getData();
+    bool headerHasFields = !(*s == '\r' && s[1] == '\n');
+
+    if (headerHasFields) {
+        std::tie(s, n) = peekCharsUntilCRLFCRLF<HeaderTooLarge>(options_.maxHeaderSize);
+        ParseHeader(s, n, header);
+    }
+
+    inputStream_.discardData(n);
+}
+
+
+template <class T>
+void
+BasicParser<T>::parseBodyOrChunkSize(Header *header)
+{
+    bool bodyIsChunked;
+    std::size_t bodySize;
+    std::tie(bodyIsChunked, bodySize) = parseBodySize(header);
+
+    if (bodyIsChunked) {
+        remainingChunkSize_ = parseFirstChunkSize();
+    } else {
+        remainingBodySize_ = bodySize;
+    }
+
+    bodyIsChunked_ = bodyIsChunked;
+}
+
+
+template <class T>
+std::size_t
+BasicParser<T>::parseFirstChunkSize()
+{
+    maxChunkSize_ = options_.maxBodySize;
+    return parseChunkSize();
+}
+
+
+template <class T>
+std::size_t
+BasicParser<T>::parseChunkSize()
+{
+    constexpr unsigned int k = (std::numeric_limits<std::size_t>::digits + 3) / 4;
+
+    const char *s;
+    std::size_t n;
+    std::tie(s, n) = peekCharsUntilCRLF<InvalidMessage>(k + 2);
+    std::size_t chunkSize = ParseChunkSize(s, n);
+
+    if (chunkSize > maxChunkSize_) {
+        throw BodyTooLarge();
+    }
+
+    maxChunkSize_ -= chunkSize;
+    inputStream_.discardData(n);
+    return chunkSize;
+}
+
+
+template <class T>
+template <ParseException F()>
+std::tuple<const char *, std::size_t>
+BasicParser<T>::peekCharsUntilCRLF(std::size_t maxNumberOfChars)
+{
+    std::size_t charCount = 2;
+
+    for (;;) {
+        if (charCount > maxNumberOfChars) {
+            throw F();
+        }
+
+        inputStream_.peekData(charCount);
+        const char *chars = inputStream_.getData();
+        int c1 = chars[charCount - 2];
+        int c2 = chars[charCount - 1];
+
+        if (c2 == '\n') {
+            if (c1 == '\r') {
+                return std::make_tuple(chars, charCount);
+            } else {
+                charCount += 2;
+            }
+        } else {
+            if (c2 == '\r') {
+                charCount += 1;
+            } else {
+                charCount += 2;
+            }
+        }
+    }
+}
+
+
+template <class T>
+template <ParseException F()>
+std::tuple<const char *, std::size_t>
+BasicParser<T>::peekCharsUntilCRLFCRLF(std::size_t maxNumberOfChars)
+{
+    std::size_t charCount = 4;
+
+    for (;;) {
+        if (charCount > maxNumberOfChars) {
+            throw F();
+        }
+
+        inputStream_.peekData(charCount);
+        const char *chars = inputStream_.getData();
+        int c1 = chars[charCount - 4];
+        int c2 = chars[charCount - 3];
+        int c3 = chars[charCount - 2];
+        int c4 = chars[charCount - 1];
+
+        if (c4 == '\n') {
+            if (c3 == '\r') {
+                if (c2 == '\n' && c1 == '\r') {
+                    return std::make_tuple(chars, charCount);
+                } else {
+                    charCount += 2;
+                }
+            } else {
+                charCount += 4;
+            }
+        } else {
+            if (c4 == '\r') {
+                if (c3 == '\n' && c2 == '\r') {
+                    charCount += 1;
+                } else {
+                    charCount += 3;
+                }
+            } else {
+                charCount += 4;
+            }
+        }
+    }
+}
+
+
 ParseExceptionType
 ParseException::getType() const noexcept
 {
@@ -225,6 +571,20 @@ BodyTooLarge()
     return ParseException(ParseExceptionType::BodyTooLarge);
 }
 
+
+ParseException
+TimedOut()
+{
+    return ParseException(ParseExceptionType::TimedOut);
+}
+
+
+ParseException
+UnknownContentCoding()
+{
+    return ParseException(ParseExceptionType::UnknownContentCoding);
+}
+
 } // namespace http
 
 } // namespace siren
@@ -0,0 +1,96 @@
+#pragma once
+
+
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <utility>
+
+#include <siren/semaphore.h>
+
+#include "connection.h"
+
+
+namespace siren {
+
+class Loop;
+
+
+namespace http {
+
+namespace detail {
+
+struct PipelinedClientOptions
+{
+    std::size_t maxNumberOfInflightRequests = 16;
+};
+
+} // namespace detail
+
+
+struct PipelinedClientOptions
+  : detail::PipelinedClientOptions,
+    ConnectionOptions
+{
+};
+
+
+class PipelinedClient final
+{
+public:
+    typedef std::function<void (std::exception_ptr, Response *, PayloadReader *)> Callback;
+
+    inline std::size_t getNumberOfInflightRequests() const noexcept;
+
+    explicit PipelinedClient(const PipelinedClientOptions &, TCPSocket &&);
+    ~PipelinedClient();
+
+    void sendRequest(const Request &, Callback);
+    void sendRequest(const Request &, const void *, std::size_t, Callback);
+    void close();
+
+private:
+    Loop *loop_;
+    Connection connection_;
+    Semaphore windowSemaphore_;
+    Semaphore sendSemaphore_;
+    Semaphore responseSemaphore_;
+    Semaphore exitSemaphore_;
+    std::deque<std::pair<MethodType, Callback>> callbacks_;
+    std::exception_ptr exception_;
+    std::size_t numberOfQueuedSenders_;
+    bool isClosed_;
+
+    PipelinedClient(const PipelinedClient &) = delete;
+    PipelinedClient &operator=(const PipelinedClient &) = delete;
+
+    static void SkipPayload(PayloadReader *);
+
+    void receiveResponses();
+    void receiveResponse(MethodType, Callback *);
+};
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "pipelined_client-inl.h"
+ */
+
+
+namespace siren {
+
+namespace http {
+
+std::size_t
+PipelinedClient::getNumberOfInflightRequests() const noexcept
+{
+    return callbacks_.size();
+}
+
+} // namespace http
+
+} // namespace siren
@@ -0,0 +1,487 @@
+#pragma once
+
+
+#include <cstddef>
+#include <string>
+
+#include "parser.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+enum class PushParserState
+{
+    StartLine = 0,
+    Header,
+    Body,
+    ChunkSize,
+    ChunkData,
+    ChunkDataEnd,
+    LastChunkEnd,
+};
+
+} // namespace detail
+
+
+template <class T, class U>
+class PushParser final
+  : private detail::ParserBase
+{
+public:
+    typedef ParseOptions Options;
+
+    template <class ...V>
+    inline explicit PushParser(const Options &, V &&...);
+
+    inline PushParser(PushParser &&) noexcept;
+    inline PushParser &operator=(PushParser &&) noexcept;
+
+    inline bool isIdle() const noexcept;
+    inline const U &getHandler() const noexcept;
+    inline void feed(const char *, std::size_t);
+
+private:
+    typedef detail::PushParserState State;
+
+    U handler_;
+    State state_;
+    T message_;
+    std::string buffer_;
+    std::size_t lineStart_;
+
+    inline static void ParseStartLine(const char *, std::size_t, Request *);
+    inline static void ParseStartLine(const char *, std::size_t, Response *);
+
+    inline void initialize() noexcept;
+    inline void move(PushParser *) noexcept;
+    inline std::size_t feedStartLine(const char *, std::size_t);
+    inline std::size_t feedHeader(const char *, std::size_t);
+    inline std::size_t feedBody(const char *, std::size_t);
+    inline std::size_t feedChunkSize(const char *, std::size_t);
+    inline std::size_t feedChunkData(const char *, std::size_t);
+    inline std::size_t feedCRLF(const char *, std::size_t);
+    inline void endMessage();
+    inline std::size_t findHeaderEnd(const char *, std::size_t) const noexcept;
+
+    template <ParseException F()>
+    inline std::size_t collectLine(const char *, std::size_t, std::size_t, const char **
+                                   , std::size_t *);
+};
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "push_parser-inl.h"
+ */
+
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+#include <siren/assert.h>
+#include <siren/utility.h>
+
+
+namespace siren {
+
+namespace http {
+
+template <class T, class U>
+template <class ...V>
+PushParser<T, U>::PushParser(const Options &options, V &&...handler)
+  : ParserBase(options),
+    handler_(std::forward<V>(handler)...),
+    message_()
+{
+    initialize();
+}
+
+
+template <class T, class U>
+PushParser<T, U>::PushParser(PushParser &&other) noexcept
+  : ParserBase(std::move(other)),
+    handler_(std::move(other.handler_)),
+    message_(std::move(other.message_)),
+    buffer_(std::move(other.buffer_))
+{
+    other.move(this);
+}
+
+
+template <class T, class U>
+PushParser<T, U> &
+PushParser<T, U>::operator=(PushParser &&other) noexcept
+{
+    if (&other != this) {
+        ParserBase::operator=(std::move(other));
+        handler_ = std::move(other.handler_);
+        message_ = std::move(other.message_);
+        buffer_ = std::move(other.buffer_);
+        other.move(this);
+    }
+
+    return *this;
+}
+
+
+template <class T, class U>
+void
+PushParser<T, U>::initialize() noexcept
+{
+    state_ = State::StartLine;
+    lineStart_ = 0;
+}
+
+
+template <class T, class U>
+void
+PushParser<T, U>::move(PushParser *other) noexcept
+{
+    other->state_ = state_;
+    other->lineStart_ = lineStart_;
+    initialize();
+}
+
+
+template <class T, class U>
+bool
+PushParser<T, U>::isIdle() const noexcept
+{
+    return state_ == State::StartLine && buffer_.empty();
+}
+
+
+template <class T, class U>
+const U &
+PushParser<T, U>::getHandler() const noexcept
+{
+    return handler_;
+}
+
+
+template <class T, class U>
+void
+PushParser<T, U>::feed(const char *data, std::size_t dataSize)
+{
+    SIREN_ASSERT(data != nullptr || dataSize == 0);
+
+    while (dataSize >= 1) {
+        std::size_t n;
+
+        switch (state_) {
+        case State::StartLine:
+            n = feedStartLine(data, dataSize);
+            break;
+
+        case State::Header:
+            n = feedHeader(data, dataSize);
+            break;
+
+        case State::Body:
+            n = feedBody(data, dataSize);
+            break;
+
+        case State::ChunkSize:
+            n = feedChunkSize(data, dataSize);
+            break;
+
+        case State::ChunkData:
+            n = feedChunkData(data, dataSize);
+            break;
+
+        case State::ChunkDataEnd:
+        case State::LastChunkEnd:
+            n = feedCRLF(data, dataSize);
+            break;
+
+        default:
+            SIREN_ASSERT(false);
+            n = 0;
+        }
+
+        data += n;
+        dataSize -= n;
+    }
+}
+
+
+template <class T, class U>
+void
+PushParser<T, U>::ParseStartLine(const char *s, std::size_t n, Request *request)
+{
+    ParseRequestStartLine(s, n, request);
+}
+
+
+template <class T, class U>
+void
+PushParser<T, U>::ParseStartLine(const char *s, std::size_t n, Response *response)
+{
+    ParseResponseStartLine(s, n, response);
+}
+
+
+template <class T, class U>
+std::size_t
+PushParser<T, U>::feedStartLine(const char *data, std::size_t dataSize)
+{
+    const char *s;
+    std::size_t n = 0;
+    std::size_t m = collectLine<StartLineTooLong>(data, dataSize, options_.maxStartLineSize, &s
+                                                  , &n);
+
+    if (s != nullptr) {
+        ParseStartLine(s, n, &message_);
+        buffer_.clear();
+        lineStart_ = 0;
+        handler_.onStartLine(&message_);
+        state_ = State::Header;
+    }
+
+    return m;
+}
+
+
+template <class T, class U>
+std::size_t
+PushParser<T, U>::feedHeader(const char *data, std::size_t dataSize)
+{
+    const char *s = nullptr;
+    std::size_t n = buffer_.empty() ? findHeaderEnd(data, dataSize) : 0;
+    std::size_t m;
+
+    if (n >= 1) {
+        s = data;
+        m = n;
+    } else {
+        const char *line;
+        std::size_t lineSize = 0;
+        m = collectLine<HeaderTooLarge>(data, dataSize, options_.maxHeaderSize, &line
+                                        , &lineSize);
+
+        if (line != nullptr && lineSize == SIREN_STRLEN("\r\n")) {
+            s = buffer_.data();
+            n = buffer_.size();
+        }
+    }
+
+    if (s != nullptr) {
+        if (n > SIREN_STRLEN("\r\n")) {
+            ParseHeader(s, n, &message_.header);
+        }
+
+        buffer_.clear();
+        lineStart_ = 0;
+        bool bodyIsChunked;
+        std::size_t bodySize;
+        std::tie(bodyIsChunked, bodySize) = parseBodySize(&message_.header);
+        handler_.onHeader(&message_);
+
+        if (bodyIsChunked) {
+            maxChunkSize_ = options_.maxBodySize;
+            bodyIsChunked_ = true;
+            remainingChunkSize_ = 0;
+            state_ = State::ChunkSize;
+        } else {
+            bodyIsChunked_ = false;
+            remainingBodySize_ = bodySize;
+
+            if (bodySize == 0) {
+                endMessage();
+            } else {
+                state_ = State::Body;
+            }
+        }
+    }
+
+    return m;
+}
+
+
+template <class T, class U>
+std::size_t
+PushParser<T, U>::feedBody(const char *data, std::size_t dataSize)
+{
+    std::size_t n = std::min(dataSize, remainingBodySize_);
+    remainingBodySize_ -= n;
+    handler_.onPayloadData(data, n);
+
+    if (remainingBodySize_ == 0) {
+        endMessage();
+    }
+
+    return n;
+}
+
+
+template <class T, class U>
+std::size_t
+PushParser<T, U>::feedChunkSize(const char *data, std::size_t dataSize)
+{
+    constexpr unsigned int k = (std::numeric_limits<std::size_t>::digits + 3) / 4;
+
+    const char *s;
+    std::size_t n = 0;
+    std::size_t m = collectLine<InvalidMessage>(data, dataSize, k + 2, &s, &n);
+
+    if (s != nullptr) {
+        std::size_t chunkSize = ParseChunkSize(s, n);
+
+        if (chunkSize > maxChunkSize_) {
+            throw BodyTooLarge();
+        }
+
+        maxChunkSize_ -= chunkSize;
+        buffer_.clear();
+        lineStart_ = 0;
+        remainingChunkSize_ = chunkSize;
+        state_ = chunkSize == 0 ? State::LastChunkEnd : State::ChunkData;
+    }
+
+    return m;
+}
+
+
+template <class T, class U>
+std::size_t
+PushParser<T, U>::feedChunkData(const char *data, std::size_t dataSize)
+{
+    std::size_t n = std::min(dataSize, remainingChunkSize_);
+    remainingChunkSize_ -= n;
+    handler_.onPayloadData(data, n);
+
+    if (remainingChunkSize_ == 0) {
+        state_ = State::ChunkDataEnd;
+    }
+
+    return n;
+}
+
+
+template <class T, class U>
+std::size_t
+PushParser<T, U>::feedCRLF(const char *data, std::size_t dataSize)
+{
+    std::size_t n = 0;
+
+    while (n < dataSize && lineStart_ < SIREN_STRLEN("\r\n")) {
+        if (data[n] != "\r\n"[lineStart_]) {
+            throw InvalidMessage();
+        }
+
+        ++n;
+        ++lineStart_;
+    }
+
+    if (lineStart_ == SIREN_STRLEN("\r\n")) {
+        lineStart_ = 0;
+
+        if (state_ == State::LastChunkEnd) {
+            bodyIsChunked_ = false;
+            endMessage();
+        } else {
+            state_ = State::ChunkSize;
+        }
+    }
+
+    return n;
+}
+
+
+template <class T, class U>
+void
+PushParser<T, U>::endMessage()
+{
+    state_ = State::StartLine;
+    handler_.onMessageEnd(&message_);
+    message_ = T();
+}
+
+
+template <class T, class U>
+std::size_t
+PushParser<T, U>::findHeaderEnd(const char *data, std::size_t dataSize) const noexcept
+{
+    const char *dataEnd = data + std::min(dataSize, options_.maxHeaderSize);
+    const char *lineStart = data;
+
+    for (const char *s = data;;) {
+        s = static_cast<const char *>(std::memchr(s, '\n', dataEnd - s));
+
+        if (s == nullptr) {
+            return 0;
+        }
+
+        ++s;
+
+        if (s - lineStart >= 2 && s[-2] == '\r') {
+            if (s - lineStart == 2) {
+                return s - data;
+            }
+
+            lineStart = s;
+        }
+    }
+}
+
+
+template <class T, class U>
+template <ParseException F()>
+std::size_t
+PushParser<T, U>::collectLine(const char *data, std::size_t dataSize, std::size_t maxLineSize
+                              , const char **line, std::size_t *lineSize)
+{
+    const char *dataEnd = data + dataSize;
+
+    for (const char *s = data;;) {
+        s = static_cast<const char *>(std::memchr(s, '\n', dataEnd - s));
+
+        if (s == nullptr) {
+            break;
+        }
+
+        ++s;
+        std::size_t n = s - data;
+        char c = n >= 2 ? s[-2] : buffer_.size() > lineStart_ ? buffer_.back() : '\0';
+
+        if (c == '\r') {
+            if (buffer_.size() + n > maxLineSize) {
+                throw F();
+            }
+
+            if (buffer_.empty() && state_ != State::Header) {
+                *line = data;
+                *lineSize = n;
+            } else {
+                buffer_.append(data, n);
+                *line = buffer_.data() + lineStart_;
+                *lineSize = buffer_.size() - lineStart_;
+                lineStart_ = buffer_.size();
+            }
+
+            return n;
+        }
+    }
+
+    if (buffer_.size() + dataSize > maxLineSize) {
+        throw F();
+    }
+
+    buffer_.append(data, dataSize);
+    *line = nullptr;
+    return dataSize;
+}
+
+} // namespace http
+
+} // namespace siren
@@ -0,0 +1,194 @@
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace siren {
+
+namespace http {
+
+class CachedResponse;
+class Connection;
+struct Request;
+struct Response;
+
+
+constexpr std::size_t MaxNumberOfResponseVariants = 8;
+
+
+namespace detail {
+
+struct CachedResponseAccess
+{
+    static std::shared_ptr<CachedResponse> Make(const Request &, const Response &, const void *
+                                                , std::size_t, std::size_t);
+    static void Serialize(const CachedResponse &, std::string *);
+    static std::shared_ptr<CachedResponse> Deserialize(const char *, std::size_t);
+};
+
+
+bool RequestAllowsCachedResponse(const Request &);
+std::string MakeResponseCacheKey(const Request &);
+
+} // namespace detail
+
+
+struct ResponseCacheOptions
+{
+    std::size_t maxCacheSize = 64 * 1024 * 1024;
+    std::size_t numberOfShards = 16;
+    std::size_t maxResponseSize = 1024 * 1024;
+};
+
+
+class CachedResponse final
+{
+public:
+    inline const char *getData() const noexcept;
+    inline std::size_t getSize() const noexcept;
+    inline std::size_t getStartLineSize() const noexcept;
+    inline std::size_t getHeadSize() const noexcept;
+    inline unsigned short getMajorVersionNumber() const noexcept;
+    inline unsigned short getMinorVersionNumber() const noexcept;
+    inline std::chrono::steady_clock::time_point getExpiryTime() const noexcept;
+
+    explicit CachedResponse() noexcept;
+
+    bool matchRequest(const Request &) const;
+
+private:
+    std::string data_;
+    std::size_t startLineSize_;
+    std::size_t headSize_;
+    unsigned short majorVersionNumber_;
+    unsigned short minorVersionNumber_;
+    std::vector<std::pair<std::string, std::string>> varyFields_;
+    std::chrono::steady_clock::time_point expiryTime_;
+
+    friend detail::CachedResponseAccess;
+};
+
+
+namespace detail {
+
+struct ResponseCacheEntry
+{
+    std::string key;
+    std::vector<std::shared_ptr<const CachedResponse>> variants;
+    std::size_t size = 0;
+};
+
+
+struct ResponseCacheShard
+{
+    typedef std::list<ResponseCacheEntry> EntryList;
+
+    std::mutex mutex;
+    EntryList entries;
+    std::unordered_map<std::string, EntryList::iterator> key2Entry;
+};
+
+} // namespace detail
+
+
+class ResponseCache final
+{
+public:
+    explicit ResponseCache(const ResponseCacheOptions &);
+
+    std::shared_ptr<const CachedResponse> findResponse(const Request &);
+    std::shared_ptr<const CachedResponse> storeResponse(const Request &, const Response &
+                                                        , const void *, std::size_t);
+    std::size_t getCacheSize();
+    std::size_t getNumberOfCachedResponses();
+
+private:
+    typedef detail::ResponseCacheShard Shard;
+    typedef detail::ResponseCacheEntry Entry;
+
+    ResponseCacheOptions options_;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<std::size_t> cacheSize_;
+
+    Shard *getShard(const std::string &) noexcept;
+    void evictEntries(Shard *) noexcept;
+};
+
+
+void DumpCachedResponse(Connection *, const Request &, const CachedResponse &);
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "response_cache-inl.h"
+ */
+
+
+namespace siren {
+
+namespace http {
+
+const char *
+CachedResponse::getData() const noexcept
+{
+    return data_.data();
+}
+
+
+std::size_t
+CachedResponse::getSize() const noexcept
+{
+    return data_.size();
+}
+
+
+std::size_t
+CachedResponse::getStartLineSize() const noexcept
+{
+    return startLineSize_;
+}
+
+
+std::size_t
+CachedResponse::getHeadSize() const noexcept
+{
+    return headSize_;
+}
+
+
+unsigned short
+CachedResponse::getMajorVersionNumber() const noexcept
+{
+    return majorVersionNumber_;
+}
+
+
+unsigned short
+CachedResponse::getMinorVersionNumber() const noexcept
+{
+    return minorVersionNumber_;
+}
+
+
+std::chrono::steady_clock::time_point
+CachedResponse::getExpiryTime() const noexcept
+{
+    return expiryTime_;
+}
+
+} // namespace http
+
+} // namespace siren
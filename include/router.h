@@ -0,0 +1,210 @@
+#pragma once
+
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace siren {
+
+namespace http {
+
+enum class MethodType;
+struct Request;
+
+
+constexpr std::size_t MaxNumberOfRouteParameters = 16;
+
+
+struct RouteParameter
+{
+    const char *name;
+    const char *value;
+    std::size_t valueSize;
+};
+
+
+namespace detail {
+
+class RouterBase;
+struct RouteParametersAccess;
+
+} // namespace detail
+
+
+class RouteParameters final
+{
+public:
+    inline explicit RouteParameters() noexcept;
+
+    inline std::size_t getCount() const noexcept;
+    inline const RouteParameter &operator[](std::size_t) const noexcept;
+    inline const RouteParameter *find(const char *) const noexcept;
+
+private:
+    RouteParameter items_[MaxNumberOfRouteParameters];
+    std::size_t count_;
+
+    friend detail::RouterBase;
+    friend detail::RouteParametersAccess;
+};
+
+
+namespace detail {
+
+struct RouterNode
+{
+    std::string label;
+    std::string childFirstChars;
+    std::vector<std::unique_ptr<RouterNode>> children;
+    std::unique_ptr<RouterNode> parameterChild;
+    std::unique_ptr<RouterNode> wildcardChild;
+    std::size_t routeIndex = -1;
+};
+
+
+struct Route
+{
+    std::vector<std::string> parameterNames;
+};
+
+
+class RouterBase
+{
+protected:
+    explicit RouterBase();
+    RouterBase(RouterBase &&) noexcept;
+    RouterBase &operator=(RouterBase &&) noexcept;
+    ~RouterBase();
+
+    std::size_t addRoute(MethodType, const char *);
+    std::size_t matchRoute(MethodType, const char *, std::size_t, RouteParameters *) const noexcept;
+
+private:
+    typedef RouterNode Node;
+
+    static Node *InsertLabel(Node *, const char *, std::size_t);
+    static std::size_t MatchNode(const Node *, const char *, const char *
+                                 , RouteParameters *) noexcept;
+
+    std::unique_ptr<Node[]> roots_;
+    std::vector<Route> routes_;
+};
+
+} // namespace detail
+
+
+template <class T>
+class Router final
+  : private detail::RouterBase
+{
+public:
+    template <class U>
+    inline void addRoute(MethodType, const char *, U &&);
+
+    inline const T *matchRoute(MethodType, const char *, RouteParameters *) const noexcept;
+    inline const T *matchRoute(const Request &, RouteParameters *) const noexcept;
+
+private:
+    std::vector<T> values_;
+};
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "router-inl.h"
+ */
+
+
+#include <cstring>
+#include <utility>
+
+#include <siren/assert.h>
+
+#include "request.h"
+
+
+namespace siren {
+
+namespace http {
+
+RouteParameters::RouteParameters() noexcept
+  : count_(0)
+{
+}
+
+
+std::size_t
+RouteParameters::getCount() const noexcept
+{
+    return count_;
+}
+
+
+const RouteParameter &
+RouteParameters::operator[](std::size_t index) const noexcept
+{
+    SIREN_ASSERT(index < count_);
+    return items_[index];
+}
+
+
+const RouteParameter *
+RouteParameters::find(const char *name) const noexcept
+{
+    SIREN_ASSERT(name != nullptr);
+
+    for (std::size_t i = 0; i < count_; ++i) {
+        if (std::strcmp(items_[i].name, name) == 0) {
+            return &items_[i];
+        }
+    }
+
+    return nullptr;
+}
+
+
+template <class T>
+template <class U>
+void
+Router<T>::addRoute(MethodType methodType, const char *pattern, U &&value)
+{
+    std::size_t routeIndex = RouterBase::addRoute(methodType, pattern);
+    SIREN_ASSERT(routeIndex == values_.size());
+    static_cast<void>(routeIndex);
+    values_.emplace_back(std::forward<U>(value));
+}
+
+
+template <class T>
+const T *
+Router<T>::matchRoute(MethodType methodType, const char *path
+                      , RouteParameters *parameters) const noexcept
+{
+    SIREN_ASSERT(path != nullptr);
+    std::size_t routeIndex = RouterBase::matchRoute(methodType, path, std::strlen(path)
+                                                    , parameters);
+
+    if (routeIndex == std::size_t(-1)) {
+        return nullptr;
+    }
+
+    return &values_[routeIndex];
+}
+
+
+template <class T>
+const T *
+Router<T>::matchRoute(const Request &request, RouteParameters *parameters) const noexcept
+{
+    return matchRoute(request.methodType, request.uri.getPathName(), parameters);
+}
+
+} // namespace http
+
+} // namespace siren
@@ -0,0 +1,119 @@
+#pragma once
+
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <siren/ip_endpoint.h>
+
+#include "connection.h"
+#include "io_uring.h"
+
+
+namespace siren {
+
+class TCPSocket;
+
+
+namespace http {
+
+namespace detail {
+
+struct ServerOptions
+{
+    unsigned int numberOfReactors = 0;
+    bool reactorsArePinned = false;
+    unsigned int maxLoadImbalance = 16;
+    int backlog = 1024;
+    long timerTickInterval = 100;
+};
+
+
+struct Reactor;
+
+} // namespace detail
+
+
+struct ServerOptions
+  : detail::ServerOptions,
+    ConnectionOptions,
+    IOURingOptions
+{
+};
+
+
+class Server final
+{
+public:
+    typedef std::function<void (Connection *)> Handler;
+
+    inline bool isRunning() const noexcept;
+    inline const IPEndpoint &getLocalEndpoint() const noexcept;
+    inline unsigned int getNumberOfReactors() const noexcept;
+
+    explicit Server(const ServerOptions &, Handler);
+    ~Server();
+
+    void start(const IPEndpoint &);
+    void stop() noexcept;
+    void wait();
+
+private:
+    ServerOptions options_;
+    Handler handler_;
+    IPEndpoint localEndpoint_;
+    std::vector<std::unique_ptr<detail::Reactor>> reactors_;
+    std::atomic_bool isStopping_;
+
+    Server(const Server &) = delete;
+    Server &operator=(const Server &) = delete;
+
+    static void WakeReactor(detail::Reactor *) noexcept;
+
+    void runReactor(detail::Reactor *);
+    void acceptConnections(detail::Reactor *);
+    void receiveConnections(detail::Reactor *);
+    void runTimers(detail::Reactor *);
+    detail::Reactor *selectReactor(detail::Reactor *) const noexcept;
+    void serveConnection(detail::Reactor *, TCPSocket *);
+};
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "server-inl.h"
+ */
+
+
+namespace siren {
+
+namespace http {
+
+bool
+Server::isRunning() const noexcept
+{
+    return !reactors_.empty();
+}
+
+
+const IPEndpoint &
+Server::getLocalEndpoint() const noexcept
+{
+    return localEndpoint_;
+}
+
+
+unsigned int
+Server::getNumberOfReactors() const noexcept
+{
+    return reactors_.size();
+}
+
+} // namespace http
+
+} // namespace siren
@@ -0,0 +1,121 @@
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+namespace siren {
+
+namespace http {
+
+class CachedResponse;
+struct Request;
+struct Response;
+
+
+namespace detail {
+
+constexpr std::size_t SharedCacheBucketSize = 8;
+constexpr std::size_t MinSharedCacheChunkSize = 64;
+constexpr std::size_t MaxNumberOfSharedCacheSlabClasses = 32;
+
+
+struct SharedCacheItem
+{
+    std::uint64_t keyHash;
+    std::uint64_t chunkOffset;
+    std::int64_t expiryTime;
+    std::uint32_t keySize;
+    std::uint32_t valueSize;
+    std::uint32_t slabClassIndex;
+};
+
+
+struct alignas(64) SharedCacheBucket
+{
+    std::atomic<std::uint32_t> sequenceNumber;
+    std::atomic<std::uint32_t> ownerPID;
+    SharedCacheItem items[SharedCacheBucketSize];
+};
+
+
+struct alignas(64) SharedCacheSegmentHeader
+{
+    std::atomic<std::uint64_t> state;
+    std::uint64_t segmentSize;
+    std::uint64_t numberOfBuckets;
+    std::uint64_t slabSize;
+    std::uint64_t numberOfSlabs;
+    std::uint64_t numberOfSlabClasses;
+    std::uint64_t bucketsOffset;
+    std::uint64_t slabsOffset;
+    std::atomic<std::uint32_t> allocatorLock;
+    std::uint64_t numberOfUsedSlabs;
+    std::uint64_t freeChunkOffsets[MaxNumberOfSharedCacheSlabClasses];
+    std::atomic<std::uint64_t> clockHand;
+    std::atomic<std::uint64_t> numberOfItems;
+    std::atomic<std::uint64_t> numberOfSlabClassItems[MaxNumberOfSharedCacheSlabClasses];
+};
+
+} // namespace detail
+
+
+struct SharedResponseCacheOptions
+{
+    std::string segmentFileName;
+    std::size_t segmentSize = 64 * 1024 * 1024;
+    std::size_t numberOfBuckets = 16 * 1024;
+    std::size_t slabSize = 1024 * 1024;
+    std::size_t maxResponseSize = 1024 * 1024;
+};
+
+
+class SharedResponseCache final
+{
+public:
+    explicit SharedResponseCache(const SharedResponseCacheOptions &);
+    ~SharedResponseCache();
+
+    std::shared_ptr<const CachedResponse> findResponse(const Request &);
+    std::shared_ptr<const CachedResponse> storeResponse(const Request &, const Response &
+                                                        , const void *, std::size_t);
+    bool findItem(const std::string &, std::string *);
+    bool storeItem(const std::string &, const void *, std::size_t
+                   , std::chrono::steady_clock::time_point);
+    void removeItem(const std::string &);
+    std::size_t getNumberOfItems() const noexcept;
+
+private:
+    typedef detail::SharedCacheItem Item;
+    typedef detail::SharedCacheBucket Bucket;
+    typedef detail::SharedCacheSegmentHeader SegmentHeader;
+
+    SharedResponseCacheOptions options_;
+    char *segment_;
+    SegmentHeader *segmentHeader_;
+    Bucket *buckets_;
+
+    SharedResponseCache(const SharedResponseCache &) = delete;
+    SharedResponseCache &operator=(const SharedResponseCache &) = delete;
+
+    void initializeSegment() noexcept;
+    Bucket *getBucket(std::uint64_t) noexcept;
+    void lockBucket(Bucket *) noexcept;
+    bool tryLockBucket(Bucket *) noexcept;
+    bool tryRecoverBucket(Bucket *) noexcept;
+    void unlockBucket(Bucket *) noexcept;
+    void lockAllocator() noexcept;
+    void unlockAllocator() noexcept;
+    std::uint64_t allocateChunk(std::size_t) noexcept;
+    void freeChunk(std::uint64_t, std::size_t) noexcept;
+    bool evictItems(std::size_t) noexcept;
+};
+
+} // namespace http
+
+} // namespace siren
@@ -0,0 +1,104 @@
+#pragma once
+
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <siren/semaphore.h>
+
+#include "response.h"
+
+
+namespace siren {
+
+class Loop;
+
+
+namespace http {
+
+class Connection;
+struct Request;
+
+
+struct SharedResponse
+{
+    Response response;
+    std::string body;
+};
+
+
+namespace detail {
+
+struct Flight
+{
+    Semaphore semaphore;
+    std::size_t numberOfWaiters;
+    std::shared_ptr<const SharedResponse> sharedResponse;
+    std::exception_ptr exception;
+
+    explicit Flight(Loop *);
+};
+
+} // namespace detail
+
+
+struct SingleFlightOptions
+{
+    std::vector<std::string> varyFieldNames = {"Accept", "Accept-Encoding"};
+};
+
+
+class SingleFlight final
+{
+public:
+    typedef std::function<std::shared_ptr<const SharedResponse> ()> Fetcher;
+
+    inline std::size_t getNumberOfFlights() const noexcept;
+
+    explicit SingleFlight(Loop *, const SingleFlightOptions &);
+
+    std::shared_ptr<const SharedResponse> fetch(const Request &, const Fetcher &);
+
+private:
+    Loop *loop_;
+    SingleFlightOptions options_;
+    std::unordered_map<std::string, std::shared_ptr<detail::Flight>> flights_;
+
+    SingleFlight(const SingleFlight &) = delete;
+    SingleFlight &operator=(const SingleFlight &) = delete;
+
+    std::string makeFlightKey(const Request &) const;
+};
+
+
+std::shared_ptr<const SharedResponse> FetchSharedResponse(Connection *, const Request &);
+void DumpSharedResponse(Connection *, const SharedResponse &);
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "single_flight-inl.h"
+ */
+
+
+namespace siren {
+
+namespace http {
+
+std::size_t
+SingleFlight::getNumberOfFlights() const noexcept
+{
+    return flights_.size();
+}
+
+} // namespace http
+
+} // namespace siren
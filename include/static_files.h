@@ -0,0 +1,94 @@
+#pragma once
+
+
+#include <sys/types.h>
+#include <time.h>
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+
+namespace siren {
+
+namespace http {
+
+class Connection;
+struct Request;
+
+
+namespace detail {
+
+struct StaticFile
+{
+    std::string pathName;
+    int fd;
+    std::string content;
+    dev_t deviceID;
+    ino_t inodeNumber;
+    std::size_t size;
+    timespec modificationTime;
+    std::string lastModified;
+    std::string eTag;
+    const char *contentType;
+    std::chrono::steady_clock::time_point validationTime;
+
+    explicit StaticFile() noexcept;
+    ~StaticFile();
+
+    StaticFile(const StaticFile &) = delete;
+    StaticFile &operator=(const StaticFile &) = delete;
+};
+
+} // namespace detail
+
+
+struct StaticFilesOptions
+{
+    std::string indexFileName = "index.html";
+    std::size_t maxNumberOfCachedFiles = 1024;
+    std::size_t maxBufferedFileSize = 64 * 1024;
+    long fileRevalidationInterval = 1000;
+};
+
+
+class StaticFiles final
+{
+public:
+    explicit StaticFiles(const StaticFilesOptions &, const std::string &);
+    ~StaticFiles();
+
+    void handleRequest(Connection *, const Request &);
+    void handleRequest(Connection *, const Request &, const char *);
+    std::size_t getNumberOfCachedFiles();
+
+private:
+    typedef std::list<std::pair<std::string, std::shared_ptr<detail::StaticFile>>> FileList;
+
+    StaticFilesOptions options_;
+    int rootDirectoryFD_;
+    std::mutex mutex_;
+    FileList files_;
+    std::unordered_map<std::string, FileList::iterator> pathName2File_;
+
+    std::shared_ptr<detail::StaticFile> getFile(const std::string &);
+    std::shared_ptr<detail::StaticFile> openFile(const std::string &);
+    bool revalidateFile(const detail::StaticFile &);
+
+    StaticFiles(const StaticFiles &) = delete;
+    StaticFiles &operator=(const StaticFiles &) = delete;
+};
+
+
+const char *LookupContentType(const char *) noexcept;
+bool NormalizePathName(const char *, std::string *);
+
+} // namespace http
+
+} // namespace siren
+
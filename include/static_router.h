@@ -0,0 +1,627 @@
+#pragma once
+
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "router.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+struct RouteParametersAccess
+{
+    static inline void Clear(RouteParameters *) noexcept;
+    static inline void Add(RouteParameters *, const char *, const char *, std::size_t) noexcept;
+    static inline void Truncate(RouteParameters *, std::size_t) noexcept;
+    static inline void SetName(RouteParameters *, std::size_t, const char *) noexcept;
+};
+
+
+constexpr std::size_t FindRouteSegmentEnd(const char *, std::size_t) noexcept;
+constexpr std::size_t FindRouteParameter(const char *, std::size_t) noexcept;
+constexpr std::size_t CountRouteParameters(const char *) noexcept;
+constexpr bool RouteParametersAreNamed(const char *) noexcept;
+constexpr bool RouteWildcardIsLast(const char *) noexcept;
+constexpr std::size_t GetNextRouteOffset(const char *, std::size_t) noexcept;
+
+
+template <const char *P, std::size_t I
+          , class = std::make_index_sequence<FindRouteSegmentEnd(P, I) - I>>
+struct RouteParameterName;
+
+
+template <const char *P, std::size_t I, std::size_t ...J>
+struct RouteParameterName<P, I, std::index_sequence<J...>>
+{
+    static constexpr char Value[] = {P[I + J]..., '\0'};
+};
+
+
+template <const char *P, std::size_t I = FindRouteParameter(P, 0), char C = P[I]>
+struct RouteParameterNamer
+{
+    static inline void Name(RouteParameters *, std::size_t) noexcept;
+};
+
+
+template <const char *P, std::size_t I>
+struct RouteParameterNamer<P, I, '\0'>
+{
+    static inline void Name(RouteParameters *, std::size_t) noexcept;
+};
+
+
+template <std::size_t I, std::size_t J>
+struct RouteCursor
+{
+    static constexpr std::size_t RouteIndex = I;
+    static constexpr std::size_t Offset = J;
+};
+
+
+template <class ...T>
+struct RouteCursorList
+{
+};
+
+
+template <class T>
+struct MakeRouteCursorList;
+
+
+template <std::size_t ...I>
+struct MakeRouteCursorList<std::index_sequence<I...>>
+{
+    typedef RouteCursorList<RouteCursor<I, 0>...> Type;
+};
+
+
+template <class R, class T>
+struct RouteCursorChar
+{
+    static constexpr char Value = std::tuple_element_t<T::RouteIndex, R>::Pattern[T::Offset];
+};
+
+
+template <class R, class L>
+struct FirstRouteCursorLiteral;
+
+
+template <class R, class L, char C>
+struct AdvanceRouteCursors;
+
+
+template <class R, class L, char C>
+struct RemoveRouteCursors;
+
+
+template <class R, class L>
+struct RouteTrieMatcher
+{
+    static inline std::size_t Match(MethodType, const char *, const char *
+                                    , RouteParameters *) noexcept;
+};
+
+
+template <class R>
+struct RouteTrieMatcher<R, RouteCursorList<>>
+{
+    static inline std::size_t Match(MethodType, const char *, const char *
+                                    , RouteParameters *) noexcept;
+};
+
+
+template <class R, class L, char C = FirstRouteCursorLiteral<R, L>::Value>
+struct RouteLiteralMatcher
+{
+    static inline std::size_t Match(MethodType, const char *, const char *
+                                    , RouteParameters *) noexcept;
+};
+
+
+template <class R, class L>
+struct RouteLiteralMatcher<R, L, '\0'>
+{
+    static inline std::size_t Match(MethodType, const char *, const char *
+                                    , RouteParameters *) noexcept;
+};
+
+
+template <class R, class L>
+struct RouteParameterMatcher
+{
+    static inline std::size_t Match(MethodType, const char *, const char *
+                                    , RouteParameters *) noexcept;
+};
+
+
+template <class R>
+struct RouteParameterMatcher<R, RouteCursorList<>>
+{
+    static inline std::size_t Match(MethodType, const char *, const char *
+                                    , RouteParameters *) noexcept;
+};
+
+
+template <class R, class L, char C>
+struct RouteEndMatcher;
+
+
+template <class R, char C>
+struct RouteEndMatcher<R, RouteCursorList<>, C>
+{
+    static inline std::size_t Match(MethodType, const char *, const char *
+                                    , RouteParameters *) noexcept;
+};
+
+
+template <class R, class T, class ...U, char C>
+struct RouteEndMatcher<R, RouteCursorList<T, U...>, C>
+{
+    static inline std::size_t Match(MethodType, const char *, const char *
+                                    , RouteParameters *) noexcept;
+};
+
+} // namespace detail
+
+
+template <MethodType M, const char *P>
+struct StaticRoute
+{
+    static_assert(P[0] == '/', "route pattern must start with `/`");
+    static_assert(detail::RouteParametersAreNamed(P), "route parameter must have a name");
+    static_assert(detail::RouteWildcardIsLast(P), "route wildcard must be the last segment");
+    static_assert(detail::CountRouteParameters(P) <= MaxNumberOfRouteParameters
+                  , "too many route parameters");
+
+    static constexpr MethodType Method = M;
+    static constexpr const char *Pattern = P;
+
+    static inline void NameParameters(RouteParameters *) noexcept;
+};
+
+
+template <class ...T>
+class StaticRouter final
+{
+public:
+    static constexpr std::size_t NumberOfRoutes = sizeof...(T);
+
+    static inline std::size_t MatchRoute(MethodType, const char *, RouteParameters *) noexcept;
+    static inline std::size_t MatchRoute(const Request &, RouteParameters *) noexcept;
+
+private:
+    typedef std::tuple<T...> Routes;
+    typedef typename detail::MakeRouteCursorList<std::index_sequence_for<T...>>::Type Cursors;
+};
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "static_router-inl.h"
+ */
+
+
+#include <cstring>
+
+#include <siren/assert.h>
+
+#include "request.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+void
+RouteParametersAccess::Clear(RouteParameters *parameters) noexcept
+{
+    parameters->count_ = 0;
+}
+
+
+void
+RouteParametersAccess::Add(RouteParameters *parameters, const char *name, const char *value
+                           , std::size_t valueSize) noexcept
+{
+    RouteParameter *parameter = &parameters->items_[parameters->count_++];
+    parameter->name = name;
+    parameter->value = value;
+    parameter->valueSize = valueSize;
+}
+
+
+void
+RouteParametersAccess::Truncate(RouteParameters *parameters, std::size_t count) noexcept
+{
+    parameters->count_ = count;
+}
+
+
+void
+RouteParametersAccess::SetName(RouteParameters *parameters, std::size_t i, const char *name)
+    noexcept
+{
+    parameters->items_[i].name = name;
+}
+
+
+constexpr std::size_t
+FindRouteSegmentEnd(const char *pattern, std::size_t i) noexcept
+{
+    while (pattern[i] != '\0' && pattern[i] != '/') {
+        ++i;
+    }
+
+    return i;
+}
+
+
+constexpr std::size_t
+FindRouteParameter(const char *pattern, std::size_t i) noexcept
+{
+    while (pattern[i] != '\0' && pattern[i] != ':' && pattern[i] != '*') {
+        ++i;
+    }
+
+    return i;
+}
+
+
+constexpr std::size_t
+CountRouteParameters(const char *pattern) noexcept
+{
+    std::size_t n = 0;
+
+    for (std::size_t i = 0; pattern[i] != '\0'; ++i) {
+        if (pattern[i] == ':' || pattern[i] == '*') {
+            ++n;
+            i = FindRouteSegmentEnd(pattern, i) - 1;
+        }
+    }
+
+    return n;
+}
+
+
+constexpr bool
+RouteParametersAreNamed(const char *pattern) noexcept
+{
+    for (std::size_t i = 0; pattern[i] != '\0'; ++i) {
+        if (pattern[i] == ':') {
+            if (FindRouteSegmentEnd(pattern, i + 1) == i + 1) {
+                return false;
+            }
+
+            i = FindRouteSegmentEnd(pattern, i + 1) - 1;
+        } else if (pattern[i] == '*') {
+            break;
+        }
+    }
+
+    return true;
+}
+
+
+constexpr bool
+RouteWildcardIsLast(const char *pattern) noexcept
+{
+    for (std::size_t i = 0; pattern[i] != '\0'; ++i) {
+        if (pattern[i] == ':') {
+            i = FindRouteSegmentEnd(pattern, i + 1) - 1;
+        } else if (pattern[i] == '*') {
+            return pattern[FindRouteSegmentEnd(pattern, i + 1)] == '\0';
+        }
+    }
+
+    return true;
+}
+
+
+constexpr std::size_t
+GetNextRouteOffset(const char *pattern, std::size_t i) noexcept
+{
+    return pattern[i] == ':' ? FindRouteSegmentEnd(pattern, i + 1) : i + 1;
+}
+
+
+template <const char *P, std::size_t I, std::size_t ...J>
+constexpr char RouteParameterName<P, I, std::index_sequence<J...>>::Value[];
+
+
+template <const char *P, std::size_t I, char C>
+void
+RouteParameterNamer<P, I, C>::Name(RouteParameters *parameters, std::size_t i) noexcept
+{
+    RouteParametersAccess::SetName(parameters, i, RouteParameterName<P, I + 1>::Value);
+    RouteParameterNamer<P, FindRouteParameter(P, I + 1)>::Name(parameters, i + 1);
+}
+
+
+template <const char *P, std::size_t I>
+void
+RouteParameterNamer<P, I, '\0'>::Name(RouteParameters *, std::size_t) noexcept
+{
+}
+
+
+template <std::size_t I, std::size_t J>
+constexpr std::size_t RouteCursor<I, J>::RouteIndex;
+
+
+template <std::size_t I, std::size_t J>
+constexpr std::size_t RouteCursor<I, J>::Offset;
+
+
+template <class R, class T>
+constexpr char RouteCursorChar<R, T>::Value;
+
+
+template <class R>
+struct FirstRouteCursorLiteral<R, RouteCursorList<>>
+{
+    static constexpr char Value = '\0';
+};
+
+
+template <class R, class T, class ...U>
+struct FirstRouteCursorLiteral<R, RouteCursorList<T, U...>>
+{
+    static constexpr char C = RouteCursorChar<R, T>::Value;
+
+    static constexpr char Value = C == '\0' || C == ':' || C == '*'
+                                  ? FirstRouteCursorLiteral<R, RouteCursorList<U...>>::Value
+                                  : C;
+};
+
+
+template <class R, char C>
+struct AdvanceRouteCursors<R, RouteCursorList<>, C>
+{
+    typedef RouteCursorList<> Type;
+};
+
+
+template <class R, class T, class ...U, char C>
+struct AdvanceRouteCursors<R, RouteCursorList<T, U...>, C>
+{
+    template <class V>
+    struct Prepend;
+
+    template <class ...V>
+    struct Prepend<RouteCursorList<V...>>
+    {
+        typedef RouteCursorList<RouteCursor<T::RouteIndex
+                                            , GetNextRouteOffset(std::tuple_element_t<
+                                                  T::RouteIndex, R>::Pattern, T::Offset)>
+                                , V...> Type;
+    };
+
+    typedef typename AdvanceRouteCursors<R, RouteCursorList<U...>, C>::Type Rest;
+
+    typedef std::conditional_t<RouteCursorChar<R, T>::Value == C, typename Prepend<Rest>::Type
+                               , Rest> Type;
+};
+
+
+template <class R, char C>
+struct RemoveRouteCursors<R, RouteCursorList<>, C>
+{
+    typedef RouteCursorList<> Type;
+};
+
+
+template <class R, class T, class ...U, char C>
+struct RemoveRouteCursors<R, RouteCursorList<T, U...>, C>
+{
+    template <class V>
+    struct Prepend;
+
+    template <class ...V>
+    struct Prepend<RouteCursorList<V...>>
+    {
+        typedef RouteCursorList<T, V...> Type;
+    };
+
+    typedef typename RemoveRouteCursors<R, RouteCursorList<U...>, C>::Type Rest;
+
+    typedef std::conditional_t<RouteCursorChar<R, T>::Value == C, Rest
+                               , typename Prepend<Rest>::Type> Type;
+};
+
+
+template <class R, class L>
+std::size_t
+RouteTrieMatcher<R, L>::Match(MethodType methodType, const char *s1, const char *s2
+                              , RouteParameters *parameters) noexcept
+{
+    std::size_t routeIndex;
+
+    if (s1 == s2) {
+        routeIndex = RouteEndMatcher<R, L, '\0'>::Match(methodType, s1, s2, parameters);
+    } else {
+        routeIndex = RouteLiteralMatcher<R, L>::Match(methodType, s1, s2, parameters);
+
+        if (routeIndex != std::size_t(-1)) {
+            return routeIndex;
+        }
+
+        routeIndex = RouteParameterMatcher<R, typename AdvanceRouteCursors<R, L, ':'>::Type>
+                     ::Match(methodType, s1, s2, parameters);
+    }
+
+    if (routeIndex != std::size_t(-1)) {
+        return routeIndex;
+    }
+
+    return RouteEndMatcher<R, L, '*'>::Match(methodType, s1, s2, parameters);
+}
+
+
+template <class R>
+std::size_t
+RouteTrieMatcher<R, RouteCursorList<>>::Match(MethodType, const char *, const char *
+                                              , RouteParameters *) noexcept
+{
+    return -1;
+}
+
+
+template <class R, class L, char C>
+std::size_t
+RouteLiteralMatcher<R, L, C>::Match(MethodType methodType, const char *s1, const char *s2
+                                    , RouteParameters *parameters) noexcept
+{
+    if (*s1 == C) {
+        return RouteTrieMatcher<R, typename AdvanceRouteCursors<R, L, C>::Type>
+               ::Match(methodType, s1 + 1, s2, parameters);
+    }
+
+    return RouteLiteralMatcher<R, typename RemoveRouteCursors<R, L, C>::Type>
+           ::Match(methodType, s1, s2, parameters);
+}
+
+
+template <class R, class L>
+std::size_t
+RouteLiteralMatcher<R, L, '\0'>::Match(MethodType, const char *, const char *
+                                       , RouteParameters *) noexcept
+{
+    return -1;
+}
+
+
+template <class R, class L>
+std::size_t
+RouteParameterMatcher<R, L>::Match(MethodType methodType, const char *s1, const char *s2
+                                   , RouteParameters *parameters) noexcept
+{
+    if (*s1 == '/') {
+        return -1;
+    }
+
+    auto s3 = static_cast<const char *>(std::memchr(s1, '/', s2 - s1));
+
+    if (s3 == nullptr) {
+        s3 = s2;
+    }
+
+    std::size_t i = parameters->getCount();
+    RouteParametersAccess::Add(parameters, nullptr, s1, s3 - s1);
+    std::size_t routeIndex = RouteTrieMatcher<R, L>::Match(methodType, s3, s2, parameters);
+
+    if (routeIndex == std::size_t(-1)) {
+        RouteParametersAccess::Truncate(parameters, i);
+    }
+
+    return routeIndex;
+}
+
+
+template <class R>
+std::size_t
+RouteParameterMatcher<R, RouteCursorList<>>::Match(MethodType, const char *, const char *
+                                                   , RouteParameters *) noexcept
+{
+    return -1;
+}
+
+
+template <class R, char C>
+std::size_t
+RouteEndMatcher<R, RouteCursorList<>, C>::Match(MethodType, const char *, const char *
+                                                , RouteParameters *) noexcept
+{
+    return -1;
+}
+
+
+template <class R, class T, class ...U, char C>
+std::size_t
+RouteEndMatcher<R, RouteCursorList<T, U...>, C>::Match(MethodType methodType, const char *s1
+                                                       , const char *s2
+                                                       , RouteParameters *parameters) noexcept
+{
+    typedef std::tuple_element_t<T::RouteIndex, R> Route;
+
+    if (RouteCursorChar<R, T>::Value == C && Route::Method == methodType) {
+        if (C == '*') {
+            RouteParametersAccess::Add(parameters, nullptr, s1, s2 - s1);
+        }
+
+        Route::NameParameters(parameters);
+        return T::RouteIndex;
+    }
+
+    return RouteEndMatcher<R, RouteCursorList<U...>, C>::Match(methodType, s1, s2, parameters);
+}
+
+} // namespace detail
+
+
+template <MethodType M, const char *P>
+void
+StaticRoute<M, P>::NameParameters(RouteParameters *parameters) noexcept
+{
+    detail::RouteParameterNamer<P>::Name(parameters, 0);
+}
+
+
+template <MethodType M, const char *P>
+constexpr MethodType StaticRoute<M, P>::Method;
+
+
+template <MethodType M, const char *P>
+constexpr const char *StaticRoute<M, P>::Pattern;
+
+
+template <class ...T>
+constexpr std::size_t StaticRouter<T...>::NumberOfRoutes;
+
+
+template <class ...T>
+std::size_t
+StaticRouter<T...>::MatchRoute(MethodType methodType, const char *path
+                               , RouteParameters *parameters) noexcept
+{
+    SIREN_ASSERT(path != nullptr);
+    RouteParameters dummyParameters;
+
+    if (parameters == nullptr) {
+        parameters = &dummyParameters;
+    }
+
+    detail::RouteParametersAccess::Clear(parameters);
+    std::size_t routeIndex = detail::RouteTrieMatcher<Routes, Cursors>
+                             ::Match(methodType, path, path + std::strlen(path), parameters);
+
+    if (routeIndex == std::size_t(-1)) {
+        detail::RouteParametersAccess::Clear(parameters);
+    }
+
+    return routeIndex;
+}
+
+
+template <class ...T>
+std::size_t
+StaticRouter<T...>::MatchRoute(const Request &request, RouteParameters *parameters) noexcept
+{
+    return MatchRoute(request.methodType, request.uri.getPathName(), parameters);
+}
+
+} // namespace http
+
+} // namespace siren
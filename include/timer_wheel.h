@@ -0,0 +1,288 @@
+#pragma once
+
+
+#include <cstdint>
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+constexpr unsigned int TimerWheelSlotBits = 6;
+constexpr unsigned int TimerWheelDepth = 4;
+
+
+class TimerWheel;
+
+
+class Timer
+{
+public:
+    inline bool isActive() const noexcept;
+
+    inline explicit Timer() noexcept;
+    inline ~Timer();
+
+private:
+    Timer *prev_;
+    Timer *next_;
+    std::uint64_t expiryTick_;
+
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+
+    inline void initialize() noexcept;
+    inline void insertAfter(Timer *) noexcept;
+    inline void remove() noexcept;
+
+    friend TimerWheel;
+};
+
+
+class TimerWheel final
+{
+public:
+    inline long getTickInterval() const noexcept;
+    inline void addTimer(Timer *, long);
+    inline void removeTimer(Timer *) noexcept;
+
+    template <class T>
+    inline void advance(long, T &&);
+
+    inline explicit TimerWheel(long) noexcept;
+    inline ~TimerWheel();
+
+private:
+    static constexpr unsigned int NumberOfSlots = 1U << TimerWheelSlotBits;
+
+    long tickInterval_;
+    long remainingTime_;
+    std::uint64_t currentTick_;
+    Timer slots_[TimerWheelDepth][NumberOfSlots];
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    inline void insertTimer(Timer *) noexcept;
+    inline void cascadeTimers(unsigned int, unsigned int) noexcept;
+
+    template <class T>
+    inline void tick(T *);
+};
+
+} // namespace detail
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "timer_wheel-inl.h"
+ */
+
+
+#include <siren/assert.h>
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+Timer::Timer() noexcept
+{
+    initialize();
+}
+
+
+Timer::~Timer()
+{
+    if (isActive()) {
+        remove();
+    }
+}
+
+
+void
+Timer::initialize() noexcept
+{
+    prev_ = nullptr;
+    next_ = nullptr;
+    expiryTick_ = 0;
+}
+
+
+bool
+Timer::isActive() const noexcept
+{
+    return prev_ != nullptr;
+}
+
+
+void
+Timer::insertAfter(Timer *other) noexcept
+{
+    prev_ = other;
+    next_ = other->next_;
+    other->next_->prev_ = this;
+    other->next_ = this;
+}
+
+
+void
+Timer::remove() noexcept
+{
+    prev_->next_ = next_;
+    next_->prev_ = prev_;
+    prev_ = nullptr;
+    next_ = nullptr;
+}
+
+
+TimerWheel::TimerWheel(long tickInterval) noexcept
+  : tickInterval_(tickInterval),
+    remainingTime_(0),
+    currentTick_(0)
+{
+    SIREN_ASSERT(tickInterval >= 1);
+
+    for (Timer (&level)[NumberOfSlots] : slots_) {
+        for (Timer &slot : level) {
+            slot.prev_ = &slot;
+            slot.next_ = &slot;
+        }
+    }
+}
+
+
+TimerWheel::~TimerWheel()
+{
+    for (Timer (&level)[NumberOfSlots] : slots_) {
+        for (Timer &slot : level) {
+            for (Timer *timer = slot.next_, *nextTimer; timer != &slot; timer = nextTimer) {
+                nextTimer = timer->next_;
+                timer->initialize();
+            }
+
+            slot.initialize();
+        }
+    }
+}
+
+
+long
+TimerWheel::getTickInterval() const noexcept
+{
+    return tickInterval_;
+}
+
+
+void
+TimerWheel::addTimer(Timer *timer, long timeout)
+{
+    SIREN_ASSERT(timer != nullptr);
+    SIREN_ASSERT(!timer->isActive());
+    SIREN_ASSERT(timeout >= 0);
+    timer->expiryTick_ = currentTick_ + (timeout + tickInterval_ - 1) / tickInterval_;
+    insertTimer(timer);
+}
+
+
+void
+TimerWheel::removeTimer(Timer *timer) noexcept
+{
+    SIREN_ASSERT(timer != nullptr);
+
+    if (timer->isActive()) {
+        timer->remove();
+    }
+}
+
+
+template <class T>
+void
+TimerWheel::advance(long elapsedTime, T &&callback)
+{
+    SIREN_ASSERT(elapsedTime >= 0);
+    remainingTime_ += elapsedTime;
+
+    while (remainingTime_ >= tickInterval_) {
+        remainingTime_ -= tickInterval_;
+        tick(&callback);
+    }
+}
+
+
+void
+TimerWheel::insertTimer(Timer *timer) noexcept
+{
+    constexpr std::uint64_t k = std::uint64_t(1) << (TimerWheelSlotBits * TimerWheelDepth);
+
+    std::uint64_t delay = timer->expiryTick_ - currentTick_;
+
+    if (delay >= k) {
+        delay = k - 1;
+        timer->expiryTick_ = currentTick_ + delay;
+    }
+
+    unsigned int level = 0;
+
+    while (delay >= std::uint64_t(1) << (TimerWheelSlotBits * (level + 1))) {
+        ++level;
+    }
+
+    unsigned int slotIndex = (timer->expiryTick_ >> (TimerWheelSlotBits * level))
+                             & (NumberOfSlots - 1);
+    timer->insertAfter(slots_[level][slotIndex].prev_);
+}
+
+
+void
+TimerWheel::cascadeTimers(unsigned int level, unsigned int slotIndex) noexcept
+{
+    Timer *slot = &slots_[level][slotIndex];
+
+    while (slot->next_ != slot) {
+        Timer *timer = slot->next_;
+        timer->remove();
+        insertTimer(timer);
+    }
+}
+
+
+template <class T>
+void
+TimerWheel::tick(T *callback)
+{
+    unsigned int slotIndex = currentTick_ & (NumberOfSlots - 1);
+
+    if (slotIndex == 0) {
+        for (unsigned int level = 1; level < TimerWheelDepth; ++level) {
+            unsigned int i = (currentTick_ >> (TimerWheelSlotBits * level)) & (NumberOfSlots - 1);
+            cascadeTimers(level, i);
+
+            if (i != 0) {
+                break;
+            }
+        }
+    }
+
+    ++currentTick_;
+    Timer *slot = &slots_[0][slotIndex];
+
+    while (slot->next_ != slot) {
+        Timer *timer = slot->next_;
+        timer->remove();
+        (*callback)(timer);
+    }
+}
+
+} // namespace detail
+
+} // namespace http
+
+} // namespace siren
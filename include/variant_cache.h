@@ -0,0 +1,164 @@
+#pragma once
+
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "content_coding.h"
+
+
+namespace siren {
+
+namespace http {
+
+class Asset;
+class Connection;
+class Header;
+class VariantCache;
+struct Request;
+struct Response;
+
+
+namespace detail {
+
+struct AssetFile
+{
+    dev_t deviceID;
+    ino_t inodeNumber;
+    timespec modificationTime;
+    off_t size;
+    std::weak_ptr<const Asset> asset;
+};
+
+} // namespace detail
+
+
+struct VariantCacheOptions
+{
+    std::size_t maxCacheSize = 64 * 1024 * 1024;
+    std::size_t minCompressionSize = 1024;
+    int compressionLevel = 9;
+};
+
+
+class Asset final
+{
+public:
+    inline std::uint64_t getContentHash() const noexcept;
+    inline const std::string &getContent() const noexcept;
+    inline const std::string *getVariant(ContentCoding) const noexcept;
+    inline unsigned int getContentCodingMask() const noexcept;
+    inline std::size_t getSize() const noexcept;
+
+    explicit Asset() noexcept;
+
+    std::pair<ContentCoding, const std::string *> selectVariant(const Header &) const noexcept;
+
+private:
+    std::uint64_t contentHash_;
+    std::string variants_[static_cast<int>(ContentCoding::Zstd) + 1];
+    unsigned int contentCodingMask_;
+    std::size_t size_;
+
+    void setVariant(ContentCoding, std::string &&) noexcept;
+
+    friend VariantCache;
+};
+
+
+class VariantCache final
+{
+public:
+    explicit VariantCache(const VariantCacheOptions &);
+
+    std::shared_ptr<const Asset> addAsset(std::string);
+    std::shared_ptr<const Asset> loadAsset(const std::string &);
+    std::size_t getCacheSize() const;
+    std::size_t getNumberOfAssets() const;
+
+private:
+    typedef std::list<std::shared_ptr<const Asset>> AssetList;
+
+    VariantCacheOptions options_;
+    mutable std::mutex mutex_;
+    AssetList assets_;
+    std::unordered_map<std::uint64_t, AssetList::iterator> contentHash2Asset_;
+    std::unordered_map<std::string, detail::AssetFile> fileName2AssetFile_;
+    std::size_t cacheSize_;
+
+    std::shared_ptr<const Asset> findAsset(std::uint64_t, const std::string &);
+    std::shared_ptr<const Asset> findAssetFile(const std::string &, const struct stat &);
+    void insertAssetFile(const std::string &, const struct stat &
+                         , const std::shared_ptr<const Asset> &);
+    std::shared_ptr<const Asset> insertAsset(std::shared_ptr<const Asset>);
+    void compressAsset(Asset *);
+};
+
+
+void DumpAsset(Connection *, const Request &, Response *, const Asset &);
+
+} // namespace http
+
+} // namespace siren
+
+
+/*
+ * #include "variant_cache-inl.h"
+ */
+
+
+namespace siren {
+
+namespace http {
+
+std::uint64_t
+Asset::getContentHash() const noexcept
+{
+    return contentHash_;
+}
+
+
+const std::string &
+Asset::getContent() const noexcept
+{
+    return variants_[static_cast<int>(ContentCoding::Identity)];
+}
+
+
+const std::string *
+Asset::getVariant(ContentCoding contentCoding) const noexcept
+{
+    if ((contentCodingMask_ & 1U << static_cast<int>(contentCoding)) == 0) {
+        return nullptr;
+    }
+
+    return &variants_[static_cast<int>(contentCoding)];
+}
+
+
+unsigned int
+Asset::getContentCodingMask() const noexcept
+{
+    return contentCodingMask_;
+}
+
+
+std::size_t
+Asset::getSize() const noexcept
+{
+    return size_;
+}
+
+} // namespace http
+
+} // namespace siren
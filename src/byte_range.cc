@@ -0,0 +1,279 @@
+#include "byte_range.h"
+
+#include <strings.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+#include <siren/assert.h>
+#include <siren/utility.h>
+
+#include "connection.h"
+#include "header.h"
+#include "response.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace {
+
+const char *SkipWhitespaces(const char *) noexcept;
+bool ParseNumber(const char **, std::size_t *) noexcept;
+std::string MakeBoundary();
+void WriteString(PayloadWriter *, const std::string &);
+
+} // namespace
+
+
+ByteRangesStatus
+ParseByteRanges(const Header &header, std::size_t contentSize, const char *eTag
+                , const char *lastModified, std::vector<ByteRange> *byteRanges)
+{
+    const char *rangeValue = nullptr;
+    int numberOfRanges = 0;
+    const char *ifRangeValue = nullptr;
+
+    header.traverse([&] (std::size_t, const char *headerFieldName, const char *headerFieldValue)
+                    -> void {
+        if (std::strcmp(headerFieldName, "Range") == 0) {
+            rangeValue = headerFieldValue;
+            ++numberOfRanges;
+        } else if (std::strcmp(headerFieldName, "If-Range") == 0) {
+            ifRangeValue = headerFieldValue;
+        }
+    });
+
+    byteRanges->clear();
+
+    if (numberOfRanges != 1) {
+        return ByteRangesStatus::None;
+    }
+
+    if (ifRangeValue != nullptr) {
+        const char *validator = *ifRangeValue == '"' ? eTag : lastModified;
+
+        if (validator == nullptr || std::strncmp(validator, "W/", SIREN_STRLEN("W/")) == 0
+            || std::strcmp(ifRangeValue, validator) != 0) {
+            return ByteRangesStatus::None;
+        }
+    }
+
+    if (strncasecmp(rangeValue, "bytes=", SIREN_STRLEN("bytes=")) != 0) {
+        return ByteRangesStatus::None;
+    }
+
+    std::size_t numberOfByteRangeSpecs = 0;
+
+    for (const char *s = rangeValue + SIREN_STRLEN("bytes=");;) {
+        s = SkipWhitespaces(s);
+
+        if (*s == ',') {
+            ++s;
+            continue;
+        }
+
+        if (*s == '\0') {
+            break;
+        }
+
+        std::size_t first, last;
+        bool firstIsPresent = ParseNumber(&s, &first);
+
+        if (*s != '-') {
+            return ByteRangesStatus::None;
+        }
+
+        ++s;
+        bool lastIsPresent = ParseNumber(&s, &last);
+        s = SkipWhitespaces(s);
+
+        if ((*s != ',' && *s != '\0') || (!firstIsPresent && !lastIsPresent)
+            || (firstIsPresent && lastIsPresent && last < first)
+            || ++numberOfByteRangeSpecs > MaxNumberOfByteRanges) {
+            return ByteRangesStatus::None;
+        }
+
+        if (firstIsPresent) {
+            if (first < contentSize) {
+                last = lastIsPresent ? std::min(last, contentSize - 1) : contentSize - 1;
+                byteRanges->push_back({first, last - first + 1});
+            }
+        } else {
+            if (last >= 1 && contentSize >= 1) {
+                last = std::min(last, contentSize);
+                byteRanges->push_back({contentSize - last, last});
+            }
+        }
+    }
+
+    if (numberOfByteRangeSpecs == 0) {
+        return ByteRangesStatus::None;
+    }
+
+    if (byteRanges->empty()) {
+        return ByteRangesStatus::Unsatisfiable;
+    }
+
+    std::sort(byteRanges->begin(), byteRanges->end()
+              , [] (const ByteRange &byteRange1, const ByteRange &byteRange2) -> bool {
+        return byteRange1.offset < byteRange2.offset;
+    });
+
+    std::size_t i = 0;
+
+    for (std::size_t j = 1; j < byteRanges->size(); ++j) {
+        ByteRange *byteRange1 = &(*byteRanges)[i];
+        const ByteRange &byteRange2 = (*byteRanges)[j];
+
+        if (byteRange2.offset <= byteRange1->offset + byteRange1->size) {
+            byteRange1->size = std::max(byteRange1->offset + byteRange1->size
+                                        , byteRange2.offset + byteRange2.size)
+                               - byteRange1->offset;
+        } else {
+            (*byteRanges)[++i] = byteRange2;
+        }
+    }
+
+    byteRanges->resize(i + 1);
+    return ByteRangesStatus::Satisfiable;
+}
+
+
+void
+DumpPartialResponse(Connection *connection, Response *response, std::size_t contentSize
+                    , const std::vector<ByteRange> &byteRanges
+                    , const ByteRangeWriter &byteRangeWriter)
+{
+    SIREN_ASSERT(!byteRanges.empty());
+    response->statusCode = StatusCode::PartialContent;
+    response->reasonPhrase = DescribeStatus(response->statusCode);
+    char contentRange[64];
+
+    if (byteRanges.size() == 1) {
+        const ByteRange &byteRange = byteRanges[0];
+        std::sprintf(contentRange, "bytes %zu-%zu/%zu", byteRange.offset
+                     , byteRange.offset + byteRange.size - 1, contentSize);
+        response->header.addField("Content-Range", contentRange);
+        PayloadWriter payloadWriter = connection->dumpResponse(*response, byteRange.size);
+        byteRangeWriter(&payloadWriter, byteRange);
+        return;
+    }
+
+    std::string contentType = "application/octet-stream";
+
+    response->header.traverse([&] (std::size_t headerFieldIndex, const char *headerFieldName
+                                   , const char *headerFieldValue) -> void {
+        if (std::strcmp(headerFieldName, "Content-Type") == 0) {
+            contentType = headerFieldValue;
+            response->header.removeField(headerFieldIndex);
+        }
+    });
+
+    std::string boundary = MakeBoundary();
+    std::vector<std::string> partHeaders;
+    std::size_t bodySize = 0;
+
+    for (const ByteRange &byteRange : byteRanges) {
+        std::sprintf(contentRange, "%zu-%zu/%zu", byteRange.offset
+                     , byteRange.offset + byteRange.size - 1, contentSize);
+        partHeaders.push_back("\r\n--" + boundary + "\r\nContent-Type: " + contentType
+                              + "\r\nContent-Range: bytes " + contentRange + "\r\n\r\n");
+        bodySize += partHeaders.back().size() + byteRange.size;
+    }
+
+    std::string trailer = "\r\n--" + boundary + "--\r\n";
+    bodySize += trailer.size();
+    response->header.addField("Content-Type", "multipart/byteranges; boundary=" + boundary);
+    PayloadWriter payloadWriter = connection->dumpResponse(*response, bodySize);
+
+    for (std::size_t i = 0; i < byteRanges.size(); ++i) {
+        WriteString(&payloadWriter, partHeaders[i]);
+        byteRangeWriter(&payloadWriter, byteRanges[i]);
+    }
+
+    WriteString(&payloadWriter, trailer);
+}
+
+
+void
+DumpRangeNotSatisfiableResponse(Connection *connection, Response *response
+                                , std::size_t contentSize)
+{
+    response->statusCode = StatusCode::RangeNotSatisfiable;
+    response->reasonPhrase = DescribeStatus(response->statusCode);
+    char contentRange[32];
+    std::sprintf(contentRange, "bytes */%zu", contentSize);
+    response->header.addField("Content-Range", contentRange);
+    response->header.addField("Content-Length", "0");
+    connection->dumpResponse(*response, 0);
+}
+
+
+namespace {
+
+const char *
+SkipWhitespaces(const char *s) noexcept
+{
+    while (*s == ' ' || *s == '\t') {
+        ++s;
+    }
+
+    return s;
+}
+
+
+bool
+ParseNumber(const char **s, std::size_t *number) noexcept
+{
+    const char *s1 = *s;
+    std::size_t n = 0;
+
+    for (; *s1 >= '0' && *s1 <= '9'; ++s1) {
+        std::size_t d = *s1 - '0';
+
+        if (n > (std::numeric_limits<std::size_t>::max() - d) / 10) {
+            n = std::numeric_limits<std::size_t>::max();
+        } else {
+            n = n * 10 + d;
+        }
+    }
+
+    if (s1 == *s) {
+        return false;
+    }
+
+    *s = s1;
+    *number = n;
+    return true;
+}
+
+
+std::string
+MakeBoundary()
+{
+    static thread_local std::mt19937_64 randomNumberGenerator(std::random_device{}());
+    char boundary[17];
+    std::sprintf(boundary, "%016llx"
+                 , static_cast<unsigned long long>(randomNumberGenerator()));
+    return boundary;
+}
+
+
+void
+WriteString(PayloadWriter *payloadWriter, const std::string &string)
+{
+    std::memcpy(payloadWriter->reserveBuffer(string.size()), string.data(), string.size());
+    payloadWriter->flushBuffer(string.size());
+}
+
+} // namespace
+
+} // namespace http
+
+} // namespace siren
@@ -0,0 +1,254 @@
+#include "capture_parser.h"
+
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <thread>
+#include <utility>
+
+#include <siren/assert.h>
+#include <siren/utility.h>
+
+#include "memory_parser.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace {
+
+struct Segment
+{
+    std::size_t start;
+    std::size_t end;
+    std::size_t stop;
+    std::exception_ptr exception;
+};
+
+
+template <class T>
+std::vector<T> ParseCapturedMessages(const ParseOptions &, const char *, std::size_t
+                                     , unsigned int);
+
+template <class T>
+std::vector<T> ParseSegment(const ParseOptions &, const char *, std::size_t, Segment *);
+
+template <class T>
+std::size_t FindMessageStart(const char *, std::size_t, std::size_t) noexcept;
+
+bool GetMessage(MemoryParser *, CapturedRequest *);
+bool GetMessage(MemoryParser *, CapturedResponse *);
+bool TestStartLine(const char *, const char *, const CapturedRequest *) noexcept;
+bool TestStartLine(const char *, const char *, const CapturedResponse *) noexcept;
+
+} // namespace
+
+
+std::vector<CapturedRequest>
+ParseCapturedRequests(const ParseOptions &options, const void *data, std::size_t dataSize
+                      , unsigned int numberOfThreads)
+{
+    return ParseCapturedMessages<CapturedRequest>(options, static_cast<const char *>(data)
+                                                  , dataSize, numberOfThreads);
+}
+
+
+std::vector<CapturedResponse>
+ParseCapturedResponses(const ParseOptions &options, const void *data, std::size_t dataSize
+                       , unsigned int numberOfThreads)
+{
+    return ParseCapturedMessages<CapturedResponse>(options, static_cast<const char *>(data)
+                                                   , dataSize, numberOfThreads);
+}
+
+
+namespace {
+
+template <class T>
+std::vector<T>
+ParseCapturedMessages(const ParseOptions &options, const char *data, std::size_t dataSize
+                      , unsigned int numberOfThreads)
+{
+    SIREN_ASSERT(data != nullptr);
+    SIREN_ASSERT(numberOfThreads >= 1);
+
+    if (dataSize == 0) {
+        return std::vector<T>();
+    }
+
+    if (numberOfThreads > dataSize) {
+        numberOfThreads = dataSize;
+    }
+
+    std::vector<Segment> segments(numberOfThreads);
+    std::size_t segmentSize = dataSize / numberOfThreads;
+
+    for (unsigned int i = 0; i < numberOfThreads; ++i) {
+        segments[i].start = i == 0 ? 0 : FindMessageStart<T>(data, dataSize, i * segmentSize);
+    }
+
+    for (unsigned int i = 0; i < numberOfThreads; ++i) {
+        segments[i].end = i + 1 == numberOfThreads ? dataSize : segments[i + 1].start;
+    }
+
+    std::vector<std::vector<T>> results(numberOfThreads);
+    std::vector<std::thread> threads;
+    threads.reserve(numberOfThreads - 1);
+
+    for (unsigned int i = 1; i < numberOfThreads; ++i) {
+        threads.emplace_back([&, i] () -> void {
+            results[i] = ParseSegment<T>(options, data, dataSize, &segments[i]);
+        });
+    }
+
+    results[0] = ParseSegment<T>(options, data, dataSize, &segments[0]);
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    std::vector<T> messages;
+
+    for (unsigned int i = 0; i < numberOfThreads; ++i) {
+        Segment *segment = &segments[i];
+
+        if (i >= 1 && segment->start != segments[i - 1].stop) {
+            segment->start = segments[i - 1].stop;
+            results[i] = ParseSegment<T>(options, data, dataSize, segment);
+        }
+
+        if (segment->exception != nullptr) {
+            std::rethrow_exception(segment->exception);
+        }
+
+        messages.insert(messages.end(), std::make_move_iterator(results[i].begin())
+                        , std::make_move_iterator(results[i].end()));
+    }
+
+    return messages;
+}
+
+
+template <class T>
+std::vector<T>
+ParseSegment(const ParseOptions &options, const char *data, std::size_t dataSize
+             , Segment *segment)
+{
+    std::vector<T> messages;
+    segment->stop = segment->start;
+    segment->exception = nullptr;
+
+    if (segment->start >= segment->end) {
+        return messages;
+    }
+
+    MemoryParser parser(options, data + segment->start, dataSize - segment->start);
+
+    try {
+        for (;;) {
+            T message;
+            message.offset = segment->start + parser.getOffset();
+
+            if (!GetMessage(&parser, &message)) {
+                break;
+            }
+
+            message.bodySize = 0;
+
+            parser.readPayload([&] (const char *, std::size_t payloadDataSize) -> void {
+                message.bodySize += payloadDataSize;
+            });
+
+            segment->stop = segment->start + parser.getOffset();
+            message.size = segment->stop - message.offset;
+            messages.push_back(std::move(message));
+
+            if (segment->stop >= segment->end) {
+                break;
+            }
+        }
+    } catch (...) {
+        segment->exception = std::current_exception();
+    }
+
+    return messages;
+}
+
+
+template <class T>
+std::size_t
+FindMessageStart(const char *data, std::size_t dataSize, std::size_t offset) noexcept
+{
+    const char *s = data + offset - 1;
+    const char *dataEnd = data + dataSize;
+
+    for (;;) {
+        s = static_cast<const char *>(std::memchr(s, '\n', dataEnd - s));
+
+        if (s == nullptr) {
+            return dataSize;
+        }
+
+        ++s;
+
+        if (TestStartLine(s, dataEnd, static_cast<const T *>(nullptr))) {
+            return s - data;
+        }
+    }
+}
+
+
+bool
+GetMessage(MemoryParser *parser, CapturedRequest *capturedRequest)
+{
+    return parser->getRequest(&capturedRequest->request);
+}
+
+
+bool
+GetMessage(MemoryParser *parser, CapturedResponse *capturedResponse)
+{
+    return parser->getResponse(&capturedResponse->response);
+}
+
+
+bool
+TestStartLine(const char *s1, const char *s2, const CapturedRequest *) noexcept
+{
+    static const char *const methodNames[] = {
+        "CONNECT ",
+        "DELETE ",
+        "GET ",
+        "HEAD ",
+        "OPTIONS ",
+        "PATCH ",
+        "POST ",
+        "PUT ",
+        "TRACE ",
+    };
+
+    for (const char *methodName : methodNames) {
+        std::size_t n = std::strlen(methodName);
+
+        if (static_cast<std::size_t>(s2 - s1) >= n && std::memcmp(s1, methodName, n) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool
+TestStartLine(const char *s1, const char *s2, const CapturedResponse *) noexcept
+{
+    return static_cast<std::size_t>(s2 - s1) >= SIREN_STRLEN("HTTP/")
+           && std::memcmp(s1, "HTTP/", SIREN_STRLEN("HTTP/")) == 0;
+}
+
+} // namespace
+
+} // namespace http
+
+} // namespace siren
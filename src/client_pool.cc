@@ -0,0 +1,168 @@
+#include "client_pool.h"
+
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <utility>
+
+#include <siren/ip_endpoint.h>
+#include <siren/loop.h>
+#include <siren/tcp_socket.h>
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+PooledConnection::PooledConnection(ClientPoolEndpoint *endpoint
+                                   , const http::ConnectionOptions &options
+                                   , TCPSocket &&tcpSocket)
+  : endpoint(endpoint),
+    fd(tcpSocket.getFD()),
+    connection(options, std::move(tcpSocket))
+{
+}
+
+
+ClientPoolEndpoint::ClientPoolEndpoint(Loop *loop, std::size_t maxNumberOfConnections)
+  : semaphore(loop, maxNumberOfConnections, 0, maxNumberOfConnections)
+{
+}
+
+} // namespace detail
+
+
+ClientPool::ClientPool(Loop *loop, const ClientPoolOptions &options)
+  : loop_(loop),
+    options_(options)
+{
+    SIREN_ASSERT(loop != nullptr);
+    SIREN_ASSERT(options.maxNumberOfConnectionsPerEndpoint >= 1);
+}
+
+
+std::size_t
+ClientPool::getNumberOfIdleConnections(const IPEndpoint &endpoint) const noexcept
+{
+    auto it = endpoints_.find(MakeEndpointKey(endpoint));
+
+    if (it == endpoints_.end()) {
+        return 0;
+    }
+
+    return it->second->idleConnections.size();
+}
+
+
+ClientConnection
+ClientPool::acquireConnection(const IPEndpoint &endpoint)
+{
+    std::unique_ptr<detail::ClientPoolEndpoint> &endpointSlot
+        = endpoints_[MakeEndpointKey(endpoint)];
+
+    if (endpointSlot == nullptr) {
+        endpointSlot.reset(new detail::ClientPoolEndpoint(
+            loop_, options_.maxNumberOfConnectionsPerEndpoint));
+    }
+
+    detail::ClientPoolEndpoint *endpointRecord = endpointSlot.get();
+    endpointRecord->semaphore.down();
+    Clock::time_point now = Clock::now();
+    evictIdleConnections(endpointRecord, now);
+
+    while (!endpointRecord->idleConnections.empty()) {
+        std::unique_ptr<detail::PooledConnection> pooledConnection
+            = std::move(endpointRecord->idleConnections.back());
+        endpointRecord->idleConnections.pop_back();
+
+        if (connectionIsHealthy(*pooledConnection, now)) {
+            return ClientConnection(this, pooledConnection.release());
+        }
+    }
+
+    try {
+        TCPSocket tcpSocket(loop_);
+        tcpSocket.connect(endpoint);
+        tcpSocket.setNoDelay(true);
+
+        return ClientConnection(this, new detail::PooledConnection(endpointRecord, options_
+                                                                   , std::move(tcpSocket)));
+    } catch (...) {
+        endpointRecord->semaphore.up();
+        throw;
+    }
+}
+
+
+std::uint64_t
+ClientPool::MakeEndpointKey(const IPEndpoint &endpoint) noexcept
+{
+    return std::uint64_t(endpoint.address.value) << 16 | endpoint.portNumber;
+}
+
+
+bool
+ClientPool::connectionIsHealthy(const detail::PooledConnection &pooledConnection
+                                , Clock::time_point now) const noexcept
+{
+    if (options_.maxIdleTime >= 1 && now - pooledConnection.lastUseTime
+                                     > std::chrono::milliseconds(options_.maxIdleTime)) {
+        return false;
+    }
+
+    char c;
+
+    if (::recv(pooledConnection.fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) >= 0) {
+        return false;
+    }
+
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+
+void
+ClientPool::evictIdleConnections(detail::ClientPoolEndpoint *endpoint, Clock::time_point now)
+    noexcept
+{
+    if (options_.maxIdleTime == 0) {
+        return;
+    }
+
+    while (!endpoint->idleConnections.empty()
+           && now - endpoint->idleConnections.front()->lastUseTime
+              > std::chrono::milliseconds(options_.maxIdleTime)) {
+        endpoint->idleConnections.pop_front();
+    }
+}
+
+
+void
+ClientPool::releaseConnection(detail::PooledConnection *pooledConnection) noexcept
+{
+    detail::ClientPoolEndpoint *endpoint = pooledConnection->endpoint;
+
+    if (pooledConnection->connection.isReusable() && pooledConnection->connection.isIdle()) {
+        pooledConnection->lastUseTime = Clock::now();
+        endpoint->idleConnections.emplace_back(pooledConnection);
+        evictIdleConnections(endpoint, pooledConnection->lastUseTime);
+    } else {
+        delete pooledConnection;
+    }
+
+    endpoint->semaphore.up();
+}
+
+
+void
+ClientPool::discardConnection(detail::PooledConnection *pooledConnection) noexcept
+{
+    detail::ClientPoolEndpoint *endpoint = pooledConnection->endpoint;
+    delete pooledConnection;
+    endpoint->semaphore.up();
+}
+
+} // namespace http
+
+} // namespace siren
@@ -1,40 +1,359 @@
 #include "connection.h"
 
-#include <functional>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
 #include <utility>
 
+#include "response.h"
+
 
 namespace siren {
 
 namespace http {
 
-Connection::Connection(const ConnectionOptions &options, TCPSocket &&tcpSocket)
+namespace {
+
+bool HeaderClosesConnection(const Header &) noexcept;
+bool streqi(const char *, const char *, const char *) noexcept;
+
+} // namespace
+
+
+Connection::Connection(const ConnectionOptions &options, TCPSocket &&tcpSocket
+                       , detail::TimerWheel *timerWheel, IOURing *ioURing)
   : options_(options),
     tcpSocket_(std::move(tcpSocket)),
-    parser_(options, &streams_[0], std::bind(&Connection::writeStream, this
-                                             , std::placeholders::_1)),
-    dumper_(&streams_[1], std::bind(&Connection::readStream, this, std::placeholders::_1))
+    ioURingSocket_(options.transport == ConnectionTransport::IOURing ? ioURing : nullptr
+                   , tcpSocket_.getFD(), options.receiveIsMultishot),
+    parser_(options, &inputStream_, detail::ConnectionStreamWriter(this)),
+    dumper_(options, &outputStream_, detail::ConnectionStreamReader(this)),
+    acceptedContentCoding_(ContentCoding::Identity),
+    writeSemaphore_(tcpSocket_.getLoop(), 1, 0, 1),
+    numberOfDeferredMessages_(0),
+    numberOfRequests_(0),
+    numberOfPendingResponses_(0),
+    isReusable_(true),
+    timerWheel_(timerWheel),
+    timer_(this),
+    deadline_(Deadline::None),
+    isTimedOut_(false)
+{
+    SIREN_ASSERT(timerWheel != nullptr || (options.headerTimeout == 0 && options.bodyTimeout == 0
+                                           && options.idleTimeout == 0));
+    SIREN_ASSERT(ioURing != nullptr || options.transport == ConnectionTransport::Socket);
+}
+
+
+void
+Connection::sendFile(int fd, off_t offset, std::size_t size)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(!dumper_.bodyIsChunked() && size <= dumper_.getRemainingBodySize());
+    dumper_.flush();
+    writeSemaphore_.down();
+
+    try {
+        for (std::size_t remainingSize = size; remainingSize >= 1;) {
+            ssize_t n = ::sendfile(tcpSocket_.getFD(), fd, &offset, remainingSize);
+
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                if (errno != EAGAIN) {
+                    throw std::system_error(errno, std::system_category(), "sendfile() failed");
+                }
+
+                std::size_t bufferSize = std::min(remainingSize, options_.minReadBufferSize);
+                outputStream_.reserveBuffer(bufferSize);
+                n = pread(fd, outputStream_.getBuffer(), bufferSize, offset);
+
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+
+                    throw std::system_error(errno, std::system_category(), "pread() failed");
+                }
+
+                if (n >= 1) {
+                    outputStream_.commitBuffer(n);
+                    writeSocket(&outputStream_);
+                    offset += n;
+                }
+            }
+
+            if (n == 0) {
+                throw std::runtime_error("file truncated");
+            }
+
+            remainingSize -= n;
+        }
+    } catch (...) {
+        writeSemaphore_.up();
+        throw;
+    }
+
+    writeSemaphore_.up();
+    dumper_.skipPayload(size);
+}
+
+
+PayloadReader
+Connection::makeDecompressedPayloadReader(ContentCoding contentCoding)
+{
+    if (!parser_.bodyIsChunked() && parser_.getRemainingBodyOrChunkSize() == 0) {
+        return PayloadReader(&parser_);
+    }
+
+    decompressor_.start(contentCoding, options_.maxBodySize);
+
+    try {
+        PayloadReader payloadReader(&parser_, &decompressor_);
+        payloadReader.readDecompressedData();
+        return payloadReader;
+    } catch (...) {
+        decompressor_.stop();
+        throw;
+    }
+}
+
+
+bool
+Connection::responseIsCompressible(const Response &response) const noexcept
 {
+    if (response.majorVersionNumber < 1
+        || (response.majorVersionNumber == 1 && response.minorVersionNumber < 1)) {
+        return false;
+    }
+
+    if (response.statusCode == StatusCode::NoContent
+        || response.statusCode == StatusCode::NotModified) {
+        return false;
+    }
+
+    bool headerHasContentEncoding = false;
+
+    response.header.traverse([&] (std::size_t, const char *headerFieldName, const char *)
+                             -> void {
+        if (std::strcmp(headerFieldName, "Content-Encoding") == 0) {
+            headerHasContentEncoding = true;
+        }
+    });
+
+    return !headerHasContentEncoding;
+}
+
+
+void
+Connection::updateReusability(const Header &header) noexcept
+{
+    if (HeaderClosesConnection(header)) {
+        isReusable_ = false;
+    }
+}
+
+
+bool
+Connection::bodyIsBuffered() const noexcept
+{
+    return !parser_.bodyIsChunked()
+           && parser_.getRemainingBodyOrChunkSize() <= inputStream_.getDataSize();
+}
+
+
+void
+Connection::setDeadline(Deadline deadline)
+{
+    deadline_ = deadline;
+
+    if (timerWheel_ == nullptr) {
+        return;
+    }
+
+    timerWheel_->removeTimer(&timer_);
+    long timeout;
+
+    switch (deadline) {
+    case Deadline::Header:
+        timeout = options_.headerTimeout;
+        break;
+
+    case Deadline::Body:
+        timeout = options_.bodyTimeout;
+        break;
+
+    case Deadline::Idle:
+        timeout = options_.idleTimeout;
+        break;
+
+    default:
+        timeout = 0;
+    }
+
+    if (timeout >= 1) {
+        timerWheel_->addTimer(&timer_, timeout);
+    }
+}
+
+
+void
+Connection::handleTimeout()
+{
+    if (deadline_ == Deadline::Body && bodyIsBuffered()) {
+        deadline_ = Deadline::None;
+        return;
+    }
+
+    deadline_ = Deadline::None;
+    isTimedOut_ = true;
+
+    try {
+        tcpSocket_.closeRead();
+    } catch (const std::system_error &) {
+    }
+}
+
+
+void
+Connection::deferResponse() noexcept
+{
+    if (numberOfDeferredMessages_ + 1 >= options_.maxPipelineDepth) {
+        return;
+    }
+
+    if (parser_.bodyIsChunked() || parser_.getRemainingBodyOrChunkSize() >= 1) {
+        return;
+    }
+
+    std::size_t dataSize = inputStream_.getDataSize();
+
+    if (dataSize == 0 || std::memchr(inputStream_.getData(), '\n', dataSize) == nullptr) {
+        return;
+    }
+
+    dumper_.deferFlush();
+    ++numberOfDeferredMessages_;
 }
 
 
 void
 Connection::readStream(Stream *stream)
 {
-    tcpSocket_.write(stream);
+    writeSemaphore_.down();
+
+    try {
+        writeSocket(stream);
+    } catch (...) {
+        writeSemaphore_.up();
+        throw;
+    }
+
+    writeSemaphore_.up();
+    numberOfDeferredMessages_ = 0;
 }
 
 
 void
 Connection::writeStream(Stream *stream)
 {
+    if (numberOfDeferredMessages_ >= 1 && writeSemaphore_.getValue() >= 1) {
+        dumper_.flush();
+    }
+
     stream->reserveBuffer(options_.minReadBufferSize);
 
-    if (tcpSocket_.read(stream) == 0) {
+    if (readSocket(stream) == 0) {
+        if (isTimedOut_) {
+            throw TimedOut();
+        }
+
         throw EndOfStream();
     }
+
+    if (deadline_ == Deadline::Idle) {
+        setDeadline(Deadline::Header);
+    } else if (deadline_ == Deadline::Body) {
+        setDeadline(bodyIsBuffered() ? Deadline::None : Deadline::Body);
+    }
+}
+
+
+std::size_t
+Connection::readSocket(Stream *stream)
+{
+    return ioURingSocket_.isValid() ? ioURingSocket_.read(stream) : tcpSocket_.read(stream);
+}
+
+
+void
+Connection::writeSocket(Stream *stream)
+{
+    if (ioURingSocket_.isValid()) {
+        ioURingSocket_.write(stream);
+    } else {
+        tcpSocket_.write(stream);
+    }
+}
+
+
+namespace {
+
+bool
+HeaderClosesConnection(const Header &header) noexcept
+{
+    bool connectionIsClosed = false;
+
+    header.traverse([&] (std::size_t, const char *headerFieldName, const char *headerFieldValue)
+                    -> void {
+        if (std::strcmp(headerFieldName, "Connection") != 0) {
+            return;
+        }
+
+        for (const char *s1 = headerFieldValue; *s1 != '\0';) {
+            while (*s1 == ',' || *s1 == ' ' || *s1 == '\t') {
+                ++s1;
+            }
+
+            const char *s2 = s1;
+
+            while (*s2 != '\0' && *s2 != ',' && *s2 != ' ' && *s2 != '\t') {
+                ++s2;
+            }
+
+            if (streqi(s1, s2, "close")) {
+                connectionIsClosed = true;
+            }
+
+            s1 = s2;
+        }
+    });
+
+    return connectionIsClosed;
 }
 
+
+bool
+streqi(const char *s1, const char *s2, const char *s) noexcept
+{
+    for (; s1 < s2; ++s1, ++s) {
+        if ((*s1 | 0x20) != (*s | 0x20)) {
+            return false;
+        }
+    }
+
+    return *s == '\0';
+}
+
+} // namespace
+
 } // namespace http
 
 } // namespace siren
@@ -0,0 +1,773 @@
+#include "content_coding.h"
+
+#include <zlib.h>
+
+#ifdef SIREN_HTTP_WITH_BROTLI
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+#endif
+
+#ifdef SIREN_HTTP_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include "header.h"
+#include "parser.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+struct CompressorState
+{
+    z_stream zStream;
+    bool zStreamIsInitialized;
+    int zStreamWindowBits;
+    int zStreamLevel;
+#ifdef SIREN_HTTP_WITH_BROTLI
+    BrotliEncoderState *brotliState;
+#endif
+#ifdef SIREN_HTTP_WITH_ZSTD
+    ZSTD_CCtx *zstdContext;
+#endif
+};
+
+
+struct DecompressorState
+{
+    z_stream zStream;
+    bool zStreamIsInitialized;
+#ifdef SIREN_HTTP_WITH_BROTLI
+    BrotliDecoderState *brotliState;
+#endif
+#ifdef SIREN_HTTP_WITH_ZSTD
+    ZSTD_DCtx *zstdContext;
+#endif
+};
+
+} // namespace detail
+
+
+namespace {
+
+const ContentCoding PreferredContentCodings[] = {
+    ContentCoding::Brotli,
+    ContentCoding::Zstd,
+    ContentCoding::Gzip,
+    ContentCoding::Deflate,
+};
+
+
+bool streqi(const char *, const char *, const char *) noexcept;
+int ParseQValue(const char *, const char *) noexcept;
+
+} // namespace
+
+
+const char *
+GetContentCodingName(ContentCoding contentCoding) noexcept
+{
+    static const char *const contentCodingNames[] = {
+        "identity",
+        "gzip",
+        "deflate",
+        "br",
+        "zstd",
+    };
+
+    return contentCodingNames[static_cast<int>(contentCoding)];
+}
+
+
+bool
+ContentCodingIsSupported(ContentCoding contentCoding) noexcept
+{
+    switch (contentCoding) {
+    case ContentCoding::Identity:
+    case ContentCoding::Gzip:
+    case ContentCoding::Deflate:
+        return true;
+
+#ifdef SIREN_HTTP_WITH_BROTLI
+    case ContentCoding::Brotli:
+        return true;
+#endif
+
+#ifdef SIREN_HTTP_WITH_ZSTD
+    case ContentCoding::Zstd:
+        return true;
+#endif
+
+    default:
+        return false;
+    }
+}
+
+
+ContentCoding
+NegotiateContentCoding(const Header &header) noexcept
+{
+    unsigned int contentCodingMask = 0;
+
+    for (ContentCoding contentCoding : PreferredContentCodings) {
+        if (ContentCodingIsSupported(contentCoding)) {
+            contentCodingMask |= 1U << static_cast<int>(contentCoding);
+        }
+    }
+
+    return NegotiateContentCoding(header, contentCodingMask);
+}
+
+
+ContentCoding
+NegotiateContentCoding(const Header &header, unsigned int contentCodingMask) noexcept
+{
+    int qValues[static_cast<int>(ContentCoding::Zstd) + 1];
+    std::fill(std::begin(qValues), std::end(qValues), -1);
+    int wildcardQValue = -1;
+
+    header.traverse([&] (std::size_t, const char *headerFieldName, const char *headerFieldValue)
+                    -> void {
+        if (std::strcmp(headerFieldName, "Accept-Encoding") != 0) {
+            return;
+        }
+
+        for (const char *s1 = headerFieldValue; *s1 != '\0';) {
+            while (*s1 == ',' || *s1 == ' ' || *s1 == '\t') {
+                ++s1;
+            }
+
+            const char *s2 = s1;
+
+            while (*s2 != '\0' && *s2 != ',' && *s2 != ';' && *s2 != ' ' && *s2 != '\t') {
+                ++s2;
+            }
+
+            const char *s3 = s2;
+
+            while (*s3 != '\0' && *s3 != ',') {
+                ++s3;
+            }
+
+            int qValue = ParseQValue(s2, s3);
+
+            if (s2 - s1 == 1 && *s1 == '*') {
+                wildcardQValue = qValue;
+            } else {
+                for (ContentCoding contentCoding : PreferredContentCodings) {
+                    if (streqi(s1, s2, GetContentCodingName(contentCoding))) {
+                        qValues[static_cast<int>(contentCoding)] = qValue;
+                    }
+                }
+            }
+
+            s1 = s3;
+        }
+    });
+
+    ContentCoding bestContentCoding = ContentCoding::Identity;
+    int bestQValue = 0;
+
+    for (ContentCoding contentCoding : PreferredContentCodings) {
+        if ((contentCodingMask & 1U << static_cast<int>(contentCoding)) == 0) {
+            continue;
+        }
+
+        int qValue = qValues[static_cast<int>(contentCoding)];
+
+        if (qValue < 0) {
+            qValue = wildcardQValue;
+        }
+
+        if (qValue > bestQValue) {
+            bestContentCoding = contentCoding;
+            bestQValue = qValue;
+        }
+    }
+
+    return bestContentCoding;
+}
+
+
+ContentCoding
+ExtractContentCoding(Header *header)
+{
+    ContentCoding contentCoding = ContentCoding::Identity;
+    std::vector<std::size_t> headerFieldIndexes;
+
+    header->traverse([&] (std::size_t headerFieldIndex, const char *headerFieldName
+                          , const char *headerFieldValue) -> void {
+        if (std::strcmp(headerFieldName, "Content-Encoding") != 0) {
+            return;
+        }
+
+        for (const char *s1 = headerFieldValue; *s1 != '\0';) {
+            while (*s1 == ',' || *s1 == ' ' || *s1 == '\t') {
+                ++s1;
+            }
+
+            const char *s2 = s1;
+
+            while (*s2 != '\0' && *s2 != ',' && *s2 != ' ' && *s2 != '\t') {
+                ++s2;
+            }
+
+            if (s2 == s1 || streqi(s1, s2, "identity")) {
+                s1 = s2;
+                continue;
+            }
+
+            if (contentCoding != ContentCoding::Identity) {
+                throw UnknownContentCoding();
+            }
+
+            if (streqi(s1, s2, "x-gzip")) {
+                contentCoding = ContentCoding::Gzip;
+            } else {
+                for (ContentCoding otherContentCoding : PreferredContentCodings) {
+                    if (streqi(s1, s2, GetContentCodingName(otherContentCoding))) {
+                        contentCoding = otherContentCoding;
+                    }
+                }
+
+                if (contentCoding == ContentCoding::Identity
+                    || !ContentCodingIsSupported(contentCoding)) {
+                    throw UnknownContentCoding();
+                }
+            }
+
+            s1 = s2;
+        }
+
+        headerFieldIndexes.push_back(headerFieldIndex);
+    });
+
+    for (std::size_t headerFieldIndex : headerFieldIndexes) {
+        header->removeField(headerFieldIndex);
+    }
+
+    return contentCoding;
+}
+
+
+namespace detail {
+
+Compressor::Compressor() noexcept
+  : state_(nullptr),
+    contentCoding_(ContentCoding::Identity),
+    isFinished_(false),
+    inputIsChunked_(false),
+    remainingInputSize_(0)
+{
+}
+
+
+Compressor::~Compressor()
+{
+    if (state_ == nullptr) {
+        return;
+    }
+
+    if (state_->zStreamIsInitialized) {
+        deflateEnd(&state_->zStream);
+    }
+
+#ifdef SIREN_HTTP_WITH_BROTLI
+    if (state_->brotliState != nullptr) {
+        BrotliEncoderDestroyInstance(state_->brotliState);
+    }
+#endif
+
+#ifdef SIREN_HTTP_WITH_ZSTD
+    ZSTD_freeCCtx(state_->zstdContext);
+#endif
+
+    delete state_;
+}
+
+
+void
+Compressor::start(ContentCoding contentCoding, int level, bool inputIsChunked
+                  , std::size_t inputSize)
+{
+    SIREN_ASSERT(contentCoding != ContentCoding::Identity);
+    SIREN_ASSERT(ContentCodingIsSupported(contentCoding));
+
+    if (state_ == nullptr) {
+        state_ = new CompressorState();
+    }
+
+    switch (contentCoding) {
+    case ContentCoding::Gzip:
+    case ContentCoding::Deflate:
+    {
+        int windowBits = contentCoding == ContentCoding::Gzip ? 15 + 16 : 15;
+        int zLevel = level < 0 ? Z_DEFAULT_COMPRESSION : std::min(level, Z_BEST_COMPRESSION);
+
+        if (state_->zStreamIsInitialized && (state_->zStreamWindowBits != windowBits
+                                             || state_->zStreamLevel != zLevel)) {
+            deflateEnd(&state_->zStream);
+            state_->zStreamIsInitialized = false;
+        }
+
+        if (state_->zStreamIsInitialized) {
+            deflateReset(&state_->zStream);
+        } else {
+            state_->zStream = z_stream();
+
+            if (deflateInit2(&state_->zStream, zLevel, Z_DEFLATED, windowBits, 8
+                             , Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::runtime_error("deflateInit2() failed");
+            }
+
+            state_->zStreamIsInitialized = true;
+            state_->zStreamWindowBits = windowBits;
+            state_->zStreamLevel = zLevel;
+        }
+
+        break;
+    }
+
+#ifdef SIREN_HTTP_WITH_BROTLI
+    case ContentCoding::Brotli:
+        if (state_->brotliState != nullptr) {
+            BrotliEncoderDestroyInstance(state_->brotliState);
+        }
+
+        state_->brotliState = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+
+        if (state_->brotliState == nullptr) {
+            throw std::runtime_error("BrotliEncoderCreateInstance() failed");
+        }
+
+        BrotliEncoderSetParameter(state_->brotliState, BROTLI_PARAM_QUALITY
+                                  , level < 0 ? 5 : std::min(level, BROTLI_MAX_QUALITY));
+
+        if (!inputIsChunked) {
+            BrotliEncoderSetParameter(state_->brotliState, BROTLI_PARAM_SIZE_HINT
+                                      , std::min<std::size_t>(inputSize, 1U << 30));
+        }
+
+        break;
+#endif
+
+#ifdef SIREN_HTTP_WITH_ZSTD
+    case ContentCoding::Zstd:
+        if (state_->zstdContext == nullptr) {
+            state_->zstdContext = ZSTD_createCCtx();
+
+            if (state_->zstdContext == nullptr) {
+                throw std::runtime_error("ZSTD_createCCtx() failed");
+            }
+        } else {
+            ZSTD_CCtx_reset(state_->zstdContext, ZSTD_reset_session_only);
+        }
+
+        ZSTD_CCtx_setParameter(state_->zstdContext, ZSTD_c_compressionLevel
+                               , level < 0 ? 3 : std::min(level, ZSTD_maxCLevel()));
+
+        if (!inputIsChunked) {
+            ZSTD_CCtx_setPledgedSrcSize(state_->zstdContext, inputSize);
+        }
+
+        break;
+#endif
+
+    default:
+        SIREN_ASSERT(false);
+    }
+
+    contentCoding_ = contentCoding;
+    isFinished_ = false;
+    inputIsChunked_ = inputIsChunked;
+    remainingInputSize_ = inputIsChunked ? 0 : inputSize;
+}
+
+
+char *
+Compressor::reserveInputBuffer(std::size_t inputBufferSize)
+{
+    SIREN_ASSERT(isActive());
+    SIREN_ASSERT(inputIsChunked_ || inputBufferSize <= remainingInputSize_);
+
+    if (inputBuffer_.size() < inputBufferSize) {
+        inputBuffer_.resize(inputBufferSize);
+    }
+
+    return &inputBuffer_[0];
+}
+
+
+bool
+Compressor::commitInput(std::size_t inputSize) noexcept
+{
+    SIREN_ASSERT(isActive());
+
+    if (inputIsChunked_) {
+        return inputSize == 0;
+    } else {
+        SIREN_ASSERT(inputSize <= remainingInputSize_);
+        remainingInputSize_ -= inputSize;
+        return remainingInputSize_ == 0;
+    }
+}
+
+
+std::size_t
+Compressor::getMaxOutputSize(std::size_t inputSize) const noexcept
+{
+    return std::max<std::size_t>(inputSize + inputSize / 8 + 64, 4096);
+}
+
+
+std::pair<std::size_t, std::size_t>
+Compressor::compress(const char *input, std::size_t inputSize, char *output
+                     , std::size_t outputSize, bool inputIsFinal)
+{
+    SIREN_ASSERT(isActive());
+    SIREN_ASSERT(!isFinished_);
+
+    switch (contentCoding_) {
+    case ContentCoding::Gzip:
+    case ContentCoding::Deflate:
+    {
+        z_stream *zStream = &state_->zStream;
+        inputSize = std::min<std::size_t>(inputSize, UINT_MAX);
+        outputSize = std::min<std::size_t>(outputSize, UINT_MAX);
+        zStream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input));
+        zStream->avail_in = inputSize;
+        zStream->next_out = reinterpret_cast<Bytef *>(output);
+        zStream->avail_out = outputSize;
+        int result = deflate(zStream, inputIsFinal ? Z_FINISH : Z_NO_FLUSH);
+
+        if (result == Z_STREAM_END) {
+            isFinished_ = true;
+        } else if (result != Z_OK && result != Z_BUF_ERROR) {
+            throw std::runtime_error("deflate() failed");
+        }
+
+        return {inputSize - zStream->avail_in, outputSize - zStream->avail_out};
+    }
+
+#ifdef SIREN_HTTP_WITH_BROTLI
+    case ContentCoding::Brotli:
+    {
+        const std::uint8_t *nextInput = reinterpret_cast<const std::uint8_t *>(input);
+        std::size_t availableInput = inputSize;
+        std::uint8_t *nextOutput = reinterpret_cast<std::uint8_t *>(output);
+        std::size_t availableOutput = outputSize;
+
+        if (!BrotliEncoderCompressStream(state_->brotliState, inputIsFinal
+                                         ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_PROCESS
+                                         , &availableInput, &nextInput, &availableOutput
+                                         , &nextOutput, nullptr)) {
+            throw std::runtime_error("BrotliEncoderCompressStream() failed");
+        }
+
+        isFinished_ = inputIsFinal && BrotliEncoderIsFinished(state_->brotliState);
+        return {inputSize - availableInput, outputSize - availableOutput};
+    }
+#endif
+
+#ifdef SIREN_HTTP_WITH_ZSTD
+    case ContentCoding::Zstd:
+    {
+        ZSTD_inBuffer inBuffer = {input, inputSize, 0};
+        ZSTD_outBuffer outBuffer = {output, outputSize, 0};
+        std::size_t result = ZSTD_compressStream2(state_->zstdContext, &outBuffer, &inBuffer
+                                                  , inputIsFinal ? ZSTD_e_end : ZSTD_e_continue);
+
+        if (ZSTD_isError(result)) {
+            throw std::runtime_error("ZSTD_compressStream2() failed");
+        }
+
+        isFinished_ = inputIsFinal && result == 0;
+        return {inBuffer.pos, outBuffer.pos};
+    }
+#endif
+
+    default:
+        SIREN_ASSERT(false);
+        return {0, 0};
+    }
+}
+
+
+void
+Compressor::stop() noexcept
+{
+    contentCoding_ = ContentCoding::Identity;
+}
+
+
+Decompressor::Decompressor() noexcept
+  : state_(nullptr),
+    contentCoding_(ContentCoding::Identity),
+    isFinished_(false),
+    remainingOutputSize_(0),
+    dataOffset_(0),
+    dataSize_(0)
+{
+}
+
+
+Decompressor::~Decompressor()
+{
+    if (state_ == nullptr) {
+        return;
+    }
+
+    if (state_->zStreamIsInitialized) {
+        inflateEnd(&state_->zStream);
+    }
+
+#ifdef SIREN_HTTP_WITH_BROTLI
+    if (state_->brotliState != nullptr) {
+        BrotliDecoderDestroyInstance(state_->brotliState);
+    }
+#endif
+
+#ifdef SIREN_HTTP_WITH_ZSTD
+    ZSTD_freeDCtx(state_->zstdContext);
+#endif
+
+    delete state_;
+}
+
+
+void
+Decompressor::start(ContentCoding contentCoding, std::size_t maxOutputSize)
+{
+    SIREN_ASSERT(contentCoding != ContentCoding::Identity);
+    SIREN_ASSERT(ContentCodingIsSupported(contentCoding));
+
+    if (state_ == nullptr) {
+        state_ = new DecompressorState();
+    }
+
+    switch (contentCoding) {
+    case ContentCoding::Gzip:
+    case ContentCoding::Deflate:
+        if (state_->zStreamIsInitialized) {
+            inflateReset(&state_->zStream);
+        } else {
+            state_->zStream = z_stream();
+
+            if (inflateInit2(&state_->zStream, 15 + 32) != Z_OK) {
+                throw std::runtime_error("inflateInit2() failed");
+            }
+
+            state_->zStreamIsInitialized = true;
+        }
+
+        break;
+
+#ifdef SIREN_HTTP_WITH_BROTLI
+    case ContentCoding::Brotli:
+        if (state_->brotliState != nullptr) {
+            BrotliDecoderDestroyInstance(state_->brotliState);
+        }
+
+        state_->brotliState = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+
+        if (state_->brotliState == nullptr) {
+            throw std::runtime_error("BrotliDecoderCreateInstance() failed");
+        }
+
+        break;
+#endif
+
+#ifdef SIREN_HTTP_WITH_ZSTD
+    case ContentCoding::Zstd:
+        if (state_->zstdContext == nullptr) {
+            state_->zstdContext = ZSTD_createDCtx();
+
+            if (state_->zstdContext == nullptr) {
+                throw std::runtime_error("ZSTD_createDCtx() failed");
+            }
+        } else {
+            ZSTD_DCtx_reset(state_->zstdContext, ZSTD_reset_session_only);
+        }
+
+        break;
+#endif
+
+    default:
+        SIREN_ASSERT(false);
+    }
+
+    buffer_.resize(DecompressorBufferSize);
+    contentCoding_ = contentCoding;
+    isFinished_ = false;
+    remainingOutputSize_ = maxOutputSize;
+    dataOffset_ = 0;
+    dataSize_ = 0;
+}
+
+
+std::size_t
+Decompressor::decompress(const char *input, std::size_t inputSize)
+{
+    SIREN_ASSERT(isActive());
+    SIREN_ASSERT(!isFinished_);
+    SIREN_ASSERT(dataSize_ == 0);
+    char *output = &buffer_[0];
+    std::size_t outputSize = buffer_.size();
+    std::size_t inputSizeUsed;
+    std::size_t outputSizeUsed;
+
+    switch (contentCoding_) {
+    case ContentCoding::Gzip:
+    case ContentCoding::Deflate:
+    {
+        z_stream *zStream = &state_->zStream;
+        inputSize = std::min<std::size_t>(inputSize, UINT_MAX);
+        zStream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input));
+        zStream->avail_in = inputSize;
+        zStream->next_out = reinterpret_cast<Bytef *>(output);
+        zStream->avail_out = outputSize;
+        int result = inflate(zStream, Z_NO_FLUSH);
+
+        if (result == Z_STREAM_END) {
+            isFinished_ = true;
+        } else if (result != Z_OK && result != Z_BUF_ERROR) {
+            throw InvalidMessage();
+        }
+
+        inputSizeUsed = inputSize - zStream->avail_in;
+        outputSizeUsed = outputSize - zStream->avail_out;
+        break;
+    }
+
+#ifdef SIREN_HTTP_WITH_BROTLI
+    case ContentCoding::Brotli:
+    {
+        const std::uint8_t *nextInput = reinterpret_cast<const std::uint8_t *>(input);
+        std::size_t availableInput = inputSize;
+        std::uint8_t *nextOutput = reinterpret_cast<std::uint8_t *>(output);
+        std::size_t availableOutput = outputSize;
+        BrotliDecoderResult result = BrotliDecoderDecompressStream(state_->brotliState
+                                                                   , &availableInput
+                                                                   , &nextInput
+                                                                   , &availableOutput
+                                                                   , &nextOutput, nullptr);
+
+        if (result == BROTLI_DECODER_RESULT_SUCCESS) {
+            isFinished_ = true;
+        } else if (result == BROTLI_DECODER_RESULT_ERROR) {
+            throw InvalidMessage();
+        }
+
+        inputSizeUsed = inputSize - availableInput;
+        outputSizeUsed = outputSize - availableOutput;
+        break;
+    }
+#endif
+
+#ifdef SIREN_HTTP_WITH_ZSTD
+    case ContentCoding::Zstd:
+    {
+        ZSTD_inBuffer inBuffer = {input, inputSize, 0};
+        ZSTD_outBuffer outBuffer = {output, outputSize, 0};
+        std::size_t result = ZSTD_decompressStream(state_->zstdContext, &outBuffer, &inBuffer);
+
+        if (ZSTD_isError(result)) {
+            throw InvalidMessage();
+        }
+
+        isFinished_ = result == 0;
+        inputSizeUsed = inBuffer.pos;
+        outputSizeUsed = outBuffer.pos;
+        break;
+    }
+#endif
+
+    default:
+        SIREN_ASSERT(false);
+        inputSizeUsed = 0;
+        outputSizeUsed = 0;
+    }
+
+    if (outputSizeUsed > remainingOutputSize_) {
+        throw BodyTooLarge();
+    }
+
+    remainingOutputSize_ -= outputSizeUsed;
+    dataOffset_ = 0;
+    dataSize_ = outputSizeUsed;
+    return inputSizeUsed;
+}
+
+
+void
+Decompressor::stop() noexcept
+{
+    contentCoding_ = ContentCoding::Identity;
+    dataOffset_ = 0;
+    dataSize_ = 0;
+}
+
+} // namespace detail
+
+
+namespace {
+
+bool
+streqi(const char *s1, const char *s2, const char *s) noexcept
+{
+    for (; s1 < s2; ++s1, ++s) {
+        if ((*s1 | 0x20) != (*s | 0x20)) {
+            return false;
+        }
+    }
+
+    return *s == '\0';
+}
+
+
+int
+ParseQValue(const char *s1, const char *s2) noexcept
+{
+    for (const char *s = s1; s < s2; ++s) {
+        if ((*s != 'q' && *s != 'Q') || s + 1 >= s2 || s[1] != '=') {
+            continue;
+        }
+
+        s += 2;
+
+        if (s >= s2 || (*s != '0' && *s != '1')) {
+            return 0;
+        }
+
+        int qValue = (*s++ - '0') * 1000;
+
+        if (s < s2 && *s == '.') {
+            ++s;
+
+            for (int k = 100; k >= 1 && s < s2 && *s >= '0' && *s <= '9'; k /= 10, ++s) {
+                qValue += (*s - '0') * k;
+            }
+        }
+
+        return std::min(qValue, 1000);
+    }
+
+    return 1000;
+}
+
+} // namespace
+
+} // namespace http
+
+} // namespace siren
@@ -15,311 +15,304 @@ namespace siren {
 
 namespace http {
 
-Dumper::Dumper(Dumper &&other) noexcept
-  : outputStream_(std::move(other.outputStream_))
+namespace detail {
+
+std::size_t
+DumperBase::GetMaxRequestStartLineSize(const Request &request) noexcept
 {
-    other.move(this);
+    return std::strlen(GetMethodName(request.methodType)) +
+           SIREN_STRLEN(" ") +
+           std::strlen(request.uri.getSchemeName()) +
+           SIREN_STRLEN("://") +
+           std::strlen(request.uri.getUserInfo()) +
+           SIREN_STRLEN("@") +
+           std::strlen(request.uri.getHostName()) +
+           SIREN_STRLEN(":") +
+           std::numeric_limits<std::uint16_t>::digits10 +
+           std::strlen(request.uri.getPathName()) +
+           SIREN_STRLEN("?") +
+           std::strlen(request.uri.getQueryString()) +
+           SIREN_STRLEN("#") +
+           std::strlen(request.uri.getFragmentID()) +
+           SIREN_STRLEN(" ") +
+           SIREN_STRLEN("HTTP/") +
+           std::numeric_limits<unsigned short>::digits10 +
+           SIREN_STRLEN(".") +
+           std::numeric_limits<unsigned short>::digits10 +
+           SIREN_STRLEN("\r\n");
 }
 
 
-Dumper &
-Dumper::operator=(Dumper &&other) noexcept
+char *
+DumperBase::DumpRequestStartLine(const Request &request, char *s) noexcept
 {
-    if (&other != this) {
-        outputStream_ = std::move(other.outputStream_);
-        other.move(this);
-    }
+    const char *methodName = GetMethodName(request.methodType);
+    const char *schemeName = request.uri.getSchemeName();
+    const char *userInfo = request.uri.getUserInfo();
+    const char *hostName = request.uri.getHostName();
+    const char *pathName = request.uri.getPathName();
+    const char *queryString = request.uri.getQueryString();
+    const char *fragmentID = request.uri.getFragmentID();
 
-    return *this;
-}
+    s += std::sprintf(s, "%s ", methodName);
+
+    if (*pathName == '\0') {
+        *s++ = '*';
+    } else {
+        if (*schemeName != '\0') {
+            s += std::sprintf(s, "%s://", schemeName);
 
+            if (*userInfo != '\0') {
+                s += std::sprintf(s, "%s@", userInfo);
+            }
 
-void
-Dumper::initialize() noexcept
-{
-    bodyIsChunked_ = false;
-    remainingBodySize_ = 0;
-}
+            s += std::sprintf(s, "%s", hostName);
 
+            if (request.uri.portNumber >= 0) {
+                s += std::sprintf(s, ":%" PRIu16, request.uri.portNumber);
+            }
+        }
 
-void
-Dumper::move(Dumper *other) noexcept
-{
-    other->bodyIsChunked_ = bodyIsChunked_;
+        s += std::sprintf(s, "%s", pathName);
 
-    if (!bodyIsChunked_) {
-        other->remainingBodySize_ = remainingBodySize_;
+        if (*queryString != '\0') {
+            s += std::sprintf(s, "?%s", queryString);
+        }
+
+        if (*fragmentID != '\0') {
+            s += std::sprintf(s, "#%s", fragmentID);
+        }
     }
+
+    s += std::sprintf(s, " HTTP/%hu.%hu", request.majorVersionNumber, request.minorVersionNumber);
+    *s++ = '\r';
+    *s++ = '\n';
+    return s;
 }
 
 
-void
-Dumper::putRequest(const Request &request)
+std::size_t
+DumperBase::GetMaxResponseStartLineSize(const Response &response) noexcept
 {
-    SIREN_ASSERT(isValid());
-    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
-    dumpRequestStartLine(request);
-    dumpHeader(request.header, true, -1);
-    bodyIsChunked_ = true;
+    return SIREN_STRLEN("HTTP/") +
+           std::numeric_limits<unsigned short>::digits10 +
+           SIREN_STRLEN(".") +
+           std::numeric_limits<unsigned short>::digits10 +
+           SIREN_STRLEN(" ") +
+           std::numeric_limits<int>::digits10 +
+           SIREN_STRLEN(" ") +
+           response.reasonPhrase.size() +
+           SIREN_STRLEN("\r\n");
 }
 
 
-void
-Dumper::putRequest(const Request &request, std::size_t bodySize)
+char *
+DumperBase::DumpResponseStartLine(const Response &response, char *s) noexcept
 {
-    SIREN_ASSERT(isValid());
-    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
-    dumpRequestStartLine(request);
-    dumpHeader(request.header, false, bodySize);
-    bodyIsChunked_ = false;
-    remainingBodySize_ = bodySize;
+    s += std::sprintf(s, "HTTP/%hu.%hu %d %s", response.majorVersionNumber
+                      , response.minorVersionNumber, static_cast<int>(response.statusCode)
+                      , response.reasonPhrase.c_str());
+    *s++ = '\r';
+    *s++ = '\n';
+    return s;
 }
 
 
-void
-Dumper::putResponse(const Response &response)
+std::size_t
+DumperBase::GetMaxHeaderSize(const Header &header, bool bodyIsChunked, std::size_t bodySize
+                             , const char *connectionToken, const char *contentCodingName)
+    noexcept
 {
-    SIREN_ASSERT(isValid());
-    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
-    dumpResponseStartLine(response);
-    dumpHeader(response.header, true, -1);
-    bodyIsChunked_ = true;
-}
+    std::size_t n = 0;
 
+    if (connectionToken != nullptr) {
+        n += SIREN_STRLEN("Connection: ") + std::strlen(connectionToken) + SIREN_STRLEN("\r\n");
+    }
 
-void
-Dumper::putResponse(const Response &response, std::size_t bodySize)
-{
-    SIREN_ASSERT(isValid());
-    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
-    dumpResponseStartLine(response);
-    dumpHeader(response.header, false, bodySize);
-    bodyIsChunked_ = false;
-    remainingBodySize_ = bodySize;
+    if (contentCodingName != nullptr) {
+        n += SIREN_STRLEN("Content-Encoding: ") + std::strlen(contentCodingName)
+             + SIREN_STRLEN("\r\n") + SIREN_STRLEN("Vary: Accept-Encoding\r\n");
+    }
+
+    if (bodyIsChunked) {
+        n += SIREN_STRLEN("Transfer-Encoding: chunked\r\n");
+    } else {
+        if (bodySize >= 1) {
+            constexpr unsigned int k = (std::numeric_limits<std::size_t>::digits + 2) / 3;
+
+            n += SIREN_STRLEN("Content-Length: ") + k + SIREN_STRLEN("\r\n");
+        }
+    }
+
+    header.traverseEdits([&] (const char *, std::size_t rawSize) -> void {
+        n += rawSize;
+    }, [&] (std::size_t, const char *headerFieldName, const char *headerFieldValue) -> void {
+        n += std::strlen(headerFieldName) + SIREN_STRLEN(": ") + std::strlen(headerFieldValue)
+             + SIREN_STRLEN("\r\n");
+    });
+
+    n += SIREN_STRLEN("\r\n");
+    return n;
 }
 
 
 char *
-Dumper::reservePayloadBuffer(std::size_t payloadBufferSize)
+DumperBase::DumpHeader(const Header &header, bool bodyIsChunked, std::size_t bodySize
+                       , const char *connectionToken, const char *contentCodingName, char *s)
+    noexcept
 {
-    SIREN_ASSERT(isValid());
-    char *payloadBuffer;
+    if (connectionToken != nullptr) {
+        s += std::sprintf(s, "Connection: %s", connectionToken);
+        *s++ = '\r';
+        *s++ = '\n';
+    }
 
-    if (bodyIsChunked_) {
-        constexpr unsigned int k = (std::numeric_limits<std::size_t>::digits + 3) / 4;
+    if (contentCodingName != nullptr) {
+        if (std::strcmp(contentCodingName, "identity") != 0) {
+            s += std::sprintf(s, "Content-Encoding: %s", contentCodingName);
+            *s++ = '\r';
+            *s++ = '\n';
+        }
+
+        s += std::sprintf(s, "Vary: Accept-Encoding");
+        *s++ = '\r';
+        *s++ = '\n';
+    }
 
-        outputStream_.reserveBuffer(k + SIREN_STRLEN("\r\n") + payloadBufferSize
-                                    + SIREN_STRLEN("\r\n"));
-        payloadBuffer = outputStream_.getBuffer() + k + SIREN_STRLEN("\r\n");
+    if (bodyIsChunked) {
+        s += std::sprintf(s, "Transfer-Encoding: chunked");
+        *s++ = '\r';
+        *s++ = '\n';
     } else {
-        SIREN_ASSERT(payloadBufferSize <= remainingBodySize_);
-        outputStream_.reserveBuffer(payloadBufferSize);
-        payloadBuffer = outputStream_.getBuffer();
+        if (bodySize >= 1) {
+            s += std::sprintf(s, "Content-Length: %zo", bodySize);
+            *s++ = '\r';
+            *s++ = '\n';
+        }
     }
 
-    return payloadBuffer;
+    header.traverseEdits([&] (const char *raw, std::size_t rawSize) -> void {
+        std::memcpy(s, raw, rawSize);
+        s += rawSize;
+    }, [&] (std::size_t, const char *headerFieldName, const char *headerFieldValue) -> void {
+        s += std::sprintf(s, "%s: %s", headerFieldName, headerFieldValue);
+        *s++ = '\r';
+        *s++ = '\n';
+    });
+
+    *s++ = '\r';
+    *s++ = '\n';
+    return s;
 }
 
 
-void
-Dumper::flushPayloadBuffer(std::size_t payloadBufferSize)
+char *
+DumperBase::DumpChunkSize(std::size_t chunkSize, char *s) noexcept
 {
-    SIREN_ASSERT(isValid());
-
-    if (bodyIsChunked_) {
-        constexpr unsigned int k = (std::numeric_limits<std::size_t>::digits + 3) / 4;
-
-        char *s1 = outputStream_.getBuffer();
-        char *s2 = s1;
-        s2 += std::sprintf(s2, "%0*zX", k, payloadBufferSize);
-        *s2++ = '\r';
-        *s2++ = '\n';
-        s2 += payloadBufferSize;
-        *s2++ = '\r';
-        *s2++ = '\n';
-        outputStream_.flushBuffer(s2 - s1);
-
-        if (payloadBufferSize == 0) {
-            bodyIsChunked_ = false;
+    constexpr unsigned int k = (std::numeric_limits<std::size_t>::digits + 3) / 4;
+
+    s += std::sprintf(s, "%0*zX", k, chunkSize);
+    *s++ = '\r';
+    *s++ = '\n';
+    return s;
+}
+
+
+const char *
+DumperBase::getConnectionToken(const Header &header, unsigned short majorVersionNumber
+                               , unsigned short minorVersionNumber) const noexcept
+{
+    if (connectionPersistence_ == ConnectionPersistence::Unspecified) {
+        return nullptr;
+    }
+
+    bool headerHasConnection = false;
+
+    header.traverse([&] (std::size_t, const char *headerFieldName, const char *) -> void {
+        if (std::strcmp(headerFieldName, "Connection") == 0) {
+            headerHasConnection = true;
         }
-    } else {
-        SIREN_ASSERT(payloadBufferSize <= remainingBodySize_);
-        outputStream_.flushBuffer(payloadBufferSize);
-        remainingBodySize_ -= payloadBufferSize;
+    });
+
+    if (headerHasConnection) {
+        return nullptr;
     }
+
+    return getConnectionToken(majorVersionNumber, minorVersionNumber);
 }
 
 
-void
-Dumper::dumpRequestStartLine(const Request &request)
+const char *
+DumperBase::getConnectionToken(unsigned short majorVersionNumber
+                               , unsigned short minorVersionNumber) const noexcept
 {
-    const char *methodName = GetMethodName(request.methodType);
-    const char *schemeName = request.uri.getSchemeName();
-    const char *userInfo = request.uri.getUserInfo();
-    const char *hostName = request.uri.getHostName();
-    const char *pathName = request.uri.getPathName();
-    const char *queryString = request.uri.getQueryString();
-    const char *fragmentID = request.uri.getFragmentID();
+    if (connectionPersistence_ == ConnectionPersistence::Unspecified) {
+        return nullptr;
+    }
 
-    outputStream_.reserveBuffer(
-        std::strlen(methodName) +
-        SIREN_STRLEN(" ") +
-        std::strlen(schemeName) +
-        SIREN_STRLEN("://") +
-        std::strlen(userInfo) +
-        SIREN_STRLEN("@") +
-        std::strlen(hostName) +
-        SIREN_STRLEN(":") +
-        std::numeric_limits<std::uint16_t>::digits10 +
-        std::strlen(pathName) +
-        SIREN_STRLEN("?") +
-        std::strlen(queryString) +
-        SIREN_STRLEN("#") +
-        std::strlen(fragmentID) +
-        SIREN_STRLEN(" ") +
-        SIREN_STRLEN("HTTP/") +
-        std::numeric_limits<unsigned short>::digits10 +
-        SIREN_STRLEN(".") +
-        std::numeric_limits<unsigned short>::digits10 +
-        SIREN_STRLEN("\r\n")
-    );
-
-    char *s1 = outputStream_.getBuffer();
-    char *s2 = s1;
-    s2 += std::sprintf(s2, "%s ", methodName);
+    bool connectionIsPersistentByDefault = majorVersionNumber > 1
+                                           || (majorVersionNumber == 1 && minorVersionNumber >= 1);
 
-    if (*pathName == '\0') {
-        *s2++ = '*';
+    if (connectionPersistence_ == ConnectionPersistence::KeepAlive) {
+        return connectionIsPersistentByDefault ? nullptr : "keep-alive";
     } else {
-        if (*schemeName != '\0') {
-            s2 += std::sprintf(s2, "%s://", schemeName);
+        return connectionIsPersistentByDefault ? "close" : nullptr;
+    }
+}
 
-            if (*userInfo != '\0') {
-                s2 += std::sprintf(s2, "%s@", userInfo);
-            }
 
-            s2 += std::sprintf(s2, "%s", hostName);
+DumperBase::DumperBase(const DumpOptions &options) noexcept
+  : options_(options)
+{
+    initialize();
+}
 
-            if (request.uri.portNumber >= 0) {
-                s2 += std::sprintf(s2, ":%" PRIu16, request.uri.portNumber);
-            }
-        }
 
-        s2 += std::sprintf(s2, "%s", pathName);
+DumperBase::DumperBase(DumperBase &&other) noexcept
+  : options_(other.options_)
+{
+    other.move(this);
+}
 
-        if (*queryString != '\0') {
-            s2 += std::sprintf(s2, "?%s", queryString);
-        }
 
-        if (*fragmentID != '\0') {
-            s2 += std::sprintf(s2, "#%s", fragmentID);
-        }
+DumperBase &
+DumperBase::operator=(DumperBase &&other) noexcept
+{
+    if (&other != this) {
+        options_ = other.options_;
+        other.move(this);
     }
 
-    s2 += std::sprintf(s2, " HTTP/%hu.%hu", request.majorVersionNumber, request.minorVersionNumber);
-    *s2++ = '\r';
-    *s2++ = '\n';
-    outputStream_.flushBuffer(s2 - s1);
+    return *this;
 }
 
 
 void
-Dumper::dumpResponseStartLine(const Response &response)
+DumperBase::initialize() noexcept
 {
-    outputStream_.reserveBuffer(
-        SIREN_STRLEN("HTTP/") +
-        std::numeric_limits<unsigned short>::digits10 +
-        SIREN_STRLEN(".") +
-        std::numeric_limits<unsigned short>::digits10 +
-        SIREN_STRLEN(" ") +
-        std::numeric_limits<int>::digits10 +
-        SIREN_STRLEN(" ") +
-        response.reasonPhrase.size() +
-        SIREN_STRLEN("\r\n")
-    );
-
-    char *s1 = outputStream_.getBuffer();
-    char *s2 = s1;
-    s2 += std::sprintf(s2, "HTTP/%hu.%hu %d %s", response.majorVersionNumber
-                       , response.minorVersionNumber, static_cast<int>(response.statusCode)
-                       , response.reasonPhrase.c_str());
-    *s2++ = '\r';
-    *s2++ = '\n';
-    outputStream_.flushBuffer(s2 - s1);
+    bodyIsChunked_ = false;
+    flushIsDeferred_ = false;
+    connectionPersistence_ = ConnectionPersistence::Unspecified;
+    contentCodingName_ = nullptr;
+    remainingBodySize_ = 0;
 }
 
 
 void
-Dumper::dumpHeader(const Header &header, bool bodyIsChunked, std::size_t bodySize)
+DumperBase::move(DumperBase *other) noexcept
 {
-    std::size_t n = 0;
-
-    if (bodyIsChunked) {
-        outputStream_.reserveBuffer(
-            n +
-            SIREN_STRLEN("Transfer-Encoding: chunked\r\n")
-        );
-
-        char *s1 = outputStream_.getBuffer() + n;
-        char *s2 = s1;
-        s2 += std::sprintf(s2, "Transfer-Encoding: chunked");
-        *s2++ = '\r';
-        *s2++ = '\n';
-        n += s2 - s1;
-    } else {
-        if (bodySize >= 1) {
-            constexpr unsigned int k = (std::numeric_limits<std::size_t>::digits + 2) / 3;
-
-            outputStream_.reserveBuffer(
-                n +
-                SIREN_STRLEN("Content-Length: ") +
-                k +
-                SIREN_STRLEN("\r\n")
-            );
-
-            char *s1 = outputStream_.getBuffer() + n;
-            char *s2 = s1;
-            s2 += std::sprintf(s2, "Content-Length: %zo", bodySize);
-            *s2++ = '\r';
-            *s2++ = '\n';
-            n += s2 - s1;
-        }
-    }
-
-    header.traverse([&] (std::size_t, const char *headerFieldName , const char *headerFieldValue)
-                    -> void {
-        outputStream_.reserveBuffer(
-            n +
-            std::strlen(headerFieldName) +
-            SIREN_STRLEN(": ") +
-            std::strlen(headerFieldValue) +
-            SIREN_STRLEN("\r\n")
-        );
-
-        char *s1 = outputStream_.getBuffer() + n;
-        char *s2 = s1;
-        s2 += std::sprintf(s2, "%s: %s", headerFieldName, headerFieldValue);
-        *s2++ = '\r';
-        *s2++ = '\n';
-        n += s2 - s1;
-    });
+    other->bodyIsChunked_ = bodyIsChunked_;
+    other->flushIsDeferred_ = flushIsDeferred_;
+    other->connectionPersistence_ = connectionPersistence_;
+    other->contentCodingName_ = contentCodingName_;
 
-    {
-        outputStream_.reserveBuffer(
-            n +
-            SIREN_STRLEN("\r\n")
-        );
-
-        char *s1 = outputStream_.getBuffer() + n;
-        char *s2 = s1;
-        *s2++ = '\r';
-        *s2++ = '\n';
-        n += s2 - s1;
+    if (!bodyIsChunked_) {
+        other->remainingBodySize_ = remainingBodySize_;
     }
-
-    outputStream_.flushBuffer(n);
 }
 
+} // namespace detail
+
 } // namespace http
 
 } // namespace siren
@@ -0,0 +1,295 @@
+#include "etag.h"
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include <siren/utility.h>
+
+#include "connection.h"
+#include "header.h"
+#include "request.h"
+#include "response.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace {
+
+struct CRC32CLookupTable
+{
+    std::uint32_t values[256];
+};
+
+
+constexpr CRC32CLookupTable MakeCRC32CLookupTable() noexcept;
+std::uint32_t UpdateCRC32CBySoftware(std::uint32_t, const unsigned char *, std::size_t)
+    noexcept;
+#if defined(__x86_64__)
+std::uint32_t UpdateCRC32CByHardware(std::uint32_t, const unsigned char *, std::size_t)
+    noexcept;
+#endif
+const char *SkipOpaqueTagPrefix(const char *) noexcept;
+bool ETagListContains(const char *, const char *) noexcept;
+
+} // namespace
+
+
+namespace detail {
+
+std::uint32_t
+UpdateCRC32C(std::uint32_t crc, const void *data, std::size_t dataSize) noexcept
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+#if defined(__x86_64__)
+    static const bool hardwareIsAvailable = __builtin_cpu_supports("sse4.2");
+
+    if (hardwareIsAvailable) {
+        return ~UpdateCRC32CByHardware(~crc, bytes, dataSize);
+    }
+#endif
+    return ~UpdateCRC32CBySoftware(~crc, bytes, dataSize);
+}
+
+
+bool
+ParseHTTPDate(const char *s, time_t *t) noexcept
+{
+    struct tm tm = {};
+    s = strptime(s, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+    if (s == nullptr || *s != '\0') {
+        return false;
+    }
+
+    *t = timegm(&tm);
+    return true;
+}
+
+} // namespace detail
+
+
+std::string
+ETagGenerator::getETag() const
+{
+    char eTag[32];
+    std::sprintf(eTag, "\"%08" PRIx32 "-%zx\"", crc_, size_);
+    return eTag;
+}
+
+
+std::string
+MakeETag(const void *data, std::size_t dataSize)
+{
+    ETagGenerator eTagGenerator;
+    eTagGenerator.update(data, dataSize);
+    return eTagGenerator.getETag();
+}
+
+
+bool
+ResourceIsNotModified(const Header &header, const char *eTag, const char *lastModified)
+    noexcept
+{
+    bool ifNoneMatchIsPresent = false;
+    bool eTagIsMatched = false;
+    const char *ifModifiedSince = nullptr;
+
+    header.traverse([&] (std::size_t, const char *headerFieldName, const char *headerFieldValue)
+                    -> void {
+        if (std::strcmp(headerFieldName, "If-None-Match") == 0) {
+            ifNoneMatchIsPresent = true;
+
+            if (eTag != nullptr && ETagListContains(headerFieldValue, eTag)) {
+                eTagIsMatched = true;
+            }
+        } else if (std::strcmp(headerFieldName, "If-Modified-Since") == 0) {
+            ifModifiedSince = headerFieldValue;
+        }
+    });
+
+    if (ifNoneMatchIsPresent) {
+        return eTagIsMatched;
+    }
+
+    if (ifModifiedSince == nullptr || lastModified == nullptr) {
+        return false;
+    }
+
+    time_t t1, t2;
+
+    if (!detail::ParseHTTPDate(ifModifiedSince, &t1)
+        || !detail::ParseHTTPDate(lastModified, &t2)) {
+        return false;
+    }
+
+    return t2 <= t1;
+}
+
+
+void
+DumpNotModifiedResponse(Connection *connection, Response *response, const char *eTag)
+{
+    response->statusCode = StatusCode::NotModified;
+    response->reasonPhrase = DescribeStatus(response->statusCode);
+
+    if (eTag != nullptr) {
+        response->header.addField("ETag", eTag);
+    }
+
+    connection->dumpResponse(*response, 0);
+}
+
+
+void
+DumpTaggedResponse(Connection *connection, const Request &request, Response *response
+                   , const void *body, std::size_t bodySize)
+{
+    std::string eTag = MakeETag(body, bodySize);
+
+    if ((request.methodType == MethodType::Get || request.methodType == MethodType::Head)
+        && ResourceIsNotModified(request.header, eTag.c_str(), nullptr)) {
+        DumpNotModifiedResponse(connection, response, eTag.c_str());
+        return;
+    }
+
+    response->header.addField("ETag", std::move(eTag));
+
+    if (request.methodType == MethodType::Head) {
+        char contentLength[32];
+        std::sprintf(contentLength, "%zo", bodySize);
+        response->header.addField("Content-Length", contentLength);
+        connection->dumpResponse(*response, 0);
+        return;
+    }
+
+    PayloadWriter payloadWriter = connection->dumpResponse(*response, bodySize);
+
+    if (bodySize >= 1) {
+        std::memcpy(payloadWriter.reserveBuffer(bodySize), body, bodySize);
+        payloadWriter.flushBuffer(bodySize);
+    }
+}
+
+
+namespace {
+
+constexpr CRC32CLookupTable
+MakeCRC32CLookupTable() noexcept
+{
+    CRC32CLookupTable table = {};
+
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        std::uint32_t value = i;
+
+        for (int j = 0; j < 8; ++j) {
+            value = (value & 1) == 0 ? value >> 1 : (value >> 1) ^ UINT32_C(0x82F63B78);
+        }
+
+        table.values[i] = value;
+    }
+
+    return table;
+}
+
+
+constexpr CRC32CLookupTable CRC32CTable = MakeCRC32CLookupTable();
+
+
+std::uint32_t
+UpdateCRC32CBySoftware(std::uint32_t crc, const unsigned char *bytes, std::size_t numberOfBytes)
+    noexcept
+{
+    for (std::size_t i = 0; i < numberOfBytes; ++i) {
+        crc = CRC32CTable.values[(crc ^ bytes[i]) & 0xFF] ^ crc >> 8;
+    }
+
+    return crc;
+}
+
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) std::uint32_t
+UpdateCRC32CByHardware(std::uint32_t crc, const unsigned char *bytes, std::size_t numberOfBytes)
+    noexcept
+{
+    std::uint64_t crc64 = crc;
+
+    for (; numberOfBytes >= 8; numberOfBytes -= 8) {
+        std::uint64_t x;
+        std::memcpy(&x, bytes, 8);
+        crc64 = _mm_crc32_u64(crc64, x);
+        bytes += 8;
+    }
+
+    crc = crc64;
+
+    for (; numberOfBytes >= 1; --numberOfBytes) {
+        crc = _mm_crc32_u8(crc, *bytes++);
+    }
+
+    return crc;
+}
+#endif
+
+
+const char *
+SkipOpaqueTagPrefix(const char *eTag) noexcept
+{
+    return std::strncmp(eTag, "W/", SIREN_STRLEN("W/")) == 0 ? eTag + SIREN_STRLEN("W/") : eTag;
+}
+
+
+bool
+ETagListContains(const char *eTagList, const char *eTag) noexcept
+{
+    const char *opaqueTag = SkipOpaqueTagPrefix(eTag);
+    std::size_t opaqueTagLength = std::strlen(opaqueTag);
+
+    for (const char *s1 = eTagList;;) {
+        while (*s1 == ',' || *s1 == ' ' || *s1 == '\t') {
+            ++s1;
+        }
+
+        if (*s1 == '\0') {
+            return false;
+        }
+
+        if (*s1 == '*') {
+            return true;
+        }
+
+        s1 = SkipOpaqueTagPrefix(s1);
+
+        if (*s1 != '"') {
+            return false;
+        }
+
+        const char *s2 = std::strchr(s1 + 1, '"');
+
+        if (s2 == nullptr) {
+            return false;
+        }
+
+        ++s2;
+
+        if (static_cast<std::size_t>(s2 - s1) == opaqueTagLength
+            && std::memcmp(s1, opaqueTag, opaqueTagLength) == 0) {
+            return true;
+        }
+
+        s1 = s2;
+    }
+}
+
+} // namespace
+
+} // namespace http
+
+} // namespace siren
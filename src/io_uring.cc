@@ -0,0 +1,663 @@
+#include "io_uring.h"
+
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <system_error>
+
+#include <siren/assert.h>
+#include <siren/loop.h>
+
+
+namespace siren {
+
+namespace http {
+
+namespace {
+
+const unsigned short ReceiveBufferGroupID = 0;
+
+
+int SetUpIOURing(unsigned int, io_uring_params *) noexcept;
+int EnterIOURing(int, unsigned int, unsigned int) noexcept;
+int RegisterIOURing(int, unsigned int, void *, unsigned int) noexcept;
+char *MapIOURing(int, std::size_t, off_t);
+std::size_t AlignSize(std::size_t, std::size_t) noexcept;
+void WaitForCompletions(detail::IOURingOperation *);
+detail::IOURingCompletion WaitForCompletion(detail::IOURingOperation *);
+
+} // namespace
+
+
+IOURing::IOURing(const IOURingOptions &options, Loop *loop)
+  : options_(options),
+    loop_(loop),
+    fd_(-1),
+    eventFD_(-1),
+    submissionRing_(nullptr),
+    submissionRingSize_(0),
+    completionRing_(nullptr),
+    completionRingSize_(0),
+    submissionEntries_(nullptr),
+    submissionEntriesSize_(0),
+    receiveBufferRing_(nullptr),
+    receiveBufferRingSize_(0),
+    receiveBuffers_(nullptr),
+    receiveBufferTail_(0),
+    numberOfUnsubmittedEntries_(0),
+    numberOfSockets_(0),
+    numberOfPendingOperations_(0),
+    submissionSemaphore_(loop, 0, 0, 1),
+    isStopping_(false),
+    isFinished_(false)
+{
+    SIREN_ASSERT(loop != nullptr);
+    SIREN_ASSERT(options_.submissionQueueSize >= 1);
+    SIREN_ASSERT(options_.numberOfReceiveBuffers <= 32768);
+    SIREN_ASSERT((options_.numberOfReceiveBuffers & (options_.numberOfReceiveBuffers - 1)) == 0);
+    SIREN_ASSERT(options_.receiveBufferSize >= 1 && options_.receiveBufferSize <= UINT_MAX);
+
+    try {
+        initialize();
+        setUpReceiveBuffers();
+    } catch (...) {
+        finalize();
+        throw;
+    }
+}
+
+
+IOURing::~IOURing()
+{
+    finalize();
+}
+
+
+void
+IOURing::run()
+{
+    SIREN_ASSERT(!isFinished_);
+    loop_->registerFD(eventFD_);
+
+    loop_->createFiber([this] () -> void {
+        submitEntries();
+    });
+
+    while (!isStopping_ || numberOfSockets_ >= 1 || numberOfPendingOperations_ >= 1) {
+        std::uint64_t counter;
+        loop_->read(eventFD_, &counter, sizeof(counter));
+        reapCompletions();
+    }
+
+    isFinished_ = true;
+    submissionSemaphore_.tryUp();
+    loop_->unregisterFD(eventFD_);
+}
+
+
+void
+IOURing::stop() noexcept
+{
+    isStopping_ = true;
+    wake();
+}
+
+
+void
+IOURing::initialize()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd_ = SetUpIOURing(options_.submissionQueueSize, &params);
+
+    if (fd_ < 0) {
+        throw std::system_error(errno, std::system_category(), "io_uring_setup() failed");
+    }
+
+    submissionRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    completionRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+        submissionRingSize_ = std::max(submissionRingSize_, completionRingSize_);
+        completionRingSize_ = 0;
+    }
+
+    submissionRing_ = MapIOURing(fd_, submissionRingSize_, IORING_OFF_SQ_RING);
+    completionRing_ = completionRingSize_ == 0
+                      ? submissionRing_
+                      : MapIOURing(fd_, completionRingSize_, IORING_OFF_CQ_RING);
+    submissionEntriesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    submissionEntries_ = reinterpret_cast<io_uring_sqe *>(MapIOURing(fd_, submissionEntriesSize_
+                                                                     , IORING_OFF_SQES));
+    submissionHead_ = reinterpret_cast<unsigned int *>(submissionRing_ + params.sq_off.head);
+    submissionTail_ = reinterpret_cast<unsigned int *>(submissionRing_ + params.sq_off.tail);
+    submissionFlags_ = reinterpret_cast<unsigned int *>(submissionRing_ + params.sq_off.flags);
+    submissionMask_ = *reinterpret_cast<unsigned int *>(submissionRing_
+                                                        + params.sq_off.ring_mask);
+    completionHead_ = reinterpret_cast<unsigned int *>(completionRing_ + params.cq_off.head);
+    completionTail_ = reinterpret_cast<unsigned int *>(completionRing_ + params.cq_off.tail);
+    completionMask_ = *reinterpret_cast<unsigned int *>(completionRing_
+                                                        + params.cq_off.ring_mask);
+    completionEntries_ = reinterpret_cast<io_uring_cqe *>(completionRing_ + params.cq_off.cqes);
+    auto submissionArray = reinterpret_cast<unsigned int *>(submissionRing_
+                                                            + params.sq_off.array);
+
+    for (unsigned int i = 0; i < params.sq_entries; ++i) {
+        submissionArray[i] = i;
+    }
+
+    eventFD_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (eventFD_ < 0) {
+        throw std::system_error(errno, std::system_category(), "eventfd() failed");
+    }
+
+    if (RegisterIOURing(fd_, IORING_REGISTER_EVENTFD, &eventFD_, 1) < 0) {
+        throw std::system_error(errno, std::system_category(), "io_uring_register() failed");
+    }
+}
+
+
+void
+IOURing::setUpReceiveBuffers()
+{
+    unsigned int numberOfBuffers = options_.numberOfReceiveBuffers;
+
+    if (numberOfBuffers == 0) {
+        return;
+    }
+
+    std::size_t ringSize = AlignSize(numberOfBuffers * sizeof(io_uring_buf)
+                                     , sysconf(_SC_PAGESIZE));
+    void *ring = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1
+                      , 0);
+
+    if (ring == MAP_FAILED) {
+        throw std::system_error(errno, std::system_category(), "mmap() failed");
+    }
+
+    receiveBufferRing_ = static_cast<io_uring_buf *>(ring);
+    receiveBufferRingSize_ = ringSize;
+    receiveBuffers_ = new char[numberOfBuffers * options_.receiveBufferSize];
+    io_uring_buf_reg bufferRegistration;
+    std::memset(&bufferRegistration, 0, sizeof(bufferRegistration));
+    bufferRegistration.ring_addr = reinterpret_cast<std::uintptr_t>(ring);
+    bufferRegistration.ring_entries = numberOfBuffers;
+    bufferRegistration.bgid = ReceiveBufferGroupID;
+
+    if (RegisterIOURing(fd_, IORING_REGISTER_PBUF_RING, &bufferRegistration, 1) < 0) {
+        if (errno != EINVAL) {
+            throw std::system_error(errno, std::system_category(), "io_uring_register() failed");
+        }
+
+        munmap(receiveBufferRing_, receiveBufferRingSize_);
+        receiveBufferRing_ = nullptr;
+        delete[] receiveBuffers_;
+        receiveBuffers_ = nullptr;
+        return;
+    }
+
+    for (unsigned int i = 0; i < numberOfBuffers; ++i) {
+        releaseReceiveBuffer(i);
+    }
+}
+
+
+void
+IOURing::finalize() noexcept
+{
+    if (receiveBufferRing_ != nullptr) {
+        munmap(receiveBufferRing_, receiveBufferRingSize_);
+    }
+
+    delete[] receiveBuffers_;
+
+    if (submissionEntries_ != nullptr) {
+        munmap(submissionEntries_, submissionEntriesSize_);
+    }
+
+    if (completionRing_ != nullptr && completionRing_ != submissionRing_) {
+        munmap(completionRing_, completionRingSize_);
+    }
+
+    if (submissionRing_ != nullptr) {
+        munmap(submissionRing_, submissionRingSize_);
+    }
+
+    if (eventFD_ >= 0) {
+        close(eventFD_);
+    }
+
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+
+void
+IOURing::wake() noexcept
+{
+    std::uint64_t counter = 1;
+    ::write(eventFD_, &counter, sizeof(counter));
+}
+
+
+void
+IOURing::submitEntries()
+{
+    for (;;) {
+        submissionSemaphore_.down();
+
+        if (numberOfUnsubmittedEntries_ >= 1) {
+            flushEntries();
+            reapCompletions();
+        } else if (isFinished_) {
+            return;
+        }
+    }
+}
+
+
+void
+IOURing::flushEntries()
+{
+    while (numberOfUnsubmittedEntries_ >= 1) {
+        int n = EnterIOURing(fd_, numberOfUnsubmittedEntries_, 0);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno == EAGAIN || errno == EBUSY) {
+                reapCompletions();
+                continue;
+            }
+
+            throw std::system_error(errno, std::system_category(), "io_uring_enter() failed");
+        }
+
+        numberOfUnsubmittedEntries_ -= n;
+    }
+}
+
+
+void
+IOURing::reapCompletions()
+{
+    for (;;) {
+        unsigned int head = *completionHead_;
+        unsigned int tail = __atomic_load_n(completionTail_, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; ++head) {
+            const io_uring_cqe &completionEntry = completionEntries_[head & completionMask_];
+            auto operation = reinterpret_cast<Operation *>(completionEntry.user_data);
+
+            if (operation == nullptr) {
+                continue;
+            }
+
+            if ((completionEntry.flags & IORING_CQE_F_MORE) == 0) {
+                operation->isPending = false;
+                --numberOfPendingOperations_;
+            }
+
+            if (operation->isOrphaned) {
+                if ((completionEntry.flags & IORING_CQE_F_BUFFER) != 0) {
+                    releaseReceiveBuffer(completionEntry.flags >> IORING_CQE_BUFFER_SHIFT);
+                }
+
+                if (!operation->isPending) {
+                    delete operation;
+                }
+
+                continue;
+            }
+
+            operation->completions.push_back({completionEntry.res, completionEntry.flags});
+            operation->semaphore.tryUp();
+        }
+
+        __atomic_store_n(completionHead_, head, __ATOMIC_RELEASE);
+
+        if ((__atomic_load_n(submissionFlags_, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) == 0
+            || EnterIOURing(fd_, 0, IORING_ENTER_GETEVENTS) < 0) {
+            return;
+        }
+    }
+}
+
+
+void
+IOURing::addEntry(Operation *operation, const io_uring_sqe &entry)
+{
+    unsigned int tail = *submissionTail_;
+
+    if (tail - __atomic_load_n(submissionHead_, __ATOMIC_ACQUIRE) > submissionMask_) {
+        flushEntries();
+    }
+
+    io_uring_sqe *submissionEntry = &submissionEntries_[tail & submissionMask_];
+    *submissionEntry = entry;
+    submissionEntry->user_data = reinterpret_cast<std::uintptr_t>(operation);
+    __atomic_store_n(submissionTail_, tail + 1, __ATOMIC_RELEASE);
+
+    if (operation != nullptr) {
+        operation->isPending = true;
+        ++numberOfPendingOperations_;
+    }
+
+    if (++numberOfUnsubmittedEntries_ == 1) {
+        submissionSemaphore_.tryUp();
+    }
+}
+
+
+const char *
+IOURing::getReceiveBuffer(unsigned int bufferID) const noexcept
+{
+    return receiveBuffers_ + bufferID * options_.receiveBufferSize;
+}
+
+
+void
+IOURing::releaseReceiveBuffer(unsigned int bufferID) noexcept
+{
+    io_uring_buf *buffer = &receiveBufferRing_[receiveBufferTail_
+                                               & (options_.numberOfReceiveBuffers - 1)];
+    buffer->addr = reinterpret_cast<std::uintptr_t>(getReceiveBuffer(bufferID));
+    buffer->len = options_.receiveBufferSize;
+    buffer->bid = bufferID;
+    ++receiveBufferTail_;
+    __atomic_store_n(&reinterpret_cast<io_uring_buf_ring *>(receiveBufferRing_)->tail
+                     , receiveBufferTail_, __ATOMIC_RELEASE);
+}
+
+
+bool
+IOURing::attachSocket() noexcept
+{
+    if (isFinished_) {
+        return false;
+    }
+
+    ++numberOfSockets_;
+    return true;
+}
+
+
+void
+IOURing::detachSocket() noexcept
+{
+    if (--numberOfSockets_ == 0 && isStopping_) {
+        wake();
+    }
+}
+
+
+namespace detail {
+
+IOURingSocket::IOURingSocket(IOURing *ioURing, int fd, bool receiveIsMultishot)
+  : ioURing_(ioURing != nullptr && ioURing->attachSocket() ? ioURing : nullptr),
+    fd_(fd),
+    receiveIsMultishot_(receiveIsMultishot && ioURing_ != nullptr
+                        && ioURing_->receiveBufferRing_ != nullptr),
+    receiveOperation_(nullptr),
+    sendOperation_(nullptr)
+{
+}
+
+
+IOURingSocket::~IOURingSocket()
+{
+    if (ioURing_ == nullptr) {
+        return;
+    }
+
+    releaseOperation(receiveOperation_);
+    releaseOperation(sendOperation_);
+    ioURing_->detachSocket();
+}
+
+
+std::size_t
+IOURingSocket::read(Stream *stream)
+{
+    SIREN_ASSERT(isValid());
+
+    if (receiveOperation_ == nullptr) {
+        receiveOperation_ = makeOperation();
+    }
+
+    return receiveIsMultishot_ ? receiveMultishot(stream) : receive(stream);
+}
+
+
+std::size_t
+IOURingSocket::write(Stream *stream)
+{
+    SIREN_ASSERT(isValid());
+
+    if (sendOperation_ == nullptr) {
+        sendOperation_ = makeOperation();
+    }
+
+    std::size_t dataSize = stream->getDataSize();
+    sendStream_.write(stream->getData(), dataSize);
+    stream->discardData(dataSize);
+
+    while (sendStream_.getDataSize() >= 1) {
+        io_uring_sqe entry{};
+        entry.opcode = IORING_OP_SEND;
+        entry.fd = fd_;
+        entry.addr = reinterpret_cast<std::uintptr_t>(sendStream_.getData());
+        entry.len = std::min<std::size_t>(sendStream_.getDataSize(), UINT_MAX);
+        entry.msg_flags = MSG_NOSIGNAL;
+        ioURing_->addEntry(sendOperation_, entry);
+        IOURingCompletion completion = WaitForCompletion(sendOperation_);
+
+        if (completion.result < 0) {
+            sendStream_.discardData(sendStream_.getDataSize());
+            throw std::system_error(-completion.result, std::system_category(), "send() failed");
+        }
+
+        sendStream_.discardData(completion.result);
+    }
+
+    return dataSize;
+}
+
+
+std::size_t
+IOURingSocket::receive(Stream *stream)
+{
+    io_uring_sqe entry{};
+    entry.opcode = IORING_OP_RECV;
+    entry.fd = fd_;
+    entry.addr = reinterpret_cast<std::uintptr_t>(stream->getBuffer());
+    entry.len = std::min<std::size_t>(stream->getBufferSize(), UINT_MAX);
+    ioURing_->addEntry(receiveOperation_, entry);
+    IOURingCompletion completion = WaitForCompletion(receiveOperation_);
+
+    if (completion.result < 0) {
+        throw std::system_error(-completion.result, std::system_category(), "recv() failed");
+    }
+
+    stream->commitBuffer(completion.result);
+    return completion.result;
+}
+
+
+std::size_t
+IOURingSocket::receiveMultishot(Stream *stream)
+{
+    Operation *operation = receiveOperation_;
+
+    if (!operation->isPending && operation->completions.empty()) {
+        io_uring_sqe entry{};
+        entry.opcode = IORING_OP_RECV;
+        entry.flags = IOSQE_BUFFER_SELECT;
+        entry.ioprio = IORING_RECV_MULTISHOT;
+        entry.fd = fd_;
+        entry.buf_group = ReceiveBufferGroupID;
+        ioURing_->addEntry(operation, entry);
+    }
+
+    WaitForCompletions(operation);
+    std::size_t dataSize = 0;
+
+    while (!operation->completions.empty()) {
+        IOURingCompletion completion = operation->completions.front();
+
+        if (completion.result <= 0 && dataSize >= 1) {
+            break;
+        }
+
+        if ((completion.flags & IORING_CQE_F_BUFFER) != 0) {
+            unsigned int bufferID = completion.flags >> IORING_CQE_BUFFER_SHIFT;
+
+            if (completion.result >= 1) {
+                stream->write(ioURing_->getReceiveBuffer(bufferID), completion.result);
+            }
+
+            ioURing_->releaseReceiveBuffer(bufferID);
+        }
+
+        operation->completions.pop_front();
+
+        if (completion.result < 0) {
+            if (completion.result == -EINVAL) {
+                receiveIsMultishot_ = false;
+                return receive(stream);
+            }
+
+            if (completion.result == -ENOBUFS) {
+                return receive(stream);
+            }
+
+            throw std::system_error(-completion.result, std::system_category(), "recv() failed");
+        }
+
+        if (completion.result == 0) {
+            return 0;
+        }
+
+        dataSize += completion.result;
+    }
+
+    return dataSize;
+}
+
+
+IOURingOperation *
+IOURingSocket::makeOperation()
+{
+    return new Operation(ioURing_->loop_);
+}
+
+
+void
+IOURingSocket::releaseOperation(Operation *operation)
+{
+    if (operation == nullptr) {
+        return;
+    }
+
+    for (const IOURingCompletion &completion : operation->completions) {
+        if ((completion.flags & IORING_CQE_F_BUFFER) != 0) {
+            ioURing_->releaseReceiveBuffer(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+        }
+    }
+
+    if (!operation->isPending) {
+        delete operation;
+        return;
+    }
+
+    operation->isOrphaned = true;
+    io_uring_sqe entry{};
+    entry.opcode = IORING_OP_ASYNC_CANCEL;
+    entry.fd = -1;
+    entry.addr = reinterpret_cast<std::uintptr_t>(operation);
+    ioURing_->addEntry(nullptr, entry);
+}
+
+} // namespace detail
+
+
+namespace {
+
+int
+SetUpIOURing(unsigned int numberOfEntries, io_uring_params *params) noexcept
+{
+    return syscall(__NR_io_uring_setup, numberOfEntries, params);
+}
+
+
+int
+EnterIOURing(int fd, unsigned int numberOfEntries, unsigned int flags) noexcept
+{
+    return syscall(__NR_io_uring_enter, fd, numberOfEntries, 0, flags, nullptr, 0);
+}
+
+
+int
+RegisterIOURing(int fd, unsigned int opcode, void *argument, unsigned int numberOfArguments)
+    noexcept
+{
+    return syscall(__NR_io_uring_register, fd, opcode, argument, numberOfArguments);
+}
+
+
+char *
+MapIOURing(int fd, std::size_t size, off_t offset)
+{
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd
+                        , offset);
+
+    if (memory == MAP_FAILED) {
+        throw std::system_error(errno, std::system_category(), "mmap() failed");
+    }
+
+    return static_cast<char *>(memory);
+}
+
+
+std::size_t
+AlignSize(std::size_t size, std::size_t alignment) noexcept
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+
+void
+WaitForCompletions(detail::IOURingOperation *operation)
+{
+    while (operation->completions.empty()) {
+        operation->semaphore.down();
+    }
+}
+
+
+detail::IOURingCompletion
+WaitForCompletion(detail::IOURingOperation *operation)
+{
+    WaitForCompletions(operation);
+    detail::IOURingCompletion completion = operation->completions.front();
+    operation->completions.pop_front();
+    return completion;
+}
+
+} // namespace
+
+} // namespace http
+
+} // namespace siren
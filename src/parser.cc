@@ -1,6 +1,7 @@
 #include "parser.h"
 
 #include <cstring>
+#include <initializer_list>
 #include <limits>
 
 #include <siren/utility.h>
@@ -28,19 +29,63 @@ namespace http {
 
 namespace {
 
-struct {
+struct CharFlag
+{
     unsigned char digit: 1;
     unsigned char hexdigit: 1;
     unsigned char octdigit: 1;
     unsigned char print: 1;
     unsigned char space: 1;
-} CharFlags[256];
+};
+
+
+struct CharFlagTable
+{
+    CharFlag entries[256];
+
+    constexpr const CharFlag &operator[](unsigned char c) const noexcept {
+        return entries[c];
+    }
+};
+
+
+constexpr CharFlagTable
+MakeCharFlagTable() noexcept
+{
+    CharFlagTable charFlagTable = {};
+
+    for (char c : {DIGIT}) {
+        charFlagTable.entries[static_cast<unsigned char>(c)].digit = 1;
+    }
+
+    for (char c : {HEXDIGIT}) {
+        charFlagTable.entries[static_cast<unsigned char>(c)].hexdigit = 1;
+    }
+
+    for (char c : {OCTDIGIT}) {
+        charFlagTable.entries[static_cast<unsigned char>(c)].octdigit = 1;
+    }
+
+    for (char c : {PRINT}) {
+        charFlagTable.entries[static_cast<unsigned char>(c)].print = 1;
+    }
+
+    for (char c : {SPACE}) {
+        charFlagTable.entries[static_cast<unsigned char>(c)].space = 1;
+    }
+
+    return charFlagTable;
+}
+
+
+constexpr CharFlagTable CharFlags = MakeCharFlagTable();
 
 
 char tolower(char) noexcept;
+bool streq(const char *, const char *, const char *) noexcept;
+bool streqi(const char *, const char *, const char *) noexcept;
 bool isprint(char) noexcept;
 bool isspace(char) noexcept;
-void InitializeCharFlags() noexcept;
 
 template <std::size_t N = 10>
 bool isdigit(char) noexcept;
@@ -69,63 +114,65 @@ int digit2int<16>(char) noexcept;
 } // namespace
 
 
+namespace detail {
+
 MethodType
-Parser::ParseMethod(const char *s)
+ParserBase::ParseMethod(const char *s1, const char *s2)
 {
-    switch (*s) {
+    switch (*s1) {
     case 'C':
-        if (std::strcmp(s + 1, "ONNECT") == 0) {
+        if (streq(s1 + 1, s2, "ONNECT")) {
             return MethodType::Connect;
         } else {
             break;
         }
 
     case 'D':
-        if (std::strcmp(s + 1, "ELETE") == 0) {
+        if (streq(s1 + 1, s2, "ELETE")) {
             return MethodType::Delete;
         } else {
             break;
         }
 
     case 'G':
-        if (std::strcmp(s + 1, "ET") == 0) {
+        if (streq(s1 + 1, s2, "ET")) {
             return MethodType::Get;
         } else {
             break;
         }
 
     case 'H':
-        if (std::strcmp(s + 1, "EAD") == 0) {
+        if (streq(s1 + 1, s2, "EAD")) {
             return MethodType::Head;
         } else {
             break;
         }
 
     case 'O':
-        if (std::strcmp(s + 1, "PTIONS") == 0) {
+        if (streq(s1 + 1, s2, "PTIONS")) {
             return MethodType::Options;
         } else {
             break;
         }
 
     case 'P':
-        switch (s[1]) {
+        switch (s1 + 1 < s2 ? s1[1] : '\0') {
         case 'A':
-            if (std::strcmp(s + 2, "TCH") == 0) {
+            if (streq(s1 + 2, s2, "TCH")) {
                 return MethodType::Patch;
             } else {
                 break;
             }
 
         case 'O':
-            if (std::strcmp(s + 2, "ST") == 0) {
+            if (streq(s1 + 2, s2, "ST")) {
                 return MethodType::Post;
             } else {
                 break;
             }
 
         case 'U':
-            if (std::strcmp(s + 2, "T") == 0) {
+            if (streq(s1 + 2, s2, "T")) {
                 return MethodType::Put;
             } else {
                 break;
@@ -135,7 +182,7 @@ Parser::ParseMethod(const char *s)
         break;
 
     case 'T':
-        if (std::strcmp(s + 1, "RACE") == 0) {
+        if (streq(s1 + 1, s2, "RACE")) {
             return MethodType::Trace;
         } else {
             break;
@@ -147,10 +194,10 @@ Parser::ParseMethod(const char *s)
 
 
 void
-Parser::ParseURI(const char *s, URI *uri)
+ParserBase::ParseURI(const char *s1, const char *s2, URI *uri)
 {
-    if (*s == '*') {
-        if (s[1] != '\0') {
+    if (*s1 == '*') {
+        if (s2 - s1 != 1) {
             throw InvalidMessage();
         }
 
@@ -166,38 +213,38 @@ Parser::ParseURI(const char *s, URI *uri)
         const char *portNumberEnd;
         const char *pathNameStart;
 
-        if (*s == '/') {
+        if (*s1 == '/') {
             schemeNameStart = schemeNameEnd = nullptr;
             userInfoStart = userInfoEnd = nullptr;
             hostNameStart = hostNameEnd = nullptr;
             portNumberStart = portNumberEnd = nullptr;
-            pathNameStart = s;
+            pathNameStart = s1;
         } else {
-            schemeNameStart = s;
+            schemeNameStart = s1;
 
-            for (schemeNameEnd = schemeNameStart; *schemeNameEnd != '\0'; ++schemeNameEnd) {
+            for (schemeNameEnd = schemeNameStart; schemeNameEnd < s2; ++schemeNameEnd) {
                 if (*schemeNameEnd == ':') {
                     break;
                 }
             }
 
-            if (*schemeNameEnd == '\0') {
+            if (schemeNameEnd == s2) {
                 throw InvalidMessage();
             }
 
-            if (!(schemeNameEnd[1] == '/' && schemeNameEnd[2] == '/')) {
+            if (!(s2 - schemeNameEnd >= 3 && schemeNameEnd[1] == '/' && schemeNameEnd[2] == '/')) {
                 throw InvalidMessage();
             }
 
             hostNameStart = schemeNameEnd + 3;
 
-            for (pathNameStart = hostNameStart; *pathNameStart != '\0'; ++pathNameStart) {
+            for (pathNameStart = hostNameStart; pathNameStart < s2; ++pathNameStart) {
                 if (*pathNameStart == '/') {
                     break;
                 }
             }
 
-            if (*pathNameStart == '\0') {
+            if (pathNameStart == s2) {
                 throw InvalidMessage();
             }
 
@@ -233,7 +280,7 @@ Parser::ParseURI(const char *s, URI *uri)
 
         const char *pathNameEnd;
 
-        for (pathNameEnd = pathNameStart; *pathNameEnd != '\0'; ++pathNameEnd) {
+        for (pathNameEnd = pathNameStart; pathNameEnd < s2; ++pathNameEnd) {
             if (*pathNameEnd == '?' || *pathNameEnd == '#') {
                 break;
             }
@@ -244,25 +291,25 @@ Parser::ParseURI(const char *s, URI *uri)
         const char *fragmentIDStart;
         const char *fragmentIDEnd;
 
-        if (*pathNameEnd == '?') {
+        if (pathNameEnd < s2 && *pathNameEnd == '?') {
             queryStringStart = pathNameEnd + 1;
 
-            for (queryStringEnd = queryStringStart; *queryStringEnd != '\0'; ++queryStringEnd) {
+            for (queryStringEnd = queryStringStart; queryStringEnd < s2; ++queryStringEnd) {
                 if (*queryStringEnd == '#') {
                     break;
                 }
             }
 
-            if (*queryStringEnd == '#') {
+            if (queryStringEnd < s2) {
                 fragmentIDStart = queryStringEnd + 1;
-                for (fragmentIDEnd = fragmentIDStart; *fragmentIDEnd != '\0'; ++fragmentIDEnd);
+                for (fragmentIDEnd = fragmentIDStart; fragmentIDEnd < s2; ++fragmentIDEnd);
             } else {
                 fragmentIDStart = fragmentIDEnd = nullptr;
             }
-        } else if (*pathNameEnd == '#') {
+        } else if (pathNameEnd < s2 && *pathNameEnd == '#') {
             queryStringStart = queryStringEnd = nullptr;
             fragmentIDStart = pathNameEnd + 1;
-            for (fragmentIDEnd = fragmentIDStart; *fragmentIDEnd != '\0'; ++fragmentIDEnd);
+            for (fragmentIDEnd = fragmentIDStart; fragmentIDEnd < s2; ++fragmentIDEnd);
         } else {
             queryStringStart = queryStringEnd = nullptr;
             fragmentIDStart = fragmentIDEnd = nullptr;
@@ -286,23 +333,24 @@ Parser::ParseURI(const char *s, URI *uri)
 
 
 std::tuple<unsigned short, unsigned short>
-Parser::ParseVersion(const char *s)
+ParserBase::ParseVersion(const char *s1, const char *s2)
 {
-    if (std::strncmp(s, "HTTP/", SIREN_STRLEN("HTTP/")) != 0) {
+    if (!(static_cast<std::size_t>(s2 - s1) >= SIREN_STRLEN("HTTP/")
+          && std::memcmp(s1, "HTTP/", SIREN_STRLEN("HTTP/")) == 0)) {
         throw InvalidMessage();
     }
 
-    const char *majorVersionNumberStart = s + SIREN_STRLEN("HTTP/");
+    const char *majorVersionNumberStart = s1 + SIREN_STRLEN("HTTP/");
     const char *majorVersionNumberEnd;
 
-    for (majorVersionNumberEnd = majorVersionNumberStart; *majorVersionNumberEnd != '\0'
+    for (majorVersionNumberEnd = majorVersionNumberStart; majorVersionNumberEnd < s2
          ; ++majorVersionNumberEnd) {
         if (*majorVersionNumberEnd == '.') {
             break;
         }
     }
 
-    if (*majorVersionNumberEnd == '\0') {
+    if (majorVersionNumberEnd == s2) {
         throw InvalidMessage();
     }
 
@@ -314,19 +362,19 @@ Parser::ParseVersion(const char *s)
                                                                     , majorVersionNumberEnd);
     const char *minorVersionNumberStart = majorVersionNumberEnd + 1;
 
-    if (*minorVersionNumberStart == '\0') {
+    if (minorVersionNumberStart == s2) {
         throw InvalidMessage();
     }
 
-    unsigned short minorVersionNumber = ParseNumber<unsigned short>(minorVersionNumberStart);
+    unsigned short minorVersionNumber = ParseNumber<unsigned short>(minorVersionNumberStart, s2);
     return std::make_tuple(majorVersionNumber, minorVersionNumber);
 }
 
 
 StatusCode
-Parser::ParseStatusCode(const char *s)
+ParserBase::ParseStatusCode(const char *s1, const char *s2)
 {
-    int rawStatusCode = ParseNumber<int>(s);
+    int rawStatusCode = ParseNumber<int>(s1, s2);
 
     if (!TestRawStatusCode(rawStatusCode)) {
         throw UnknownStatus();
@@ -337,9 +385,10 @@ Parser::ParseStatusCode(const char *s)
 
 
 void
-Parser::ParseHeaderFields(const char *s, Header *header)
+ParserBase::ParseHeaderFields(const char *s1, const char *s2, Header *header)
 {
-    const char *headerFieldStart = s;
+    std::size_t rawOffset = HeaderAccess::AddRaw(header, s1, s2 - s1);
+    const char *headerFieldStart = s1;
 
     do {
         const char *headerFieldEnd = headerFieldStart;
@@ -363,15 +412,16 @@ Parser::ParseHeaderFields(const char *s, Header *header)
             }
         }
 
-        ParseHeaderField(headerFieldStart, headerFieldEnd, header);
+        ParseHeaderField(headerFieldStart, headerFieldEnd, rawOffset + (headerFieldStart - s1)
+                         , header);
         headerFieldStart = headerFieldEnd + 2;
-    } while (*headerFieldStart != '\0');
+    } while (headerFieldStart < s2);
 }
 
 
 template <class T, std::size_t N>
 T
-Parser::ParseNumber(const char *s)
+ParserBase::ParseNumber(const char *s)
 {
     constexpr T k1 = std::numeric_limits<T>::max() / N;
     constexpr T k2 = std::numeric_limits<T>::max() % N;
@@ -396,7 +446,7 @@ Parser::ParseNumber(const char *s)
 
 template <class T, std::size_t N>
 T
-Parser::ParseNumber(const char *s1, const char *s2)
+ParserBase::ParseNumber(const char *s1, const char *s2)
 {
     constexpr T k1 = std::numeric_limits<T>::max() / N;
     constexpr T k2 = std::numeric_limits<T>::max() % N;
@@ -420,7 +470,8 @@ Parser::ParseNumber(const char *s1, const char *s2)
 
 
 void
-Parser::ParseHeaderField(const char *s1, const char *s2, Header *header)
+ParserBase::ParseHeaderField(const char *s1, const char *s2, std::size_t rawOffset
+                             , Header *header)
 {
     const char *headerFieldNameStart = s1;
     const char *headerFieldNameEnd;
@@ -457,25 +508,31 @@ Parser::ParseHeaderField(const char *s1, const char *s2, Header *header)
         }
     }
 
-    header->addField(std::make_tuple(headerFieldNameStart, headerFieldNameEnd)
-                     , std::make_tuple(headerFieldValueStart, headerFieldValueEnd));
+    HeaderAccess::AddRawField(header, rawOffset, s2 + 2 - s1
+                              , std::make_tuple(headerFieldNameStart, headerFieldNameEnd)
+                              , std::make_tuple(headerFieldValueStart, headerFieldValueEnd));
+}
+
+
+ParserBase::ParserBase(const ParseOptions &options) noexcept
+  : options_(options)
+{
+    initialize();
 }
 
 
-Parser::Parser(Parser &&other) noexcept
-  : options_(other.options_),
-    inputStream_(std::move(other.inputStream_))
+ParserBase::ParserBase(ParserBase &&other) noexcept
+  : options_(other.options_)
 {
     other.move(this);
 }
 
 
-Parser &
-Parser::operator=(Parser &&other) noexcept
+ParserBase &
+ParserBase::operator=(ParserBase &&other) noexcept
 {
     if (&other != this) {
         options_ = other.options_;
-        inputStream_ = std::move(other.inputStream_);
         other.move(this);
     }
 
@@ -484,278 +541,187 @@ Parser::operator=(Parser &&other) noexcept
 
 
 void
-Parser::initialize() noexcept
+ParserBase::initialize() noexcept
 {
     bodyIsChunked_ = false;
+    connectionIsPersistent_ = false;
     remainingBodySize_ = 0;
-    InitializeCharFlags();
 }
 
 
 void
-Parser::move(Parser *other) noexcept
+ParserBase::move(ParserBase *other) noexcept
 {
     if (bodyIsChunked_) {
         other->maxChunkSize_ = maxChunkSize_;
     }
 
     other->bodyIsChunked_ = bodyIsChunked_;
+    other->connectionIsPersistent_ = connectionIsPersistent_;
     other->remainingBodyOrChunkSize_ = remainingBodyOrChunkSize_;
 }
 
 
 void
-Parser::getRequest(Request *request)
+ParserBase::ParseRequestStartLine(const char *s, std::size_t n, Request *request)
 {
-    SIREN_ASSERT(isValid());
-    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
-    SIREN_ASSERT(request != nullptr);
-    parseRequestStartLine(request);
-    parseHeader(&request->header);
-    std::tie(bodyIsChunked_, remainingBodyOrChunkSize_) = parseBodyOrChunkSize(&request->header);
-}
-
-
-void
-Parser::getResponse(Response *response)
-{
-    SIREN_ASSERT(isValid());
-    SIREN_ASSERT(!bodyIsChunked_ && remainingBodySize_ == 0);
-    SIREN_ASSERT(response != nullptr);
-    parseResponseStartLine(response);
-    parseHeader(&response->header);
-    std::tie(bodyIsChunked_, remainingBodyOrChunkSize_) = parseBodyOrChunkSize(&response->header);
-}
-
-
-char *
-Parser::peekPayloadData(std::size_t payloadDataSize)
-{
-    SIREN_ASSERT(isValid());
-    SIREN_ASSERT(payloadDataSize <= remainingBodyOrChunkSize_);
-    char *payloadData;
-
-    if (payloadDataSize == remainingBodyOrChunkSize_ && bodyIsChunked_) {
-        inputStream_.peekData(remainingChunkSize_ + 2);
-        payloadData = inputStream_.getData();
-
-        if (!(payloadData[remainingChunkSize_] == '\r'
-              && payloadData[remainingChunkSize_ + 1] == '\n')) {
-            throw InvalidMessage();
-        }
-    } else {
-        inputStream_.peekData(remainingBodyOrChunkSize_);
-        payloadData = inputStream_.getData();
-    }
-
-    return payloadData;
-}
-
-
-void
-Parser::discardPayloadData(std::size_t payloadDataSize)
-{
-    SIREN_ASSERT(isValid());
-    SIREN_ASSERT(payloadDataSize <= remainingBodyOrChunkSize_);
-
-    if (payloadDataSize == remainingBodyOrChunkSize_ && bodyIsChunked_) {
-        inputStream_.discardData(remainingChunkSize_ + SIREN_STRLEN("\r\n"));
-
-        if (remainingChunkSize_ == 0) {
-            bodyIsChunked_ = false;
-        } else {
-            remainingChunkSize_ = parseChunkSize();
-        }
-    } else {
-        inputStream_.discardData(remainingBodyOrChunkSize_);
-        remainingBodyOrChunkSize_ -= payloadDataSize;
-    }
-}
-
-
-void
-Parser::parseRequestStartLine(Request *request)
-{
-    char *s;
-    std::size_t n;
-    std::tie(s, n) = peekCharsUntilCRLF<StartLineTooLong>(options_.maxStartLineSize);
-
     for (std::size_t i = 0; i < n - 2; ++i) {
         if (!(isprint(s[i]) || isspace(s[i]))) {
             throw InvalidMessage();
         }
     }
 
-    s[n - 2] = '\0';
-    char *methodNameStart = s;
+    const char *startLineEnd = s + n - 2;
+    const char *methodNameStart = s;
 
-    if (*methodNameStart == '\0') {
+    if (methodNameStart == startLineEnd) {
         throw InvalidMessage();
     }
 
-    char *methodNameEnd;
+    const char *methodNameEnd;
 
-    for (methodNameEnd = methodNameStart; *methodNameEnd != '\0'; ++methodNameEnd) {
+    for (methodNameEnd = methodNameStart; methodNameEnd < startLineEnd; ++methodNameEnd) {
         if (isspace(*methodNameEnd)) {
             break;
         }
     }
 
-    if (*methodNameEnd == '\0') {
+    if (methodNameEnd == startLineEnd) {
         throw InvalidMessage();
     }
 
-    *methodNameEnd = '\0';
-    char *uriStart;
+    const char *uriStart;
 
-    for (uriStart = methodNameEnd + 1; *uriStart != '\0'; ++uriStart) {
+    for (uriStart = methodNameEnd + 1; uriStart < startLineEnd; ++uriStart) {
         if (!isspace(*uriStart)) {
             break;
         }
     }
 
-    if (*uriStart == '\0') {
+    if (uriStart == startLineEnd) {
         throw InvalidMessage();
     }
 
-    char *uriEnd;
+    const char *uriEnd;
 
-    for (uriEnd = uriStart; *uriEnd != '\0'; ++uriEnd) {
+    for (uriEnd = uriStart; uriEnd < startLineEnd; ++uriEnd) {
         if (isspace(*uriEnd)) {
             break;
         }
     }
 
-    if (*uriEnd == '\0') {
+    if (uriEnd == startLineEnd) {
         throw InvalidMessage();
     }
 
-    *uriEnd = '\0';
-    char *versionStart;
+    const char *versionStart;
 
-    for (versionStart = uriEnd + 1; *versionStart != '\0'; ++versionStart) {
+    for (versionStart = uriEnd + 1; versionStart < startLineEnd; ++versionStart) {
         if (!isspace(*versionStart)) {
             break;
         }
     }
 
-    if (*versionStart == '\0') {
+    if (versionStart == startLineEnd) {
         throw InvalidMessage();
     }
 
-    request->methodType = ParseMethod(methodNameStart);
-    ParseURI(uriStart, &request->uri);
-    std::tie(request->majorVersionNumber, request->minorVersionNumber) = ParseVersion(versionStart);
-    inputStream_.discardData(n);
+    request->methodType = ParseMethod(methodNameStart, methodNameEnd);
+    ParseURI(uriStart, uriEnd, &request->uri);
+    std::tie(request->majorVersionNumber
+             , request->minorVersionNumber) = ParseVersion(versionStart, startLineEnd);
 }
 
 
 void
-Parser::parseResponseStartLine(Response *response)
+ParserBase::ParseResponseStartLine(const char *s, std::size_t n, Response *response)
 {
-    char *s;
-    std::size_t n;
-    std::tie(s, n) = peekCharsUntilCRLF<StartLineTooLong>(options_.maxStartLineSize);
-
     for (std::size_t i = 0; i < n - 2; ++i) {
         if (!(isprint(s[i]) || isspace(s[i]))) {
             throw InvalidMessage();
         }
     }
 
-    s[n - 2] = '\0';
-    char *versionStart = s;
+    const char *startLineEnd = s + n - 2;
+    const char *versionStart = s;
 
-    if (*versionStart == '\0') {
+    if (versionStart == startLineEnd) {
         throw InvalidMessage();
     }
 
-    char *versionEnd;
+    const char *versionEnd;
 
-    for (versionEnd = versionStart; *versionEnd != '\0'; ++versionEnd) {
+    for (versionEnd = versionStart; versionEnd < startLineEnd; ++versionEnd) {
         if (isspace(*versionEnd)) {
             break;
         }
     }
 
-    if (*versionEnd == '\0') {
+    if (versionEnd == startLineEnd) {
         throw InvalidMessage();
     }
 
-    *versionEnd = '\0';
-    char *statusCodeStart;
+    const char *statusCodeStart;
 
-    for (statusCodeStart = versionEnd + 1; *statusCodeStart != '\0'; ++statusCodeStart) {
+    for (statusCodeStart = versionEnd + 1; statusCodeStart < startLineEnd; ++statusCodeStart) {
         if (!isspace(*statusCodeStart)) {
             break;
         }
     }
 
-    if (*statusCodeStart == '\0') {
+    if (statusCodeStart == startLineEnd) {
         throw InvalidMessage();
     }
 
-    char *statusCodeEnd;
+    const char *statusCodeEnd;
 
-    for (statusCodeEnd = statusCodeStart; *statusCodeEnd != '\0'; ++statusCodeEnd) {
+    for (statusCodeEnd = statusCodeStart; statusCodeEnd < startLineEnd; ++statusCodeEnd) {
         if (isspace(*statusCodeEnd)) {
             break;
         }
     }
 
-    if (*statusCodeEnd == '\0') {
+    if (statusCodeEnd == startLineEnd) {
         throw InvalidMessage();
     }
 
-    *statusCodeEnd = '\0';
-    char *reasonPhraseStart;
+    const char *reasonPhraseStart;
 
-    for (reasonPhraseStart = statusCodeEnd + 1; *reasonPhraseStart != '\0'; ++reasonPhraseStart) {
+    for (reasonPhraseStart = statusCodeEnd + 1; reasonPhraseStart < startLineEnd
+         ; ++reasonPhraseStart) {
         if (!isspace(*reasonPhraseStart)) {
             break;
         }
     }
 
-    if (*reasonPhraseStart == '\0') {
+    if (reasonPhraseStart == startLineEnd) {
         throw InvalidMessage();
     }
 
     std::tie(response->majorVersionNumber
-             , response->minorVersionNumber) = ParseVersion(versionStart);
-    response->statusCode = ParseStatusCode(statusCodeStart);
-    response->reasonPhrase = reasonPhraseStart;
-    inputStream_.discardData(n);
+             , response->minorVersionNumber) = ParseVersion(versionStart, versionEnd);
+    response->statusCode = ParseStatusCode(statusCodeStart, statusCodeEnd);
+    response->reasonPhrase.assign(reasonPhraseStart, startLineEnd);
 }
 
 
 void
-Parser::parseHeader(Header *header)
+ParserBase::ParseHeader(const char *s, std::size_t n, Header *header)
 {
-    std::size_t n = 2;
-    inputStream_.peekData(n);
-    char *s = inputStream_.getData();
-    bool headerHasFields = !(*s == '\r' && s[1] == '\n');
-
-    if (headerHasFields) {
-        std::tie(s, n) = peekCharsUntilCRLFCRLF<HeaderTooLarge>(options_.maxHeaderSize);
-
-        for (std::size_t i = 0; i < n - 4; ++i) {
-            if (!(isprint(s[i]) || isspace(s[i]))) {
-                throw InvalidMessage();
-            }
+    for (std::size_t i = 0; i < n - 4; ++i) {
+        if (!(isprint(s[i]) || isspace(s[i]))) {
+            throw InvalidMessage();
         }
-
-        s[n - 2] = '\0';
-        const char *headerFieldsStart = s;
-        ParseHeaderFields(headerFieldsStart, header);
     }
 
-    inputStream_.discardData(n);
+    const char *headerFieldsStart = s;
+    const char *headerFieldsEnd = s + n - 2;
+    ParseHeaderFields(headerFieldsStart, headerFieldsEnd, header);
 }
 
 
 std::tuple<bool, std::size_t>
-Parser::parseBodyOrChunkSize(Header *header)
+ParserBase::parseBodySize(Header *header) const
 {
     header->sort();
     bool bodyIsChunked = false;
@@ -774,17 +740,11 @@ Parser::parseBodyOrChunkSize(Header *header)
         return true;
     });
 
-    union {
-        std::size_t bodySize;
-        std::size_t chunkSize;
-        std::size_t bodyOrChunkSize;
-    };
-
+    std::size_t bodySize;
     bool bodySizeIsDefined = false;
 
     header->search("Content-Length"
-                   , [&, &bodySize = bodySize] (std::size_t headerFieldIndex
-                                                , const char *headerFieldValue) -> bool {
+                   , [&] (std::size_t headerFieldIndex, const char *headerFieldValue) -> bool {
         if (*headerFieldValue != '\0') {
             if (bodySizeIsDefined) {
                 throw InvalidMessage();
@@ -803,7 +763,7 @@ Parser::parseBodyOrChunkSize(Header *header)
             throw InvalidMessage();
         }
 
-        chunkSize = parseFirstChunkSize();
+        bodySize = 0;
     } else {
         if (bodySizeIsDefined) {
             if (bodySize > options_.maxBodySize) {
@@ -814,120 +774,68 @@ Parser::parseBodyOrChunkSize(Header *header)
         }
     }
 
-    return std::make_tuple(bodyIsChunked, bodyOrChunkSize);
+    return std::make_tuple(bodyIsChunked, bodySize);
 }
 
 
 std::size_t
-Parser::parseFirstChunkSize()
+ParserBase::ParseChunkSize(const char *s, std::size_t n)
 {
-    maxChunkSize_ = options_.maxBodySize;
-    return parseChunkSize();
-}
-
-
-std::size_t
-Parser::parseChunkSize()
-{
-    constexpr unsigned int k = (std::numeric_limits<std::size_t>::digits + 3) / 4;
-
-    char *s;
-    std::size_t n;
-    std::tie(s, n) = peekCharsUntilCRLF<InvalidMessage>(k + 2);
-    char *chunkSizeStart = s;
-    char *chunkSizeEnd = s + n - 2;
+    const char *chunkSizeStart = s;
+    const char *chunkSizeEnd = s + n - 2;
 
     if (chunkSizeStart == chunkSizeEnd) {
         throw InvalidMessage();
     }
 
-    std::size_t chunkSize = ParseNumber<std::size_t, 16>(chunkSizeStart, chunkSizeEnd);
-
-    if (chunkSize > maxChunkSize_) {
-        throw BodyTooLarge();
-    }
-
-    maxChunkSize_ -= chunkSize;
-    inputStream_.discardData(n);
-    return chunkSize;
+    return ParseNumber<std::size_t, 16>(chunkSizeStart, chunkSizeEnd);
 }
 
 
-template <ParseException F()>
-std::tuple<char *, std::size_t>
-Parser::peekCharsUntilCRLF(std::size_t maxNumberOfChars)
+bool
+ParserBase::ParseConnectionPersistence(const Header &header, unsigned short majorVersionNumber
+                                       , unsigned short minorVersionNumber)
 {
-    std::size_t charCount = 2;
+    bool connectionIsClosed = false;
+    bool connectionIsKeptAlive = false;
 
-    for (;;) {
-        if (charCount > maxNumberOfChars) {
-            throw F();
-        }
+    header.search("Connection", [&] (std::size_t, const char *headerFieldValue) -> bool {
+        for (const char *s1 = headerFieldValue; *s1 != '\0';) {
+            while (*s1 == ',' || *s1 == ' ' || *s1 == '\t') {
+                ++s1;
+            }
 
-        inputStream_.peekData(charCount);
-        char *chars = inputStream_.getData();
-        int c1 = chars[charCount - 2];
-        int c2 = chars[charCount - 1];
+            const char *s2 = s1;
 
-        if (c2 == '\n') {
-            if (c1 == '\r') {
-                return std::make_tuple(chars, charCount);
-            } else {
-                charCount += 2;
+            while (*s2 != '\0' && *s2 != ',' && *s2 != ' ' && *s2 != '\t') {
+                ++s2;
             }
-        } else {
-            if (c2 == '\r') {
-                charCount += 1;
-            } else {
-                charCount += 2;
+
+            if (streqi(s1, s2, "close")) {
+                connectionIsClosed = true;
+            } else if (streqi(s1, s2, "keep-alive")) {
+                connectionIsKeptAlive = true;
             }
-        }
-    }
-}
 
+            s1 = s2;
+        }
 
-template <ParseException F()>
-std::tuple<char *, std::size_t>
-Parser::peekCharsUntilCRLFCRLF(std::size_t maxNumberOfChars)
-{
-    std::size_t charCount = 4;
+        return true;
+    });
 
-    for (;;) {
-        if (charCount > maxNumberOfChars) {
-            throw F();
-        }
+    if (connectionIsClosed) {
+        return false;
+    }
 
-        inputStream_.peekData(charCount);
-        char *chars = inputStream_.getData();
-        int c1 = chars[charCount - 4];
-        int c2 = chars[charCount - 3];
-        int c3 = chars[charCount - 2];
-        int c4 = chars[charCount - 1];
-
-        if (c4 == '\n') {
-            if (c3 == '\r') {
-                if (c2 == '\n' && c1 == '\r') {
-                    return std::make_tuple(chars, charCount);
-                } else {
-                    charCount += 2;
-                }
-            } else {
-                charCount += 4;
-            }
-        } else {
-            if (c4 == '\r') {
-                if (c3 == '\n' && c2 == '\r') {
-                    charCount += 1;
-                } else {
-                    charCount += 3;
-                }
-            } else {
-                charCount += 4;
-            }
-        }
+    if (majorVersionNumber > 1 || (majorVersionNumber == 1 && minorVersionNumber >= 1)) {
+        return true;
     }
+
+    return connectionIsKeptAlive;
 }
 
+} // namespace detail
+
 
 ParseException::ParseException(Type type) noexcept
   : type_(type)
@@ -945,6 +853,8 @@ ParseException::what() const noexcept
         "Start line too long",
         "Header too large",
         "Body too large",
+        "Timed out",
+        "Unknown content coding",
     };
 
     return descriptions[static_cast<int>(type_)];
@@ -960,6 +870,32 @@ tolower(char c) noexcept
 }
 
 
+bool
+streq(const char *s1, const char *s2, const char *s) noexcept
+{
+    for (; s1 < s2; ++s1, ++s) {
+        if (*s1 != *s) {
+            return false;
+        }
+    }
+
+    return *s == '\0';
+}
+
+
+bool
+streqi(const char *s1, const char *s2, const char *s) noexcept
+{
+    for (; s1 < s2; ++s1, ++s) {
+        if (tolower(*s1) != *s) {
+            return false;
+        }
+    }
+
+    return *s == '\0';
+}
+
+
 bool
 isprint(char c) noexcept
 {
@@ -1021,37 +957,6 @@ digit2int<16>(char c) noexcept
     return isdigit<10>(c) ? digit2int<10>(c) : 10 + (tolower(c) - 'a');
 }
 
-
-void
-InitializeCharFlags() noexcept
-{
-    static struct Helper {
-        Helper() {
-            std::memset(CharFlags, '\0', sizeof(CharFlags));
-
-            for (char c : {DIGIT}) {
-                CharFlags[static_cast<unsigned char>(c)].digit = 1;
-            }
-
-            for (char c : {HEXDIGIT}) {
-                CharFlags[static_cast<unsigned char>(c)].hexdigit = 1;
-            }
-
-            for (char c : {OCTDIGIT}) {
-                CharFlags[static_cast<unsigned char>(c)].octdigit = 1;
-            }
-
-            for (char c : {PRINT}) {
-                CharFlags[static_cast<unsigned char>(c)].print = 1;
-            }
-
-            for (char c : {SPACE}) {
-                CharFlags[static_cast<unsigned char>(c)].space = 1;
-            }
-        }
-    } helper;
-}
-
 } // namespace
 
 } // namespace http
@@ -0,0 +1,171 @@
+#include "pipelined_client.h"
+
+#include <cstring>
+#include <utility>
+
+#include <siren/assert.h>
+#include <siren/loop.h>
+#include <siren/tcp_socket.h>
+
+#include "request.h"
+#include "response.h"
+
+
+namespace siren {
+
+namespace http {
+
+PipelinedClient::PipelinedClient(const PipelinedClientOptions &options, TCPSocket &&tcpSocket)
+  : loop_(tcpSocket.getLoop()),
+    connection_(options, std::move(tcpSocket)),
+    windowSemaphore_(loop_, options.maxNumberOfInflightRequests, 0
+                     , options.maxNumberOfInflightRequests),
+    sendSemaphore_(loop_, 1, 0, 1),
+    responseSemaphore_(loop_),
+    exitSemaphore_(loop_),
+    numberOfQueuedSenders_(0),
+    isClosed_(false)
+{
+    SIREN_ASSERT(options.maxNumberOfInflightRequests >= 1);
+
+    loop_->createFiber([this] () -> void {
+        receiveResponses();
+    });
+}
+
+
+PipelinedClient::~PipelinedClient()
+{
+    if (!isClosed_) {
+        close();
+    }
+
+    exitSemaphore_.down();
+}
+
+
+void
+PipelinedClient::sendRequest(const Request &request, Callback callback)
+{
+    sendRequest(request, nullptr, 0, std::move(callback));
+}
+
+
+void
+PipelinedClient::sendRequest(const Request &request, const void *body, std::size_t bodySize
+                             , Callback callback)
+{
+    SIREN_ASSERT(!isClosed_);
+    SIREN_ASSERT(body != nullptr || bodySize == 0);
+    SIREN_ASSERT(callback != nullptr);
+    windowSemaphore_.down();
+    ++numberOfQueuedSenders_;
+    sendSemaphore_.down();
+    --numberOfQueuedSenders_;
+
+    try {
+        if (exception_ != nullptr) {
+            std::rethrow_exception(exception_);
+        }
+
+        connection_.deferFlush();
+        PayloadWriter payloadWriter = connection_.dumpRequest(request, bodySize);
+
+        if (bodySize >= 1) {
+            std::memcpy(payloadWriter.reserveBuffer(bodySize), body, bodySize);
+            payloadWriter.flushBuffer(bodySize);
+        }
+
+        if (numberOfQueuedSenders_ == 0) {
+            connection_.flush();
+        }
+    } catch (...) {
+        if (exception_ == nullptr) {
+            exception_ = std::current_exception();
+        }
+
+        sendSemaphore_.up();
+        windowSemaphore_.up();
+        throw;
+    }
+
+    callbacks_.emplace_back(request.methodType, std::move(callback));
+    sendSemaphore_.up();
+    responseSemaphore_.up();
+}
+
+
+void
+PipelinedClient::close()
+{
+    SIREN_ASSERT(!isClosed_);
+    isClosed_ = true;
+    responseSemaphore_.up();
+}
+
+
+void
+PipelinedClient::SkipPayload(PayloadReader *payloadReader)
+{
+    for (;;) {
+        std::size_t n = payloadReader->getRemainingBodyOrChunkSize();
+
+        if (n == 0 && !payloadReader->bodyIsChunked()) {
+            return;
+        }
+
+        payloadReader->peekData(n);
+        payloadReader->discardData(n);
+    }
+}
+
+
+void
+PipelinedClient::receiveResponses()
+{
+    for (;;) {
+        responseSemaphore_.down();
+
+        if (callbacks_.empty()) {
+            break;
+        }
+
+        MethodType requestMethodType = callbacks_.front().first;
+        Callback callback = std::move(callbacks_.front().second);
+        callbacks_.pop_front();
+        receiveResponse(requestMethodType, &callback);
+        windowSemaphore_.up();
+    }
+
+    exitSemaphore_.up();
+}
+
+
+void
+PipelinedClient::receiveResponse(MethodType requestMethodType, Callback *callback)
+{
+    if (exception_ == nullptr) {
+        Response response;
+        bool callbackIsCalled = false;
+
+        try {
+            PayloadReader payloadReader = connection_.parseResponse(&response, requestMethodType);
+            callbackIsCalled = true;
+            (*callback)(nullptr, &response, &payloadReader);
+            SkipPayload(&payloadReader);
+            return;
+        } catch (...) {
+            exception_ = std::current_exception();
+
+            if (callbackIsCalled) {
+                return;
+            }
+        }
+    }
+
+    (*callback)(exception_, nullptr, nullptr);
+}
+
+} // namespace http
+
+} // namespace siren
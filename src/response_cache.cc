@@ -0,0 +1,739 @@
+#include "response_cache.h"
+
+#include <strings.h>
+#include <time.h>
+
+#include <cstring>
+#include <limits>
+
+#include <siren/assert.h>
+#include <siren/stream.h>
+#include <siren/utility.h>
+
+#include "connection.h"
+#include "dumper.h"
+#include "etag.h"
+#include "request.h"
+#include "response.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace {
+
+struct CacheControl
+{
+    bool noStore = false;
+    bool noCache = false;
+    bool isPrivate = false;
+    long maxAge = -1;
+    long sharedMaxAge = -1;
+};
+
+
+const char *const HopByHopHeaderFieldNames[] = {
+    "Connection",
+    "Keep-Alive",
+    "Transfer-Encoding",
+};
+
+
+bool StatusCodeIsCacheable(StatusCode) noexcept;
+void ParseCacheControl(const char *, CacheControl *) noexcept;
+bool ParseDeltaSeconds(const char *, std::size_t, long *) noexcept;
+bool ParseVary(const char *, std::vector<std::string> *);
+std::string GetHeaderFieldValue(const Header &, const char *);
+void PutInteger(std::string *, std::uint64_t);
+bool GetInteger(const char **, const char *, std::uint64_t *) noexcept;
+void PutString(std::string *, const std::string &);
+bool GetString(const char **, const char *, std::string *);
+
+} // namespace
+
+
+CachedResponse::CachedResponse() noexcept
+  : startLineSize_(0),
+    headSize_(0),
+    majorVersionNumber_(0),
+    minorVersionNumber_(0)
+{
+}
+
+
+bool
+CachedResponse::matchRequest(const Request &request) const
+{
+    for (const auto &varyField : varyFields_) {
+        if (GetHeaderFieldValue(request.header, varyField.first.c_str()) != varyField.second) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+namespace detail {
+
+std::shared_ptr<CachedResponse>
+CachedResponseAccess::Make(const Request &request, const Response &response, const void *body
+                           , std::size_t bodySize, std::size_t maxResponseSize)
+{
+    if (request.methodType != MethodType::Get || bodySize > maxResponseSize
+        || !StatusCodeIsCacheable(response.statusCode)) {
+        return nullptr;
+    }
+
+    bool requestIsCacheable = true;
+
+    request.header.traverse([&] (std::size_t, const char *headerFieldName
+                                 , const char *headerFieldValue) -> void {
+        if (std::strcmp(headerFieldName, "Cache-Control") == 0) {
+            CacheControl cacheControl;
+            ParseCacheControl(headerFieldValue, &cacheControl);
+
+            if (cacheControl.noStore) {
+                requestIsCacheable = false;
+            }
+        } else if (std::strcmp(headerFieldName, "Authorization") == 0) {
+            requestIsCacheable = false;
+        }
+    });
+
+    if (!requestIsCacheable) {
+        return nullptr;
+    }
+
+    CacheControl cacheControl;
+    const char *expires = nullptr;
+    const char *date = nullptr;
+    std::vector<std::string> varyFieldNames;
+    bool responseIsCacheable = true;
+
+    response.header.traverse([&] (std::size_t, const char *headerFieldName
+                                  , const char *headerFieldValue) -> void {
+        if (std::strcmp(headerFieldName, "Cache-Control") == 0) {
+            ParseCacheControl(headerFieldValue, &cacheControl);
+        } else if (std::strcmp(headerFieldName, "Expires") == 0) {
+            expires = headerFieldValue;
+        } else if (std::strcmp(headerFieldName, "Date") == 0) {
+            date = headerFieldValue;
+        } else if (std::strcmp(headerFieldName, "Vary") == 0) {
+            if (!ParseVary(headerFieldValue, &varyFieldNames)) {
+                responseIsCacheable = false;
+            }
+        } else if (std::strcmp(headerFieldName, "Set-Cookie") == 0) {
+            responseIsCacheable = false;
+        }
+    });
+
+    if (!responseIsCacheable || cacheControl.noStore || cacheControl.noCache
+        || cacheControl.isPrivate) {
+        return nullptr;
+    }
+
+    long timeToLive;
+
+    if (cacheControl.sharedMaxAge >= 0) {
+        timeToLive = cacheControl.sharedMaxAge;
+    } else if (cacheControl.maxAge >= 0) {
+        timeToLive = cacheControl.maxAge;
+    } else if (expires != nullptr) {
+        time_t expiryTime, currentTime;
+
+        if (!detail::ParseHTTPDate(expires, &expiryTime)) {
+            return nullptr;
+        }
+
+        if (date == nullptr || !detail::ParseHTTPDate(date, &currentTime)) {
+            currentTime = time(nullptr);
+        }
+
+        timeToLive = expiryTime - currentTime;
+    } else {
+        return nullptr;
+    }
+
+    if (timeToLive <= 0) {
+        return nullptr;
+    }
+
+    Response strippedResponse;
+    strippedResponse.majorVersionNumber = response.majorVersionNumber;
+    strippedResponse.minorVersionNumber = response.minorVersionNumber;
+    strippedResponse.statusCode = response.statusCode;
+    strippedResponse.reasonPhrase = response.reasonPhrase;
+
+    response.header.traverse([&] (std::size_t, const char *headerFieldName
+                                  , const char *headerFieldValue) -> void {
+        for (const char *hopByHopHeaderFieldName : HopByHopHeaderFieldNames) {
+            if (std::strcmp(headerFieldName, hopByHopHeaderFieldName) == 0) {
+                return;
+            }
+        }
+
+        strippedResponse.header.addField(headerFieldName, headerFieldValue);
+    });
+
+    auto cachedResponse = std::make_shared<CachedResponse>();
+    std::string *data = &cachedResponse->data_;
+    Stream stream;
+
+    Dumper dumper(DumpOptions(), &stream, [data] (Stream *stream) -> void {
+        data->append(static_cast<const char *>(stream->getData()), stream->getDataSize());
+        stream->discardData(stream->getDataSize());
+    });
+
+    dumper.putResponse(strippedResponse, bodySize);
+
+    if (bodySize >= 1) {
+        std::memcpy(dumper.reservePayloadBuffer(bodySize), body, bodySize);
+        dumper.flushPayloadBuffer(bodySize);
+    }
+
+    if (data->size() > maxResponseSize) {
+        return nullptr;
+    }
+
+    cachedResponse->startLineSize_ = data->find("\r\n") + SIREN_STRLEN("\r\n");
+    cachedResponse->headSize_ = data->size() - bodySize;
+    cachedResponse->majorVersionNumber_ = response.majorVersionNumber;
+    cachedResponse->minorVersionNumber_ = response.minorVersionNumber;
+
+    for (std::string &varyFieldName : varyFieldNames) {
+        std::string varyFieldValue = GetHeaderFieldValue(request.header, varyFieldName.c_str());
+        cachedResponse->varyFields_.emplace_back(std::move(varyFieldName)
+                                                 , std::move(varyFieldValue));
+    }
+
+    cachedResponse->expiryTime_ = std::chrono::steady_clock::now()
+                                  + std::chrono::seconds(timeToLive);
+    return cachedResponse;
+}
+
+
+void
+CachedResponseAccess::Serialize(const CachedResponse &cachedResponse, std::string *buffer)
+{
+    buffer->clear();
+    PutInteger(buffer, cachedResponse.expiryTime_.time_since_epoch().count());
+    PutInteger(buffer, cachedResponse.startLineSize_);
+    PutInteger(buffer, cachedResponse.headSize_);
+    PutInteger(buffer, cachedResponse.majorVersionNumber_);
+    PutInteger(buffer, cachedResponse.minorVersionNumber_);
+    PutInteger(buffer, cachedResponse.varyFields_.size());
+
+    for (const auto &varyField : cachedResponse.varyFields_) {
+        PutString(buffer, varyField.first);
+        PutString(buffer, varyField.second);
+    }
+
+    PutString(buffer, cachedResponse.data_);
+}
+
+
+std::shared_ptr<CachedResponse>
+CachedResponseAccess::Deserialize(const char *buffer, std::size_t bufferSize)
+{
+    const char *bufferEnd = buffer + bufferSize;
+    auto cachedResponse = std::make_shared<CachedResponse>();
+    std::uint64_t expiryTime, startLineSize, headSize, majorVersionNumber, minorVersionNumber;
+    std::uint64_t numberOfVaryFields;
+
+    if (!GetInteger(&buffer, bufferEnd, &expiryTime)
+        || !GetInteger(&buffer, bufferEnd, &startLineSize)
+        || !GetInteger(&buffer, bufferEnd, &headSize)
+        || !GetInteger(&buffer, bufferEnd, &majorVersionNumber)
+        || !GetInteger(&buffer, bufferEnd, &minorVersionNumber)
+        || !GetInteger(&buffer, bufferEnd, &numberOfVaryFields)) {
+        return nullptr;
+    }
+
+    for (std::uint64_t i = 0; i < numberOfVaryFields; ++i) {
+        std::string varyFieldName, varyFieldValue;
+
+        if (!GetString(&buffer, bufferEnd, &varyFieldName)
+            || !GetString(&buffer, bufferEnd, &varyFieldValue)) {
+            return nullptr;
+        }
+
+        cachedResponse->varyFields_.emplace_back(std::move(varyFieldName)
+                                                 , std::move(varyFieldValue));
+    }
+
+    if (!GetString(&buffer, bufferEnd, &cachedResponse->data_)
+        || startLineSize > headSize || headSize > cachedResponse->data_.size()) {
+        return nullptr;
+    }
+
+    cachedResponse->expiryTime_ = std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(expiryTime));
+    cachedResponse->startLineSize_ = startLineSize;
+    cachedResponse->headSize_ = headSize;
+    cachedResponse->majorVersionNumber_ = majorVersionNumber;
+    cachedResponse->minorVersionNumber_ = minorVersionNumber;
+    return cachedResponse;
+}
+
+
+bool
+RequestAllowsCachedResponse(const Request &request)
+{
+    if (request.methodType != MethodType::Get && request.methodType != MethodType::Head) {
+        return false;
+    }
+
+    bool result = true;
+
+    request.header.traverse([&] (std::size_t, const char *headerFieldName
+                                 , const char *headerFieldValue) -> void {
+        if (std::strcmp(headerFieldName, "Cache-Control") == 0) {
+            CacheControl cacheControl;
+            ParseCacheControl(headerFieldValue, &cacheControl);
+
+            if (cacheControl.noStore || cacheControl.noCache || cacheControl.maxAge == 0) {
+                result = false;
+            }
+        } else if (std::strcmp(headerFieldName, "Pragma") == 0) {
+            if (strcasecmp(headerFieldValue, "no-cache") == 0) {
+                result = false;
+            }
+        } else if (std::strcmp(headerFieldName, "Authorization") == 0) {
+            result = false;
+        }
+    });
+
+    return result;
+}
+
+
+std::string
+MakeResponseCacheKey(const Request &request)
+{
+    std::string key = GetHeaderFieldValue(request.header, "Host");
+    key += ' ';
+    key += request.uri.getPathName();
+    const char *queryString = request.uri.getQueryString();
+
+    if (*queryString != '\0') {
+        key += '?';
+        key += queryString;
+    }
+
+    return key;
+}
+
+} // namespace detail
+
+
+ResponseCache::ResponseCache(const ResponseCacheOptions &options)
+  : options_(options),
+    shards_(new Shard[options.numberOfShards]),
+    cacheSize_(0)
+{
+    SIREN_ASSERT(options_.numberOfShards >= 1);
+}
+
+
+std::shared_ptr<const CachedResponse>
+ResponseCache::findResponse(const Request &request)
+{
+    if (!detail::RequestAllowsCachedResponse(request)) {
+        return nullptr;
+    }
+
+    std::string key = detail::MakeResponseCacheKey(request);
+    Shard *shard = getShard(key);
+    std::lock_guard<std::mutex> lockGuard(shard->mutex);
+    auto it = shard->key2Entry.find(key);
+
+    if (it == shard->key2Entry.end()) {
+        return nullptr;
+    }
+
+    Entry *entry = &*it->second;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::shared_ptr<const CachedResponse> cachedResponse;
+
+    for (auto it2 = entry->variants.begin(); it2 != entry->variants.end();) {
+        if ((*it2)->getExpiryTime() <= now) {
+            entry->size -= (*it2)->getSize();
+            cacheSize_ -= (*it2)->getSize();
+            it2 = entry->variants.erase(it2);
+        } else {
+            if (cachedResponse == nullptr && (*it2)->matchRequest(request)) {
+                cachedResponse = *it2;
+            }
+
+            ++it2;
+        }
+    }
+
+    if (entry->variants.empty()) {
+        cacheSize_ -= entry->size;
+        shard->entries.erase(it->second);
+        shard->key2Entry.erase(it);
+        return nullptr;
+    }
+
+    shard->entries.splice(shard->entries.begin(), shard->entries, it->second);
+    return cachedResponse;
+}
+
+
+std::shared_ptr<const CachedResponse>
+ResponseCache::storeResponse(const Request &request, const Response &response, const void *body
+                             , std::size_t bodySize)
+{
+    std::shared_ptr<const CachedResponse> cachedResponse
+        = detail::CachedResponseAccess::Make(request, response, body, bodySize
+                                             , options_.maxResponseSize);
+
+    if (cachedResponse == nullptr) {
+        return nullptr;
+    }
+
+    std::string key = detail::MakeResponseCacheKey(request);
+
+    if (key.size() + cachedResponse->getSize() > options_.maxCacheSize) {
+        return cachedResponse;
+    }
+
+    Shard *shard = getShard(key);
+
+    {
+        std::lock_guard<std::mutex> lockGuard(shard->mutex);
+        auto it = shard->key2Entry.find(key);
+
+        if (it == shard->key2Entry.end()) {
+            shard->entries.emplace_front();
+            Entry *entry = &shard->entries.front();
+            entry->key = key;
+            entry->size = key.size();
+            cacheSize_ += entry->size;
+            it = shard->key2Entry.emplace(std::move(key), shard->entries.begin()).first;
+        } else {
+            shard->entries.splice(shard->entries.begin(), shard->entries, it->second);
+        }
+
+        Entry *entry = &*it->second;
+
+        for (auto it2 = entry->variants.begin(); it2 != entry->variants.end(); ++it2) {
+            if ((*it2)->matchRequest(request)) {
+                entry->size -= (*it2)->getSize();
+                cacheSize_ -= (*it2)->getSize();
+                entry->variants.erase(it2);
+                break;
+            }
+        }
+
+        if (entry->variants.size() == MaxNumberOfResponseVariants) {
+            entry->size -= entry->variants.front()->getSize();
+            cacheSize_ -= entry->variants.front()->getSize();
+            entry->variants.erase(entry->variants.begin());
+        }
+
+        entry->variants.push_back(cachedResponse);
+        entry->size += cachedResponse->getSize();
+        cacheSize_ += cachedResponse->getSize();
+    }
+
+    evictEntries(shard);
+    return cachedResponse;
+}
+
+
+std::size_t
+ResponseCache::getCacheSize()
+{
+    return cacheSize_.load(std::memory_order_relaxed);
+}
+
+
+std::size_t
+ResponseCache::getNumberOfCachedResponses()
+{
+    std::size_t numberOfCachedResponses = 0;
+
+    for (std::size_t i = 0; i < options_.numberOfShards; ++i) {
+        Shard *shard = &shards_[i];
+        std::lock_guard<std::mutex> lockGuard(shard->mutex);
+
+        for (const Entry &entry : shard->entries) {
+            numberOfCachedResponses += entry.variants.size();
+        }
+    }
+
+    return numberOfCachedResponses;
+}
+
+
+ResponseCache::Shard *
+ResponseCache::getShard(const std::string &key) noexcept
+{
+    return &shards_[std::hash<std::string>()(key) % options_.numberOfShards];
+}
+
+
+void
+ResponseCache::evictEntries(Shard *shard) noexcept
+{
+    std::size_t shardIndex = shard - shards_.get();
+
+    for (std::size_t i = 0; i < options_.numberOfShards
+                            && cacheSize_.load(std::memory_order_relaxed) > options_.maxCacheSize
+         ; ++i) {
+        Shard *otherShard = &shards_[(shardIndex + i) % options_.numberOfShards];
+        std::lock_guard<std::mutex> lockGuard(otherShard->mutex);
+        std::size_t minNumberOfEntries = otherShard == shard ? 1 : 0;
+
+        while (otherShard->entries.size() > minNumberOfEntries
+               && cacheSize_.load(std::memory_order_relaxed) > options_.maxCacheSize) {
+            const Entry &entry = otherShard->entries.back();
+            cacheSize_ -= entry.size;
+            otherShard->key2Entry.erase(entry.key);
+            otherShard->entries.pop_back();
+        }
+    }
+}
+
+
+void
+DumpCachedResponse(Connection *connection, const Request &request
+                   , const CachedResponse &cachedResponse)
+{
+    std::size_t rawResponseSize = request.methodType == MethodType::Head
+                                  ? cachedResponse.getHeadSize() : cachedResponse.getSize();
+    connection->dumpRawResponse(cachedResponse.getData(), rawResponseSize
+                                , cachedResponse.getStartLineSize()
+                                , cachedResponse.getMajorVersionNumber()
+                                , cachedResponse.getMinorVersionNumber());
+}
+
+
+namespace {
+
+bool
+StatusCodeIsCacheable(StatusCode statusCode) noexcept
+{
+    switch (statusCode) {
+    case StatusCode::OK:
+    case StatusCode::NonAuthoritativeInformation:
+    case StatusCode::NoContent:
+    case StatusCode::MultipleChoices:
+    case StatusCode::MovedPermanently:
+    case StatusCode::PermanentRedirect:
+    case StatusCode::NotFound:
+    case StatusCode::MethodNotAllowed:
+    case StatusCode::Gone:
+    case StatusCode::URITooLong:
+    case StatusCode::NotImplemented:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+void
+ParseCacheControl(const char *s, CacheControl *cacheControl) noexcept
+{
+    for (;;) {
+        while (*s == ',' || *s == ' ' || *s == '\t') {
+            ++s;
+        }
+
+        if (*s == '\0') {
+            return;
+        }
+
+        const char *directiveName = s;
+
+        while (*s != '\0' && *s != '=' && *s != ',' && *s != ' ' && *s != '\t') {
+            ++s;
+        }
+
+        std::size_t directiveNameLength = s - directiveName;
+        const char *argument = "";
+        std::size_t argumentLength = 0;
+
+        while (*s == ' ' || *s == '\t') {
+            ++s;
+        }
+
+        if (*s == '=') {
+            ++s;
+
+            while (*s == ' ' || *s == '\t') {
+                ++s;
+            }
+
+            if (*s == '"') {
+                argument = ++s;
+
+                while (*s != '\0' && *s != '"') {
+                    ++s;
+                }
+
+                argumentLength = s - argument;
+            } else {
+                argument = s;
+
+                while (*s != '\0' && *s != ',' && *s != ' ' && *s != '\t') {
+                    ++s;
+                }
+
+                argumentLength = s - argument;
+            }
+        }
+
+        while (*s != '\0' && *s != ',') {
+            ++s;
+        }
+
+        auto directiveNameIs = [&] (const char *name) -> bool {
+            return directiveNameLength == std::strlen(name)
+                   && strncasecmp(directiveName, name, directiveNameLength) == 0;
+        };
+
+        if (directiveNameIs("no-store")) {
+            cacheControl->noStore = true;
+        } else if (directiveNameIs("no-cache")) {
+            cacheControl->noCache = true;
+        } else if (directiveNameIs("private")) {
+            cacheControl->isPrivate = true;
+        } else if (directiveNameIs("max-age")) {
+            ParseDeltaSeconds(argument, argumentLength, &cacheControl->maxAge);
+        } else if (directiveNameIs("s-maxage")) {
+            ParseDeltaSeconds(argument, argumentLength, &cacheControl->sharedMaxAge);
+        }
+    }
+}
+
+
+bool
+ParseDeltaSeconds(const char *s, std::size_t length, long *deltaSeconds) noexcept
+{
+    if (length == 0) {
+        return false;
+    }
+
+    long n = 0;
+
+    for (std::size_t i = 0; i < length; ++i) {
+        if (s[i] < '0' || s[i] > '9') {
+            return false;
+        }
+
+        long d = s[i] - '0';
+
+        if (n > (std::numeric_limits<long>::max() - d) / 10) {
+            n = std::numeric_limits<long>::max();
+        } else {
+            n = n * 10 + d;
+        }
+    }
+
+    *deltaSeconds = n;
+    return true;
+}
+
+
+bool
+ParseVary(const char *s, std::vector<std::string> *varyFieldNames)
+{
+    for (;;) {
+        while (*s == ',' || *s == ' ' || *s == '\t') {
+            ++s;
+        }
+
+        if (*s == '\0') {
+            return true;
+        }
+
+        const char *varyFieldName = s;
+
+        while (*s != '\0' && *s != ',' && *s != ' ' && *s != '\t') {
+            ++s;
+        }
+
+        if (s - varyFieldName == 1 && *varyFieldName == '*') {
+            return false;
+        }
+
+        varyFieldNames->emplace_back(varyFieldName, s - varyFieldName);
+    }
+}
+
+
+std::string
+GetHeaderFieldValue(const Header &header, const char *headerFieldName)
+{
+    std::string headerFieldValue;
+
+    header.traverse([&] (std::size_t, const char *headerFieldName2
+                         , const char *headerFieldValue2) -> void {
+        if (strcasecmp(headerFieldName2, headerFieldName) == 0) {
+            if (!headerFieldValue.empty()) {
+                headerFieldValue += ", ";
+            }
+
+            headerFieldValue += headerFieldValue2;
+        }
+    });
+
+    return headerFieldValue;
+}
+
+
+void
+PutInteger(std::string *buffer, std::uint64_t integer)
+{
+    buffer->append(reinterpret_cast<const char *>(&integer), sizeof(integer));
+}
+
+
+bool
+GetInteger(const char **buffer, const char *bufferEnd, std::uint64_t *integer) noexcept
+{
+    if (static_cast<std::size_t>(bufferEnd - *buffer) < sizeof(*integer)) {
+        return false;
+    }
+
+    std::memcpy(integer, *buffer, sizeof(*integer));
+    *buffer += sizeof(*integer);
+    return true;
+}
+
+
+void
+PutString(std::string *buffer, const std::string &string)
+{
+    PutInteger(buffer, string.size());
+    buffer->append(string);
+}
+
+
+bool
+GetString(const char **buffer, const char *bufferEnd, std::string *string)
+{
+    std::uint64_t stringSize;
+
+    if (!GetInteger(buffer, bufferEnd, &stringSize)
+        || static_cast<std::uint64_t>(bufferEnd - *buffer) < stringSize) {
+        return false;
+    }
+
+    string->assign(*buffer, stringSize);
+    *buffer += stringSize;
+    return true;
+}
+
+} // namespace
+
+} // namespace http
+
+} // namespace siren
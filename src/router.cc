@@ -0,0 +1,246 @@
+#include "router.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <siren/assert.h>
+
+#include "request.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace {
+
+constexpr std::size_t NumberOfMethodTypes = static_cast<std::size_t>(MethodType::Trace) + 1;
+
+} // namespace
+
+
+namespace detail {
+
+RouterBase::RouterBase()
+  : roots_(new Node[NumberOfMethodTypes])
+{
+}
+
+
+RouterBase::RouterBase(RouterBase &&) noexcept = default;
+RouterBase &RouterBase::operator=(RouterBase &&) noexcept = default;
+RouterBase::~RouterBase() = default;
+
+
+std::size_t
+RouterBase::addRoute(MethodType methodType, const char *pattern)
+{
+    SIREN_ASSERT(pattern != nullptr);
+
+    if (*pattern != '/') {
+        throw std::invalid_argument("route pattern must start with `/`");
+    }
+
+    struct Segment
+    {
+        char type;
+        const char *s1;
+        const char *s2;
+    };
+
+    std::vector<Segment> segments;
+    Route route;
+
+    for (const char *s1 = pattern; *s1 != '\0';) {
+        const char *s2 = s1 + 1;
+
+        if (*s1 == ':') {
+            while (*s2 != '\0' && *s2 != '/') {
+                ++s2;
+            }
+
+            if (s2 == s1 + 1) {
+                throw std::invalid_argument("route parameter must have a name");
+            }
+
+            route.parameterNames.emplace_back(s1 + 1, s2);
+        } else if (*s1 == '*') {
+            s2 += std::strlen(s2);
+
+            if (std::memchr(s1, '/', s2 - s1) != nullptr) {
+                throw std::invalid_argument("route wildcard must be the last segment");
+            }
+
+            route.parameterNames.emplace_back(s1 + 1, s2);
+        } else {
+            while (*s2 != '\0' && *s2 != ':' && *s2 != '*') {
+                ++s2;
+            }
+        }
+
+        segments.push_back({*s1, s1, s2});
+        s1 = s2;
+    }
+
+    if (route.parameterNames.size() > MaxNumberOfRouteParameters) {
+        throw std::invalid_argument("too many route parameters");
+    }
+
+    Node *node = &roots_[static_cast<std::size_t>(methodType)];
+
+    for (const Segment &segment : segments) {
+        if (segment.type == ':') {
+            if (node->parameterChild == nullptr) {
+                node->parameterChild.reset(new Node);
+            }
+
+            node = node->parameterChild.get();
+        } else if (segment.type == '*') {
+            if (node->wildcardChild == nullptr) {
+                node->wildcardChild.reset(new Node);
+            }
+
+            node = node->wildcardChild.get();
+        } else {
+            node = InsertLabel(node, segment.s1, segment.s2 - segment.s1);
+        }
+    }
+
+    if (node->routeIndex != std::size_t(-1)) {
+        throw std::invalid_argument("duplicate route");
+    }
+
+    node->routeIndex = routes_.size();
+    routes_.push_back(std::move(route));
+    return node->routeIndex;
+}
+
+
+std::size_t
+RouterBase::matchRoute(MethodType methodType, const char *path, std::size_t pathLength
+                       , RouteParameters *parameters) const noexcept
+{
+    RouteParameters dummyParameters;
+
+    if (parameters == nullptr) {
+        parameters = &dummyParameters;
+    }
+
+    parameters->count_ = 0;
+    std::size_t routeIndex = MatchNode(&roots_[static_cast<std::size_t>(methodType)], path
+                                       , path + pathLength, parameters);
+
+    if (routeIndex != std::size_t(-1)) {
+        const Route &route = routes_[routeIndex];
+
+        for (std::size_t i = 0; i < parameters->count_; ++i) {
+            parameters->items_[i].name = route.parameterNames[i].c_str();
+        }
+    }
+
+    return routeIndex;
+}
+
+
+RouterNode *
+RouterBase::InsertLabel(Node *node, const char *label, std::size_t labelLength)
+{
+    while (labelLength >= 1) {
+        std::size_t i = node->childFirstChars.find(*label);
+
+        if (i == std::string::npos) {
+            std::unique_ptr<Node> child(new Node);
+            child->label.assign(label, labelLength);
+            node->childFirstChars.push_back(*label);
+            node->children.push_back(std::move(child));
+            return node->children.back().get();
+        }
+
+        Node *child = node->children[i].get();
+        std::size_t n = 0;
+
+        while (n < labelLength && n < child->label.size() && child->label[n] == label[n]) {
+            ++n;
+        }
+
+        if (n < child->label.size()) {
+            std::unique_ptr<Node> parent(new Node);
+            parent->label.assign(child->label, 0, n);
+            child->label.erase(0, n);
+            parent->childFirstChars.push_back(child->label[0]);
+            parent->children.push_back(std::move(node->children[i]));
+            node->children[i] = std::move(parent);
+            child = node->children[i].get();
+        }
+
+        node = child;
+        label += n;
+        labelLength -= n;
+    }
+
+    return node;
+}
+
+
+std::size_t
+RouterBase::MatchNode(const Node *node, const char *s1, const char *s2
+                      , RouteParameters *parameters) noexcept
+{
+    if (s1 == s2 && node->routeIndex != std::size_t(-1)) {
+        return node->routeIndex;
+    }
+
+    if (s1 < s2) {
+        auto firstChar = static_cast<const char *>(std::memchr(node->childFirstChars.data(), *s1
+                                                               , node->childFirstChars.size()));
+
+        if (firstChar != nullptr) {
+            const Node *child = node->children[firstChar - node->childFirstChars.data()].get();
+            std::size_t n = child->label.size();
+
+            if (static_cast<std::size_t>(s2 - s1) >= n
+                && std::memcmp(s1, child->label.data(), n) == 0) {
+                std::size_t routeIndex = MatchNode(child, s1 + n, s2, parameters);
+
+                if (routeIndex != std::size_t(-1)) {
+                    return routeIndex;
+                }
+            }
+        }
+
+        if (node->parameterChild != nullptr && *s1 != '/') {
+            auto s3 = static_cast<const char *>(std::memchr(s1, '/', s2 - s1));
+
+            if (s3 == nullptr) {
+                s3 = s2;
+            }
+
+            std::size_t i = parameters->count_++;
+            parameters->items_[i].value = s1;
+            parameters->items_[i].valueSize = s3 - s1;
+            std::size_t routeIndex = MatchNode(node->parameterChild.get(), s3, s2, parameters);
+
+            if (routeIndex != std::size_t(-1)) {
+                return routeIndex;
+            }
+
+            parameters->count_ = i;
+        }
+    }
+
+    if (node->wildcardChild != nullptr && node->wildcardChild->routeIndex != std::size_t(-1)) {
+        std::size_t i = parameters->count_++;
+        parameters->items_[i].value = s1;
+        parameters->items_[i].valueSize = s2 - s1;
+        return node->wildcardChild->routeIndex;
+    }
+
+    return -1;
+}
+
+} // namespace detail
+
+} // namespace http
+
+} // namespace siren
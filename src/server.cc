@@ -0,0 +1,345 @@
+#include "server.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+
+#include <siren/assert.h>
+#include <siren/loop.h>
+#include <siren/stream.h>
+#include <siren/tcp_socket.h>
+
+#include "mpsc_queue.h"
+#include "timer_wheel.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+struct Reactor
+{
+    unsigned int number;
+    Loop loop;
+    std::unique_ptr<IOURing> ioURing;
+    TCPSocket listener;
+    std::thread thread;
+    int eventFD;
+    MPSCQueue<int> handoffQueue;
+    std::atomic_long load;
+    TimerWheel timerWheel;
+    std::unordered_set<int> connectionFDs;
+
+    explicit Reactor(unsigned int, const http::ServerOptions &);
+    ~Reactor();
+};
+
+
+Reactor::Reactor(unsigned int number, const http::ServerOptions &options)
+  : number(number),
+    ioURing(options.transport == ConnectionTransport::IOURing ? new IOURing(options, &loop)
+                                                               : nullptr),
+    listener(&loop),
+    eventFD(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+    load(0),
+    timerWheel(options.timerTickInterval)
+{
+    if (eventFD < 0) {
+        throw std::system_error(errno, std::system_category(), "eventfd() failed");
+    }
+}
+
+
+Reactor::~Reactor()
+{
+    int fd;
+
+    while (handoffQueue.pop(&fd)) {
+        ::close(fd);
+    }
+
+    ::close(eventFD);
+}
+
+} // namespace detail
+
+
+Server::Server(const ServerOptions &options, Handler handler)
+  : options_(options),
+    handler_(std::move(handler)),
+    localEndpoint_(),
+    isStopping_(false)
+{
+    SIREN_ASSERT(handler_ != nullptr);
+}
+
+
+Server::~Server()
+{
+    if (isRunning()) {
+        stop();
+        wait();
+    }
+}
+
+
+void
+Server::start(const IPEndpoint &endpoint)
+{
+    SIREN_ASSERT(!isRunning());
+    unsigned int numberOfReactors = options_.numberOfReactors;
+
+    if (numberOfReactors == 0) {
+        numberOfReactors = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+    std::vector<std::unique_ptr<detail::Reactor>> reactors;
+    localEndpoint_ = endpoint;
+
+    for (unsigned int i = 0; i < numberOfReactors; ++i) {
+        reactors.emplace_back(new detail::Reactor(i, options_));
+        TCPSocket *listener = &reactors.back()->listener;
+        listener->setReuseAddress(true);
+        listener->setReusePort(true);
+        listener->listen(localEndpoint_, options_.backlog);
+
+        if (i == 0) {
+            localEndpoint_ = listener->getLocalEndpoint();
+        }
+    }
+
+    isStopping_.store(false, std::memory_order_relaxed);
+    reactors_ = std::move(reactors);
+
+    for (const std::unique_ptr<detail::Reactor> &reactor : reactors_) {
+        reactor->thread = std::thread(&Server::runReactor, this, reactor.get());
+    }
+}
+
+
+void
+Server::stop() noexcept
+{
+    SIREN_ASSERT(isRunning());
+    isStopping_.store(true, std::memory_order_release);
+
+    for (const std::unique_ptr<detail::Reactor> &reactor : reactors_) {
+        ::shutdown(reactor->listener.getFD(), SHUT_RDWR);
+        WakeReactor(reactor.get());
+    }
+}
+
+
+void
+Server::wait()
+{
+    SIREN_ASSERT(isRunning());
+
+    for (const std::unique_ptr<detail::Reactor> &reactor : reactors_) {
+        if (reactor->thread.joinable()) {
+            reactor->thread.join();
+        }
+    }
+
+    reactors_.clear();
+}
+
+
+void
+Server::WakeReactor(detail::Reactor *reactor) noexcept
+{
+    std::uint64_t counter = 1;
+    ::write(reactor->eventFD, &counter, sizeof(counter));
+}
+
+
+void
+Server::runReactor(detail::Reactor *reactor)
+{
+    if (options_.reactorsArePinned) {
+        unsigned int numberOfCPUs = std::max(std::thread::hardware_concurrency(), 1U);
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(reactor->number % numberOfCPUs, &cpuSet);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    }
+
+    reactor->loop.createFiber([this, reactor] () -> void {
+        acceptConnections(reactor);
+    });
+
+    reactor->loop.createFiber([this, reactor] () -> void {
+        receiveConnections(reactor);
+    });
+
+    reactor->loop.createFiber([this, reactor] () -> void {
+        runTimers(reactor);
+    });
+
+    if (reactor->ioURing != nullptr) {
+        reactor->loop.createFiber([reactor] () -> void {
+            reactor->ioURing->run();
+        });
+    }
+
+    reactor->loop.run();
+}
+
+
+void
+Server::acceptConnections(detail::Reactor *reactor)
+{
+    for (;;) {
+        std::shared_ptr<TCPSocket> tcpSocket;
+
+        try {
+            tcpSocket = std::make_shared<TCPSocket>(reactor->listener.accept());
+        } catch (const std::system_error &) {
+            if (isStopping_.load(std::memory_order_acquire)) {
+                return;
+            }
+
+            throw;
+        }
+
+        detail::Reactor *targetReactor = selectReactor(reactor);
+
+        if (targetReactor != reactor) {
+            int fd = ::dup(tcpSocket->getFD());
+
+            if (fd >= 0) {
+                tcpSocket.reset();
+                targetReactor->load.fetch_add(1, std::memory_order_relaxed);
+                targetReactor->handoffQueue.push(fd);
+                WakeReactor(targetReactor);
+                continue;
+            }
+        }
+
+        reactor->load.fetch_add(1, std::memory_order_relaxed);
+
+        reactor->loop.createFiber([this, reactor, tcpSocket] () -> void {
+            serveConnection(reactor, tcpSocket.get());
+        });
+    }
+}
+
+
+void
+Server::receiveConnections(detail::Reactor *reactor)
+{
+    reactor->loop.registerFD(reactor->eventFD);
+
+    while (!isStopping_.load(std::memory_order_acquire)) {
+        std::uint64_t counter;
+        reactor->loop.read(reactor->eventFD, &counter, sizeof(counter));
+        int fd;
+
+        while (reactor->handoffQueue.pop(&fd)) {
+            auto tcpSocket = std::make_shared<TCPSocket>(&reactor->loop, fd);
+
+            reactor->loop.createFiber([this, reactor, tcpSocket] () -> void {
+                serveConnection(reactor, tcpSocket.get());
+            });
+        }
+    }
+
+    reactor->loop.unregisterFD(reactor->eventFD);
+
+    for (int fd : reactor->connectionFDs) {
+        ::shutdown(fd, SHUT_RD);
+    }
+
+    if (reactor->ioURing != nullptr) {
+        reactor->ioURing->stop();
+    }
+}
+
+
+void
+Server::runTimers(detail::Reactor *reactor)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point lastTime = Clock::now();
+
+    while (!isStopping_.load(std::memory_order_acquire)) {
+        reactor->loop.usleep(options_.timerTickInterval * 1000);
+        auto elapsedTime = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now()
+                                                                                 - lastTime);
+        lastTime += elapsedTime;
+
+        reactor->timerWheel.advance(elapsedTime.count(), [] (detail::Timer *timer) -> void {
+            static_cast<detail::ConnectionTimer *>(timer)->expire();
+        });
+    }
+}
+
+
+detail::Reactor *
+Server::selectReactor(detail::Reactor *reactor) const noexcept
+{
+    detail::Reactor *minLoadReactor = reactor;
+    long minLoad = reactor->load.load(std::memory_order_relaxed);
+    long load = minLoad;
+
+    for (const std::unique_ptr<detail::Reactor> &otherReactor : reactors_) {
+        long otherLoad = otherReactor->load.load(std::memory_order_relaxed);
+
+        if (otherLoad < minLoad) {
+            minLoadReactor = otherReactor.get();
+            minLoad = otherLoad;
+        }
+    }
+
+    if (static_cast<unsigned long>(load - minLoad) > options_.maxLoadImbalance) {
+        return minLoadReactor;
+    } else {
+        return reactor;
+    }
+}
+
+
+void
+Server::serveConnection(detail::Reactor *reactor, TCPSocket *tcpSocket)
+{
+    tcpSocket->setNoDelay(true);
+    int fd = tcpSocket->getFD();
+    reactor->connectionFDs.insert(fd);
+
+    if (isStopping_.load(std::memory_order_acquire)) {
+        ::shutdown(fd, SHUT_RD);
+    }
+
+    Connection connection(options_, std::move(*tcpSocket), &reactor->timerWheel
+                          , reactor->ioURing.get());
+
+    try {
+        handler_(&connection);
+        connection.flush();
+    } catch (const EndOfStream &) {
+    } catch (const ParseException &) {
+    } catch (const std::system_error &) {
+    } catch (...) {
+    }
+
+    reactor->connectionFDs.erase(fd);
+    reactor->load.fetch_sub(1, std::memory_order_relaxed);
+}
+
+} // namespace http
+
+} // namespace siren
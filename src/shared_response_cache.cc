@@ -0,0 +1,615 @@
+#include "shared_response_cache.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <siren/assert.h>
+
+#include "response_cache.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace {
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2
+              , "shared memory requires address-free atomics");
+
+
+enum SegmentState : std::uint64_t
+{
+    SegmentUninitialized = 0,
+    SegmentInitializing,
+    SegmentReady,
+};
+
+
+std::uint64_t HashKey(const std::string &) noexcept;
+std::size_t AlignSize(std::size_t, std::size_t) noexcept;
+std::uint64_t GetBootTag();
+std::int64_t GetCurrentTime() noexcept;
+bool ProcessIsDead(std::uint32_t) noexcept;
+void Relax(unsigned int *) noexcept;
+
+} // namespace
+
+
+SharedResponseCache::SharedResponseCache(const SharedResponseCacheOptions &options)
+  : options_(options)
+{
+    SIREN_ASSERT(options_.segmentSize >= sizeof(SegmentHeader));
+    SIREN_ASSERT(options_.numberOfBuckets >= 1);
+    SIREN_ASSERT(options_.slabSize >= detail::MinSharedCacheChunkSize);
+    void *segment;
+
+    if (options_.segmentFileName.empty()) {
+        segment = mmap(nullptr, options_.segmentSize, PROT_READ | PROT_WRITE
+                       , MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    } else {
+        int fd = open(options_.segmentFileName.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+
+        if (fd < 0) {
+            throw std::system_error(errno, std::system_category(), "open() failed");
+        }
+
+        struct stat fileStatus;
+
+        if (fstat(fd, &fileStatus) < 0) {
+            int errorNumber = errno;
+            close(fd);
+            throw std::system_error(errorNumber, std::system_category(), "fstat() failed");
+        }
+
+        if (static_cast<std::size_t>(fileStatus.st_size) < options_.segmentSize
+            && ftruncate(fd, options_.segmentSize) < 0) {
+            int errorNumber = errno;
+            close(fd);
+            throw std::system_error(errorNumber, std::system_category(), "ftruncate() failed");
+        }
+
+        segment = mmap(nullptr, options_.segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+
+    if (segment == MAP_FAILED) {
+        throw std::system_error(errno, std::system_category(), "mmap() failed");
+    }
+
+    segment_ = static_cast<char *>(segment);
+    segmentHeader_ = reinterpret_cast<SegmentHeader *>(segment_);
+    std::uint64_t readyState = GetBootTag() << 2 | SegmentReady;
+
+    for (unsigned int n = 0;; Relax(&n)) {
+        std::uint64_t state = segmentHeader_->state.load(std::memory_order_acquire);
+
+        if (state == readyState) {
+            break;
+        }
+
+        if (state != SegmentInitializing
+            && segmentHeader_->state.compare_exchange_weak(state, SegmentInitializing
+                                                           , std::memory_order_acquire
+                                                           , std::memory_order_relaxed)) {
+            initializeSegment();
+            segmentHeader_->state.store(readyState, std::memory_order_release);
+            break;
+        }
+    }
+
+    if (segmentHeader_->segmentSize != options_.segmentSize
+        || segmentHeader_->numberOfBuckets != options_.numberOfBuckets
+        || segmentHeader_->slabSize != options_.slabSize
+        || segmentHeader_->numberOfSlabs == 0) {
+        munmap(segment_, options_.segmentSize);
+        throw std::runtime_error("incompatible shared cache segment");
+    }
+
+    buckets_ = reinterpret_cast<Bucket *>(segment_ + segmentHeader_->bucketsOffset);
+}
+
+
+SharedResponseCache::~SharedResponseCache()
+{
+    munmap(segment_, options_.segmentSize);
+}
+
+
+std::shared_ptr<const CachedResponse>
+SharedResponseCache::findResponse(const Request &request)
+{
+    if (!detail::RequestAllowsCachedResponse(request)) {
+        return nullptr;
+    }
+
+    std::string value;
+
+    if (!findItem(detail::MakeResponseCacheKey(request), &value)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<const CachedResponse> cachedResponse
+        = detail::CachedResponseAccess::Deserialize(value.data(), value.size());
+
+    if (cachedResponse == nullptr || !cachedResponse->matchRequest(request)) {
+        return nullptr;
+    }
+
+    return cachedResponse;
+}
+
+
+std::shared_ptr<const CachedResponse>
+SharedResponseCache::storeResponse(const Request &request, const Response &response
+                                   , const void *body, std::size_t bodySize)
+{
+    std::shared_ptr<const CachedResponse> cachedResponse
+        = detail::CachedResponseAccess::Make(request, response, body, bodySize
+                                             , options_.maxResponseSize);
+
+    if (cachedResponse == nullptr) {
+        return nullptr;
+    }
+
+    std::string value;
+    detail::CachedResponseAccess::Serialize(*cachedResponse, &value);
+    storeItem(detail::MakeResponseCacheKey(request), value.data(), value.size()
+              , cachedResponse->getExpiryTime());
+    return cachedResponse;
+}
+
+
+bool
+SharedResponseCache::findItem(const std::string &key, std::string *value)
+{
+    std::uint64_t keyHash = HashKey(key);
+    Bucket *bucket = getBucket(keyHash);
+
+    for (unsigned int n = 0;; Relax(&n)) {
+        std::uint32_t sequenceNumber = bucket->sequenceNumber.load(std::memory_order_acquire);
+
+        if ((sequenceNumber & 1) == 1) {
+            if (n % 1024 == 1023 && tryRecoverBucket(bucket)) {
+                unlockBucket(bucket);
+            }
+
+            continue;
+        }
+
+        Item item;
+        bool itemIsFound = false;
+
+        for (const Item &item2 : bucket->items) {
+            std::memcpy(&item, &item2, sizeof(item));
+
+            if (item.chunkOffset != 0 && item.keyHash == keyHash && item.keySize == key.size()) {
+                itemIsFound = true;
+                break;
+            }
+        }
+
+        bool keyIsMatched = false;
+
+        if (itemIsFound && item.chunkOffset >= segmentHeader_->slabsOffset
+            && item.chunkOffset + item.keySize + item.valueSize <= options_.segmentSize) {
+            const char *chunk = segment_ + item.chunkOffset;
+            keyIsMatched = std::memcmp(chunk, key.data(), key.size()) == 0;
+
+            if (keyIsMatched) {
+                value->assign(chunk + item.keySize, item.valueSize);
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (bucket->sequenceNumber.load(std::memory_order_relaxed) != sequenceNumber) {
+            continue;
+        }
+
+        return keyIsMatched && item.expiryTime > GetCurrentTime();
+    }
+}
+
+
+bool
+SharedResponseCache::storeItem(const std::string &key, const void *value, std::size_t valueSize
+                               , std::chrono::steady_clock::time_point expiryTime)
+{
+    std::size_t chunkSize = key.size() + valueSize;
+    std::size_t slabClassIndex = 0;
+
+    while (detail::MinSharedCacheChunkSize << slabClassIndex < chunkSize) {
+        if (++slabClassIndex == segmentHeader_->numberOfSlabClasses) {
+            return false;
+        }
+    }
+
+    std::uint64_t chunkOffset = allocateChunk(slabClassIndex);
+
+    while (chunkOffset == 0) {
+        if (segmentHeader_->numberOfSlabClassItems[slabClassIndex].load(std::memory_order_relaxed)
+            == 0 || !evictItems(slabClassIndex)) {
+            return false;
+        }
+
+        chunkOffset = allocateChunk(slabClassIndex);
+    }
+
+    char *chunk = segment_ + chunkOffset;
+    std::memcpy(chunk, key.data(), key.size());
+    std::memcpy(chunk + key.size(), value, valueSize);
+    std::uint64_t keyHash = HashKey(key);
+    Bucket *bucket = getBucket(keyHash);
+    lockBucket(bucket);
+    Item *victimItem = nullptr;
+
+    for (Item &item : bucket->items) {
+        if (item.chunkOffset != 0 && item.keyHash == keyHash && item.keySize == key.size()
+            && std::memcmp(segment_ + item.chunkOffset, key.data(), key.size()) == 0) {
+            victimItem = &item;
+            break;
+        }
+    }
+
+    if (victimItem == nullptr) {
+        victimItem = &bucket->items[0];
+
+        for (Item &item : bucket->items) {
+            if (item.chunkOffset == 0) {
+                victimItem = &item;
+                break;
+            }
+
+            if (item.expiryTime < victimItem->expiryTime) {
+                victimItem = &item;
+            }
+        }
+    }
+
+    Item oldItem = *victimItem;
+    victimItem->keyHash = keyHash;
+    victimItem->chunkOffset = chunkOffset;
+    victimItem->expiryTime = expiryTime.time_since_epoch().count();
+    victimItem->keySize = key.size();
+    victimItem->valueSize = valueSize;
+    victimItem->slabClassIndex = slabClassIndex;
+    unlockBucket(bucket);
+    segmentHeader_->numberOfSlabClassItems[slabClassIndex].fetch_add(1
+                                                                     , std::memory_order_relaxed);
+
+    if (oldItem.chunkOffset == 0) {
+        segmentHeader_->numberOfItems.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        segmentHeader_->numberOfSlabClassItems[oldItem.slabClassIndex]
+            .fetch_sub(1, std::memory_order_relaxed);
+        freeChunk(oldItem.chunkOffset, oldItem.slabClassIndex);
+    }
+
+    return true;
+}
+
+
+void
+SharedResponseCache::removeItem(const std::string &key)
+{
+    std::uint64_t keyHash = HashKey(key);
+    Bucket *bucket = getBucket(keyHash);
+    lockBucket(bucket);
+    Item oldItem = {};
+
+    for (Item &item : bucket->items) {
+        if (item.chunkOffset != 0 && item.keyHash == keyHash && item.keySize == key.size()
+            && std::memcmp(segment_ + item.chunkOffset, key.data(), key.size()) == 0) {
+            oldItem = item;
+            item.chunkOffset = 0;
+            break;
+        }
+    }
+
+    unlockBucket(bucket);
+
+    if (oldItem.chunkOffset != 0) {
+        segmentHeader_->numberOfItems.fetch_sub(1, std::memory_order_relaxed);
+        segmentHeader_->numberOfSlabClassItems[oldItem.slabClassIndex]
+            .fetch_sub(1, std::memory_order_relaxed);
+        freeChunk(oldItem.chunkOffset, oldItem.slabClassIndex);
+    }
+}
+
+
+std::size_t
+SharedResponseCache::getNumberOfItems() const noexcept
+{
+    return segmentHeader_->numberOfItems.load(std::memory_order_relaxed);
+}
+
+
+void
+SharedResponseCache::initializeSegment() noexcept
+{
+    std::size_t bucketsOffset = AlignSize(sizeof(SegmentHeader), alignof(Bucket));
+    std::size_t slabsOffset = AlignSize(bucketsOffset + options_.numberOfBuckets * sizeof(Bucket)
+                                        , alignof(Bucket));
+    segmentHeader_->segmentSize = options_.segmentSize;
+    segmentHeader_->numberOfBuckets = options_.numberOfBuckets;
+    segmentHeader_->slabSize = options_.slabSize;
+    segmentHeader_->numberOfSlabs = slabsOffset > options_.segmentSize
+                                    ? 0 : (options_.segmentSize - slabsOffset) / options_.slabSize;
+    segmentHeader_->numberOfSlabClasses = 0;
+
+    while (segmentHeader_->numberOfSlabClasses < detail::MaxNumberOfSharedCacheSlabClasses
+           && detail::MinSharedCacheChunkSize << segmentHeader_->numberOfSlabClasses
+              <= options_.slabSize) {
+        ++segmentHeader_->numberOfSlabClasses;
+    }
+
+    segmentHeader_->bucketsOffset = bucketsOffset;
+    segmentHeader_->slabsOffset = slabsOffset;
+    segmentHeader_->allocatorLock.store(0, std::memory_order_relaxed);
+    segmentHeader_->numberOfUsedSlabs = 0;
+
+    for (std::uint64_t &freeChunkOffset : segmentHeader_->freeChunkOffsets) {
+        freeChunkOffset = 0;
+    }
+
+    segmentHeader_->clockHand.store(0, std::memory_order_relaxed);
+    segmentHeader_->numberOfItems.store(0, std::memory_order_relaxed);
+
+    for (std::atomic<std::uint64_t> &numberOfSlabClassItems
+         : segmentHeader_->numberOfSlabClassItems) {
+        numberOfSlabClassItems.store(0, std::memory_order_relaxed);
+    }
+
+    if (segmentHeader_->numberOfSlabs >= 1) {
+        std::memset(segment_ + bucketsOffset, 0, options_.numberOfBuckets * sizeof(Bucket));
+    }
+}
+
+
+SharedResponseCache::Bucket *
+SharedResponseCache::getBucket(std::uint64_t keyHash) noexcept
+{
+    return &buckets_[keyHash % options_.numberOfBuckets];
+}
+
+
+void
+SharedResponseCache::lockBucket(Bucket *bucket) noexcept
+{
+    for (unsigned int n = 0; !tryLockBucket(bucket); Relax(&n)) {
+        if (n % 1024 == 1023 && tryRecoverBucket(bucket)) {
+            return;
+        }
+    }
+}
+
+
+bool
+SharedResponseCache::tryLockBucket(Bucket *bucket) noexcept
+{
+    std::uint32_t sequenceNumber = bucket->sequenceNumber.load(std::memory_order_relaxed);
+
+    if ((sequenceNumber & 1) == 1
+        || !bucket->sequenceNumber.compare_exchange_weak(sequenceNumber, sequenceNumber + 1
+                                                         , std::memory_order_acquire
+                                                         , std::memory_order_relaxed)) {
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_release);
+    bucket->ownerPID.store(getpid(), std::memory_order_relaxed);
+    return true;
+}
+
+
+bool
+SharedResponseCache::tryRecoverBucket(Bucket *bucket) noexcept
+{
+    std::uint32_t ownerPID = bucket->ownerPID.load(std::memory_order_relaxed);
+
+    return ProcessIsDead(ownerPID)
+           && bucket->ownerPID.compare_exchange_strong(ownerPID, getpid()
+                                                       , std::memory_order_acquire
+                                                       , std::memory_order_relaxed);
+}
+
+
+void
+SharedResponseCache::unlockBucket(Bucket *bucket) noexcept
+{
+    bucket->ownerPID.store(0, std::memory_order_relaxed);
+    bucket->sequenceNumber.fetch_add(1, std::memory_order_release);
+}
+
+
+void
+SharedResponseCache::lockAllocator() noexcept
+{
+    std::uint32_t pid = getpid();
+
+    for (unsigned int n = 0;; Relax(&n)) {
+        std::uint32_t allocatorLock = 0;
+
+        if (segmentHeader_->allocatorLock.compare_exchange_weak(allocatorLock, pid
+                                                                , std::memory_order_acquire
+                                                                , std::memory_order_relaxed)) {
+            return;
+        }
+
+        if (n % 1024 == 1023 && ProcessIsDead(allocatorLock)
+            && segmentHeader_->allocatorLock.compare_exchange_strong(allocatorLock, pid
+                                                                     , std::memory_order_acquire
+                                                                     , std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+
+void
+SharedResponseCache::unlockAllocator() noexcept
+{
+    segmentHeader_->allocatorLock.store(0, std::memory_order_release);
+}
+
+
+std::uint64_t
+SharedResponseCache::allocateChunk(std::size_t slabClassIndex) noexcept
+{
+    lockAllocator();
+    std::uint64_t *freeChunkOffset = &segmentHeader_->freeChunkOffsets[slabClassIndex];
+
+    if (*freeChunkOffset == 0
+        && segmentHeader_->numberOfUsedSlabs < segmentHeader_->numberOfSlabs) {
+        std::size_t chunkSize = detail::MinSharedCacheChunkSize << slabClassIndex;
+        std::uint64_t slabOffset = segmentHeader_->slabsOffset
+                                   + segmentHeader_->numberOfUsedSlabs++ * options_.slabSize;
+
+        for (std::size_t i = options_.slabSize / chunkSize; i >= 1; --i) {
+            std::uint64_t chunkOffset = slabOffset + (i - 1) * chunkSize;
+            std::memcpy(segment_ + chunkOffset, freeChunkOffset, sizeof(*freeChunkOffset));
+            *freeChunkOffset = chunkOffset;
+        }
+    }
+
+    std::uint64_t chunkOffset = *freeChunkOffset;
+
+    if (chunkOffset != 0) {
+        std::memcpy(freeChunkOffset, segment_ + chunkOffset, sizeof(*freeChunkOffset));
+    }
+
+    unlockAllocator();
+    return chunkOffset;
+}
+
+
+void
+SharedResponseCache::freeChunk(std::uint64_t chunkOffset, std::size_t slabClassIndex) noexcept
+{
+    lockAllocator();
+    std::uint64_t *freeChunkOffset = &segmentHeader_->freeChunkOffsets[slabClassIndex];
+    std::memcpy(segment_ + chunkOffset, freeChunkOffset, sizeof(*freeChunkOffset));
+    *freeChunkOffset = chunkOffset;
+    unlockAllocator();
+}
+
+
+bool
+SharedResponseCache::evictItems(std::size_t slabClassIndex) noexcept
+{
+    bool chunkIsFreed = false;
+
+    for (std::size_t i = 0; i < options_.numberOfBuckets && !chunkIsFreed; ++i) {
+        Bucket *bucket = &buckets_[segmentHeader_->clockHand.fetch_add(1
+                                                                       , std::memory_order_relaxed)
+                                   % options_.numberOfBuckets];
+
+        if (!tryLockBucket(bucket)) {
+            continue;
+        }
+
+        Item oldItems[detail::SharedCacheBucketSize];
+        std::size_t numberOfOldItems = 0;
+        std::int64_t currentTime = GetCurrentTime();
+
+        for (Item &item : bucket->items) {
+            if (item.chunkOffset != 0
+                && (item.expiryTime <= currentTime || (item.slabClassIndex == slabClassIndex
+                                                       && !chunkIsFreed))) {
+                chunkIsFreed = chunkIsFreed || item.slabClassIndex == slabClassIndex;
+                oldItems[numberOfOldItems++] = item;
+                item.chunkOffset = 0;
+            }
+        }
+
+        unlockBucket(bucket);
+        segmentHeader_->numberOfItems.fetch_sub(numberOfOldItems, std::memory_order_relaxed);
+
+        for (std::size_t j = 0; j < numberOfOldItems; ++j) {
+            segmentHeader_->numberOfSlabClassItems[oldItems[j].slabClassIndex]
+                .fetch_sub(1, std::memory_order_relaxed);
+            freeChunk(oldItems[j].chunkOffset, oldItems[j].slabClassIndex);
+        }
+    }
+
+    return chunkIsFreed;
+}
+
+
+namespace {
+
+std::uint64_t
+HashKey(const std::string &key) noexcept
+{
+    std::uint64_t keyHash = UINT64_C(14695981039346656037);
+
+    for (char c : key) {
+        keyHash ^= static_cast<unsigned char>(c);
+        keyHash *= UINT64_C(1099511628211);
+    }
+
+    return keyHash ^ keyHash >> 32;
+}
+
+
+std::size_t
+AlignSize(std::size_t size, std::size_t alignment) noexcept
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+
+std::uint64_t
+GetBootTag()
+{
+    char bootID[64] = {};
+    int fd = open("/proc/sys/kernel/random/boot_id", O_RDONLY | O_CLOEXEC);
+
+    if (fd >= 0) {
+        while (read(fd, bootID, sizeof(bootID) - 1) < 0 && errno == EINTR) {
+        }
+
+        close(fd);
+    }
+
+    return HashKey(bootID);
+}
+
+
+std::int64_t
+GetCurrentTime() noexcept
+{
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+
+bool
+ProcessIsDead(std::uint32_t pid) noexcept
+{
+    return pid != 0 && kill(pid, 0) < 0 && errno == ESRCH;
+}
+
+
+void
+Relax(unsigned int *numberOfSpins) noexcept
+{
+    if (++*numberOfSpins % 64 == 0) {
+        sched_yield();
+    }
+}
+
+} // namespace
+
+} // namespace http
+
+} // namespace siren
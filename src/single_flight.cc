@@ -0,0 +1,178 @@
+#include "single_flight.h"
+
+#include <strings.h>
+
+#include <cstring>
+#include <utility>
+
+#include <siren/assert.h>
+
+#include "connection.h"
+#include "request.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace detail {
+
+Flight::Flight(Loop *loop)
+  : semaphore(loop),
+    numberOfWaiters(0)
+{
+}
+
+} // namespace detail
+
+
+SingleFlight::SingleFlight(Loop *loop, const SingleFlightOptions &options)
+  : loop_(loop),
+    options_(options)
+{
+    SIREN_ASSERT(loop != nullptr);
+}
+
+
+std::shared_ptr<const SharedResponse>
+SingleFlight::fetch(const Request &request, const Fetcher &fetcher)
+{
+    if (request.methodType != MethodType::Get && request.methodType != MethodType::Head) {
+        return fetcher();
+    }
+
+    std::string flightKey = makeFlightKey(request);
+    auto it = flights_.find(flightKey);
+
+    if (it != flights_.end()) {
+        std::shared_ptr<detail::Flight> flight = it->second;
+        ++flight->numberOfWaiters;
+        flight->semaphore.down();
+
+        if (flight->exception != nullptr) {
+            std::rethrow_exception(flight->exception);
+        }
+
+        return flight->sharedResponse;
+    }
+
+    auto flight = std::make_shared<detail::Flight>(loop_);
+    it = flights_.emplace(std::move(flightKey), flight).first;
+
+    try {
+        flight->sharedResponse = fetcher();
+    } catch (...) {
+        flight->exception = std::current_exception();
+    }
+
+    flights_.erase(it);
+
+    for (std::size_t i = 0; i < flight->numberOfWaiters; ++i) {
+        flight->semaphore.up();
+    }
+
+    if (flight->exception != nullptr) {
+        std::rethrow_exception(flight->exception);
+    }
+
+    return flight->sharedResponse;
+}
+
+
+std::string
+SingleFlight::makeFlightKey(const Request &request) const
+{
+    std::string flightKey = GetMethodName(request.methodType);
+    flightKey += ' ';
+
+    request.header.traverse([&] (std::size_t, const char *headerFieldName
+                                 , const char *headerFieldValue) -> void {
+        if (std::strcmp(headerFieldName, "Host") == 0) {
+            flightKey += headerFieldValue;
+        }
+    });
+
+    flightKey += request.uri.getPathName();
+    const char *queryString = request.uri.getQueryString();
+
+    if (*queryString != '\0') {
+        flightKey += '?';
+        flightKey += queryString;
+    }
+
+    for (const std::string &varyFieldName : options_.varyFieldNames) {
+        flightKey += '\n';
+        flightKey += varyFieldName;
+        flightKey += ':';
+
+        request.header.traverse([&] (std::size_t, const char *headerFieldName
+                                     , const char *headerFieldValue) -> void {
+            if (strcasecmp(headerFieldName, varyFieldName.c_str()) == 0) {
+                flightKey += headerFieldValue;
+                flightKey += ',';
+            }
+        });
+    }
+
+    return flightKey;
+}
+
+
+std::shared_ptr<const SharedResponse>
+FetchSharedResponse(Connection *connection, const Request &request)
+{
+    connection->dumpRequest(request, 0);
+    auto sharedResponse = std::make_shared<SharedResponse>();
+    PayloadReader payloadReader = connection->parseResponse(&sharedResponse->response
+                                                            , request.methodType);
+
+    for (;;) {
+        std::size_t n = payloadReader.getRemainingBodyOrChunkSize();
+
+        if (n == 0 && !payloadReader.bodyIsChunked()) {
+            break;
+        }
+
+        const char *data = payloadReader.peekData(n);
+
+        if (n >= 1) {
+            sharedResponse->body.append(data, n);
+        }
+
+        payloadReader.discardData(n);
+    }
+
+    return sharedResponse;
+}
+
+
+void
+DumpSharedResponse(Connection *connection, const SharedResponse &sharedResponse)
+{
+    const Response &response = sharedResponse.response;
+    Response response2;
+    response2.majorVersionNumber = response.majorVersionNumber;
+    response2.minorVersionNumber = response.minorVersionNumber;
+    response2.statusCode = response.statusCode;
+    response2.reasonPhrase = response.reasonPhrase;
+
+    response.header.traverse([&] (std::size_t, const char *headerFieldName
+                                  , const char *headerFieldValue) -> void {
+        if (std::strcmp(headerFieldName, "Connection") != 0
+            && std::strcmp(headerFieldName, "Keep-Alive") != 0) {
+            response2.header.addField(headerFieldName, headerFieldValue);
+        }
+    });
+
+    const std::string &body = sharedResponse.body;
+    PayloadWriter payloadWriter = connection->dumpResponse(response2, body.size());
+
+    if (body.size() >= 1) {
+        std::memcpy(payloadWriter.reserveBuffer(body.size()), body.data(), body.size());
+        payloadWriter.flushBuffer(body.size());
+    }
+}
+
+} // namespace http
+
+} // namespace siren
@@ -0,0 +1,605 @@
+#include "static_files.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <siren/assert.h>
+
+#include "byte_range.h"
+#include "connection.h"
+#include "etag.h"
+#include "request.h"
+#include "response.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace {
+
+struct FileExtension
+{
+    const char *name;
+    const char *contentType;
+};
+
+
+constexpr FileExtension FileExtensions[] = {
+    {"7z", "application/x-7z-compressed"},
+    {"avif", "image/avif"},
+    {"bin", "application/octet-stream"},
+    {"bmp", "image/bmp"},
+    {"css", "text/css; charset=utf-8"},
+    {"csv", "text/csv; charset=utf-8"},
+    {"eot", "application/vnd.ms-fontobject"},
+    {"gif", "image/gif"},
+    {"gz", "application/gzip"},
+    {"htm", "text/html; charset=utf-8"},
+    {"html", "text/html; charset=utf-8"},
+    {"ico", "image/x-icon"},
+    {"jpeg", "image/jpeg"},
+    {"jpg", "image/jpeg"},
+    {"js", "text/javascript; charset=utf-8"},
+    {"json", "application/json"},
+    {"map", "application/json"},
+    {"md", "text/markdown; charset=utf-8"},
+    {"mjs", "text/javascript; charset=utf-8"},
+    {"mp3", "audio/mpeg"},
+    {"mp4", "video/mp4"},
+    {"ogg", "audio/ogg"},
+    {"otf", "font/otf"},
+    {"pdf", "application/pdf"},
+    {"png", "image/png"},
+    {"svg", "image/svg+xml"},
+    {"tar", "application/x-tar"},
+    {"ttf", "font/ttf"},
+    {"txt", "text/plain; charset=utf-8"},
+    {"wasm", "application/wasm"},
+    {"wav", "audio/wav"},
+    {"webm", "video/webm"},
+    {"webmanifest", "application/manifest+json"},
+    {"webp", "image/webp"},
+    {"woff", "font/woff"},
+    {"woff2", "font/woff2"},
+    {"xml", "application/xml"},
+    {"zip", "application/zip"},
+};
+
+
+constexpr std::size_t NumberOfFileExtensions = sizeof(FileExtensions)
+                                               / sizeof(FileExtensions[0]);
+
+
+constexpr int CompareFileExtensions(const char *, const char *) noexcept;
+constexpr bool FileExtensionsAreSorted() noexcept;
+int DecodeHexDigit(char) noexcept;
+int OpenFileBeneath(int, const char *) noexcept;
+std::size_t ReadFile(int, char *, std::size_t);
+void DumpStatus(Connection *, const Request &, StatusCode);
+
+} // namespace
+
+
+namespace detail {
+
+StaticFile::StaticFile() noexcept
+  : fd(-1),
+    size(0)
+{
+}
+
+
+StaticFile::~StaticFile()
+{
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+} // namespace detail
+
+
+StaticFiles::StaticFiles(const StaticFilesOptions &options, const std::string &rootDirectoryName)
+  : options_(options),
+    rootDirectoryFD_(open(rootDirectoryName.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+{
+    SIREN_ASSERT(options.maxNumberOfCachedFiles >= 1);
+
+    if (rootDirectoryFD_ < 0) {
+        throw std::system_error(errno, std::system_category(), "open() failed");
+    }
+}
+
+
+StaticFiles::~StaticFiles()
+{
+    close(rootDirectoryFD_);
+}
+
+
+void
+StaticFiles::handleRequest(Connection *connection, const Request &request)
+{
+    handleRequest(connection, request, request.uri.getPathName());
+}
+
+
+void
+StaticFiles::handleRequest(Connection *connection, const Request &request
+                           , const char *pathName)
+{
+    if (request.methodType != MethodType::Get && request.methodType != MethodType::Head) {
+        DumpStatus(connection, request, StatusCode::MethodNotAllowed);
+        return;
+    }
+
+    std::string normalizedPathName;
+
+    if (!NormalizePathName(pathName, &normalizedPathName)) {
+        DumpStatus(connection, request, StatusCode::BadRequest);
+        return;
+    }
+
+    std::shared_ptr<detail::StaticFile> file = getFile(normalizedPathName);
+
+    if (file == nullptr) {
+        DumpStatus(connection, request, StatusCode::NotFound);
+        return;
+    }
+
+    Response response;
+    response.majorVersionNumber = request.majorVersionNumber;
+    response.minorVersionNumber = request.minorVersionNumber;
+    response.statusCode = StatusCode::OK;
+    response.reasonPhrase = DescribeStatus(response.statusCode);
+    response.header.addField("Content-Type", file->contentType);
+    response.header.addField("Last-Modified", file->lastModified);
+    response.header.addField("Accept-Ranges", "bytes");
+
+    if (ResourceIsNotModified(request.header, file->eTag.c_str(), file->lastModified.c_str())) {
+        DumpNotModifiedResponse(connection, &response, file->eTag.c_str());
+        return;
+    }
+
+    response.header.addField("ETag", file->eTag);
+
+    if (request.methodType == MethodType::Head) {
+        char contentLength[32];
+        std::sprintf(contentLength, "%zo", file->size);
+        response.header.addField("Content-Length", contentLength);
+        connection->dumpResponse(response, 0);
+        return;
+    }
+
+    auto writeByteRange = [connection, &file] (PayloadWriter *payloadWriter
+                                               , const ByteRange &byteRange) -> void {
+        if (byteRange.size == 0) {
+            return;
+        }
+
+        if (file->fd >= 0) {
+            connection->sendFile(file->fd, byteRange.offset, byteRange.size);
+        } else {
+            std::memcpy(payloadWriter->reserveBuffer(byteRange.size)
+                        , file->content.data() + byteRange.offset, byteRange.size);
+            payloadWriter->flushBuffer(byteRange.size);
+        }
+    };
+
+    std::vector<ByteRange> byteRanges;
+
+    switch (ParseByteRanges(request.header, file->size, file->eTag.c_str()
+                            , file->lastModified.c_str(), &byteRanges)) {
+    case ByteRangesStatus::Satisfiable:
+        DumpPartialResponse(connection, &response, file->size, byteRanges, writeByteRange);
+        return;
+
+    case ByteRangesStatus::Unsatisfiable:
+        DumpRangeNotSatisfiableResponse(connection, &response, file->size);
+        return;
+
+    default:
+        break;
+    }
+
+    PayloadWriter payloadWriter = connection->dumpResponse(response, file->size);
+    writeByteRange(&payloadWriter, {0, file->size});
+}
+
+
+std::size_t
+StaticFiles::getNumberOfCachedFiles()
+{
+    std::lock_guard<std::mutex> lockGuard(mutex_);
+    return files_.size();
+}
+
+
+std::shared_ptr<detail::StaticFile>
+StaticFiles::getFile(const std::string &pathName)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::shared_ptr<detail::StaticFile> file;
+
+    {
+        std::lock_guard<std::mutex> lockGuard(mutex_);
+        auto it = pathName2File_.find(pathName);
+
+        if (it != pathName2File_.end()) {
+            files_.splice(files_.begin(), files_, it->second);
+            file = it->second->second;
+
+            if (now - file->validationTime
+                < std::chrono::milliseconds(options_.fileRevalidationInterval)) {
+                return file;
+            }
+        }
+    }
+
+    if (file != nullptr && revalidateFile(*file)) {
+        std::lock_guard<std::mutex> lockGuard(mutex_);
+        file->validationTime = now;
+        return file;
+    }
+
+    file = openFile(pathName);
+    std::lock_guard<std::mutex> lockGuard(mutex_);
+    auto it = pathName2File_.find(pathName);
+
+    if (it != pathName2File_.end()) {
+        files_.erase(it->second);
+        pathName2File_.erase(it);
+    }
+
+    if (file == nullptr) {
+        return nullptr;
+    }
+
+    file->validationTime = now;
+
+    while (files_.size() >= options_.maxNumberOfCachedFiles) {
+        pathName2File_.erase(files_.back().first);
+        files_.pop_back();
+    }
+
+    files_.emplace_front(pathName, file);
+    pathName2File_.emplace(pathName, files_.begin());
+    return file;
+}
+
+
+std::shared_ptr<detail::StaticFile>
+StaticFiles::openFile(const std::string &pathName)
+{
+    auto file = std::make_shared<detail::StaticFile>();
+    file->pathName = pathName.empty() ? "." : pathName;
+    struct stat fileStatus;
+
+    for (int i = 0;; ++i) {
+        file->fd = OpenFileBeneath(rootDirectoryFD_, file->pathName.c_str());
+
+        if (file->fd < 0) {
+            if (errno == ENOENT || errno == ENOTDIR || errno == ELOOP || errno == EACCES
+                || errno == ENAMETOOLONG) {
+                return nullptr;
+            }
+
+            throw std::system_error(errno, std::system_category(), "openat() failed");
+        }
+
+        if (fstat(file->fd, &fileStatus) < 0) {
+            throw std::system_error(errno, std::system_category(), "fstat() failed");
+        }
+
+        if (S_ISREG(fileStatus.st_mode)) {
+            break;
+        }
+
+        close(file->fd);
+        file->fd = -1;
+
+        if (!S_ISDIR(fileStatus.st_mode) || i >= 1) {
+            return nullptr;
+        }
+
+        file->pathName += '/';
+        file->pathName += options_.indexFileName;
+    }
+
+    file->deviceID = fileStatus.st_dev;
+    file->inodeNumber = fileStatus.st_ino;
+    file->size = fileStatus.st_size;
+    file->modificationTime = fileStatus.st_mtim;
+    char lastModified[64];
+    std::tm modificationTime;
+    gmtime_r(&fileStatus.st_mtim.tv_sec, &modificationTime);
+    std::strftime(lastModified, sizeof(lastModified), "%a, %d %b %Y %H:%M:%S GMT"
+                  , &modificationTime);
+    file->lastModified = lastModified;
+    file->contentType = LookupContentType(file->pathName.c_str());
+
+    if (file->size <= options_.maxBufferedFileSize) {
+        file->content.resize(file->size);
+        file->size = ReadFile(file->fd, &file->content[0], file->size);
+        file->content.resize(file->size);
+        close(file->fd);
+        file->fd = -1;
+        file->eTag = MakeETag(file->content.data(), file->size);
+    } else {
+        unsigned long long inodeNumber = file->inodeNumber;
+        unsigned long long modificationTime = fileStatus.st_mtim.tv_sec * 1000000000ULL
+                                              + fileStatus.st_mtim.tv_nsec;
+        char eTag[64];
+        std::sprintf(eTag, "\"%llx-%llx-%zx\"", inodeNumber, modificationTime, file->size);
+        file->eTag = eTag;
+    }
+
+    return file;
+}
+
+
+bool
+StaticFiles::revalidateFile(const detail::StaticFile &file)
+{
+    struct stat fileStatus;
+
+    if (fstatat(rootDirectoryFD_, file.pathName.c_str(), &fileStatus, AT_SYMLINK_NOFOLLOW) < 0) {
+        return false;
+    }
+
+    return fileStatus.st_dev == file.deviceID && fileStatus.st_ino == file.inodeNumber
+           && static_cast<std::size_t>(fileStatus.st_size) == file.size
+           && fileStatus.st_mtim.tv_sec == file.modificationTime.tv_sec
+           && fileStatus.st_mtim.tv_nsec == file.modificationTime.tv_nsec;
+}
+
+
+const char *
+LookupContentType(const char *fileName) noexcept
+{
+    const char *baseName = std::strrchr(fileName, '/');
+    baseName = baseName == nullptr ? fileName : baseName + 1;
+    const char *extensionName = std::strrchr(baseName, '.');
+
+    if (extensionName == nullptr || extensionName == baseName) {
+        return "application/octet-stream";
+    }
+
+    ++extensionName;
+    char lowerExtensionName[16];
+    std::size_t n = std::strlen(extensionName);
+
+    if (n >= sizeof(lowerExtensionName)) {
+        return "application/octet-stream";
+    }
+
+    std::transform(extensionName, extensionName + n + 1, lowerExtensionName
+                   , [] (char c) -> char {
+        return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+    });
+
+    const FileExtension *fileExtension = std::lower_bound(
+        FileExtensions, FileExtensions + NumberOfFileExtensions, lowerExtensionName
+        , [] (const FileExtension &fileExtension, const char *name) -> bool {
+            return std::strcmp(fileExtension.name, name) < 0;
+        });
+
+    if (fileExtension == FileExtensions + NumberOfFileExtensions
+        || std::strcmp(fileExtension->name, lowerExtensionName) != 0) {
+        return "application/octet-stream";
+    }
+
+    return fileExtension->contentType;
+}
+
+
+bool
+NormalizePathName(const char *pathName, std::string *normalizedPathName)
+{
+    if (*pathName != '/') {
+        return false;
+    }
+
+    std::string decodedPathName;
+
+    for (const char *s = pathName; *s != '\0'; ++s) {
+        char c = *s;
+
+        if (c == '%') {
+            int d1 = DecodeHexDigit(s[1]);
+            int d2 = d1 < 0 ? -1 : DecodeHexDigit(s[2]);
+
+            if (d2 < 0) {
+                return false;
+            }
+
+            c = d1 << 4 | d2;
+            s += 2;
+        }
+
+        if (c == '\0' || c == '\\') {
+            return false;
+        }
+
+        decodedPathName += c;
+    }
+
+    normalizedPathName->clear();
+
+    for (std::size_t i = 0; i < decodedPathName.size();) {
+        std::size_t j = decodedPathName.find('/', i);
+
+        if (j == std::string::npos) {
+            j = decodedPathName.size();
+        }
+
+        std::size_t n = j - i;
+
+        if (n == 2 && decodedPathName.compare(i, 2, "..") == 0) {
+            if (normalizedPathName->empty()) {
+                return false;
+            }
+
+            std::size_t k = normalizedPathName->rfind('/');
+            normalizedPathName->resize(k == std::string::npos ? 0 : k);
+        } else if (n >= 1 && !(n == 1 && decodedPathName[i] == '.')) {
+            if (!normalizedPathName->empty()) {
+                *normalizedPathName += '/';
+            }
+
+            normalizedPathName->append(decodedPathName, i, n);
+        }
+
+        i = j + 1;
+    }
+
+    return true;
+}
+
+
+namespace {
+
+constexpr int
+CompareFileExtensions(const char *s1, const char *s2) noexcept
+{
+    while (*s1 != '\0' && *s1 == *s2) {
+        ++s1;
+        ++s2;
+    }
+
+    return static_cast<unsigned char>(*s1) - static_cast<unsigned char>(*s2);
+}
+
+
+constexpr bool
+FileExtensionsAreSorted() noexcept
+{
+    for (std::size_t i = 1; i < NumberOfFileExtensions; ++i) {
+        if (CompareFileExtensions(FileExtensions[i - 1].name, FileExtensions[i].name) >= 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static_assert(FileExtensionsAreSorted(), "file extensions not sorted");
+
+
+int
+DecodeHexDigit(char c) noexcept
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+
+    return -1;
+}
+
+
+int
+OpenFileBeneath(int rootDirectoryFD, const char *pathName) noexcept
+{
+    int directoryFD = rootDirectoryFD;
+
+    for (;;) {
+        const char *componentEnd = std::strchr(pathName, '/');
+        int fd;
+
+        if (componentEnd == nullptr) {
+            fd = openat(directoryFD, pathName, O_RDONLY | O_CLOEXEC | O_NOFOLLOW | O_NONBLOCK);
+        } else if (componentEnd - pathName > NAME_MAX) {
+            fd = -1;
+            errno = ENAMETOOLONG;
+        } else {
+            char component[NAME_MAX + 1];
+            *std::copy(pathName, componentEnd, component) = '\0';
+            fd = openat(directoryFD, component, O_RDONLY | O_CLOEXEC | O_NOFOLLOW | O_DIRECTORY);
+        }
+
+        if (directoryFD != rootDirectoryFD) {
+            int errorNumber = errno;
+            close(directoryFD);
+            errno = errorNumber;
+        }
+
+        if (fd < 0 || componentEnd == nullptr) {
+            return fd;
+        }
+
+        directoryFD = fd;
+        pathName = componentEnd + 1;
+    }
+}
+
+
+std::size_t
+ReadFile(int fd, char *buffer, std::size_t bufferSize)
+{
+    std::size_t dataSize = 0;
+
+    while (dataSize < bufferSize) {
+        ssize_t n = pread(fd, buffer + dataSize, bufferSize - dataSize, dataSize);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            throw std::system_error(errno, std::system_category(), "pread() failed");
+        }
+
+        if (n == 0) {
+            break;
+        }
+
+        dataSize += n;
+    }
+
+    return dataSize;
+}
+
+
+void
+DumpStatus(Connection *connection, const Request &request, StatusCode statusCode)
+{
+    Response response;
+    response.majorVersionNumber = request.majorVersionNumber;
+    response.minorVersionNumber = request.minorVersionNumber;
+    response.statusCode = statusCode;
+    response.reasonPhrase = DescribeStatus(statusCode);
+
+    if (statusCode == StatusCode::MethodNotAllowed) {
+        response.header.addField("Allow", "GET, HEAD");
+    }
+
+    response.header.addField("Content-Length", "0");
+    connection->dumpResponse(response, 0);
+}
+
+} // namespace
+
+} // namespace http
+
+} // namespace siren
@@ -0,0 +1,454 @@
+#include "variant_cache.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+#include <tuple>
+
+#include <siren/assert.h>
+
+#include "connection.h"
+#include "etag.h"
+#include "header.h"
+#include "request.h"
+#include "response.h"
+
+
+namespace siren {
+
+namespace http {
+
+namespace {
+
+const std::pair<ContentCoding, const char *> SidecarFileNameSuffixes[] = {
+    {ContentCoding::Brotli, ".br"},
+    {ContentCoding::Zstd, ".zst"},
+    {ContentCoding::Gzip, ".gz"},
+};
+
+
+std::uint64_t HashContent(const std::string &) noexcept;
+bool ReadFile(const std::string &, std::string *, struct stat *);
+bool TimeIsBefore(const timespec &, const timespec &) noexcept;
+std::string CompressContent(detail::Compressor *, ContentCoding, int, const std::string &);
+
+} // namespace
+
+
+Asset::Asset() noexcept
+  : contentHash_(0),
+    contentCodingMask_(1U << static_cast<int>(ContentCoding::Identity)),
+    size_(0)
+{
+}
+
+
+std::pair<ContentCoding, const std::string *>
+Asset::selectVariant(const Header &header) const noexcept
+{
+    ContentCoding contentCoding = NegotiateContentCoding(header, contentCodingMask_);
+    return {contentCoding, &variants_[static_cast<int>(contentCoding)]};
+}
+
+
+void
+Asset::setVariant(ContentCoding contentCoding, std::string &&variant) noexcept
+{
+    std::string *oldVariant = &variants_[static_cast<int>(contentCoding)];
+    size_ += variant.size() - oldVariant->size();
+    *oldVariant = std::move(variant);
+    contentCodingMask_ |= 1U << static_cast<int>(contentCoding);
+}
+
+
+VariantCache::VariantCache(const VariantCacheOptions &options)
+  : options_(options),
+    cacheSize_(0)
+{
+}
+
+
+std::shared_ptr<const Asset>
+VariantCache::addAsset(std::string content)
+{
+    std::uint64_t contentHash = HashContent(content);
+    std::shared_ptr<const Asset> asset = findAsset(contentHash, content);
+
+    if (asset != nullptr) {
+        return asset;
+    }
+
+    auto newAsset = std::make_shared<Asset>();
+    newAsset->contentHash_ = contentHash;
+    newAsset->setVariant(ContentCoding::Identity, std::move(content));
+    compressAsset(newAsset.get());
+    return insertAsset(std::move(newAsset));
+}
+
+
+std::shared_ptr<const Asset>
+VariantCache::loadAsset(const std::string &fileName)
+{
+    struct stat fileStatus;
+
+    if (stat(fileName.c_str(), &fileStatus) == 0) {
+        std::shared_ptr<const Asset> asset = findAssetFile(fileName, fileStatus);
+
+        if (asset != nullptr) {
+            return asset;
+        }
+    }
+
+    std::string content;
+
+    if (!ReadFile(fileName, &content, &fileStatus)) {
+        throw std::system_error(ENOENT, std::system_category(), "open() failed");
+    }
+
+    std::uint64_t contentHash = HashContent(content);
+    std::shared_ptr<const Asset> asset = findAsset(contentHash, content);
+
+    if (asset != nullptr) {
+        insertAssetFile(fileName, fileStatus, asset);
+        return asset;
+    }
+
+    auto newAsset = std::make_shared<Asset>();
+    newAsset->contentHash_ = contentHash;
+    newAsset->setVariant(ContentCoding::Identity, std::move(content));
+
+    for (const auto &sidecarFileNameSuffix : SidecarFileNameSuffixes) {
+        std::string variant;
+        struct stat sidecarFileStatus;
+
+        if (ReadFile(fileName + sidecarFileNameSuffix.second, &variant, &sidecarFileStatus)
+            && !TimeIsBefore(sidecarFileStatus.st_mtim, fileStatus.st_mtim)) {
+            newAsset->setVariant(sidecarFileNameSuffix.first, std::move(variant));
+        }
+    }
+
+    compressAsset(newAsset.get());
+    asset = insertAsset(std::move(newAsset));
+    insertAssetFile(fileName, fileStatus, asset);
+    return asset;
+}
+
+
+std::size_t
+VariantCache::getCacheSize() const
+{
+    std::lock_guard<std::mutex> lockGuard(mutex_);
+    return cacheSize_;
+}
+
+
+std::size_t
+VariantCache::getNumberOfAssets() const
+{
+    std::lock_guard<std::mutex> lockGuard(mutex_);
+    return assets_.size();
+}
+
+
+std::shared_ptr<const Asset>
+VariantCache::findAsset(std::uint64_t contentHash, const std::string &content)
+{
+    std::lock_guard<std::mutex> lockGuard(mutex_);
+    auto it = contentHash2Asset_.find(contentHash);
+
+    if (it == contentHash2Asset_.end() || (*it->second)->getContent() != content) {
+        return nullptr;
+    }
+
+    assets_.splice(assets_.begin(), assets_, it->second);
+    return *it->second;
+}
+
+
+std::shared_ptr<const Asset>
+VariantCache::findAssetFile(const std::string &fileName, const struct stat &fileStatus)
+{
+    std::lock_guard<std::mutex> lockGuard(mutex_);
+    auto it = fileName2AssetFile_.find(fileName);
+
+    if (it == fileName2AssetFile_.end()) {
+        return nullptr;
+    }
+
+    const detail::AssetFile &assetFile = it->second;
+
+    if (assetFile.deviceID != fileStatus.st_dev || assetFile.inodeNumber != fileStatus.st_ino
+        || assetFile.modificationTime.tv_sec != fileStatus.st_mtim.tv_sec
+        || assetFile.modificationTime.tv_nsec != fileStatus.st_mtim.tv_nsec
+        || assetFile.size != fileStatus.st_size) {
+        return nullptr;
+    }
+
+    std::shared_ptr<const Asset> asset = assetFile.asset.lock();
+
+    if (asset == nullptr) {
+        return nullptr;
+    }
+
+    auto it2 = contentHash2Asset_.find(asset->getContentHash());
+
+    if (it2 != contentHash2Asset_.end() && *it2->second == asset) {
+        assets_.splice(assets_.begin(), assets_, it2->second);
+    }
+
+    return asset;
+}
+
+
+void
+VariantCache::insertAssetFile(const std::string &fileName, const struct stat &fileStatus
+                              , const std::shared_ptr<const Asset> &asset)
+{
+    std::lock_guard<std::mutex> lockGuard(mutex_);
+
+    if (fileName2AssetFile_.size() >= 2 * assets_.size() + 16) {
+        for (auto it = fileName2AssetFile_.begin(); it != fileName2AssetFile_.end();) {
+            if (it->second.asset.expired()) {
+                it = fileName2AssetFile_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    detail::AssetFile *assetFile = &fileName2AssetFile_[fileName];
+    assetFile->deviceID = fileStatus.st_dev;
+    assetFile->inodeNumber = fileStatus.st_ino;
+    assetFile->modificationTime = fileStatus.st_mtim;
+    assetFile->size = fileStatus.st_size;
+    assetFile->asset = asset;
+}
+
+
+std::shared_ptr<const Asset>
+VariantCache::insertAsset(std::shared_ptr<const Asset> asset)
+{
+    if (asset->getSize() > options_.maxCacheSize) {
+        return asset;
+    }
+
+    std::lock_guard<std::mutex> lockGuard(mutex_);
+    auto it = contentHash2Asset_.find(asset->getContentHash());
+
+    if (it != contentHash2Asset_.end()) {
+        if ((*it->second)->getContent() == asset->getContent()) {
+            assets_.splice(assets_.begin(), assets_, it->second);
+            return *it->second;
+        }
+
+        return asset;
+    }
+
+    while (cacheSize_ + asset->getSize() > options_.maxCacheSize) {
+        const Asset *oldAsset = assets_.back().get();
+        contentHash2Asset_.erase(oldAsset->getContentHash());
+        cacheSize_ -= oldAsset->getSize();
+        assets_.pop_back();
+    }
+
+    assets_.push_front(asset);
+    contentHash2Asset_.emplace(asset->getContentHash(), assets_.begin());
+    cacheSize_ += asset->getSize();
+    return asset;
+}
+
+
+void
+VariantCache::compressAsset(Asset *asset)
+{
+    const std::string &content = asset->getContent();
+
+    if (content.size() < options_.minCompressionSize) {
+        return;
+    }
+
+    detail::Compressor compressor;
+
+    for (const auto &sidecarFileNameSuffix : SidecarFileNameSuffixes) {
+        ContentCoding contentCoding = sidecarFileNameSuffix.first;
+
+        if (asset->getVariant(contentCoding) != nullptr
+            || !ContentCodingIsSupported(contentCoding)) {
+            continue;
+        }
+
+        std::string variant = CompressContent(&compressor, contentCoding
+                                              , options_.compressionLevel, content);
+
+        if (variant.size() < content.size()) {
+            asset->setVariant(contentCoding, std::move(variant));
+        }
+    }
+}
+
+
+void
+DumpAsset(Connection *connection, const Request &request, Response *response
+          , const Asset &asset)
+{
+    ContentCoding contentCoding;
+    const std::string *variant;
+    std::tie(contentCoding, variant) = asset.selectVariant(request.header);
+    char eTag[64];
+
+    if (contentCoding == ContentCoding::Identity) {
+        std::sprintf(eTag, "\"%016" PRIx64 "\"", asset.getContentHash());
+    } else {
+        std::sprintf(eTag, "\"%016" PRIx64 "-%s\"", asset.getContentHash()
+                     , GetContentCodingName(contentCoding));
+    }
+
+    response->header.addField("ETag", eTag);
+    bool assetHasVariants = asset.getContentCodingMask()
+                            != 1U << static_cast<int>(ContentCoding::Identity);
+
+    if (ResourceIsNotModified(request.header, eTag, nullptr)) {
+        response->statusCode = StatusCode::NotModified;
+        response->reasonPhrase = DescribeStatus(response->statusCode);
+
+        if (assetHasVariants) {
+            connection->dumpEncodedResponse(*response, ContentCoding::Identity, 0);
+        } else {
+            connection->dumpResponse(*response, 0);
+        }
+
+        return;
+    }
+
+    std::size_t bodySize = variant->size();
+
+    if (request.methodType == MethodType::Head) {
+        char contentLength[32];
+        std::sprintf(contentLength, "%zo", bodySize);
+        response->header.addField("Content-Length", contentLength);
+        bodySize = 0;
+    }
+
+    PayloadWriter payloadWriter
+        = assetHasVariants
+          ? connection->dumpEncodedResponse(*response, contentCoding, bodySize)
+          : connection->dumpResponse(*response, bodySize);
+
+    if (bodySize >= 1) {
+        std::memcpy(payloadWriter.reserveBuffer(bodySize), variant->data(), bodySize);
+        payloadWriter.flushBuffer(bodySize);
+    }
+}
+
+
+namespace {
+
+std::uint64_t
+HashContent(const std::string &content) noexcept
+{
+    std::uint64_t contentHash = UINT64_C(14695981039346656037);
+
+    for (char c : content) {
+        contentHash ^= static_cast<unsigned char>(c);
+        contentHash *= UINT64_C(1099511628211);
+    }
+
+    return contentHash;
+}
+
+
+bool
+ReadFile(const std::string &fileName, std::string *content, struct stat *fileStatus)
+{
+    int fd = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return false;
+        }
+
+        throw std::system_error(errno, std::system_category(), "open() failed");
+    }
+
+    try {
+        if (fstat(fd, fileStatus) < 0) {
+            throw std::system_error(errno, std::system_category(), "fstat() failed");
+        }
+
+        content->resize(fileStatus->st_size);
+        std::size_t contentSize = 0;
+
+        while (contentSize < content->size()) {
+            ssize_t n = read(fd, &(*content)[contentSize], content->size() - contentSize);
+
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                throw std::system_error(errno, std::system_category(), "read() failed");
+            }
+
+            if (n == 0) {
+                break;
+            }
+
+            contentSize += n;
+        }
+
+        content->resize(contentSize);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+
+    close(fd);
+    return true;
+}
+
+
+bool
+TimeIsBefore(const timespec &time1, const timespec &time2) noexcept
+{
+    return time1.tv_sec < time2.tv_sec
+           || (time1.tv_sec == time2.tv_sec && time1.tv_nsec < time2.tv_nsec);
+}
+
+
+std::string
+CompressContent(detail::Compressor *compressor, ContentCoding contentCoding
+                , int compressionLevel, const std::string &content)
+{
+    compressor->start(contentCoding, compressionLevel, false, content.size());
+    compressor->commitInput(content.size());
+    const char *input = content.data();
+    std::size_t inputSize = content.size();
+    std::string variant;
+
+    while (!compressor->isFinished()) {
+        std::size_t variantSize = variant.size();
+        std::size_t outputSize = compressor->getMaxOutputSize(inputSize);
+        variant.resize(variantSize + outputSize);
+        std::size_t n1, n2;
+        std::tie(n1, n2) = compressor->compress(input, inputSize, &variant[variantSize]
+                                                , outputSize, true);
+        input += n1;
+        inputSize -= n1;
+        variant.resize(variantSize + n2);
+    }
+
+    compressor->stop();
+    return variant;
+}
+
+} // namespace
+
+} // namespace http
+
+} // namespace siren
@@ -0,0 +1,73 @@
+#include <vector>
+
+#include <siren/test.h>
+
+#include "byte_range.h"
+#include "header.h"
+
+
+namespace {
+
+using namespace siren::http;
+
+
+SIREN_TEST("Parse byte ranges")
+{
+    std::vector<ByteRange> brs;
+
+    auto parse = [&brs] (const char *range, const char *ifRange = nullptr)
+                 -> ByteRangesStatus {
+        Header h;
+
+        if (range != nullptr) {
+            h.addField("Range", range);
+        }
+
+        if (ifRange != nullptr) {
+            h.addField("If-Range", ifRange);
+        }
+
+        return ParseByteRanges(h, 1000, "\"v1\"", "Sun, 06 Nov 1994 08:49:37 GMT", &brs);
+    };
+
+    SIREN_TEST_ASSERT(parse(nullptr) == ByteRangesStatus::None);
+    SIREN_TEST_ASSERT(parse("bytes=0-99") == ByteRangesStatus::Satisfiable);
+    SIREN_TEST_ASSERT(brs.size() == 1 && brs[0].offset == 0 && brs[0].size == 100);
+    SIREN_TEST_ASSERT(parse("Bytes=900-") == ByteRangesStatus::Satisfiable);
+    SIREN_TEST_ASSERT(brs.size() == 1 && brs[0].offset == 900 && brs[0].size == 100);
+    SIREN_TEST_ASSERT(parse("bytes=-10") == ByteRangesStatus::Satisfiable);
+    SIREN_TEST_ASSERT(brs.size() == 1 && brs[0].offset == 990 && brs[0].size == 10);
+    SIREN_TEST_ASSERT(parse("bytes=-5000") == ByteRangesStatus::Satisfiable);
+    SIREN_TEST_ASSERT(brs.size() == 1 && brs[0].offset == 0 && brs[0].size == 1000);
+    SIREN_TEST_ASSERT(parse("bytes=990-99999999999999999999999") == ByteRangesStatus::Satisfiable);
+    SIREN_TEST_ASSERT(brs.size() == 1 && brs[0].offset == 990 && brs[0].size == 10);
+
+    SIREN_TEST_ASSERT(parse("bytes=500-599, 0-9 ,, 5-19, 20-29")
+                      == ByteRangesStatus::Satisfiable);
+    SIREN_TEST_ASSERT(brs.size() == 2);
+    SIREN_TEST_ASSERT(brs[0].offset == 0 && brs[0].size == 30);
+    SIREN_TEST_ASSERT(brs[1].offset == 500 && brs[1].size == 100);
+
+    SIREN_TEST_ASSERT(parse("bytes=1000-") == ByteRangesStatus::Unsatisfiable);
+    SIREN_TEST_ASSERT(parse("bytes=-0") == ByteRangesStatus::Unsatisfiable);
+    SIREN_TEST_ASSERT(parse("bytes=1000-1001, 0-0") == ByteRangesStatus::Satisfiable);
+    SIREN_TEST_ASSERT(brs.size() == 1 && brs[0].offset == 0 && brs[0].size == 1);
+
+    SIREN_TEST_ASSERT(parse("items=0-1") == ByteRangesStatus::None);
+    SIREN_TEST_ASSERT(parse("bytes=") == ByteRangesStatus::None);
+    SIREN_TEST_ASSERT(parse("bytes=5-1") == ByteRangesStatus::None);
+    SIREN_TEST_ASSERT(parse("bytes=-") == ByteRangesStatus::None);
+    SIREN_TEST_ASSERT(parse("bytes=1-2x") == ByteRangesStatus::None);
+    SIREN_TEST_ASSERT(parse("bytes=0-0,1-1,2-2,3-3,4-4,5-5,6-6,7-7,8-8,9-9,10-10,11-11,12-12"
+                            ",13-13,14-14,15-15,16-16") == ByteRangesStatus::None);
+
+    SIREN_TEST_ASSERT(parse("bytes=0-1", "\"v1\"") == ByteRangesStatus::Satisfiable);
+    SIREN_TEST_ASSERT(parse("bytes=0-1", "\"v2\"") == ByteRangesStatus::None);
+    SIREN_TEST_ASSERT(parse("bytes=0-1", "W/\"v1\"") == ByteRangesStatus::None);
+    SIREN_TEST_ASSERT(parse("bytes=0-1", "Sun, 06 Nov 1994 08:49:37 GMT")
+                      == ByteRangesStatus::Satisfiable);
+    SIREN_TEST_ASSERT(parse("bytes=0-1", "Sun, 06 Nov 1994 08:49:38 GMT")
+                      == ByteRangesStatus::None);
+}
+
+} // namespace
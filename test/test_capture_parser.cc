@@ -0,0 +1,84 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <siren/stream.h>
+#include <siren/test.h>
+
+#include "capture_parser.h"
+#include "dumper.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+SIREN_TEST("Parse captured http requests in parallel")
+{
+    Stream s;
+    std::string c;
+
+    Dumper d(DumpOptions(), &s, [&] (Stream *s) -> void {
+        c.append(static_cast<const char *>(s->getData()), s->getDataSize());
+        s->discardData(s->getDataSize());
+    });
+
+    for (int i = 0; i < 200; ++i) {
+        Request req;
+        req.methodType = i % 3 == 0 ? MethodType::Post : MethodType::Get;
+        req.uri.setPathName("/" + std::to_string(i));
+        req.majorVersionNumber = 1;
+        req.minorVersionNumber = 1;
+        req.header.addField("Host", "test.com");
+        std::string pl = i % 2 == 0 ? "x\r\nGET /fake HTTP/1.1\r\n\r\n" : "";
+
+        if (i % 5 == 0) {
+            d.putRequest(req);
+            char *b = d.reservePayloadBuffer(pl.size());
+            std::memcpy(b, pl.data(), pl.size());
+            d.flushPayloadBuffer(pl.size());
+
+            if (pl.size() >= 1) {
+                d.flushPayloadBuffer(0);
+            }
+        } else {
+            d.putRequest(req, pl.size());
+            char *b = d.reservePayloadBuffer(pl.size());
+            std::memcpy(b, pl.data(), pl.size());
+            d.flushPayloadBuffer(pl.size());
+        }
+    }
+
+    ParseOptions po;
+    std::vector<CapturedRequest> crs1 = ParseCapturedRequests(po, c.data(), c.size(), 1);
+    SIREN_TEST_ASSERT(crs1.size() == 200);
+
+    for (unsigned int n : {2, 3, 7, 16}) {
+        std::vector<CapturedRequest> crs2 = ParseCapturedRequests(po, c.data(), c.size(), n);
+        SIREN_TEST_ASSERT(crs2.size() == crs1.size());
+
+        for (std::size_t i = 0; i < crs1.size(); ++i) {
+            SIREN_TEST_ASSERT(crs2[i].offset == crs1[i].offset);
+            SIREN_TEST_ASSERT(crs2[i].size == crs1[i].size);
+            SIREN_TEST_ASSERT(crs2[i].bodySize == crs1[i].bodySize);
+            SIREN_TEST_ASSERT(std::strcmp(crs2[i].request.uri.getPathName()
+                                          , ("/" + std::to_string(i)).c_str()) == 0);
+        }
+    }
+
+    {
+        bool t = false;
+
+        try {
+            ParseCapturedRequests(po, c.data(), c.size() - 1, 4);
+        } catch (const EndOfStream &) {
+            t = true;
+        }
+
+        SIREN_TEST_ASSERT(t);
+    }
+}
+
+}
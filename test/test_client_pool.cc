@@ -0,0 +1,176 @@
+#include <atomic>
+#include <cstring>
+
+#include <siren/loop.h>
+#include <siren/test.h>
+
+#include "client_pool.h"
+#include "request.h"
+#include "response.h"
+#include "server.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+void
+RoundTrip(ClientPool *pool, const IPEndpoint &endpoint)
+{
+    ClientConnection c = pool->acquireConnection(endpoint);
+    Request req;
+    req.methodType = MethodType::Get;
+    req.uri.setPathName("/");
+    req.majorVersionNumber = 1;
+    req.minorVersionNumber = 1;
+    c->dumpRequest(req, 0);
+    Response rsp;
+    PayloadReader pr = c->parseResponse(&rsp);
+    SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+    SIREN_TEST_ASSERT(pr.getRemainingBodyOrChunkSize() == 2);
+    SIREN_TEST_ASSERT(std::memcmp(pr.peekData(2), "ok", 2) == 0);
+    pr.discardData(2);
+    c.release();
+}
+
+
+void
+Serve(Connection *connection, bool keepsAlive)
+{
+    Response rsp;
+    rsp.majorVersionNumber = 1;
+    rsp.minorVersionNumber = 1;
+    rsp.statusCode = StatusCode::OK;
+    rsp.reasonPhrase = "OK";
+
+    do {
+        Request req;
+        connection->parseRequest(&req);
+        PayloadWriter pw = connection->dumpResponse(rsp, 2);
+        std::memcpy(pw.reserveBuffer(2), "ok", 2);
+        pw.flushBuffer(2);
+    } while (keepsAlive && connection->isReusable());
+}
+
+
+SIREN_TEST("Reuse pooled client connections")
+{
+    std::atomic_int numberOfConnections(0);
+    ServerOptions so;
+    so.numberOfReactors = 1;
+
+    Server server(so, [&numberOfConnections] (Connection *connection) -> void {
+        ++numberOfConnections;
+        Serve(connection, true);
+    });
+
+    server.start(IPEndpoint());
+
+    {
+        Loop loop;
+        ClientPoolOptions po;
+        po.maxNumberOfConnectionsPerEndpoint = 1;
+        ClientPool pool(&loop, po);
+
+        for (int i = 0; i < 3; ++i) {
+            loop.createFiber([&pool, &server] () -> void {
+                for (int j = 0; j < 10; ++j) {
+                    RoundTrip(&pool, server.getLocalEndpoint());
+                }
+            });
+        }
+
+        loop.run();
+        SIREN_TEST_ASSERT(pool.getNumberOfIdleConnections(server.getLocalEndpoint()) == 1);
+    }
+
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(numberOfConnections == 1);
+}
+
+
+SIREN_TEST("Evict closed pooled client connections")
+{
+    std::atomic_int numberOfConnections(0);
+    ServerOptions so;
+    so.numberOfReactors = 1;
+
+    Server server(so, [&numberOfConnections] (Connection *connection) -> void {
+        ++numberOfConnections;
+        Serve(connection, false);
+    });
+
+    server.start(IPEndpoint());
+
+    {
+        Loop loop;
+        ClientPool pool(&loop, ClientPoolOptions());
+
+        loop.createFiber([&loop, &pool, &server] () -> void {
+            RoundTrip(&pool, server.getLocalEndpoint());
+            SIREN_TEST_ASSERT(pool.getNumberOfIdleConnections(server.getLocalEndpoint()) == 1);
+            loop.usleep(100000);
+            RoundTrip(&pool, server.getLocalEndpoint());
+        });
+
+        loop.run();
+    }
+
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(numberOfConnections == 2);
+}
+
+
+
+SIREN_TEST("Discard client connections released in the middle of responses")
+{
+    std::atomic_int numberOfConnections(0);
+    ServerOptions so;
+    so.numberOfReactors = 1;
+
+    Server server(so, [&numberOfConnections] (Connection *connection) -> void {
+        ++numberOfConnections;
+        Serve(connection, true);
+    });
+
+    server.start(IPEndpoint());
+
+    {
+        Loop loop;
+        ClientPool pool(&loop, ClientPoolOptions());
+
+        loop.createFiber([&pool, &server] () -> void {
+            ClientConnection c = pool.acquireConnection(server.getLocalEndpoint());
+            Request req;
+            req.methodType = MethodType::Get;
+            req.uri.setPathName("/");
+            req.majorVersionNumber = 1;
+            req.minorVersionNumber = 1;
+            c->dumpRequest(req, 0);
+            Response rsp;
+            PayloadReader pr = c->parseResponse(&rsp);
+            pr.peekData(1);
+            pr.discardData(1);
+            c.release();
+            SIREN_TEST_ASSERT(pool.getNumberOfIdleConnections(server.getLocalEndpoint()) == 0);
+            c = pool.acquireConnection(server.getLocalEndpoint());
+            c->dumpRequest(req, 0);
+            c.release();
+            SIREN_TEST_ASSERT(pool.getNumberOfIdleConnections(server.getLocalEndpoint()) == 0);
+            RoundTrip(&pool, server.getLocalEndpoint());
+            SIREN_TEST_ASSERT(pool.getNumberOfIdleConnections(server.getLocalEndpoint()) == 1);
+        });
+
+        loop.run();
+    }
+
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(numberOfConnections == 3);
+}
+
+} // namespace
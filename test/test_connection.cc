@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <siren/loop.h>
+#include <siren/tcp_socket.h>
+#include <siren/test.h>
+
+#include "connection.h"
+#include "request.h"
+#include "response.h"
+#include "server.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+constexpr int NumberOfMessages = 16;
+constexpr std::size_t BodySize = 256 * 1024;
+
+
+void Echo(Connection *);
+std::string ReadBody(PayloadReader *);
+void WriteBody(PayloadWriter *, char);
+
+
+SIREN_TEST("Parse and dump on separate fibers")
+{
+    ServerOptions so;
+    so.numberOfReactors = 1;
+    so.maxBodySize = BodySize;
+    Server server(so, Echo);
+    server.start(IPEndpoint());
+    Loop loop;
+    TCPSocket s(&loop);
+    ConnectionOptions co;
+    co.maxBodySize = BodySize;
+    std::unique_ptr<Connection> c;
+    int numberOfResponses = 0;
+
+    loop.createFiber([&] () -> void {
+        s.connect(server.getLocalEndpoint());
+        c.reset(new Connection(co, std::move(s)));
+
+        loop.createFiber([&] () -> void {
+            for (int i = 0; i < NumberOfMessages; ++i) {
+                Request req;
+                req.methodType = MethodType::Post;
+                req.uri.setPathName("/");
+                req.majorVersionNumber = 1;
+                req.minorVersionNumber = 1;
+                PayloadWriter pw = c->dumpRequest(req, BodySize);
+                WriteBody(&pw, 'a' + i);
+            }
+        });
+
+        for (int i = 0; i < NumberOfMessages; ++i) {
+            Response rsp;
+            PayloadReader pr = c->parseResponse(&rsp);
+            SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+            SIREN_TEST_ASSERT(ReadBody(&pr) == std::string(BodySize, 'a' + i));
+            ++numberOfResponses;
+        }
+    });
+
+    loop.run();
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(numberOfResponses == NumberOfMessages);
+}
+
+
+SIREN_TEST("Stop reusing connections closed by handlers")
+{
+    ServerOptions so;
+    so.numberOfReactors = 1;
+    bool serverConnectionIsReusable = true;
+
+    Server server(so, [&] (Connection *connection) -> void {
+        Request req;
+        PayloadReader pr = connection->parseRequest(&req);
+        ReadBody(&pr);
+        Response rsp;
+        rsp.majorVersionNumber = 1;
+        rsp.minorVersionNumber = 1;
+        rsp.statusCode = StatusCode::OK;
+        rsp.reasonPhrase = "OK";
+        rsp.header.addField("Connection", "Keep-Alive, Close");
+        PayloadWriter pw = connection->dumpResponse(rsp, 0);
+        WriteBody(&pw, '\0');
+        serverConnectionIsReusable = connection->isReusable();
+    });
+
+    server.start(IPEndpoint());
+    Loop loop;
+    TCPSocket s(&loop);
+    bool clientConnectionIsReusable = true;
+
+    loop.createFiber([&] () -> void {
+        s.connect(server.getLocalEndpoint());
+        Connection c(ConnectionOptions(), std::move(s));
+        Request req;
+        req.methodType = MethodType::Get;
+        req.uri.setPathName("/");
+        req.majorVersionNumber = 1;
+        req.minorVersionNumber = 1;
+        PayloadWriter pw = c.dumpRequest(req, 0);
+        WriteBody(&pw, '\0');
+        Response rsp;
+        PayloadReader pr = c.parseResponse(&rsp);
+        SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+        ReadBody(&pr);
+        clientConnectionIsReusable = c.isReusable();
+    });
+
+    loop.run();
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(!serverConnectionIsReusable);
+    SIREN_TEST_ASSERT(!clientConnectionIsReusable);
+}
+
+
+SIREN_TEST("Vary responses negotiated to identity")
+{
+    ServerOptions so;
+    so.numberOfReactors = 1;
+
+    Server server(so, [&] (Connection *connection) -> void {
+        Request req;
+        PayloadReader pr = connection->parseRequest(&req);
+        ReadBody(&pr);
+        Response rsp;
+        rsp.majorVersionNumber = 1;
+        rsp.minorVersionNumber = 1;
+        rsp.statusCode = StatusCode::OK;
+        rsp.reasonPhrase = "OK";
+        PayloadWriter pw = connection->dumpCompressedResponse(rsp, 1);
+        WriteBody(&pw, 'a');
+    });
+
+    server.start(IPEndpoint());
+    Loop loop;
+    TCPSocket s(&loop);
+    std::string vary;
+    std::string contentEncoding;
+
+    loop.createFiber([&] () -> void {
+        s.connect(server.getLocalEndpoint());
+        Connection c(ConnectionOptions(), std::move(s));
+        Request req;
+        req.methodType = MethodType::Get;
+        req.uri.setPathName("/");
+        req.majorVersionNumber = 1;
+        req.minorVersionNumber = 1;
+        req.header.addField("Accept-Encoding", "gzip");
+        PayloadWriter pw = c.dumpRequest(req, 0);
+        WriteBody(&pw, '\0');
+        Response rsp;
+        PayloadReader pr = c.parseResponse(&rsp);
+
+        rsp.header.traverse([&] (std::size_t, const char *headerFieldName
+                                 , const char *headerFieldValue) -> void {
+            if (std::strcmp(headerFieldName, "Vary") == 0) {
+                vary = headerFieldValue;
+            } else if (std::strcmp(headerFieldName, "Content-Encoding") == 0) {
+                contentEncoding = headerFieldValue;
+            }
+        });
+
+        SIREN_TEST_ASSERT(ReadBody(&pr) == "a");
+    });
+
+    loop.run();
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(vary == "Accept-Encoding");
+    SIREN_TEST_ASSERT(contentEncoding.empty());
+}
+
+
+void
+Echo(Connection *connection)
+{
+    Response rsp;
+    rsp.majorVersionNumber = 1;
+    rsp.minorVersionNumber = 1;
+    rsp.statusCode = StatusCode::OK;
+    rsp.reasonPhrase = "OK";
+
+    do {
+        Request req;
+        PayloadReader pr = connection->parseRequest(&req);
+        std::string body = ReadBody(&pr);
+        PayloadWriter pw = connection->dumpResponse(rsp, body.size());
+        WriteBody(&pw, body.empty() ? '\0' : body[0]);
+    } while (connection->isReusable());
+}
+
+
+std::string
+ReadBody(PayloadReader *payloadReader)
+{
+    std::string body;
+
+    for (;;) {
+        std::size_t n = payloadReader->getRemainingBodyOrChunkSize();
+
+        if (n == 0 && !payloadReader->bodyIsChunked()) {
+            return body;
+        }
+
+        n = std::min(n, std::size_t(4096));
+        body.append(payloadReader->peekData(n), n);
+        payloadReader->discardData(n);
+    }
+}
+
+
+void
+WriteBody(PayloadWriter *payloadWriter, char c)
+{
+    while (payloadWriter->getRemainingBodySize() >= 1) {
+        std::size_t n = std::min(payloadWriter->getRemainingBodySize(), std::size_t(4096));
+        std::memset(payloadWriter->reserveBuffer(n), c, n);
+        payloadWriter->flushBuffer(n);
+    }
+}
+
+} // namespace
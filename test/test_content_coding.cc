@@ -0,0 +1,241 @@
+#include <zlib.h>
+
+#include <string>
+#include <tuple>
+
+#include <siren/test.h>
+
+#include "content_coding.h"
+#include "header.h"
+#include "parser.h"
+
+
+namespace {
+
+using namespace siren::http;
+
+
+std::string Compress(detail::Compressor *, const std::string &, std::size_t, bool);
+std::string Inflate(const std::string &, int);
+std::string Decompress(detail::Decompressor *, const std::string &, std::size_t);
+
+
+SIREN_TEST("Negotiate content codings")
+{
+    auto negotiate = [] (const char *acceptEncoding) -> ContentCoding {
+        Header h;
+
+        if (acceptEncoding != nullptr) {
+            h.addField("Accept-Encoding", acceptEncoding);
+        }
+
+        return NegotiateContentCoding(h);
+    };
+
+    SIREN_TEST_ASSERT(negotiate(nullptr) == ContentCoding::Identity);
+    SIREN_TEST_ASSERT(negotiate("") == ContentCoding::Identity);
+    SIREN_TEST_ASSERT(negotiate("gzip") == ContentCoding::Gzip);
+    SIREN_TEST_ASSERT(negotiate("deflate, GZIP") == ContentCoding::Gzip);
+    SIREN_TEST_ASSERT(negotiate("gzip;q=0.5, deflate") == ContentCoding::Deflate);
+    SIREN_TEST_ASSERT(negotiate("gzip; q=0, deflate;q=0.001") == ContentCoding::Deflate);
+    SIREN_TEST_ASSERT(negotiate("gzip;q=0") == ContentCoding::Identity);
+    SIREN_TEST_ASSERT(negotiate("*;q=0.1, gzip;q=0.2") == ContentCoding::Gzip);
+    SIREN_TEST_ASSERT(negotiate("compress, identity") == ContentCoding::Identity);
+
+    if (ContentCodingIsSupported(ContentCoding::Brotli)) {
+        SIREN_TEST_ASSERT(negotiate("gzip, deflate, br") == ContentCoding::Brotli);
+    } else {
+        SIREN_TEST_ASSERT(negotiate("gzip, deflate, br") == ContentCoding::Gzip);
+    }
+
+    SIREN_TEST_ASSERT(std::string(GetContentCodingName(ContentCoding::Gzip)) == "gzip");
+    SIREN_TEST_ASSERT(std::string(GetContentCodingName(ContentCoding::Brotli)) == "br");
+}
+
+
+SIREN_TEST("Compress payloads with zlib")
+{
+    std::string p;
+
+    for (int i = 0; i < 10000; ++i) {
+        p += "{\"id\": " + std::to_string(i) + ", \"name\": \"siren\"},";
+    }
+
+    detail::Compressor c;
+    SIREN_TEST_ASSERT(!c.isActive());
+    c.start(ContentCoding::Gzip, -1, false, p.size());
+    std::string d1 = Compress(&c, p, 1000, false);
+    SIREN_TEST_ASSERT(!c.isActive());
+    SIREN_TEST_ASSERT(d1.size() < p.size() / 4);
+    SIREN_TEST_ASSERT(Inflate(d1, 15 + 16) == p);
+
+    c.start(ContentCoding::Deflate, 9, true, 0);
+    std::string d2 = Compress(&c, p, 777, true);
+    SIREN_TEST_ASSERT(Inflate(d2, 15) == p);
+
+    c.start(ContentCoding::Gzip, 1, true, 0);
+    std::string d3 = Compress(&c, "", 1, true);
+    SIREN_TEST_ASSERT(Inflate(d3, 15 + 16) == "");
+}
+
+
+SIREN_TEST("Extract content codings")
+{
+    Header h;
+    h.addField("Content-Type", "text/plain");
+    h.addField("Content-Encoding", "GZIP");
+    SIREN_TEST_ASSERT(ExtractContentCoding(&h) == ContentCoding::Gzip);
+    int n = 0;
+
+    h.traverse([&n] (std::size_t, const char *, const char *) -> void {
+        ++n;
+    });
+
+    SIREN_TEST_ASSERT(n == 1);
+    SIREN_TEST_ASSERT(ExtractContentCoding(&h) == ContentCoding::Identity);
+    h.addField("Content-Encoding", "identity");
+    SIREN_TEST_ASSERT(ExtractContentCoding(&h) == ContentCoding::Identity);
+
+    for (const char *contentEncoding : {"compress", "gzip, deflate"}) {
+        Header h2;
+        h2.addField("Content-Encoding", contentEncoding);
+        bool ok = false;
+
+        try {
+            ExtractContentCoding(&h2);
+        } catch (const ParseException &e) {
+            ok = e.getType() == ParseExceptionType::UnknownContentCoding;
+        }
+
+        SIREN_TEST_ASSERT(ok);
+    }
+}
+
+
+SIREN_TEST("Decompress payloads with zlib")
+{
+    std::string p;
+
+    for (int i = 0; i < 10000; ++i) {
+        p += "{\"id\": " + std::to_string(i) + ", \"name\": \"siren\"},";
+    }
+
+    detail::Compressor c;
+    c.start(ContentCoding::Gzip, -1, false, p.size());
+    std::string d1 = Compress(&c, p, 1000, false);
+    detail::Decompressor d;
+    SIREN_TEST_ASSERT(!d.isActive());
+    d.start(ContentCoding::Gzip, p.size());
+    SIREN_TEST_ASSERT(Decompress(&d, d1, 100) == p);
+
+    c.start(ContentCoding::Deflate, 9, true, 0);
+    std::string d2 = Compress(&c, p, 777, true);
+    d.start(ContentCoding::Deflate, p.size());
+    SIREN_TEST_ASSERT(Decompress(&d, d2, 1) == p);
+
+    d.start(ContentCoding::Gzip, p.size() - 1);
+    bool ok = false;
+
+    try {
+        Decompress(&d, d1, d1.size());
+    } catch (const ParseException &e) {
+        ok = e.getType() == ParseExceptionType::BodyTooLarge;
+    }
+
+    SIREN_TEST_ASSERT(ok);
+    d.start(ContentCoding::Gzip, p.size());
+    ok = false;
+
+    try {
+        Decompress(&d, "not a gzip stream", 4);
+    } catch (const ParseException &e) {
+        ok = e.getType() == ParseExceptionType::InvalidMessage;
+    }
+
+    SIREN_TEST_ASSERT(ok);
+}
+
+
+std::string
+Compress(detail::Compressor *compressor, const std::string &payload, std::size_t chunkSize
+         , bool payloadIsChunked)
+{
+    std::string data;
+
+    for (std::size_t i = 0;; i += chunkSize) {
+        std::size_t n = i >= payload.size() ? 0 : std::min(chunkSize, payload.size() - i);
+        SIREN_TEST_ASSERT(compressor->inputIsChunked() == payloadIsChunked);
+
+        if (!payloadIsChunked) {
+            SIREN_TEST_ASSERT(compressor->getRemainingInputSize() == payload.size() - i);
+        }
+
+        char *inputBuffer = compressor->reserveInputBuffer(n);
+
+        if (n >= 1) {
+            payload.copy(inputBuffer, n, i);
+        }
+
+        bool inputIsFinal = compressor->commitInput(n);
+        const char *input = compressor->getInputBuffer();
+
+        while (n >= 1 || (inputIsFinal && !compressor->isFinished())) {
+            char output[64];
+            std::size_t n1, n2;
+            std::tie(n1, n2) = compressor->compress(input, n, output, sizeof(output)
+                                                    , inputIsFinal);
+            input += n1;
+            n -= n1;
+            data.append(output, n2);
+        }
+
+        if (inputIsFinal) {
+            compressor->stop();
+            return data;
+        }
+    }
+}
+
+
+std::string
+Inflate(const std::string &data, int windowBits)
+{
+    z_stream z = z_stream();
+    SIREN_TEST_ASSERT(inflateInit2(&z, windowBits) == Z_OK);
+    z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    z.avail_in = data.size();
+    std::string payload;
+    int result;
+
+    do {
+        char output[4096];
+        z.next_out = reinterpret_cast<Bytef *>(output);
+        z.avail_out = sizeof(output);
+        result = inflate(&z, Z_NO_FLUSH);
+        SIREN_TEST_ASSERT(result == Z_OK || result == Z_STREAM_END);
+        payload.append(output, sizeof(output) - z.avail_out);
+    } while (result != Z_STREAM_END);
+
+    inflateEnd(&z);
+    return payload;
+}
+
+std::string
+Decompress(detail::Decompressor *decompressor, const std::string &data, std::size_t chunkSize)
+{
+    std::string payload;
+
+    for (std::size_t i = 0; !decompressor->isFinished();) {
+        SIREN_TEST_ASSERT(i < data.size());
+        std::size_t n = std::min(chunkSize, data.size() - i);
+        i += decompressor->decompress(&data[i], n);
+        SIREN_TEST_ASSERT(decompressor->getDataSize() <= detail::DecompressorBufferSize);
+        payload.append(decompressor->getData(), decompressor->getDataSize());
+        decompressor->discardData(decompressor->getDataSize());
+    }
+
+    decompressor->stop();
+    return payload;
+}
+
+} // namespace
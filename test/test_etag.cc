@@ -0,0 +1,139 @@
+#include <cstring>
+#include <string>
+
+#include <siren/loop.h>
+#include <siren/tcp_socket.h>
+#include <siren/test.h>
+
+#include "connection.h"
+#include "etag.h"
+#include "header.h"
+#include "request.h"
+#include "response.h"
+#include "server.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+SIREN_TEST("Generate etags")
+{
+    SIREN_TEST_ASSERT(http::detail::UpdateCRC32C(0, "123456789", 9) == 0xE3069283);
+    SIREN_TEST_ASSERT(http::detail::UpdateCRC32C(0, "", 0) == 0);
+    std::string p(100000, 'x');
+
+    for (std::size_t i = 0; i < p.size(); ++i) {
+        p[i] = static_cast<char>(i * 7 + i / 13);
+    }
+
+    ETagGenerator g;
+    g.update(p.data(), 1);
+    g.update(p.data() + 1, 4097);
+    g.update(p.data() + 4098, p.size() - 4098);
+    SIREN_TEST_ASSERT(g.getETag() == MakeETag(p.data(), p.size()));
+    SIREN_TEST_ASSERT(MakeETag("123456789", 9) == "\"e3069283-9\"");
+    SIREN_TEST_ASSERT(MakeETag("12345678", 8) != MakeETag("12345679", 8));
+}
+
+
+SIREN_TEST("Evaluate conditional requests")
+{
+    const char *lm = "Sun, 06 Nov 1994 08:49:37 GMT";
+
+    auto notModified = [lm] (const char *name, const char *value) -> bool {
+        Header h;
+
+        if (name != nullptr) {
+            h.addField(name, value);
+        }
+
+        return ResourceIsNotModified(h, "\"abc\"", lm);
+    };
+
+    SIREN_TEST_ASSERT(!notModified(nullptr, nullptr));
+    SIREN_TEST_ASSERT(notModified("If-None-Match", "\"abc\""));
+    SIREN_TEST_ASSERT(notModified("If-None-Match", "\"x\", W/\"abc\""));
+    SIREN_TEST_ASSERT(notModified("If-None-Match", "*"));
+    SIREN_TEST_ASSERT(!notModified("If-None-Match", "\"abcd\", \"ab\""));
+    SIREN_TEST_ASSERT(!notModified("If-None-Match", "abc"));
+    SIREN_TEST_ASSERT(notModified("If-Modified-Since", lm));
+    SIREN_TEST_ASSERT(notModified("If-Modified-Since", "Mon, 07 Nov 1994 08:49:37 GMT"));
+    SIREN_TEST_ASSERT(!notModified("If-Modified-Since", "Sun, 06 Nov 1994 08:49:36 GMT"));
+    SIREN_TEST_ASSERT(!notModified("If-Modified-Since", "yesterday"));
+
+    Header h;
+    h.addField("If-None-Match", "\"x\"");
+    h.addField("If-Modified-Since", lm);
+    SIREN_TEST_ASSERT(!ResourceIsNotModified(h, "\"abc\"", lm));
+}
+
+
+SIREN_TEST("Dump tagged responses to HEAD requests")
+{
+    ServerOptions so;
+    so.numberOfReactors = 1;
+
+    Server server(so, [] (Connection *connection) -> void {
+        do {
+            Request req;
+            connection->parseRequest(&req);
+            Response rsp;
+            rsp.majorVersionNumber = 1;
+            rsp.minorVersionNumber = 1;
+            rsp.statusCode = StatusCode::OK;
+            rsp.reasonPhrase = "OK";
+            DumpTaggedResponse(connection, req, &rsp, "hello", 5);
+        } while (connection->isReusable());
+    });
+
+    server.start(IPEndpoint());
+    Loop loop;
+    int numberOfResponses = 0;
+
+    loop.createFiber([&] () -> void {
+        TCPSocket s(&loop);
+        s.connect(server.getLocalEndpoint());
+        Connection c(ConnectionOptions(), std::move(s));
+
+        for (MethodType methodType : {MethodType::Head, MethodType::Get}) {
+            Request req;
+            req.methodType = methodType;
+            req.uri.setPathName("/");
+            req.majorVersionNumber = 1;
+            req.minorVersionNumber = 1;
+            c.dumpRequest(req, 0);
+            Response rsp;
+            PayloadReader pr = c.parseResponse(&rsp, methodType);
+            SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+            std::size_t n = pr.getRemainingBodyOrChunkSize();
+
+            if (methodType == MethodType::Head) {
+                SIREN_TEST_ASSERT(n == 0);
+                int m = 0;
+
+                rsp.header.search("Content-Length", [&m] (std::size_t, const char *value)
+                                                    -> bool {
+                    m += std::strcmp(value, "5") == 0;
+                    return true;
+                });
+
+                SIREN_TEST_ASSERT(m == 1);
+            } else {
+                SIREN_TEST_ASSERT(n == 5 && std::memcmp(pr.peekData(n), "hello", n) == 0);
+                pr.discardData(n);
+            }
+
+            ++numberOfResponses;
+        }
+    });
+
+    loop.run();
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(numberOfResponses == 2);
+}
+
+} // namespace
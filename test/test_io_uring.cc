@@ -0,0 +1,203 @@
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <siren/ip_endpoint.h>
+#include <siren/loop.h>
+#include <siren/tcp_socket.h>
+#include <siren/test.h>
+
+#include "connection.h"
+#include "io_uring.h"
+#include "request.h"
+#include "response.h"
+#include "server.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+bool IOURingIsSupported();
+std::string MakeBody(int);
+void Echo(Connection *);
+void RoundTrip(Connection *, const std::string &);
+
+
+SIREN_TEST("Serve connections over io_uring")
+{
+    if (!IOURingIsSupported()) {
+        return;
+    }
+
+    for (bool receiveIsMultishot : {false, true}) {
+        ServerOptions so;
+        so.numberOfReactors = 1;
+        so.transport = ConnectionTransport::IOURing;
+        so.receiveIsMultishot = receiveIsMultishot;
+        so.numberOfReceiveBuffers = 4;
+        so.receiveBufferSize = 64;
+        Server server(so, Echo);
+        server.start(IPEndpoint());
+        Loop loop;
+        int n = 0;
+
+        for (int i = 0; i < 4; ++i) {
+            loop.createFiber([&] () -> void {
+                TCPSocket s(&loop);
+                s.connect(server.getLocalEndpoint());
+                Connection c(ConnectionOptions(), std::move(s));
+
+                for (int j = 0; j < 16; ++j) {
+                    RoundTrip(&c, MakeBody(j));
+                    ++n;
+                }
+            });
+        }
+
+        loop.run();
+        server.stop();
+        server.wait();
+        SIREN_TEST_ASSERT(n == 64);
+    }
+}
+
+
+SIREN_TEST("Exchange messages over a shared io_uring")
+{
+    if (!IOURingIsSupported()) {
+        return;
+    }
+
+    for (bool receiveIsMultishot : {false, true}) {
+        Loop loop;
+        IOURingOptions io;
+        io.numberOfReceiveBuffers = 2;
+        io.receiveBufferSize = 16;
+        IOURing ioURing(io, &loop);
+        ConnectionOptions co;
+        co.transport = ConnectionTransport::IOURing;
+        co.receiveIsMultishot = receiveIsMultishot;
+        TCPSocket l(&loop);
+        l.listen(IPEndpoint());
+        IPEndpoint e = l.getLocalEndpoint();
+        int n = 0;
+
+        loop.createFiber([&] () -> void {
+            ioURing.run();
+        });
+
+        loop.createFiber([&] () -> void {
+            Connection c(co, l.accept(), nullptr, &ioURing);
+
+            try {
+                Echo(&c);
+            } catch (const EndOfStream &) {
+            }
+        });
+
+        loop.createFiber([&] () -> void {
+            TCPSocket s(&loop);
+            s.connect(e);
+
+            {
+                Connection c(co, std::move(s), nullptr, &ioURing);
+
+                for (int i = 0; i < 16; ++i) {
+                    RoundTrip(&c, MakeBody(i));
+                    ++n;
+                }
+            }
+
+            ioURing.stop();
+        });
+
+        loop.run();
+        SIREN_TEST_ASSERT(n == 16);
+    }
+}
+
+
+bool
+IOURingIsSupported()
+{
+    Loop loop;
+
+    try {
+        IOURing ioURing(IOURingOptions(), &loop);
+    } catch (const std::system_error &) {
+        return false;
+    }
+
+    return true;
+}
+
+
+std::string
+MakeBody(int i)
+{
+    std::string body;
+
+    for (int j = 0; j < i * 97 % 1500; ++j) {
+        body.push_back('a' + (i + j) % 26);
+    }
+
+    return body;
+}
+
+
+void
+Echo(Connection *connection)
+{
+    Response rsp;
+    rsp.majorVersionNumber = 1;
+    rsp.minorVersionNumber = 1;
+    rsp.statusCode = StatusCode::OK;
+    rsp.reasonPhrase = "OK";
+
+    do {
+        Request req;
+        PayloadReader pr = connection->parseRequest(&req);
+        std::size_t n = pr.getRemainingBodyOrChunkSize();
+        const char *data = n >= 1 ? pr.peekData(n) : nullptr;
+        PayloadWriter pw = connection->dumpResponse(rsp, n);
+
+        if (n >= 1) {
+            std::memcpy(pw.reserveBuffer(n), data, n);
+            pw.flushBuffer(n);
+            pr.discardData(n);
+        }
+    } while (connection->isReusable());
+}
+
+
+void
+RoundTrip(Connection *connection, const std::string &body)
+{
+    Request req;
+    req.methodType = MethodType::Post;
+    req.uri.setPathName("/");
+    req.majorVersionNumber = 1;
+    req.minorVersionNumber = 1;
+    PayloadWriter pw = connection->dumpRequest(req, body.size());
+
+    if (!body.empty()) {
+        std::memcpy(pw.reserveBuffer(body.size()), body.data(), body.size());
+        pw.flushBuffer(body.size());
+    }
+
+    Response rsp;
+    PayloadReader pr = connection->parseResponse(&rsp);
+    SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+    SIREN_TEST_ASSERT(pr.getRemainingBodyOrChunkSize() == body.size());
+
+    if (!body.empty()) {
+        SIREN_TEST_ASSERT(std::memcmp(pr.peekData(body.size()), body.data(), body.size()) == 0);
+        pr.discardData(body.size());
+    }
+}
+
+} // namespace
@@ -0,0 +1,106 @@
+#include <cstring>
+#include <string>
+
+#include <siren/stream.h>
+#include <siren/test.h>
+
+#include "memory_parser.h"
+#include "request.h"
+#include "response.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+SIREN_TEST("Parse http requests/responses from memory")
+{
+    const char m[] =
+        "GET /a HTTP/1.1\r\n"
+        "Host: test.com\r\n"
+        "Content-Length: 6\r\n"
+        "\r\n"
+        "hello!"
+        "POST /b HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "6\r\n"
+        "hello!\r\n"
+        "6\r\n"
+        "world!\r\n"
+        "0\r\n"
+        "\r\n"
+        "GET /c HTTP/1.0\r\n"
+        "\r\n"
+    ;
+
+    ParseOptions po;
+    MemoryParser p(po, m, sizeof(m) - 1);
+    const char *pathNames[] = {"/a", "/b", "/c"};
+    const char *payloads[] = {"hello!", "hello!world!", ""};
+    int i = 0;
+
+    for (;;) {
+        Request req;
+
+        if (!p.getRequest(&req)) {
+            break;
+        }
+
+        SIREN_TEST_ASSERT(i < 3);
+        SIREN_TEST_ASSERT(std::strcmp(req.uri.getPathName(), pathNames[i]) == 0);
+        std::string pl;
+
+        p.readPayload([&] (const char *s, std::size_t n) -> void {
+            SIREN_TEST_ASSERT(s >= m && s + n <= m + sizeof(m) - 1);
+            pl.append(s, n);
+        });
+
+        SIREN_TEST_ASSERT(pl == payloads[i]);
+        ++i;
+    }
+
+    SIREN_TEST_ASSERT(i == 3);
+    SIREN_TEST_ASSERT(p.getOffset() == sizeof(m) - 1);
+}
+
+
+SIREN_TEST("Skip payloads and detect truncated messages in memory")
+{
+    const char m[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: 5\r\n"
+        "\r\n"
+        "hello"
+        "HTTP/1.1 404 Not Found\r\n"
+        "Content-Length: 5\r\n"
+        "\r\n"
+        "wor"
+    ;
+
+    ParseOptions po;
+    MemoryParser p(po, m, sizeof(m) - 1);
+    Response rsp;
+    SIREN_TEST_ASSERT(p.getResponse(&rsp));
+    SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+    rsp.header.reset();
+    SIREN_TEST_ASSERT(p.getResponse(&rsp));
+    SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::NotFound);
+    SIREN_TEST_ASSERT(rsp.reasonPhrase == "Not Found");
+
+    {
+        bool t = false;
+
+        try {
+            p.skipPayload();
+        } catch (const EndOfStream &) {
+            t = true;
+        }
+
+        SIREN_TEST_ASSERT(t);
+    }
+}
+
+}
@@ -0,0 +1,52 @@
+#include <thread>
+#include <vector>
+
+#include <siren/test.h>
+
+#include "mpsc_queue.h"
+
+
+namespace {
+
+using namespace siren::http;
+
+
+SIREN_TEST("Hand off values through mpsc queues")
+{
+    detail::MPSCQueue<int> q;
+    int v;
+    SIREN_TEST_ASSERT(!q.pop(&v));
+    std::vector<std::thread> ps;
+    const int n = 10000;
+
+    for (int i = 0; i < 4; ++i) {
+        ps.emplace_back([&q, i] () -> void {
+            for (int j = 0; j < n; ++j) {
+                q.push(i * n + j);
+            }
+        });
+    }
+
+    std::vector<int> lastValues(4, -1);
+    int m = 0;
+
+    while (m < 4 * n) {
+        if (q.pop(&v)) {
+            SIREN_TEST_ASSERT(v > lastValues[v / n]);
+            lastValues[v / n] = v;
+            ++m;
+        }
+    }
+
+    for (std::thread &p : ps) {
+        p.join();
+    }
+
+    SIREN_TEST_ASSERT(!q.pop(&v));
+
+    for (int i = 0; i < 4; ++i) {
+        SIREN_TEST_ASSERT(lastValues[i] == i * n + n - 1);
+    }
+}
+
+} // namespace
@@ -1,4 +1,5 @@
 #include <cstring>
+#include <functional>
 
 #include <siren/stream.h>
 #include <siren/test.h>
@@ -157,4 +158,143 @@ SIREN_TEST("Parse http requests/responses")
     }
 }
 
+
+SIREN_TEST("Parse connection persistence of http requests")
+{
+    Stream s;
+    ParseOptions po;
+
+    const char m[] =
+        "GET /1 HTTP/1.1\r\n"
+        "\r\n"
+        "GET /2 HTTP/1.1\r\n"
+        "Connection: Upgrade, close\r\n"
+        "\r\n"
+        "GET /3 HTTP/1.0\r\n"
+        "\r\n"
+        "GET /4 HTTP/1.0\r\n"
+        "Connection: Keep-Alive\r\n"
+        "\r\n"
+    ;
+
+    s.write(m, sizeof(m) - 1);
+
+    Parser p(po, &s, [] (Stream *) -> void {
+        throw EndOfStream();
+    });
+
+    for (bool cip : {true, false, false, true}) {
+        Request req;
+        p.getRequest(&req);
+        SIREN_TEST_ASSERT(p.connectionIsPersistent() == cip);
+    }
+}
+
+
+SIREN_TEST("Parse http responses to HEAD requests")
+{
+    Stream s;
+    ParseOptions po;
+
+    const char m[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: 15\r\n"
+        "\r\n"
+        "HTTP/1.1 200 OK\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "HTTP/1.1 204 No Content\r\n"
+        "\r\n"
+    ;
+
+    s.write(m, sizeof(m) - 1);
+
+    Parser p(po, &s, [] (Stream *) -> void {
+        throw EndOfStream();
+    });
+
+    for (const char *fn : {"Content-Length", "Transfer-Encoding"}) {
+        Response rsp;
+        p.getResponse(&rsp, MethodType::Head);
+        SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+        SIREN_TEST_ASSERT(!p.bodyIsChunked());
+        SIREN_TEST_ASSERT(p.getRemainingBodyOrChunkSize() == 0);
+        int n = 0;
+
+        rsp.header.traverse([&] (std::size_t, const char *fn2, const char *) -> void {
+            SIREN_TEST_ASSERT(std::strcmp(fn2, fn) == 0);
+            ++n;
+        });
+
+        SIREN_TEST_ASSERT(n == 1);
+    }
+
+    Response rsp;
+    p.getResponse(&rsp, MethodType::Head);
+    SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::NoContent);
+}
+
+
+SIREN_TEST("Parse http payloads partially")
+{
+    Stream s;
+    ParseOptions po;
+
+    const char m[] =
+        "POST / HTTP/1.1\r\n"
+        "Content-Length: 15\r\n"
+        "\r\n"
+        "hello, world!"
+        "POST / HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "6\r\n"
+        "hello!\r\n"
+        "0\r\n"
+        "\r\n"
+    ;
+
+    s.write(m, sizeof(m) - 1);
+
+    Parser p(po, &s, [] (Stream *) -> void {
+        throw EndOfStream();
+    });
+
+    Request req;
+    p.getRequest(&req);
+    SIREN_TEST_ASSERT(p.getRemainingBodyOrChunkSize() == 13);
+    SIREN_TEST_ASSERT(std::memcmp(p.peekPayloadData(5), "hello", 5) == 0);
+    p.discardPayloadData(5);
+    SIREN_TEST_ASSERT(p.getRemainingBodyOrChunkSize() == 8);
+    SIREN_TEST_ASSERT(std::memcmp(p.peekPayloadData(8), ", world!", 8) == 0);
+    p.discardPayloadData(8);
+    SIREN_TEST_ASSERT(p.getRemainingBodyOrChunkSize() == 0 && !p.bodyIsChunked());
+
+    p.getRequest(&req);
+    SIREN_TEST_ASSERT(p.bodyIsChunked());
+    SIREN_TEST_ASSERT(std::memcmp(p.peekPayloadData(2), "he", 2) == 0);
+    p.discardPayloadData(2);
+    SIREN_TEST_ASSERT(p.getRemainingBodyOrChunkSize() == 4);
+    SIREN_TEST_ASSERT(std::memcmp(p.peekPayloadData(4), "llo!", 4) == 0);
+    p.discardPayloadData(4);
+    SIREN_TEST_ASSERT(p.getRemainingBodyOrChunkSize() == 0 && p.bodyIsChunked());
+    p.peekPayloadData(0);
+    p.discardPayloadData(0);
+    SIREN_TEST_ASSERT(!p.bodyIsChunked());
+}
+
+
+SIREN_TEST("Reject empty stream callbacks")
+{
+    Stream s;
+    Parser p1(ParseOptions(), &s, std::function<void (Stream *)>());
+    SIREN_TEST_ASSERT(!p1.isValid());
+
+    Parser p2(ParseOptions(), &s, [] (Stream *) -> void {
+        throw EndOfStream();
+    });
+
+    SIREN_TEST_ASSERT(p2.isValid());
+}
+
 }
@@ -0,0 +1,97 @@
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <siren/loop.h>
+#include <siren/tcp_socket.h>
+#include <siren/test.h>
+
+#include "pipelined_client.h"
+#include "request.h"
+#include "response.h"
+#include "server.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+SIREN_TEST("Pipeline http requests")
+{
+    std::atomic_int numberOfConnections(0);
+    ServerOptions so;
+    so.numberOfReactors = 1;
+    so.maxPipelineDepth = 8;
+
+    Server server(so, [&numberOfConnections] (Connection *connection) -> void {
+        ++numberOfConnections;
+        Response rsp;
+        rsp.majorVersionNumber = 1;
+        rsp.minorVersionNumber = 1;
+        rsp.statusCode = StatusCode::OK;
+        rsp.reasonPhrase = "OK";
+
+        do {
+            Request req;
+            connection->parseRequest(&req);
+            std::size_t n = std::strlen(req.uri.getPathName());
+
+            if (req.methodType == MethodType::Head) {
+                char contentLength[32];
+                std::sprintf(contentLength, "%zo", n);
+                rsp.header.addField("Content-Length", contentLength);
+                connection->dumpResponse(rsp, 0);
+                rsp.header.reset();
+                continue;
+            }
+
+            PayloadWriter pw = connection->dumpResponse(rsp, n);
+            std::memcpy(pw.reserveBuffer(n), req.uri.getPathName(), n);
+            pw.flushBuffer(n);
+        } while (connection->isReusable());
+    });
+
+    server.start(IPEndpoint());
+    Loop loop;
+    int m = 0;
+
+    loop.createFiber([&loop, &server, &m] () -> void {
+        TCPSocket s(&loop);
+        s.connect(server.getLocalEndpoint());
+        PipelinedClientOptions po;
+        po.maxNumberOfInflightRequests = 4;
+        PipelinedClient c(po, std::move(s));
+
+        for (int i = 0; i < 100; ++i) {
+            Request req;
+            req.methodType = i % 3 == 0 ? MethodType::Head : MethodType::Get;
+            req.uri.setPathName("/" + std::to_string(i));
+            req.majorVersionNumber = 1;
+            req.minorVersionNumber = 1;
+
+            c.sendRequest(req, [&m, i] (std::exception_ptr e, Response *rsp, PayloadReader *pr)
+                               -> void {
+                SIREN_TEST_ASSERT(e == nullptr);
+                SIREN_TEST_ASSERT(rsp->statusCode == StatusCode::OK);
+                SIREN_TEST_ASSERT(m++ == i);
+                std::string p = i % 3 == 0 ? "" : "/" + std::to_string(i);
+                SIREN_TEST_ASSERT(pr->getRemainingBodyOrChunkSize() == p.size());
+                SIREN_TEST_ASSERT(std::memcmp(pr->peekData(p.size()), p.data(), p.size()) == 0);
+                pr->discardData(p.size());
+            });
+
+            SIREN_TEST_ASSERT(c.getNumberOfInflightRequests() <= 4);
+        }
+    });
+
+    loop.run();
+    SIREN_TEST_ASSERT(m == 100);
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(numberOfConnections == 1);
+}
+
+} // namespace
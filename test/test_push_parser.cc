@@ -0,0 +1,155 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <siren/test.h>
+
+#include "push_parser.h"
+#include "request.h"
+#include "response.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+struct RequestRecorder
+{
+    std::vector<std::string> events;
+
+    void onStartLine(Request *request) {
+        events.push_back(std::string("S") + request->uri.getPathName());
+    }
+
+    void onHeader(Request *request) {
+        std::string host;
+
+        request->header.search("Host", [&] (std::size_t, const char *value) -> bool {
+            host = value;
+            return true;
+        });
+
+        events.push_back("H" + host);
+    }
+
+    void onPayloadData(const char *data, std::size_t dataSize) {
+        if (events.back()[0] == 'P') {
+            events.back().append(data, dataSize);
+        } else {
+            events.push_back("P" + std::string(data, dataSize));
+        }
+    }
+
+    void onMessageEnd(Request *) {
+        events.push_back("E");
+    }
+};
+
+
+SIREN_TEST("Push http requests in fragments")
+{
+    const char m[] =
+        "GET /a HTTP/1.1\r\n"
+        "Host: test.com\r\n"
+        "Content-Length: 6\r\n"
+        "\r\n"
+        "hello!"
+        "POST /b HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "6\r\n"
+        "hello!\r\n"
+        "6\r\n"
+        "world!\r\n"
+        "0\r\n"
+        "\r\n"
+        "GET /c HTTP/1.0\r\n"
+        "\r\n"
+    ;
+
+    const std::vector<std::string> events = {
+        "S/a", "Htest.com", "Phello!", "E",
+        "S/b", "H", "Phello!world!", "E",
+        "S/c", "H", "E",
+    };
+
+    ParseOptions po;
+
+    for (std::size_t k : {1, 2, 3, 7, 64, 1024}) {
+        PushParser<Request, RequestRecorder> p(po);
+
+        for (std::size_t i = 0; i < sizeof(m) - 1; i += k) {
+            p.feed(m + i, std::min(k, sizeof(m) - 1 - i));
+        }
+
+        SIREN_TEST_ASSERT(p.isIdle());
+        SIREN_TEST_ASSERT(p.getHandler().events == events);
+    }
+}
+
+
+struct ResponseCounter
+{
+    int n = 0;
+
+    void onStartLine(Response *) {}
+    void onHeader(Response *) {}
+    void onPayloadData(const char *, std::size_t) {}
+
+    void onMessageEnd(Response *response) {
+        SIREN_TEST_ASSERT(response->statusCode == StatusCode::NotFound);
+        ++n;
+    }
+};
+
+
+SIREN_TEST("Reject malformed http responses pushed in fragments")
+{
+    ParseOptions po;
+    po.maxStartLineSize = 32;
+    PushParser<Response, ResponseCounter> p(po);
+    const char m1[] = "HTTP/1.1 404 Not Found\r\n\r\n";
+
+    for (const char *s = m1; *s != '\0'; ++s) {
+        p.feed(s, 1);
+    }
+
+    SIREN_TEST_ASSERT(p.getHandler().n == 1);
+    const char m2[] = "HTTP/1.1 200 This Reason Phrase Is Too Long\r\n";
+    bool ok = false;
+
+    try {
+        p.feed(m2, sizeof(m2) - 1);
+    } catch (const ParseException &e) {
+        ok = e.getType() == ParseExceptionType::StartLineTooLong;
+    }
+
+    SIREN_TEST_ASSERT(ok);
+    PushParser<Response, ResponseCounter> p2(po);
+    const char m3[] = "HTTP/1.1 404 Not Found\r\nTransfer-Encoding: chunked\r\n\r\n1\r\nxyz";
+    ok = false;
+
+    try {
+        p2.feed(m3, sizeof(m3) - 1);
+    } catch (const ParseException &e) {
+        ok = e.getType() == ParseExceptionType::InvalidMessage;
+    }
+
+    SIREN_TEST_ASSERT(ok);
+    po.maxHeaderSize = 16;
+    PushParser<Response, ResponseCounter> p3(po);
+    const char m4[] = "HTTP/1.1 404 Not Found\r\nServer: too-long-to-fit\r\n\r\n";
+    ok = false;
+
+    try {
+        p3.feed(m4, sizeof(m4) - 1);
+    } catch (const ParseException &e) {
+        ok = e.getType() == ParseExceptionType::HeaderTooLarge;
+    }
+
+    SIREN_TEST_ASSERT(ok);
+}
+
+} // namespace
@@ -0,0 +1,259 @@
+#include <memory>
+#include <string>
+
+#include <siren/test.h>
+
+#include "request.h"
+#include "response.h"
+#include "response_cache.h"
+
+
+namespace {
+
+using namespace siren::http;
+
+
+void MakeRequest(Request *, MethodType, const char *);
+void MakeResponse(Response *, StatusCode, const char *);
+
+
+SIREN_TEST("Store and find cached responses")
+{
+    ResponseCache rc((ResponseCacheOptions()));
+    Request req;
+    MakeRequest(&req, MethodType::Get, "/a");
+    Response rsp;
+    MakeResponse(&rsp, StatusCode::OK, "max-age=60");
+    rsp.header.addField("Connection", "keep-alive");
+    SIREN_TEST_ASSERT(rc.findResponse(req) == nullptr);
+    std::shared_ptr<const CachedResponse> cr = rc.storeResponse(req, rsp, "hello", 5);
+    SIREN_TEST_ASSERT(cr != nullptr);
+    std::string h = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nCache-Control: max-age=60\r\n\r\n";
+    SIREN_TEST_ASSERT(std::string(cr->getData(), cr->getSize()) == h + "hello");
+    SIREN_TEST_ASSERT(cr->getStartLineSize() == std::string("HTTP/1.1 200 OK\r\n").size());
+    SIREN_TEST_ASSERT(cr->getHeadSize() == h.size());
+    SIREN_TEST_ASSERT(rc.findResponse(req) == cr);
+    SIREN_TEST_ASSERT(rc.getNumberOfCachedResponses() == 1);
+
+    {
+        Request req2;
+        MakeRequest(&req2, MethodType::Head, "/a");
+        SIREN_TEST_ASSERT(rc.findResponse(req2) == cr);
+        SIREN_TEST_ASSERT(rc.storeResponse(req2, rsp, "", 0) == nullptr);
+    }
+
+    {
+        Request req2;
+        MakeRequest(&req2, MethodType::Get, "/a");
+        req2.uri.setQueryString("x=1");
+        SIREN_TEST_ASSERT(rc.findResponse(req2) == nullptr);
+    }
+
+    {
+        Request req2;
+        MakeRequest(&req2, MethodType::Post, "/a");
+        SIREN_TEST_ASSERT(rc.findResponse(req2) == nullptr);
+        SIREN_TEST_ASSERT(rc.storeResponse(req2, rsp, "hello", 5) == nullptr);
+    }
+
+    {
+        Request req2;
+        MakeRequest(&req2, MethodType::Get, "/a");
+        req2.header.addField("Cache-Control", "no-cache");
+        SIREN_TEST_ASSERT(rc.findResponse(req2) == nullptr);
+        req2.header.reset();
+        req2.header.addField("Host", "example.com");
+        req2.header.addField("Authorization", "Basic YTpi");
+        SIREN_TEST_ASSERT(rc.findResponse(req2) == nullptr);
+    }
+}
+
+
+SIREN_TEST("Skip uncacheable responses")
+{
+    ResponseCache rc((ResponseCacheOptions()));
+    Request req;
+    MakeRequest(&req, MethodType::Get, "/a");
+
+    const char *const ccs[] = {
+        "no-store",
+        "private, max-age=60",
+        "no-cache, max-age=60",
+        "max-age=0",
+        "public",
+    };
+
+    for (const char *cc : ccs) {
+        Response rsp;
+        MakeResponse(&rsp, StatusCode::OK, cc);
+        SIREN_TEST_ASSERT(rc.storeResponse(req, rsp, "hello", 5) == nullptr);
+    }
+
+    {
+        Response rsp;
+        MakeResponse(&rsp, StatusCode::InternalServerError, "max-age=60");
+        SIREN_TEST_ASSERT(rc.storeResponse(req, rsp, "hello", 5) == nullptr);
+    }
+
+    {
+        Response rsp;
+        MakeResponse(&rsp, StatusCode::OK, "max-age=60");
+        rsp.header.addField("Set-Cookie", "a=b");
+        SIREN_TEST_ASSERT(rc.storeResponse(req, rsp, "hello", 5) == nullptr);
+    }
+
+    {
+        Response rsp;
+        MakeResponse(&rsp, StatusCode::OK, "max-age=60");
+        rsp.header.addField("Vary", "*");
+        SIREN_TEST_ASSERT(rc.storeResponse(req, rsp, "hello", 5) == nullptr);
+    }
+
+    {
+        Response rsp;
+        MakeResponse(&rsp, StatusCode::OK, nullptr);
+        rsp.header.addField("Expires", "Sun, 06 Nov 1994 08:49:37 GMT");
+        SIREN_TEST_ASSERT(rc.storeResponse(req, rsp, "hello", 5) == nullptr);
+    }
+
+    SIREN_TEST_ASSERT(rc.getNumberOfCachedResponses() == 0);
+    SIREN_TEST_ASSERT(rc.getCacheSize() == 0);
+
+    {
+        Response rsp;
+        MakeResponse(&rsp, StatusCode::NotFound, nullptr);
+        rsp.header.addField("Date", "Sun, 06 Nov 1994 08:49:37 GMT");
+        rsp.header.addField("Expires", "Sun, 06 Nov 1994 08:50:37 GMT");
+        SIREN_TEST_ASSERT(rc.storeResponse(req, rsp, "", 0) != nullptr);
+        SIREN_TEST_ASSERT(rc.findResponse(req) != nullptr);
+    }
+
+    {
+        Request req2;
+        MakeRequest(&req2, MethodType::Get, "/b");
+        req2.header.addField("Cache-Control", "no-store");
+        Response rsp;
+        MakeResponse(&rsp, StatusCode::OK, "s-maxage=60, max-age=0");
+        SIREN_TEST_ASSERT(rc.storeResponse(req2, rsp, "hello", 5) == nullptr);
+        MakeRequest(&req2, MethodType::Get, "/b");
+        SIREN_TEST_ASSERT(rc.storeResponse(req2, rsp, "hello", 5) != nullptr);
+    }
+
+    SIREN_TEST_ASSERT(rc.getNumberOfCachedResponses() == 2);
+}
+
+
+SIREN_TEST("Vary cached responses")
+{
+    ResponseCache rc((ResponseCacheOptions()));
+    Request req1;
+    MakeRequest(&req1, MethodType::Get, "/a");
+    req1.header.addField("Accept-Encoding", "gzip");
+    Request req2;
+    MakeRequest(&req2, MethodType::Get, "/a");
+    Response rsp1;
+    MakeResponse(&rsp1, StatusCode::OK, "max-age=60");
+    rsp1.header.addField("Vary", "accept-encoding");
+    rsp1.header.addField("Content-Encoding", "gzip");
+    Response rsp2;
+    MakeResponse(&rsp2, StatusCode::OK, "max-age=60");
+    rsp2.header.addField("Vary", "Accept-Encoding");
+    std::shared_ptr<const CachedResponse> cr1 = rc.storeResponse(req1, rsp1, "xxx", 3);
+    SIREN_TEST_ASSERT(cr1 != nullptr);
+    SIREN_TEST_ASSERT(rc.findResponse(req1) == cr1);
+    SIREN_TEST_ASSERT(rc.findResponse(req2) == nullptr);
+    std::shared_ptr<const CachedResponse> cr2 = rc.storeResponse(req2, rsp2, "hello", 5);
+    SIREN_TEST_ASSERT(cr2 != nullptr);
+    SIREN_TEST_ASSERT(rc.findResponse(req1) == cr1);
+    SIREN_TEST_ASSERT(rc.findResponse(req2) == cr2);
+    SIREN_TEST_ASSERT(rc.getNumberOfCachedResponses() == 2);
+    std::shared_ptr<const CachedResponse> cr3 = rc.storeResponse(req2, rsp2, "hello!", 6);
+    SIREN_TEST_ASSERT(rc.findResponse(req2) == cr3);
+    SIREN_TEST_ASSERT(rc.getNumberOfCachedResponses() == 2);
+}
+
+
+SIREN_TEST("Evict cached responses")
+{
+    ResponseCacheOptions rco;
+    rco.numberOfShards = 1;
+    rco.maxCacheSize = 300;
+    ResponseCache rc(rco);
+    Response rsp;
+    MakeResponse(&rsp, StatusCode::OK, "max-age=60");
+    std::string b(40, 'x');
+    Request req1, req2, req3;
+    MakeRequest(&req1, MethodType::Get, "/1");
+    MakeRequest(&req2, MethodType::Get, "/2");
+    MakeRequest(&req3, MethodType::Get, "/3");
+    SIREN_TEST_ASSERT(rc.storeResponse(req1, rsp, b.data(), b.size()) != nullptr);
+    SIREN_TEST_ASSERT(rc.storeResponse(req2, rsp, b.data(), b.size()) != nullptr);
+    SIREN_TEST_ASSERT(rc.getNumberOfCachedResponses() == 2);
+    SIREN_TEST_ASSERT(rc.findResponse(req1) != nullptr);
+    SIREN_TEST_ASSERT(rc.storeResponse(req3, rsp, b.data(), b.size()) != nullptr);
+    SIREN_TEST_ASSERT(rc.getNumberOfCachedResponses() == 2);
+    SIREN_TEST_ASSERT(rc.getCacheSize() <= rco.maxCacheSize);
+    SIREN_TEST_ASSERT(rc.findResponse(req1) != nullptr);
+    SIREN_TEST_ASSERT(rc.findResponse(req2) == nullptr);
+    SIREN_TEST_ASSERT(rc.findResponse(req3) != nullptr);
+    b.resize(400);
+    SIREN_TEST_ASSERT(rc.storeResponse(req2, rsp, b.data(), b.size()) != nullptr);
+    SIREN_TEST_ASSERT(rc.findResponse(req2) == nullptr);
+    SIREN_TEST_ASSERT(rc.getNumberOfCachedResponses() == 2);
+}
+
+
+SIREN_TEST("Share the cache budget across shards")
+{
+    ResponseCacheOptions rco;
+    rco.numberOfShards = 4;
+    rco.maxCacheSize = 600;
+    ResponseCache rc(rco);
+    Response rsp;
+    MakeResponse(&rsp, StatusCode::OK, "max-age=60");
+    std::string b(300, 'x');
+    Request req;
+    MakeRequest(&req, MethodType::Get, "/big");
+    SIREN_TEST_ASSERT(rc.storeResponse(req, rsp, b.data(), b.size()) != nullptr);
+    SIREN_TEST_ASSERT(rc.findResponse(req) != nullptr);
+    b.resize(40);
+
+    for (int i = 0; i < 32; ++i) {
+        MakeRequest(&req, MethodType::Get, ("/" + std::to_string(i)).c_str());
+        SIREN_TEST_ASSERT(rc.storeResponse(req, rsp, b.data(), b.size()) != nullptr);
+        SIREN_TEST_ASSERT(rc.findResponse(req) != nullptr);
+        SIREN_TEST_ASSERT(rc.getCacheSize() <= rco.maxCacheSize);
+    }
+
+    SIREN_TEST_ASSERT(rc.getNumberOfCachedResponses() >= 2);
+}
+
+
+void
+MakeRequest(Request *request, MethodType methodType, const char *pathName)
+{
+    request->methodType = methodType;
+    request->uri.reset();
+    request->uri.setPathName(pathName);
+    request->majorVersionNumber = 1;
+    request->minorVersionNumber = 1;
+    request->header.reset();
+    request->header.addField("Host", "example.com");
+}
+
+
+void
+MakeResponse(Response *response, StatusCode statusCode, const char *cacheControl)
+{
+    response->majorVersionNumber = 1;
+    response->minorVersionNumber = 1;
+    response->statusCode = statusCode;
+    response->reasonPhrase = DescribeStatus(statusCode);
+    response->header.reset();
+
+    if (cacheControl != nullptr) {
+        response->header.addField("Cache-Control", cacheControl);
+    }
+}
+
+}
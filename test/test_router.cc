@@ -0,0 +1,106 @@
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <siren/test.h>
+
+#include "request.h"
+#include "router.h"
+
+
+namespace {
+
+using namespace siren::http;
+
+
+std::string GetParameter(const RouteParameters &, const char *);
+
+
+SIREN_TEST("Route requests by path")
+{
+    Router<int> r;
+    r.addRoute(MethodType::Get, "/", 0);
+    r.addRoute(MethodType::Get, "/users", 1);
+    r.addRoute(MethodType::Get, "/users/:id", 2);
+    r.addRoute(MethodType::Get, "/users/:id/posts/:postID", 3);
+    r.addRoute(MethodType::Get, "/users/me", 4);
+    r.addRoute(MethodType::Get, "/static/*path", 5);
+    r.addRoute(MethodType::Post, "/users", 6);
+    r.addRoute(MethodType::Get, "/user", 7);
+    r.addRoute(MethodType::Get, "/files/:name/raw", 8);
+    r.addRoute(MethodType::Get, "/files/:name", 9);
+
+    RouteParameters ps;
+    const int *v;
+
+    v = r.matchRoute(MethodType::Get, "/", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 0 && ps.getCount() == 0);
+    v = r.matchRoute(MethodType::Get, "/users", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 1);
+    v = r.matchRoute(MethodType::Post, "/users", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 6);
+    v = r.matchRoute(MethodType::Get, "/user", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 7);
+    v = r.matchRoute(MethodType::Get, "/users/me", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 4 && ps.getCount() == 0);
+    v = r.matchRoute(MethodType::Get, "/users/mel", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 2 && GetParameter(ps, "id") == "mel");
+    v = r.matchRoute(MethodType::Get, "/users/42/posts/7", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 3);
+    SIREN_TEST_ASSERT(GetParameter(ps, "id") == "42" && GetParameter(ps, "postID") == "7");
+    v = r.matchRoute(MethodType::Get, "/users/me/posts/7", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 3 && GetParameter(ps, "id") == "me");
+    v = r.matchRoute(MethodType::Get, "/static/css/a.css", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 5 && GetParameter(ps, "path") == "css/a.css");
+    v = r.matchRoute(MethodType::Get, "/static/", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 5 && GetParameter(ps, "path") == "");
+    v = r.matchRoute(MethodType::Get, "/files/a.txt", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 9 && GetParameter(ps, "name") == "a.txt");
+    v = r.matchRoute(MethodType::Get, "/files/a.txt/raw", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 8 && GetParameter(ps, "name") == "a.txt");
+    SIREN_TEST_ASSERT(r.matchRoute(MethodType::Get, "/users/", &ps) == nullptr);
+    SIREN_TEST_ASSERT(r.matchRoute(MethodType::Get, "/users/1/posts", &ps) == nullptr);
+    SIREN_TEST_ASSERT(r.matchRoute(MethodType::Put, "/users", &ps) == nullptr);
+    SIREN_TEST_ASSERT(r.matchRoute(MethodType::Get, "/nope", nullptr) == nullptr);
+
+    Request req;
+    req.methodType = MethodType::Get;
+    req.uri.setPathName("/users/9");
+    v = r.matchRoute(req, &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 2);
+    const char *pathName = req.uri.getPathName();
+    SIREN_TEST_ASSERT(ps[0].value >= pathName && ps[0].value < pathName + std::strlen(pathName));
+}
+
+
+SIREN_TEST("Reject malformed routes")
+{
+    Router<int> r;
+    r.addRoute(MethodType::Get, "/a/:id", 0);
+    int n = 0;
+
+    for (const char *p : {"a", "/a/:", "/a/*x/b", "/a/:id"}) {
+        try {
+            r.addRoute(MethodType::Get, p, 1);
+        } catch (const std::invalid_argument &) {
+            ++n;
+        }
+    }
+
+    SIREN_TEST_ASSERT(n == 4);
+    r.addRoute(MethodType::Get, "/a/:name/b", 1);
+    RouteParameters ps;
+    const int *v = r.matchRoute(MethodType::Get, "/a/x/b", &ps);
+    SIREN_TEST_ASSERT(v != nullptr && *v == 1 && GetParameter(ps, "name") == "x");
+}
+
+
+std::string
+GetParameter(const RouteParameters &parameters, const char *name)
+{
+    const RouteParameter *parameter = parameters.find(name);
+    SIREN_TEST_ASSERT(parameter != nullptr);
+    return std::string(parameter->value, parameter->valueSize);
+}
+
+} // namespace
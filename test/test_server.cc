@@ -0,0 +1,247 @@
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <siren/loop.h>
+#include <siren/tcp_socket.h>
+#include <siren/test.h>
+
+#include "connection.h"
+#include "request.h"
+#include "response.h"
+#include "server.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+void Serve(Connection *);
+void RoundTrip(Connection *);
+
+
+SIREN_TEST("Stop servers with idle keep-alive connections")
+{
+    std::atomic_int numberOfConnections(0);
+    ServerOptions so;
+    so.numberOfReactors = 1;
+
+    Server server(so, [&numberOfConnections] (Connection *connection) -> void {
+        ++numberOfConnections;
+        Serve(connection);
+    });
+
+    server.start(IPEndpoint());
+    Loop loop;
+    TCPSocket s(&loop);
+    std::unique_ptr<Connection> c;
+
+    loop.createFiber([&] () -> void {
+        s.connect(server.getLocalEndpoint());
+        c.reset(new Connection(ConnectionOptions(), std::move(s)));
+        RoundTrip(c.get());
+        SIREN_TEST_ASSERT(c->isReusable());
+    });
+
+    loop.run();
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(numberOfConnections == 1);
+}
+
+
+SIREN_TEST("Hand off connections to idle reactors")
+{
+    std::mutex mutex;
+    std::set<std::thread::id> threadIDs;
+    ServerOptions so;
+    so.numberOfReactors = 2;
+    so.maxLoadImbalance = 0;
+
+    Server server(so, [&mutex, &threadIDs] (Connection *connection) -> void {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threadIDs.insert(std::this_thread::get_id());
+        }
+
+        Serve(connection);
+    });
+
+    server.start(IPEndpoint());
+    Loop loop;
+    std::vector<std::unique_ptr<Connection>> cs;
+
+    for (int i = 0; i < 8; ++i) {
+        loop.createFiber([&] () -> void {
+            TCPSocket s(&loop);
+            s.connect(server.getLocalEndpoint());
+            cs.emplace_back(new Connection(ConnectionOptions(), std::move(s)));
+            Connection *c = cs.back().get();
+            RoundTrip(c);
+            loop.usleep(100000);
+            RoundTrip(c);
+        });
+    }
+
+    loop.run();
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(threadIDs.size() == 2);
+}
+
+
+SIREN_TEST("Survive exceptions thrown by handlers")
+{
+    std::atomic_int numberOfConnections(0);
+    ServerOptions so;
+    so.numberOfReactors = 1;
+
+    Server server(so, [&numberOfConnections] (Connection *connection) -> void {
+        if (++numberOfConnections == 1) {
+            throw std::runtime_error("oops");
+        }
+
+        Serve(connection);
+    });
+
+    server.start(IPEndpoint());
+    Loop loop;
+
+    loop.createFiber([&] () -> void {
+        for (int i = 0; i < 2; ++i) {
+            TCPSocket s(&loop);
+            s.connect(server.getLocalEndpoint());
+            Connection c(ConnectionOptions(), std::move(s));
+
+            if (i == 0) {
+                bool ok = false;
+
+                try {
+                    RoundTrip(&c);
+                } catch (const EndOfStream &) {
+                    ok = true;
+                } catch (const std::system_error &) {
+                    ok = true;
+                }
+
+                SIREN_TEST_ASSERT(ok);
+            } else {
+                RoundTrip(&c);
+            }
+        }
+    });
+
+    loop.run();
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(numberOfConnections == 2);
+}
+
+
+SIREN_TEST("Batch responses to pipelined requests")
+{
+    ServerOptions so;
+    so.numberOfReactors = 1;
+    so.maxPipelineDepth = 8;
+
+    Server server(so, [] (Connection *connection) -> void {
+        Response rsp;
+        rsp.majorVersionNumber = 1;
+        rsp.minorVersionNumber = 1;
+        rsp.statusCode = StatusCode::OK;
+        rsp.reasonPhrase = "OK";
+
+        do {
+            Request req;
+            PayloadReader pr = connection->parseRequest(&req);
+            std::size_t n = pr.getRemainingBodyOrChunkSize();
+            PayloadWriter pw = connection->dumpResponse(rsp, 1);
+            *pw.reserveBuffer(1) = '0' + n;
+            pw.flushBuffer(1);
+
+            if (n >= 1) {
+                pr.peekData(n);
+                pr.discardData(n);
+            }
+        } while (connection->isReusable());
+    });
+
+    server.start(IPEndpoint());
+    Loop loop;
+
+    loop.createFiber([&] () -> void {
+        TCPSocket s(&loop);
+        s.connect(server.getLocalEndpoint());
+        const char m[] =
+            "GET /a HTTP/1.1\r\n\r\n"
+            "POST /b HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello"
+            "GET /c HTTP/1.1\r\nConnection: close\r\n\r\n"
+        ;
+
+        s.write(m, sizeof(m) - 1);
+        Connection c(ConnectionOptions(), std::move(s));
+
+        for (char b : {'0', '5', '0'}) {
+            Response rsp;
+            PayloadReader pr = c.parseResponse(&rsp);
+            SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+            SIREN_TEST_ASSERT(pr.getRemainingBodyOrChunkSize() == 1);
+            SIREN_TEST_ASSERT(*pr.peekData(1) == b);
+            pr.discardData(1);
+        }
+
+        SIREN_TEST_ASSERT(!c.isReusable());
+    });
+
+    loop.run();
+    server.stop();
+    server.wait();
+}
+
+
+void
+Serve(Connection *connection)
+{
+    Response rsp;
+    rsp.majorVersionNumber = 1;
+    rsp.minorVersionNumber = 1;
+    rsp.statusCode = StatusCode::OK;
+    rsp.reasonPhrase = "OK";
+
+    do {
+        Request req;
+        connection->parseRequest(&req);
+        PayloadWriter pw = connection->dumpResponse(rsp, 2);
+        std::memcpy(pw.reserveBuffer(2), "ok", 2);
+        pw.flushBuffer(2);
+    } while (connection->isReusable());
+}
+
+
+void
+RoundTrip(Connection *connection)
+{
+    Request req;
+    req.methodType = MethodType::Get;
+    req.uri.setPathName("/");
+    req.majorVersionNumber = 1;
+    req.minorVersionNumber = 1;
+    connection->dumpRequest(req, 0);
+    Response rsp;
+    PayloadReader pr = connection->parseResponse(&rsp);
+    SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+    SIREN_TEST_ASSERT(pr.getRemainingBodyOrChunkSize() == 2);
+    SIREN_TEST_ASSERT(std::memcmp(pr.peekData(2), "ok", 2) == 0);
+    pr.discardData(2);
+}
+
+} // namespace
@@ -0,0 +1,230 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include <siren/test.h>
+
+#include "request.h"
+#include "response.h"
+#include "response_cache.h"
+#include "shared_response_cache.h"
+
+
+namespace {
+
+using namespace siren::http;
+
+
+std::chrono::steady_clock::time_point MakeExpiryTime(long);
+
+
+SIREN_TEST("Store and find shared cache items")
+{
+    SharedResponseCacheOptions srco;
+    srco.segmentSize = 1024 * 1024;
+    srco.numberOfBuckets = 64;
+    srco.slabSize = 64 * 1024;
+    SharedResponseCache src(srco);
+    std::string v;
+    SIREN_TEST_ASSERT(!src.findItem("a", &v));
+    SIREN_TEST_ASSERT(src.storeItem("a", "hello", 5, MakeExpiryTime(60)));
+    SIREN_TEST_ASSERT(src.findItem("a", &v) && v == "hello");
+    SIREN_TEST_ASSERT(src.storeItem("a", "hello world", 11, MakeExpiryTime(60)));
+    SIREN_TEST_ASSERT(src.findItem("a", &v) && v == "hello world");
+    SIREN_TEST_ASSERT(src.storeItem("b", "", 0, MakeExpiryTime(60)));
+    SIREN_TEST_ASSERT(src.findItem("b", &v) && v.empty());
+    SIREN_TEST_ASSERT(src.getNumberOfItems() == 2);
+    src.removeItem("a");
+    SIREN_TEST_ASSERT(!src.findItem("a", &v));
+    SIREN_TEST_ASSERT(src.getNumberOfItems() == 1);
+    SIREN_TEST_ASSERT(src.storeItem("c", "hello", 5, MakeExpiryTime(-1)));
+    SIREN_TEST_ASSERT(!src.findItem("c", &v));
+    std::string b(srco.slabSize + 1, 'x');
+    SIREN_TEST_ASSERT(!src.storeItem("d", b.data(), b.size(), MakeExpiryTime(60)));
+}
+
+
+SIREN_TEST("Evict shared cache items")
+{
+    SharedResponseCacheOptions srco;
+    srco.segmentSize = 256 * 1024;
+    srco.numberOfBuckets = 16;
+    srco.slabSize = 16 * 1024;
+    SharedResponseCache src(srco);
+    std::string b(1000, 'x');
+
+    for (int i = 0; i < 1000; ++i) {
+        std::string k = std::to_string(i);
+        SIREN_TEST_ASSERT(src.storeItem(k, b.data(), b.size(), MakeExpiryTime(60)));
+        std::string v;
+        SIREN_TEST_ASSERT(src.findItem(k, &v) && v == b);
+    }
+
+    SIREN_TEST_ASSERT(src.getNumberOfItems() >= 1);
+    SIREN_TEST_ASSERT(src.getNumberOfItems() <= srco.segmentSize / 1024);
+}
+
+
+SIREN_TEST("Share cached responses across processes")
+{
+    SharedResponseCacheOptions srco;
+    srco.segmentSize = 1024 * 1024;
+    srco.numberOfBuckets = 64;
+    srco.slabSize = 64 * 1024;
+    SharedResponseCache src(srco);
+    Request req;
+    req.methodType = MethodType::Get;
+    req.uri.setPathName("/a");
+    req.majorVersionNumber = 1;
+    req.minorVersionNumber = 1;
+    req.header.addField("Host", "example.com");
+    pid_t pid = fork();
+    SIREN_TEST_ASSERT(pid >= 0);
+
+    if (pid == 0) {
+        Response rsp;
+        rsp.majorVersionNumber = 1;
+        rsp.minorVersionNumber = 1;
+        rsp.statusCode = StatusCode::OK;
+        rsp.reasonPhrase = "OK";
+        rsp.header.addField("Cache-Control", "max-age=60");
+        _exit(src.storeResponse(req, rsp, "hello", 5) == nullptr ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
+    int status;
+    SIREN_TEST_ASSERT(waitpid(pid, &status, 0) == pid);
+    SIREN_TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    std::shared_ptr<const CachedResponse> cr = src.findResponse(req);
+    SIREN_TEST_ASSERT(cr != nullptr);
+    SIREN_TEST_ASSERT(std::string(cr->getData(), cr->getSize())
+                      == "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nCache-Control: max-age=60\r\n"
+                         "\r\nhello");
+    SIREN_TEST_ASSERT(cr->getHeadSize() == cr->getSize() - 5);
+
+    srco.segmentFileName = "/tmp/siren-http-test-" + std::to_string(getpid());
+    unlink(srco.segmentFileName.c_str());
+
+    {
+        SharedResponseCache src1(srco);
+        SharedResponseCache src2(srco);
+        SIREN_TEST_ASSERT(src1.storeItem("a", "hello", 5, MakeExpiryTime(60)));
+        std::string v;
+        SIREN_TEST_ASSERT(src2.findItem("a", &v) && v == "hello");
+    }
+
+    unlink(srco.segmentFileName.c_str());
+}
+
+
+SIREN_TEST("Recover shared cache locks held by dead processes")
+{
+    SharedResponseCacheOptions srco;
+    srco.segmentFileName = "/tmp/siren-http-test-" + std::to_string(getpid());
+    srco.segmentSize = 1024 * 1024;
+    srco.numberOfBuckets = 4;
+    srco.slabSize = 64 * 1024;
+    unlink(srco.segmentFileName.c_str());
+
+    {
+        SharedResponseCache src(srco);
+        pid_t pid = fork();
+        SIREN_TEST_ASSERT(pid >= 0);
+
+        if (pid == 0) {
+            _exit(EXIT_SUCCESS);
+        }
+
+        SIREN_TEST_ASSERT(waitpid(pid, nullptr, 0) == pid);
+        int fd = open(srco.segmentFileName.c_str(), O_RDWR);
+        SIREN_TEST_ASSERT(fd >= 0);
+        void *segment = mmap(nullptr, srco.segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd
+                             , 0);
+        close(fd);
+        SIREN_TEST_ASSERT(segment != MAP_FAILED);
+        char *s = static_cast<char *>(segment);
+        auto segmentHeader = reinterpret_cast<detail::SharedCacheSegmentHeader *>(s);
+        std::size_t bucketsOffset = segmentHeader->bucketsOffset;
+        auto buckets = reinterpret_cast<detail::SharedCacheBucket *>(s + bucketsOffset);
+        segmentHeader->allocatorLock.store(pid);
+
+        for (std::size_t i = 0; i < srco.numberOfBuckets; ++i) {
+            buckets[i].sequenceNumber.fetch_add(1);
+            buckets[i].ownerPID.store(pid);
+        }
+
+        std::string v;
+        SIREN_TEST_ASSERT(!src.findItem("a", &v));
+        SIREN_TEST_ASSERT(!src.findItem("b", &v));
+
+        for (std::size_t i = 0; i < srco.numberOfBuckets; ++i) {
+            buckets[i].sequenceNumber.fetch_add(1);
+            buckets[i].ownerPID.store(pid);
+        }
+
+        SIREN_TEST_ASSERT(src.storeItem("a", "hello", 5, MakeExpiryTime(60)));
+        SIREN_TEST_ASSERT(src.findItem("a", &v) && v == "hello");
+        munmap(segment, srco.segmentSize);
+    }
+
+    unlink(srco.segmentFileName.c_str());
+}
+
+
+SIREN_TEST("Reinitialize shared cache segments left by earlier boots")
+{
+    SharedResponseCacheOptions srco;
+    srco.segmentFileName = "/tmp/siren-http-test-" + std::to_string(getpid());
+    srco.segmentSize = 1024 * 1024;
+    srco.numberOfBuckets = 4;
+    srco.slabSize = 64 * 1024;
+    unlink(srco.segmentFileName.c_str());
+
+    {
+        SharedResponseCache src(srco);
+        SIREN_TEST_ASSERT(src.storeItem("a", "hello", 5, MakeExpiryTime(60)));
+    }
+
+    int fd = open(srco.segmentFileName.c_str(), O_RDWR);
+    SIREN_TEST_ASSERT(fd >= 0);
+    void *segment = mmap(nullptr, srco.segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    SIREN_TEST_ASSERT(segment != MAP_FAILED);
+    char *s = static_cast<char *>(segment);
+    auto segmentHeader = reinterpret_cast<detail::SharedCacheSegmentHeader *>(s);
+    std::size_t bucketsOffset = segmentHeader->bucketsOffset;
+    auto buckets = reinterpret_cast<detail::SharedCacheBucket *>(s + bucketsOffset);
+    segmentHeader->state.fetch_xor(4);
+    segmentHeader->allocatorLock.store(getpid());
+
+    for (std::size_t i = 0; i < srco.numberOfBuckets; ++i) {
+        buckets[i].sequenceNumber.fetch_add(1);
+        buckets[i].ownerPID.store(getpid());
+    }
+
+    munmap(segment, srco.segmentSize);
+
+    {
+        SharedResponseCache src(srco);
+        SIREN_TEST_ASSERT(src.getNumberOfItems() == 0);
+        std::string v;
+        SIREN_TEST_ASSERT(!src.findItem("a", &v));
+        SIREN_TEST_ASSERT(src.storeItem("b", "world", 5, MakeExpiryTime(60)));
+        SIREN_TEST_ASSERT(src.findItem("b", &v) && v == "world");
+    }
+
+    unlink(srco.segmentFileName.c_str());
+}
+
+std::chrono::steady_clock::time_point
+MakeExpiryTime(long timeToLive)
+{
+    return std::chrono::steady_clock::now() + std::chrono::seconds(timeToLive);
+}
+
+}
@@ -0,0 +1,106 @@
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <siren/loop.h>
+#include <siren/test.h>
+
+#include "request.h"
+#include "response.h"
+#include "single_flight.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+void MakeRequest(Request *, const char *);
+
+
+SIREN_TEST("Coalesce concurrent identical fetches")
+{
+    Loop loop;
+    SingleFlight sf(&loop, SingleFlightOptions());
+    int numberOfFetches = 0;
+    std::vector<std::shared_ptr<const SharedResponse>> srs;
+
+    auto fetcher = [&] () -> std::shared_ptr<const SharedResponse> {
+        ++numberOfFetches;
+        loop.usleep(10000);
+        auto sr = std::make_shared<SharedResponse>();
+        sr->response.statusCode = StatusCode::OK;
+        sr->body = "hello";
+        return sr;
+    };
+
+    for (int i = 0; i < 10; ++i) {
+        loop.createFiber([&, i] () -> void {
+            Request req;
+            MakeRequest(&req, i < 8 ? "gzip" : "br");
+            srs.push_back(sf.fetch(req, fetcher));
+        });
+    }
+
+    loop.run();
+    SIREN_TEST_ASSERT(numberOfFetches == 2);
+    SIREN_TEST_ASSERT(sf.getNumberOfFlights() == 0);
+    SIREN_TEST_ASSERT(srs.size() == 10);
+
+    for (const std::shared_ptr<const SharedResponse> &sr : srs) {
+        SIREN_TEST_ASSERT(sr != nullptr && sr->body == "hello");
+    }
+
+    SIREN_TEST_ASSERT(std::set<std::shared_ptr<const SharedResponse>>(srs.begin(), srs.end())
+                      .size() == 2);
+}
+
+
+SIREN_TEST("Propagate fetch failures to waiters")
+{
+    Loop loop;
+    SingleFlight sf(&loop, SingleFlightOptions());
+    int numberOfFetches = 0;
+    int numberOfFailures = 0;
+
+    auto fetcher = [&] () -> std::shared_ptr<const SharedResponse> {
+        ++numberOfFetches;
+        loop.usleep(10000);
+        throw std::runtime_error("upstream failed");
+    };
+
+    for (int i = 0; i < 5; ++i) {
+        loop.createFiber([&] () -> void {
+            Request req;
+            MakeRequest(&req, "gzip");
+
+            try {
+                sf.fetch(req, fetcher);
+            } catch (const std::runtime_error &) {
+                ++numberOfFailures;
+            }
+        });
+    }
+
+    loop.run();
+    SIREN_TEST_ASSERT(numberOfFetches == 1);
+    SIREN_TEST_ASSERT(numberOfFailures == 5);
+    SIREN_TEST_ASSERT(sf.getNumberOfFlights() == 0);
+}
+
+
+void
+MakeRequest(Request *request, const char *acceptEncoding)
+{
+    request->methodType = MethodType::Get;
+    request->uri.setPathName("/a");
+    request->majorVersionNumber = 1;
+    request->minorVersionNumber = 1;
+    request->header.addField("Host", "example.com");
+    request->header.addField("Accept-Encoding", acceptEncoding);
+}
+
+}
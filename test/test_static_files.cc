@@ -0,0 +1,230 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <siren/loop.h>
+#include <siren/tcp_socket.h>
+#include <siren/test.h>
+
+#include "connection.h"
+#include "request.h"
+#include "response.h"
+#include "server.h"
+#include "static_files.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+void WriteFile(const std::string &, const std::string &);
+std::string ReadPayload(PayloadReader *);
+
+
+SIREN_TEST("Normalize path names of static files")
+{
+    auto normalize = [] (const char *pathName) -> std::string {
+        std::string normalizedPathName;
+
+        if (!NormalizePathName(pathName, &normalizedPathName)) {
+            return "!";
+        }
+
+        return normalizedPathName;
+    };
+
+    SIREN_TEST_ASSERT(normalize("/") == "");
+    SIREN_TEST_ASSERT(normalize("/a/b.js") == "a/b.js");
+    SIREN_TEST_ASSERT(normalize("//a/./b//c/") == "a/b/c");
+    SIREN_TEST_ASSERT(normalize("/a/../b") == "b");
+    SIREN_TEST_ASSERT(normalize("/a/%2e%2E/b%20c") == "b c");
+    SIREN_TEST_ASSERT(normalize("/a/..") == "");
+    SIREN_TEST_ASSERT(normalize("/..") == "!");
+    SIREN_TEST_ASSERT(normalize("/a/../../etc/passwd") == "!");
+    SIREN_TEST_ASSERT(normalize("/%2e%2e/etc/passwd") == "!");
+    SIREN_TEST_ASSERT(normalize("/a%00.js") == "!");
+    SIREN_TEST_ASSERT(normalize("/a%2") == "!");
+    SIREN_TEST_ASSERT(normalize("/a\\..\\b") == "!");
+    SIREN_TEST_ASSERT(normalize("a") == "!");
+}
+
+
+SIREN_TEST("Look up content types of static files")
+{
+    SIREN_TEST_ASSERT(std::strcmp(LookupContentType("index.html")
+                                  , "text/html; charset=utf-8") == 0);
+    SIREN_TEST_ASSERT(std::strcmp(LookupContentType("a/b.c/APP.JS")
+                                  , "text/javascript; charset=utf-8") == 0);
+    SIREN_TEST_ASSERT(std::strcmp(LookupContentType("x.woff2"), "font/woff2") == 0);
+    SIREN_TEST_ASSERT(std::strcmp(LookupContentType("a.b/c"), "application/octet-stream") == 0);
+    SIREN_TEST_ASSERT(std::strcmp(LookupContentType(".png"), "application/octet-stream") == 0);
+    SIREN_TEST_ASSERT(std::strcmp(LookupContentType("x.unknown"), "application/octet-stream")
+                      == 0);
+}
+
+
+SIREN_TEST("Serve static files")
+{
+    char d[] = "/tmp/siren-http-test-XXXXXX";
+    SIREN_TEST_ASSERT(mkdtemp(d) != nullptr);
+    std::string small = "<p>hello</p>";
+    std::string large;
+
+    for (int i = 0; large.size() < 1024 * 1024; ++i) {
+        large += std::to_string(i) + ',';
+    }
+
+    char d2[] = "/tmp/siren-http-test-XXXXXX";
+    SIREN_TEST_ASSERT(mkdtemp(d2) != nullptr);
+    WriteFile(std::string(d2) + "/secret.txt", small);
+    SIREN_TEST_ASSERT(symlink(d2, (std::string(d) + "/escape").c_str()) == 0);
+    mkdir((std::string(d) + "/sub").c_str(), 0755);
+    WriteFile(std::string(d) + "/sub/index.html", small);
+    WriteFile(std::string(d) + "/large.bin", large);
+    StaticFilesOptions sfo;
+    sfo.maxNumberOfCachedFiles = 1;
+    StaticFiles sf(sfo, d);
+    ServerOptions so;
+    so.numberOfReactors = 1;
+
+    Server server(so, [&sf] (Connection *connection) -> void {
+        do {
+            Request req;
+            connection->parseRequest(&req);
+            sf.handleRequest(connection, req);
+        } while (connection->isReusable());
+    });
+
+    server.start(IPEndpoint());
+    Loop loop;
+
+    loop.createFiber([&] () -> void {
+        TCPSocket s(&loop);
+        s.connect(server.getLocalEndpoint());
+        ConnectionOptions co;
+        co.maxBodySize = 2 * large.size();
+        Connection c(co, std::move(s));
+
+        auto get = [&c] (const char *pathName, Response *rsp) -> std::string {
+            Request req;
+            req.methodType = MethodType::Get;
+            req.uri.setPathName(pathName);
+            req.majorVersionNumber = 1;
+            req.minorVersionNumber = 1;
+            c.dumpRequest(req, 0);
+            PayloadReader pr = c.parseResponse(rsp);
+            return ReadPayload(&pr);
+        };
+
+        for (int i = 0; i < 2; ++i) {
+            Response rsp;
+            SIREN_TEST_ASSERT(get("/sub/", &rsp) == small);
+            SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+            SIREN_TEST_ASSERT(get("/sub/../large.bin", &rsp) == large);
+            SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+        }
+
+        auto getRange = [&c] (const char *pathName, const char *range, Response *rsp)
+                        -> std::string {
+            Request req;
+            req.methodType = MethodType::Get;
+            req.uri.setPathName(pathName);
+            req.majorVersionNumber = 1;
+            req.minorVersionNumber = 1;
+            req.header.addField("Range", range);
+            c.dumpRequest(req, 0);
+            PayloadReader pr = c.parseResponse(rsp);
+            return ReadPayload(&pr);
+        };
+
+        for (const char *pathName : {"/sub/index.html", "/large.bin"}) {
+            const std::string &p = pathName[1] == 's' ? small : large;
+            Response rsp;
+            SIREN_TEST_ASSERT(getRange(pathName, "bytes=3-5", &rsp) == p.substr(3, 3));
+            SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::PartialContent);
+            std::string m = getRange(pathName, "bytes=0-0,-2", &rsp);
+            SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::PartialContent);
+            SIREN_TEST_ASSERT(m.find("Content-Range: bytes 0-0/") != std::string::npos);
+            SIREN_TEST_ASSERT(m.find(p.substr(p.size() - 2) + "\r\n--") != std::string::npos);
+            getRange(pathName, "bytes=99999999-", &rsp);
+            SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::RangeNotSatisfiable);
+        }
+
+        Response rsp;
+        get("/missing.html", &rsp);
+        SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::NotFound);
+        get("/../etc/passwd", &rsp);
+        SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::BadRequest);
+        get("/escape/secret.txt", &rsp);
+        SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::NotFound);
+        Request req;
+        req.methodType = MethodType::Head;
+        req.uri.setPathName("/large.bin");
+        req.majorVersionNumber = 1;
+        req.minorVersionNumber = 1;
+        c.dumpRequest(req, 0);
+        PayloadReader pr = c.parseResponse(&rsp, MethodType::Head);
+        SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+        SIREN_TEST_ASSERT(!pr.bodyIsChunked() && pr.getRemainingBodyOrChunkSize() == 0);
+        char contentLength[32];
+        std::sprintf(contentLength, "%zo", large.size());
+        int n = 0;
+
+        rsp.header.search("Content-Length", [&] (std::size_t, const char *headerFieldValue)
+                                            -> bool {
+            n += std::strcmp(headerFieldValue, contentLength) == 0;
+            return true;
+        });
+
+        SIREN_TEST_ASSERT(n == 1);
+    });
+
+    loop.run();
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(sf.getNumberOfCachedFiles() == 1);
+    std::remove((std::string(d) + "/sub/index.html").c_str());
+    std::remove((std::string(d) + "/large.bin").c_str());
+    rmdir((std::string(d) + "/sub").c_str());
+    std::remove((std::string(d) + "/escape").c_str());
+    rmdir(d);
+    std::remove((std::string(d2) + "/secret.txt").c_str());
+    rmdir(d2);
+}
+
+
+void
+WriteFile(const std::string &fileName, const std::string &content)
+{
+    std::FILE *file = std::fopen(fileName.c_str(), "w");
+    SIREN_TEST_ASSERT(file != nullptr);
+    SIREN_TEST_ASSERT(std::fwrite(content.data(), 1, content.size(), file) == content.size());
+    std::fclose(file);
+}
+
+
+std::string
+ReadPayload(PayloadReader *payloadReader)
+{
+    std::string payload;
+
+    for (;;) {
+        std::size_t n = payloadReader->getRemainingBodyOrChunkSize();
+
+        if (n == 0 && !payloadReader->bodyIsChunked()) {
+            return payload;
+        }
+
+        n = std::min<std::size_t>(n, 4096);
+        payload.append(payloadReader->peekData(n), n);
+        payloadReader->discardData(n);
+    }
+}
+
+} // namespace
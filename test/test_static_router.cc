@@ -0,0 +1,127 @@
+#include <string>
+
+#include <siren/test.h>
+
+#include "request.h"
+#include "router.h"
+#include "static_router.h"
+
+
+namespace {
+
+using namespace siren::http;
+
+
+constexpr char Root[] = "/";
+constexpr char Users[] = "/users";
+constexpr char UsersMe[] = "/users/me";
+constexpr char User[] = "/users/:id";
+constexpr char UserPost[] = "/users/:id/posts/:postID";
+constexpr char Static[] = "/static/*path";
+constexpr char Item[] = "/items/:id";
+constexpr char ItemsNew[] = "/items/new";
+constexpr char ItemTag[] = "/items/:id/tags/:tag";
+constexpr char Files[] = "/files/*path";
+constexpr char FilesIndex[] = "/files/index";
+
+
+typedef StaticRouter<
+    StaticRoute<MethodType::Get, Root>,
+    StaticRoute<MethodType::Get, Users>,
+    StaticRoute<MethodType::Post, Users>,
+    StaticRoute<MethodType::Get, UsersMe>,
+    StaticRoute<MethodType::Get, User>,
+    StaticRoute<MethodType::Get, UserPost>,
+    StaticRoute<MethodType::Get, Static>
+> TestRouter;
+
+
+typedef StaticRouter<
+    StaticRoute<MethodType::Get, Item>,
+    StaticRoute<MethodType::Post, ItemsNew>,
+    StaticRoute<MethodType::Get, ItemsNew>,
+    StaticRoute<MethodType::Get, ItemTag>,
+    StaticRoute<MethodType::Get, Files>,
+    StaticRoute<MethodType::Get, FilesIndex>
+> PriorityRouter;
+
+
+std::string GetParameter(const RouteParameters &, const char *);
+
+
+SIREN_TEST("Route requests by path at compile time")
+{
+    static_assert(TestRouter::NumberOfRoutes == 7, "");
+    RouteParameters ps;
+
+    SIREN_TEST_ASSERT(TestRouter::MatchRoute(MethodType::Get, "/", &ps) == 0);
+    SIREN_TEST_ASSERT(TestRouter::MatchRoute(MethodType::Get, "/users", &ps) == 1);
+    SIREN_TEST_ASSERT(TestRouter::MatchRoute(MethodType::Post, "/users", &ps) == 2);
+    SIREN_TEST_ASSERT(TestRouter::MatchRoute(MethodType::Get, "/users/me", &ps) == 3);
+    SIREN_TEST_ASSERT(ps.getCount() == 0);
+    SIREN_TEST_ASSERT(TestRouter::MatchRoute(MethodType::Get, "/users/mel", &ps) == 4);
+    SIREN_TEST_ASSERT(ps.getCount() == 1 && GetParameter(ps, "id") == "mel");
+    SIREN_TEST_ASSERT(TestRouter::MatchRoute(MethodType::Get, "/users/42/posts/7", &ps) == 5);
+    SIREN_TEST_ASSERT(GetParameter(ps, "id") == "42" && GetParameter(ps, "postID") == "7");
+    SIREN_TEST_ASSERT(TestRouter::MatchRoute(MethodType::Get, "/static/a/b.css", &ps) == 6);
+    SIREN_TEST_ASSERT(GetParameter(ps, "path") == "a/b.css");
+    SIREN_TEST_ASSERT(TestRouter::MatchRoute(MethodType::Get, "/users/", &ps) == std::size_t(-1));
+    SIREN_TEST_ASSERT(ps.getCount() == 0);
+    SIREN_TEST_ASSERT(TestRouter::MatchRoute(MethodType::Put, "/users", &ps) == std::size_t(-1));
+    SIREN_TEST_ASSERT(TestRouter::MatchRoute(MethodType::Get, "/user", nullptr)
+                      == std::size_t(-1));
+
+    Request req;
+    req.methodType = MethodType::Get;
+    req.uri.setPathName("/users/9/posts/1");
+    SIREN_TEST_ASSERT(TestRouter::MatchRoute(req, &ps) == 5);
+}
+
+
+SIREN_TEST("Prefer static route segments at compile time")
+{
+    RouteParameters ps;
+
+    SIREN_TEST_ASSERT(PriorityRouter::MatchRoute(MethodType::Get, "/items/new", &ps) == 2);
+    SIREN_TEST_ASSERT(ps.getCount() == 0);
+    SIREN_TEST_ASSERT(PriorityRouter::MatchRoute(MethodType::Post, "/items/new", &ps) == 1);
+    SIREN_TEST_ASSERT(PriorityRouter::MatchRoute(MethodType::Get, "/items/news", &ps) == 0);
+    SIREN_TEST_ASSERT(GetParameter(ps, "id") == "news");
+    SIREN_TEST_ASSERT(PriorityRouter::MatchRoute(MethodType::Get, "/items/new/tags/x", &ps) == 3);
+    SIREN_TEST_ASSERT(GetParameter(ps, "id") == "new" && GetParameter(ps, "tag") == "x");
+    SIREN_TEST_ASSERT(PriorityRouter::MatchRoute(MethodType::Get, "/files/index", &ps) == 5);
+    SIREN_TEST_ASSERT(PriorityRouter::MatchRoute(MethodType::Get, "/files/a/b", &ps) == 4);
+    SIREN_TEST_ASSERT(GetParameter(ps, "path") == "a/b");
+    SIREN_TEST_ASSERT(PriorityRouter::MatchRoute(MethodType::Get, "/files/", &ps) == 4);
+    SIREN_TEST_ASSERT(GetParameter(ps, "path") == "");
+    SIREN_TEST_ASSERT(PriorityRouter::MatchRoute(MethodType::Put, "/items/new", &ps)
+                      == std::size_t(-1));
+
+    Router<std::size_t> r;
+    r.addRoute(MethodType::Get, Item, 0);
+    r.addRoute(MethodType::Post, ItemsNew, 1);
+    r.addRoute(MethodType::Get, ItemsNew, 2);
+    r.addRoute(MethodType::Get, ItemTag, 3);
+    r.addRoute(MethodType::Get, Files, 4);
+    r.addRoute(MethodType::Get, FilesIndex, 5);
+
+    for (const char *path : {"/items/new", "/items/7", "/items/7/tags/a", "/items/new/tags/",
+                             "/files/index", "/files/indexes", "/files", "/", "/items/"}) {
+        for (MethodType methodType : {MethodType::Get, MethodType::Post}) {
+            const std::size_t *v = r.matchRoute(methodType, path, nullptr);
+            std::size_t routeIndex = PriorityRouter::MatchRoute(methodType, path, nullptr);
+            SIREN_TEST_ASSERT(routeIndex == (v == nullptr ? std::size_t(-1) : *v));
+        }
+    }
+}
+
+
+std::string
+GetParameter(const RouteParameters &parameters, const char *name)
+{
+    const RouteParameter *parameter = parameters.find(name);
+    SIREN_TEST_ASSERT(parameter != nullptr);
+    return std::string(parameter->value, parameter->valueSize);
+}
+
+} // namespace
@@ -0,0 +1,86 @@
+#include <vector>
+
+#include <siren/test.h>
+
+#include "timer_wheel.h"
+
+
+namespace {
+
+using namespace siren::http;
+
+
+SIREN_TEST("Expire timers in timer wheels")
+{
+    const long timeouts[] = {0, 10, 250, 640, 6400, 300000, 10000, 41000};
+    const int n = sizeof(timeouts) / sizeof(*timeouts);
+    detail::TimerWheel w(10);
+    SIREN_TEST_ASSERT(w.getTickInterval() == 10);
+    detail::Timer ts[n];
+
+    for (int i = 0; i < n; ++i) {
+        w.addTimer(&ts[i], timeouts[i]);
+        SIREN_TEST_ASSERT(ts[i].isActive());
+    }
+
+    std::vector<long> expiryTimes(n, -1);
+    long t = 0;
+
+    while (t < 400000) {
+        t += 5;
+
+        w.advance(5, [&] (detail::Timer *timer) -> void {
+            SIREN_TEST_ASSERT(!timer->isActive());
+            expiryTimes[timer - ts] = t;
+        });
+    }
+
+    for (int i = 0; i < n; ++i) {
+        SIREN_TEST_ASSERT(!ts[i].isActive());
+        SIREN_TEST_ASSERT(expiryTimes[i] > timeouts[i]);
+        SIREN_TEST_ASSERT(expiryTimes[i] <= timeouts[i] + 2 * w.getTickInterval());
+    }
+}
+
+
+SIREN_TEST("Cancel and rearm timers in timer wheels")
+{
+    detail::TimerWheel w(1);
+    detail::Timer t1, t2;
+    w.addTimer(&t1, 100);
+    w.addTimer(&t2, 100);
+    int n = 0;
+
+    w.advance(50, [&] (detail::Timer *) -> void {
+        ++n;
+    });
+
+    w.removeTimer(&t1);
+    SIREN_TEST_ASSERT(!t1.isActive());
+
+    {
+        detail::Timer t3;
+        w.addTimer(&t3, 10);
+    }
+
+    w.advance(100, [&] (detail::Timer *timer) -> void {
+        SIREN_TEST_ASSERT(timer == &t2);
+
+        if (++n == 1) {
+            w.addTimer(timer, 100);
+        }
+    });
+
+    SIREN_TEST_ASSERT(n == 1);
+    SIREN_TEST_ASSERT(t2.isActive());
+
+    w.advance(100, [&] (detail::Timer *timer) -> void {
+        SIREN_TEST_ASSERT(timer == &t2);
+        ++n;
+    });
+
+    SIREN_TEST_ASSERT(n == 2);
+    SIREN_TEST_ASSERT(!t2.isActive());
+}
+
+} // namespace
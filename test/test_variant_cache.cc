@@ -0,0 +1,240 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include <siren/loop.h>
+#include <siren/tcp_socket.h>
+#include <siren/test.h>
+
+#include "connection.h"
+#include "header.h"
+#include "request.h"
+#include "response.h"
+#include "server.h"
+#include "variant_cache.h"
+
+
+namespace {
+
+using namespace siren;
+using namespace siren::http;
+
+
+std::string MakeContent(int);
+void WriteFile(const std::string &, const std::string &);
+
+
+SIREN_TEST("Cache compressed variants of assets")
+{
+    VariantCacheOptions vco;
+    vco.maxCacheSize = 1024 * 1024;
+    VariantCache vc(vco);
+    std::string p = MakeContent(1000);
+    std::shared_ptr<const Asset> a1 = vc.addAsset(p);
+    SIREN_TEST_ASSERT(a1->getContent() == p);
+    SIREN_TEST_ASSERT(a1->getVariant(ContentCoding::Gzip) != nullptr);
+    SIREN_TEST_ASSERT(a1->getVariant(ContentCoding::Gzip)->size() < p.size() / 4);
+    SIREN_TEST_ASSERT(a1->getVariant(ContentCoding::Deflate) == nullptr);
+    SIREN_TEST_ASSERT(vc.addAsset(p) == a1);
+    SIREN_TEST_ASSERT(vc.getNumberOfAssets() == 1);
+    SIREN_TEST_ASSERT(vc.getCacheSize() == a1->getSize());
+
+    Header h;
+    SIREN_TEST_ASSERT(a1->selectVariant(h).first == ContentCoding::Identity);
+    SIREN_TEST_ASSERT(*a1->selectVariant(h).second == p);
+    h.addField("Accept-Encoding", "deflate, gzip");
+    SIREN_TEST_ASSERT(a1->selectVariant(h).first == ContentCoding::Gzip);
+    SIREN_TEST_ASSERT(a1->selectVariant(h).second == a1->getVariant(ContentCoding::Gzip));
+
+    std::shared_ptr<const Asset> a2 = vc.addAsset("tiny");
+    SIREN_TEST_ASSERT(a2->getContentCodingMask() == 1U);
+    SIREN_TEST_ASSERT(a2->selectVariant(h).first == ContentCoding::Identity);
+    SIREN_TEST_ASSERT(vc.getNumberOfAssets() == 2);
+}
+
+
+SIREN_TEST("Evict least recently used assets")
+{
+    VariantCacheOptions vco;
+    vco.maxCacheSize = 3000;
+    vco.minCompressionSize = 1000000;
+    VariantCache vc(vco);
+    std::string p1(1000, '1'), p2(1000, '2'), p3(1000, '3'), p4(1000, '4');
+    std::shared_ptr<const Asset> a1 = vc.addAsset(p1);
+    vc.addAsset(p2);
+    vc.addAsset(p3);
+    SIREN_TEST_ASSERT(vc.addAsset(p1) == a1);
+    vc.addAsset(p4);
+    SIREN_TEST_ASSERT(vc.getNumberOfAssets() == 3);
+    SIREN_TEST_ASSERT(vc.getCacheSize() == 3000);
+    SIREN_TEST_ASSERT(vc.addAsset(p1) == a1);
+    std::shared_ptr<const Asset> a5 = vc.addAsset(std::string(4000, '5'));
+    SIREN_TEST_ASSERT(a5->getSize() == 4000);
+    SIREN_TEST_ASSERT(vc.getNumberOfAssets() == 3);
+}
+
+
+SIREN_TEST("Load assets with sidecar files")
+{
+    char d[] = "/tmp/siren-http-test-XXXXXX";
+    SIREN_TEST_ASSERT(mkdtemp(d) != nullptr);
+    std::string f = std::string(d) + "/app.js";
+    std::string p = MakeContent(100);
+    WriteFile(f, p);
+    WriteFile(f + ".br", "precompressed");
+    VariantCache vc(VariantCacheOptions{});
+    std::shared_ptr<const Asset> a = vc.loadAsset(f);
+    SIREN_TEST_ASSERT(a->getContent() == p);
+    SIREN_TEST_ASSERT(a->getVariant(ContentCoding::Brotli) != nullptr);
+    SIREN_TEST_ASSERT(*a->getVariant(ContentCoding::Brotli) == "precompressed");
+    SIREN_TEST_ASSERT(a->getVariant(ContentCoding::Gzip) != nullptr);
+
+    Header h;
+    h.addField("Accept-Encoding", "gzip, br");
+    SIREN_TEST_ASSERT(a->selectVariant(h).first == ContentCoding::Brotli);
+    SIREN_TEST_ASSERT(vc.addAsset(p) == a);
+
+    bool ok = false;
+
+    try {
+        vc.loadAsset(std::string(d) + "/missing.js");
+    } catch (const std::system_error &) {
+        ok = true;
+    }
+
+    SIREN_TEST_ASSERT(ok);
+    std::remove((f + ".br").c_str());
+    std::remove(f.c_str());
+    rmdir(d);
+}
+
+
+SIREN_TEST("Skip stale sidecar files and reload changed assets")
+{
+    char d[] = "/tmp/siren-http-test-XXXXXX";
+    SIREN_TEST_ASSERT(mkdtemp(d) != nullptr);
+    std::string f = std::string(d) + "/app.css";
+    std::string p1 = MakeContent(100);
+    WriteFile(f, p1);
+    WriteFile(f + ".br", "stale");
+    const timespec ts[2] = {{1, 0}, {1, 0}};
+    SIREN_TEST_ASSERT(utimensat(AT_FDCWD, (f + ".br").c_str(), ts, 0) == 0);
+    VariantCache vc(VariantCacheOptions{});
+    std::shared_ptr<const Asset> a1 = vc.loadAsset(f);
+    SIREN_TEST_ASSERT(a1->getContent() == p1);
+    const std::string *v = a1->getVariant(ContentCoding::Brotli);
+    SIREN_TEST_ASSERT(v == nullptr || *v != "stale");
+    SIREN_TEST_ASSERT(vc.loadAsset(f) == a1);
+
+    std::string p2 = MakeContent(200);
+    WriteFile(f, p2);
+    std::shared_ptr<const Asset> a2 = vc.loadAsset(f);
+    SIREN_TEST_ASSERT(a2 != a1);
+    SIREN_TEST_ASSERT(a2->getContent() == p2);
+    SIREN_TEST_ASSERT(vc.loadAsset(f) == a2);
+    std::remove((f + ".br").c_str());
+    std::remove(f.c_str());
+    rmdir(d);
+}
+
+
+SIREN_TEST("Dump assets in responses to HEAD requests")
+{
+    VariantCache vc((VariantCacheOptions()));
+    std::shared_ptr<const Asset> a = vc.addAsset(MakeContent(1000));
+    const std::string *v = a->getVariant(ContentCoding::Gzip);
+    SIREN_TEST_ASSERT(v != nullptr);
+    ServerOptions so;
+    so.numberOfReactors = 1;
+
+    Server server(so, [&a] (Connection *connection) -> void {
+        do {
+            Request req;
+            connection->parseRequest(&req);
+            Response rsp;
+            rsp.majorVersionNumber = 1;
+            rsp.minorVersionNumber = 1;
+            rsp.statusCode = StatusCode::OK;
+            rsp.reasonPhrase = "OK";
+            DumpAsset(connection, req, &rsp, *a);
+        } while (connection->isReusable());
+    });
+
+    server.start(IPEndpoint());
+    Loop loop;
+    int numberOfResponses = 0;
+
+    loop.createFiber([&] () -> void {
+        TCPSocket s(&loop);
+        s.connect(server.getLocalEndpoint());
+        Connection c(ConnectionOptions(), std::move(s));
+        char contentLength[32];
+        std::sprintf(contentLength, "%zo", v->size());
+
+        for (MethodType methodType : {MethodType::Head, MethodType::Get}) {
+            Request req;
+            req.methodType = methodType;
+            req.uri.setPathName("/");
+            req.majorVersionNumber = 1;
+            req.minorVersionNumber = 1;
+            req.header.addField("Accept-Encoding", "gzip");
+            c.dumpRequest(req, 0);
+            Response rsp;
+            PayloadReader pr = c.parseResponse(&rsp, methodType);
+            SIREN_TEST_ASSERT(rsp.statusCode == StatusCode::OK);
+            std::size_t n = pr.getRemainingBodyOrChunkSize();
+
+            if (methodType == MethodType::Head) {
+                SIREN_TEST_ASSERT(n == 0);
+                int m = 0;
+
+                rsp.header.search("Content-Length", [&] (std::size_t, const char *value) -> bool {
+                    m += std::strcmp(value, contentLength) == 0;
+                    return true;
+                });
+
+                SIREN_TEST_ASSERT(m == 1);
+            } else {
+                SIREN_TEST_ASSERT(n == v->size());
+                SIREN_TEST_ASSERT(std::memcmp(pr.peekData(n), v->data(), n) == 0);
+                pr.discardData(n);
+            }
+
+            ++numberOfResponses;
+        }
+    });
+
+    loop.run();
+    server.stop();
+    server.wait();
+    SIREN_TEST_ASSERT(numberOfResponses == 2);
+}
+
+std::string
+MakeContent(int n)
+{
+    std::string content;
+
+    for (int i = 0; i < n; ++i) {
+        content += "{\"id\": " + std::to_string(i) + ", \"name\": \"siren\"},";
+    }
+
+    return content;
+}
+
+
+void
+WriteFile(const std::string &fileName, const std::string &content)
+{
+    std::FILE *file = std::fopen(fileName.c_str(), "w");
+    SIREN_TEST_ASSERT(file != nullptr);
+    SIREN_TEST_ASSERT(std::fwrite(content.data(), 1, content.size(), file) == content.size());
+    std::fclose(file);
+}
+
+} // namespace